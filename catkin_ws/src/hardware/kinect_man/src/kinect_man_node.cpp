@@ -17,6 +17,17 @@ sensor_msgs::PointCloud2::Ptr msgFromBag;
 bool use_oni = false;
 bool use_bag = false;
 
+//Per-frame cache. Each captured frame is converted at most once to each output frame (kinect, robot, downsampled),
+//the first time it is needed by a subscriber or by a service request. Messages are stamped with the capture time.
+sensor_msgs::PointCloud2 msgCloudKinect;
+sensor_msgs::PointCloud2 msgCloudRobot;
+sensor_msgs::PointCloud2 msgDownsampled;
+ros::Time captureStamp;
+unsigned int currentFrame = 0;       //Incremented each time a frame is captured. Zero means no frame yet.
+unsigned int kinectMsgFrame = 0;     //Frame to which each cached message corresponds
+unsigned int robotMsgFrame = 0;
+unsigned int downsampledMsgFrame = 0;
+
 void initialize_rosmsg(sensor_msgs::PointCloud2& msg, int width, int height, std::string frame_id)
 {
     msg.header.frame_id = frame_id;
@@ -48,15 +59,21 @@ void initialize_rosmsg(sensor_msgs::PointCloud2& msg, int width, int height, std
 void cvmat_2_rosmsg(cv::Mat& depth, cv::Mat& bgr, sensor_msgs::PointCloud2& msg)
 {
     //This function ONLY COPIES POINT DATA. For all headers, use initialize_msg();
+    //Images retrieved from the capture are continuous, thus, they are read as plain arrays.
     int idx = bgr.rows * bgr.cols;
-    
-    for(int i=0; i < idx; i++)
+    const float* xyz = (const float*)depth.data;
+    const unsigned char* color = bgr.data;
+    unsigned char* data = &msg.data[0];
+    for(int i=0; i < idx; i++, xyz += 3, color += 3, data += 16)
     {
-        memcpy(&msg.data[i*16], &depth.data[12*i], 12);
-        memcpy(&msg.data[i*16 + 12], &bgr.data[3*i], 3);
-        msg.data[16*i + 15] = 255;
-	float* y = (float*)&msg.data[16*i + 4];
-        *y *= -1;
+        float* p = (float*)data;
+        p[0] =  xyz[0];
+        p[1] = -xyz[1];
+        p[2] =  xyz[2];
+        data[12] = color[0];
+        data[13] = color[1];
+        data[14] = color[2];
+        data[15] = 255;
     }
 }
 
@@ -67,41 +84,99 @@ void downsample_by_3(sensor_msgs::PointCloud2& src, sensor_msgs::PointCloud2& ds
             memcpy(&dst.data[16*(j*dst.width + i)], &src.data[48*(j*src.width + i)], 16);
 }
 
-bool kinectRgbd_callback(point_cloud_manager::GetRgbd::Request &req, point_cloud_manager::GetRgbd::Response &resp)
+sensor_msgs::PointCloud2* getCloudKinect()
 {
-    if(!use_bag)
-    {
-        initialize_rosmsg(resp.point_cloud, 640, 480, "kinect_link");
-        cvmat_2_rosmsg(depthMap, bgrImage, resp.point_cloud);
-        resp.point_cloud.header.stamp = ros::Time::now();
-        return true;
-    }
-    else
+    if(currentFrame == 0)
+        return NULL;
+    if(use_bag)
+        return msgFromBag.get();
+    if(kinectMsgFrame != currentFrame)
     {
-        if(msgFromBag == NULL) return false;
-        resp.point_cloud = *msgFromBag;
-        return true;
+        if(depthMap.rows*depthMap.cols != msgCloudKinect.width*msgCloudKinect.height ||
+           bgrImage.rows*bgrImage.cols != msgCloudKinect.width*msgCloudKinect.height)
+        {
+            std::cout << "KinectMan.->Captured images do not have the expected size." << std::endl;
+            return NULL;
+        }
+        cvmat_2_rosmsg(depthMap, bgrImage, msgCloudKinect);
+        msgCloudKinect.header.stamp = captureStamp;
+        kinectMsgFrame = currentFrame;
     }
+    return &msgCloudKinect;
 }
 
-bool robotRgbd_callback(point_cloud_manager::GetRgbd::Request &req, point_cloud_manager::GetRgbd::Response &resp)
+sensor_msgs::PointCloud2* getCloudRobot()
 {
-    if(!use_bag)
-    {
-        initialize_rosmsg(resp.point_cloud, 640, 480, "kinect_link");
-        cvmat_2_rosmsg(depthMap, bgrImage, resp.point_cloud);
-        pcl_ros::transformPointCloud("base_link", resp.point_cloud, resp.point_cloud, *tf_listener);
-	resp.point_cloud.header.frame_id = "base_link";
-        return true;
+    if(robotMsgFrame == currentFrame && currentFrame != 0)
+        return &msgCloudRobot;
+    sensor_msgs::PointCloud2* cloudKinect = getCloudKinect();
+    if(cloudKinect == NULL)
+        return NULL;
+    //Live frames use the latest transform, as before. Bag frames use the transform at the time they are replayed.
+    tf::StampedTransform transformTf;
+    try{
+        ros::Time tfStamp = use_bag ? cloudKinect->header.stamp : ros::Time(0);
+        if(use_bag)
+            tf_listener->waitForTransform("base_link", cloudKinect->header.frame_id, tfStamp, ros::Duration(0.5));
+        tf_listener->lookupTransform("base_link", cloudKinect->header.frame_id, tfStamp, transformTf);
     }
-    else
-    {
-        if(msgFromBag == NULL) return false;
-        resp.point_cloud = *msgFromBag;
-        tf_listener->waitForTransform("base_link", "kinect_link", msgFromBag->header.stamp, ros::Duration(0.5));
-        pcl_ros::transformPointCloud("base_link", resp.point_cloud, resp.point_cloud, *tf_listener);
-        return true;
+    catch(tf::TransformException& ex){
+        ROS_ERROR("%s", ex.what());
+        return NULL;
     }
+    pcl_ros::transformPointCloud("base_link", transformTf, *cloudKinect, msgCloudRobot);
+    msgCloudRobot.header.frame_id = "base_link";
+    msgCloudRobot.header.stamp = cloudKinect->header.stamp;
+    robotMsgFrame = currentFrame;
+    return &msgCloudRobot;
+}
+
+sensor_msgs::PointCloud2* getCloudDownsampled()
+{
+    if(downsampledMsgFrame == currentFrame && currentFrame != 0)
+        return &msgDownsampled;
+    sensor_msgs::PointCloud2* cloudRobot = getCloudRobot();
+    if(cloudRobot == NULL || cloudRobot->width/3 != msgDownsampled.width || cloudRobot->height/3 != msgDownsampled.height)
+        return NULL;
+    downsample_by_3(*cloudRobot, msgDownsampled);
+    msgDownsampled.header.stamp = cloudRobot->header.stamp;
+    downsampledMsgFrame = currentFrame;
+    return &msgDownsampled;
+}
+
+void newFrameCaptured(const ros::Time& stamp)
+{
+    captureStamp = stamp;
+    if(++currentFrame == 0) //Zero is reserved for 'no frame'
+        currentFrame = 1;
+}
+
+bool kinectRgbd_callback(point_cloud_manager::GetRgbd::Request &req, point_cloud_manager::GetRgbd::Response &resp)
+{
+    //Several requests within the same frame get the same cached message. Header stamp is the capture time.
+    sensor_msgs::PointCloud2* cloud = getCloudKinect();
+    if(cloud == NULL) return false;
+    resp.point_cloud = *cloud;
+    return true;
+}
+
+bool robotRgbd_callback(point_cloud_manager::GetRgbd::Request &req, point_cloud_manager::GetRgbd::Response &resp)
+{
+    sensor_msgs::PointCloud2* cloud = getCloudRobot();
+    if(cloud == NULL) return false;
+    resp.point_cloud = *cloud;
+    return true;
+}
+
+void publishFrame(ros::Publisher& pubKinectFrame, ros::Publisher& pubRobotFrame, ros::Publisher& pubDownsampled)
+{
+    sensor_msgs::PointCloud2* cloud;
+    if(pubKinectFrame.getNumSubscribers() > 0 && (cloud = getCloudKinect()) != NULL)
+        pubKinectFrame.publish(*cloud);
+    if(pubRobotFrame.getNumSubscribers() > 0 && (cloud = getCloudRobot()) != NULL)
+        pubRobotFrame.publish(*cloud);
+    if(pubDownsampled.getNumSubscribers() > 0 && (cloud = getCloudDownsampled()) != NULL)
+        pubDownsampled.publish(*cloud);
 }
 
 int main(int argc, char** argv)
@@ -136,9 +211,6 @@ int main(int argc, char** argv)
     ros::Publisher pubDownsampled =n.advertise<sensor_msgs::PointCloud2>("/hardware/point_cloud_man/rgbd_wrt_robot_downsampled",1);
     ros::ServiceServer srvRgbdKinect = n.advertiseService("/hardware/point_cloud_man/get_rgbd_wrt_kinect", kinectRgbd_callback);
     ros::ServiceServer srvRgbdRobot  = n.advertiseService("/hardware/point_cloud_man/get_rgbd_wrt_robot", robotRgbd_callback);
-    sensor_msgs::PointCloud2 msgCloudKinect;
-    sensor_msgs::PointCloud2 msgCloudRobot; 
-    sensor_msgs::PointCloud2 msgDownsampled;
     tf_listener = new tf::TransformListener();
     ros::Rate loop(30);
     tf_listener->waitForTransform("base_link", "kinect_link", ros::Time(0), ros::Duration(10.0));
@@ -171,20 +243,8 @@ int main(int argc, char** argv)
             }
             capture.retrieve(depthMap, CV_CAP_OPENNI_POINT_CLOUD_MAP);
             capture.retrieve(bgrImage, CV_CAP_OPENNI_BGR_IMAGE);
-            if(pubKinectFrame.getNumSubscribers()>0 || pubRobotFrame.getNumSubscribers()>0 || pubDownsampled.getNumSubscribers()>0)
-                cvmat_2_rosmsg(depthMap, bgrImage, msgCloudKinect);
-            if(pubRobotFrame.getNumSubscribers()>0 || pubDownsampled.getNumSubscribers()>0)
-                pcl_ros::transformPointCloud("base_link", msgCloudKinect, msgCloudRobot, *tf_listener);
-            
-            if(pubKinectFrame.getNumSubscribers() > 0)
-                pubKinectFrame.publish(msgCloudKinect);
-            if(pubRobotFrame.getNumSubscribers() > 0)
-                pubRobotFrame.publish(msgCloudRobot);
-            if(pubDownsampled.getNumSubscribers() > 0)
-            {
-                downsample_by_3(msgCloudRobot, msgDownsampled);
-                pubDownsampled.publish(msgDownsampled);
-            }
+            newFrameCaptured(ros::Time::now());
+            publishFrame(pubKinectFrame, pubRobotFrame, pubDownsampled);
             
             ros::spinOnce();
             loop.sleep();
@@ -206,21 +266,8 @@ int main(int argc, char** argv)
                     continue;
                 }
                 msgFromBag->header.stamp = ros::Time::now();
-                if(pubRobotFrame.getNumSubscribers()>0 || pubDownsampled.getNumSubscribers()>0)
-                {
-                    tf_listener->waitForTransform("base_link", "kinect_link", msgFromBag->header.stamp, ros::Duration(0.5));
-                    pcl_ros::transformPointCloud("base_link", *msgFromBag, msgCloudRobot, *tf_listener);
-                }
-                
-                if(pubKinectFrame.getNumSubscribers() > 0)
-                    pubKinectFrame.publish(*msgFromBag);
-                if(pubRobotFrame.getNumSubscribers() > 0)
-                    pubRobotFrame.publish(msgCloudRobot);
-                if(pubDownsampled.getNumSubscribers() > 0)
-                {
-                    downsample_by_3(msgCloudRobot, msgDownsampled);
-                    pubDownsampled.publish(msgDownsampled);
-                }
+                newFrameCaptured(msgFromBag->header.stamp);
+                publishFrame(pubKinectFrame, pubRobotFrame, pubDownsampled);
                 ros::spinOnce();
                 loop.sleep();
             }
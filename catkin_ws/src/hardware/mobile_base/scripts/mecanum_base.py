@@ -9,6 +9,7 @@ from std_msgs.msg import Float32
 from std_msgs.msg import Float32MultiArray
 from geometry_msgs.msg import TransformStamped
 from geometry_msgs.msg import Twist
+from nav_msgs.msg import Odometry
 from hardware_tools import roboclaw
 import tf
 
@@ -92,6 +93,7 @@ def main(port_name_left, port_name_right):
     #ROS CONNECTION
     rospy.init_node("mobile_base");
     pubBattery = rospy.Publisher("mobile_base/base_battery", Float32, queue_size = 1);
+    pubOdometry = rospy.Publisher("mobile_base/odometry", Odometry, queue_size = 1);
     subStop    = rospy.Subscriber("robot_state/stop", Empty, callback_stop, queue_size=1);
     subSpeeds  = rospy.Subscriber("/hardware/mobile_base/speeds",  Float32MultiArray, callback_speeds, queue_size=1);
     subCmdVel  = rospy.Subscriber("/hardware/mobile_base/cmd_vel", Twist, callback_cmd_vel, queue_size=1);
@@ -209,7 +211,17 @@ def main(port_name_left, port_name_right):
             print "Encoders delta: " + str(delta_left_f) + "\t" + str(delta_left_r) + "\t" + str(delta_right_f) + "\t" + str(delta_right_r);
 
         quaternion = tf.transformations.quaternion_from_euler(0, 0, robot_t);
-        br.sendTransform((robot_x, robot_y, 0), quaternion, rospy.Time.now(), "base_link", "odom");
+        stamp = rospy.Time.now();
+        br.sendTransform((robot_x, robot_y, 0), quaternion, stamp, "base_link", "odom");
+        msg_odom = Odometry();
+        msg_odom.header.stamp = stamp;
+        msg_odom.header.frame_id = "odom";
+        msg_odom.child_frame_id = "base_link";
+        msg_odom.pose.pose.position.x = robot_x;
+        msg_odom.pose.pose.position.y = robot_y;
+        msg_odom.pose.pose.orientation.z = quaternion[2];
+        msg_odom.pose.pose.orientation.w = quaternion[3];
+        pubOdometry.publish(msg_odom);
         pubBattery.publish(Float32(rc_left.ReadMainBatteryVoltage(rc_address_left)[1]));
         rate.sleep();
 
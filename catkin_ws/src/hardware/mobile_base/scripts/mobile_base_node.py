@@ -154,6 +154,8 @@ def main(portName, simulated):
         br.sendTransform((robotPos[0], robotPos[1], 0), ts.transform.rotation, rospy.Time.now(), ts.child_frame_id, ts.header.frame_id)
         msgOdom = Odometry()
         msgOdom.header.stamp = rospy.Time.now()
+        msgOdom.header.frame_id = "odom"
+        msgOdom.child_frame_id = "base_link"
         msgOdom.pose.pose.position.x = robotPos[0]
         msgOdom.pose.pose.position.y = robotPos[1]
         msgOdom.pose.pose.position.z = 0
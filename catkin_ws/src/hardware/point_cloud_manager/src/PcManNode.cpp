@@ -5,6 +5,8 @@ PcManNode::PcManNode():
 {
     this->saveCloud = false;
     this->cloudFilePath = "";
+    this->robotFrameReady = false;
+    this->downsampledReady = false;
 }
 
 PcManNode::~PcManNode()
@@ -56,69 +58,143 @@ void PcManNode::spin()
 
 void PcManNode::point_cloud_callback(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &c)
 {           
-    pcl::toROSMsg(*c, this->msgCloudKinect);
-    this->msgCloudKinect.header.frame_id = "kinect_link";
-    if(this->pubKinectFrame.getNumSubscribers() > 0)
+    bool transformed = true;
     {
-        this->pubKinectFrame.publish(this->msgCloudKinect);
-    }
-    if(this->pubRobotFrame.getNumSubscribers() > 0)
-    {
-        tf::StampedTransform transformTf;
-        try{
-            tf_listener.lookupTransform("base_link", "kinect_link", ros::Time(0), transformTf);
-            Eigen::Affine3d transformEigen;
-            tf::transformTFToEigen(transformTf, transformEigen);
-            pcl::transformPointCloud(*c, *this->cloudRobot, transformEigen);
-            pcl::toROSMsg(*this->cloudRobot, this->msgCloudRobot);
-            this->msgCloudRobot.header.frame_id = "base_link";
-            this->pubRobotFrame.publish(this->msgCloudRobot);
+        boost::mutex::scoped_lock lock(this->cloudMutex);
+        this->cloudKinect = c;
+        this->robotFrameReady = false;
+        this->downsampledReady = false;
+        pcl::toROSMsg(*c, this->msgCloudKinect);
+        this->msgCloudKinect.header.frame_id = "kinect_link";
+        if(this->pubKinectFrame.getNumSubscribers() > 0)
+        {
+            this->pubKinectFrame.publish(this->msgCloudKinect);
         }
-        catch (tf::TransformException ex){
-            ROS_ERROR("%s",ex.what());
-            ros::Duration(1.0).sleep();
+        bool robotNeeded = this->pubRobotFrame.getNumSubscribers() > 0;
+        bool downsampledNeeded = this->pubRobotFrameDownsampled.getNumSubscribers() > 0;
+        if(robotNeeded || downsampledNeeded)
+        {
+            transformed = this->transformToRobot(robotNeeded, downsampledNeeded);
+            if(transformed && robotNeeded)
+                this->pubRobotFrame.publish(this->msgCloudRobot);
+            if(transformed && downsampledNeeded)
+                this->pubRobotFrameDownsampled.publish(this->msgCloudRobotDownsampled);
         }
     }
-    if(this->pubRobotFrameDownsampled.getNumSubscribers() > 0)
+    if(!transformed)
+        ros::Duration(1.0).sleep();
+    if(this->saveCloud)
+        pcl::io::savePCDFileBinary(this->cloudFilePath, *c);
+}
+
+bool PcManNode::transformToRobot(bool fullCloud, bool downsampledCloud)
+{
+    //Single pass over the kinect cloud with a single transform lookup. Each point is transformed once and written
+    //in the full robot-frame cloud and, if it is in a row and column multiple of 3, in the downsampled one.
+    //Results are written directly in the message buffers. Must be called with cloudMutex locked.
+    if(!this->cloudKinect)
+        return false;
+    tf::StampedTransform transformTf;
+    try{
+        tf_listener.lookupTransform("base_link", "kinect_link", ros::Time(0), transformTf);
+    }
+    catch (tf::TransformException ex){
+        ROS_ERROR("%s",ex.what());
+        return false;
+    }
+    Eigen::Affine3d transformEigen;
+    tf::transformTFToEigen(transformTf, transformEigen);
+    Eigen::Matrix4f m = transformEigen.matrix().cast<float>();
+
+    const pcl::PointCloud<pcl::PointXYZRGBA>& c = *this->cloudKinect;
+    int width = c.width;
+    int height = c.height;
+    int downWidth = width/3;
+    int downHeight = height/3;
+    fullCloud = fullCloud && !this->robotFrameReady;
+    downsampledCloud = downsampledCloud && !this->downsampledReady;
+    if(fullCloud && !this->prepareMessage(this->msgCloudRobot, width, height))
+        return false;
+    if(downsampledCloud && !this->prepareMessage(this->msgCloudRobotDownsampled, downWidth, downHeight))
+        return false;
+    pcl::PointXYZRGBA* full = fullCloud ? (pcl::PointXYZRGBA*)&this->msgCloudRobot.data[0] : 0;
+    pcl::PointXYZRGBA* down = downsampledCloud && downWidth > 0 && downHeight > 0 ?
+        (pcl::PointXYZRGBA*)&this->msgCloudRobotDownsampled.data[0] : 0;
+
+    //If only the downsampled cloud is needed, only one of each three rows and columns is visited
+    int step = fullCloud ? 1 : 3;
+    for(int j=0; j < height; j += step)
     {
-        try{
-            pcl::PointCloud<pcl::PointXYZRGBA> downsampled;
-            sensor_msgs::PointCloud2 msgDownsampled;
-            downsampled.width = c->width/3;
-            downsampled.height = c->height/3;
-            downsampled.is_dense = c->is_dense;
-            downsampled.points.resize(downsampled.width*downsampled.height);
-            for(int i=0; i < downsampled.width; i++)
-                for(int j=0; j < downsampled.height; j++)
-    	      downsampled.points[j*downsampled.width + i] = c->points[3*(j*c->width + i)];
-            tf::StampedTransform transformTf;
-            tf_listener.lookupTransform("base_link", "kinect_link", ros::Time(0), transformTf);
-            Eigen::Affine3d transformEigen;
-            tf::transformTFToEigen(transformTf, transformEigen);
-            pcl::transformPointCloud(downsampled, downsampled, transformEigen);
-            pcl::toROSMsg(downsampled, msgDownsampled);
-            msgDownsampled.header.frame_id = "base_link";
-            this->pubRobotFrameDownsampled.publish(msgDownsampled);
-        }
-        catch (tf::TransformException ex){
-            ROS_ERROR("%s",ex.what());
-            ros::Duration(1.0).sleep();
+        bool downRow = down != 0 && j % 3 == 0 && j/3 < downHeight;
+        if(!fullCloud && !downRow)
+            break;
+        const pcl::PointXYZRGBA* in = &c.points[j*width];
+        for(int i=0; i < width; i += step)
+        {
+            pcl::PointXYZRGBA p = in[i];
+            if(pcl_isfinite(p.x)) //Invalid points are copied as they are
+            {
+                float x = p.x, y = p.y, z = p.z;
+                p.x = m(0,0)*x + m(0,1)*y + m(0,2)*z + m(0,3);
+                p.y = m(1,0)*x + m(1,1)*y + m(1,2)*z + m(1,3);
+                p.z = m(2,0)*x + m(2,1)*y + m(2,2)*z + m(2,3);
+            }
+            if(fullCloud)
+                full[j*width + i] = p;
+            if(downRow && i % 3 == 0 && i/3 < downWidth)
+                down[(j/3)*downWidth + i/3] = p;
         }
     }
-    if(this->saveCloud)
-        pcl::io::savePCDFileBinary(this->cloudFilePath, *c);
+    if(fullCloud)
+    {
+        this->msgCloudRobot.header.stamp = this->msgCloudKinect.header.stamp;
+        this->msgCloudRobot.is_dense = c.is_dense;
+        this->robotFrameReady = true;
+    }
+    if(downsampledCloud)
+    {
+        this->msgCloudRobotDownsampled.header.stamp = this->msgCloudKinect.header.stamp;
+        this->msgCloudRobotDownsampled.is_dense = c.is_dense;
+        this->downsampledReady = true;
+    }
+    return true;
+}
+
+bool PcManNode::prepareMessage(sensor_msgs::PointCloud2& msg, int width, int height)
+{
+    //Fields and buffer are created only the first time or when the size changes.
+    if(msg.width != width || msg.height != height || msg.fields.empty())
+    {
+        pcl::PointCloud<pcl::PointXYZRGBA> layout;
+        layout.width = width;
+        layout.height = height;
+        layout.points.resize(width*height);
+        pcl::toROSMsg(layout, msg);
+        msg.header.frame_id = "base_link";
+    }
+    if(msg.point_step != sizeof(pcl::PointXYZRGBA) || msg.data.size() != (size_t)width*height*sizeof(pcl::PointXYZRGBA))
+    {
+        std::cout << "PointCloudMan.->Cannot transform cloud: unexpected point layout." << std::endl;
+        return false;
+    }
+    return true;
 }
 
 bool PcManNode::kinectRgbd_callback(point_cloud_manager::GetRgbd::Request &req, point_cloud_manager::GetRgbd::Response &resp)
 {
+    boost::mutex::scoped_lock lock(this->cloudMutex);
     resp.point_cloud = this->msgCloudKinect;
+    return true;
 }
 
 bool PcManNode::robotRgbd_callback(point_cloud_manager::GetRgbd::Request &req, point_cloud_manager::GetRgbd::Response &resp)
 {
-    pcl_ros::transformPointCloud("base_link", this->msgCloudKinect, this->msgCloudRobot, tf_listener);
-    this->msgCloudRobot.header.frame_id = "base_link";
+    //Last frame is transformed only if it has not been transformed yet for the robot-frame topic
+    boost::mutex::scoped_lock lock(this->cloudMutex);
+    if(!this->robotFrameReady && !this->transformToRobot(true, false))
+        return false;
     resp.point_cloud = this->msgCloudRobot;
+    return true;
 }
 
 void PcManNode::callback_save_cloud(const std_msgs::String::ConstPtr& msg)
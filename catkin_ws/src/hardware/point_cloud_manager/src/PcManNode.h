@@ -9,6 +9,7 @@
 #include <pcl/visualization/cloud_viewer.h>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/filesystem/path.hpp>
+#include <boost/thread/mutex.hpp>
 #include "ros/ros.h"
 #include "std_msgs/Empty.h"
 #include "std_msgs/String.h"
@@ -40,7 +41,11 @@ private:
     ros::ServiceServer srvRgbdKinect;
     ros::ServiceServer srvRgbdRobot;
     sensor_msgs::PointCloud2 msgCloudKinect;
-    sensor_msgs::PointCloud2 msgCloudRobot;
+    sensor_msgs::PointCloud2 msgCloudRobot;            //Buffers are reused between frames, they are resized only
+    sensor_msgs::PointCloud2 msgCloudRobotDownsampled; //when the kinect resolution changes
+    bool robotFrameReady;        //True if msgCloudRobot corresponds to the last kinect frame
+    bool downsampledReady;       //True if msgCloudRobotDownsampled corresponds to the last kinect frame
+    boost::mutex cloudMutex;     //Grabber callback and service callbacks run in different threads
 
     std::string default_path;
     pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr cloudKinect;
@@ -49,6 +54,8 @@ private:
     std::string cloudFilePath;
     //pcl::visualization::CloudViewer viewer;
 
+    bool transformToRobot(bool fullCloud, bool downsampledCloud);
+    bool prepareMessage(sensor_msgs::PointCloud2& msg, int width, int height);
     void point_cloud_callback(const pcl::PointCloud<pcl::PointXYZRGBA>::ConstPtr &cloud);
     void callback_save_cloud(const std_msgs::String::ConstPtr& msg);
     void callback_stop_saving_cloud(const std_msgs::Empty::ConstPtr& msg);
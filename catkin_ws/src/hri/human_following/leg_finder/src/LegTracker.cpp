@@ -0,0 +1,245 @@
+#include "LegTracker.h"
+#include <algorithm>
+
+#define NOT_ASSIGNABLE 1e6
+
+LegTracker::LegTracker()
+{
+    this->accelerationNoise = 1.5;
+    this->measurementNoise = 0.05;
+    this->gateDistance = 9.21;      //Chi square with 2 DOF, 99%
+    this->maxGateRadius = 0.6;
+    this->newTrackDistance = 0.3;
+    this->hitsToConfirm = 3;
+    this->missesToDeleteTentative = 2;
+    this->missesToDeleteConfirmed = 20;
+    this->nextId = 0;
+}
+
+LegTracker::~LegTracker()
+{
+}
+
+void LegTracker::Reset()
+{
+    this->tracks.clear();
+}
+
+std::vector<LegTrack>& LegTracker::GetTracks()
+{
+    return this->tracks;
+}
+
+LegTrack* LegTracker::GetTrack(int id)
+{
+    for(size_t i=0; i < this->tracks.size(); i++)
+        if(this->tracks[i].id == id)
+            return &this->tracks[i];
+    return NULL;
+}
+
+void LegTracker::Update(std::vector<float>& legs_x, std::vector<float>& legs_y, float dt)
+{
+    int noTracks = this->tracks.size();
+    int noHyp = legs_x.size();
+    for(int i=0; i < noTracks; i++)
+        this->predict(this->tracks[i], dt);
+
+    //Cost matrix: one row per track, one column per hypothesis plus one "not detected" column per track,
+    //whose cost is the gate. Pairs out of the gate cannot be assigned.
+    int cols = noHyp + noTracks;
+    this->costs.assign(noTracks * cols, NOT_ASSIGNABLE);
+    float maxRadius2 = this->maxGateRadius * this->maxGateRadius;
+    for(int i=0; i < noTracks; i++)
+    {
+        LegTrack& track = this->tracks[i];
+        for(int j=0; j < noHyp; j++)
+        {
+            float dx = legs_x[j] - track.x;
+            float dy = legs_y[j] - track.y;
+            if(dx*dx + dy*dy > maxRadius2)
+                continue;
+            float d2 = this->mahalanobis(track, legs_x[j], legs_y[j]);
+            if(d2 < this->gateDistance)
+                this->costs[i*cols + j] = d2;
+        }
+        this->costs[i*cols + noHyp + i] = this->gateDistance;
+    }
+    if(noTracks > 0)
+        this->solveAssignment(noTracks, cols);
+
+    this->hypAssigned.assign(noHyp, false);
+    for(int i=0; i < noTracks; i++)
+    {
+        LegTrack& track = this->tracks[i];
+        int j = this->assignment[i];
+        if(j < noHyp && this->costs[i*cols + j] < NOT_ASSIGNABLE)
+        {
+            this->correct(track, legs_x[j], legs_y[j]);
+            this->hypAssigned[j] = true;
+            track.hits++;
+            track.misses = 0;
+            if(track.hits >= this->hitsToConfirm)
+                track.confirmed = true;
+        }
+        else
+            track.misses++;
+    }
+
+    //Deletion of lost tracks, keeping the order of the rest
+    int kept = 0;
+    for(int i=0; i < noTracks; i++)
+    {
+        LegTrack& track = this->tracks[i];
+        if(track.misses > (track.confirmed ? this->missesToDeleteConfirmed : this->missesToDeleteTentative))
+            continue;
+        this->tracks[kept++] = track;
+    }
+    this->tracks.resize(kept);
+
+    //New tracks from the hypothesis not explained by any track
+    float newDist2 = this->newTrackDistance * this->newTrackDistance;
+    float r2 = this->measurementNoise * this->measurementNoise;
+    for(int j=0; j < noHyp; j++)
+    {
+        if(this->hypAssigned[j])
+            continue;
+        bool nearTrack = false;
+        for(size_t i=0; i < this->tracks.size() && !nearTrack; i++)
+        {
+            float dx = legs_x[j] - this->tracks[i].x;
+            float dy = legs_y[j] - this->tracks[i].y;
+            nearTrack = dx*dx + dy*dy < newDist2;
+        }
+        if(nearTrack)
+            continue;
+        LegTrack track;
+        track.id = this->nextId++;
+        track.x = legs_x[j];
+        track.y = legs_y[j];
+        track.vx = 0;
+        track.vy = 0;
+        //Initial velocity is unknown: walking speeds are within a couple of m/s
+        track.pxx = r2;   track.pxv = 0;   track.pvv = 1.0;
+        track.pyy = r2;   track.pyv = 0;   track.pww = 1.0;
+        track.hits = 1;
+        track.misses = 0;
+        track.inFrontCount = 0;
+        track.confirmed = this->hitsToConfirm <= 1;
+        this->tracks.push_back(track);
+    }
+}
+
+void LegTracker::predict(LegTrack& track, float dt)
+{
+    //x' = x + v*dt, P' = F*P*F^T + Q with Q of a white noise acceleration
+    float q = this->accelerationNoise * this->accelerationNoise;
+    float dt2 = dt*dt;
+    float q11 = q * dt2*dt2 / 4;
+    float q12 = q * dt2*dt / 2;
+    float q22 = q * dt2;
+
+    track.x += track.vx * dt;
+    track.y += track.vy * dt;
+    track.pxx += dt*(2*track.pxv + dt*track.pvv) + q11;
+    track.pxv += dt*track.pvv + q12;
+    track.pvv += q22;
+    track.pyy += dt*(2*track.pyv + dt*track.pww) + q11;
+    track.pyv += dt*track.pww + q12;
+    track.pww += q22;
+}
+
+void LegTracker::correct(LegTrack& track, float z_x, float z_y)
+{
+    float r2 = this->measurementNoise * this->measurementNoise;
+
+    float s = track.pxx + r2;
+    float k0 = track.pxx / s;
+    float k1 = track.pxv / s;
+    float innovation = z_x - track.x;
+    track.x  += k0 * innovation;
+    track.vx += k1 * innovation;
+    track.pvv -= k1 * track.pxv;
+    track.pxv *= 1 - k0;
+    track.pxx *= 1 - k0;
+
+    s = track.pyy + r2;
+    k0 = track.pyy / s;
+    k1 = track.pyv / s;
+    innovation = z_y - track.y;
+    track.y  += k0 * innovation;
+    track.vy += k1 * innovation;
+    track.pww -= k1 * track.pyv;
+    track.pyv *= 1 - k0;
+    track.pyy *= 1 - k0;
+}
+
+float LegTracker::mahalanobis(LegTrack& track, float z_x, float z_y)
+{
+    float r2 = this->measurementNoise * this->measurementNoise;
+    float dx = z_x - track.x;
+    float dy = z_y - track.y;
+    return dx*dx / (track.pxx + r2) + dy*dy / (track.pyy + r2);
+}
+
+//Hungarian method (shortest augmenting paths with potentials) for a rows x cols matrix with rows <= cols.
+//assignment[i] is the column assigned to row i.
+void LegTracker::solveAssignment(int rows, int cols)
+{
+    std::vector<double> u(rows + 1, 0), v(cols + 1, 0), minv(cols + 1);
+    std::vector<int> p(cols + 1, 0), way(cols + 1, 0);
+    std::vector<bool> used(cols + 1);
+    for(int i=1; i <= rows; i++)
+    {
+        p[0] = i;
+        int j0 = 0;
+        std::fill(minv.begin(), minv.end(), 1e18);
+        std::fill(used.begin(), used.end(), false);
+        do
+        {
+            used[j0] = true;
+            int i0 = p[j0];
+            int j1 = 0;
+            double delta = 1e18;
+            for(int j=1; j <= cols; j++)
+            {
+                if(used[j])
+                    continue;
+                double cur = this->costs[(i0 - 1)*cols + j - 1] - u[i0] - v[j];
+                if(cur < minv[j])
+                {
+                    minv[j] = cur;
+                    way[j] = j0;
+                }
+                if(minv[j] < delta)
+                {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+            for(int j=0; j <= cols; j++)
+            {
+                if(used[j])
+                {
+                    u[p[j]] += delta;
+                    v[j] -= delta;
+                }
+                else
+                    minv[j] -= delta;
+            }
+            j0 = j1;
+        }
+        while(p[j0] != 0);
+        do
+        {
+            int j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        }
+        while(j0 != 0);
+    }
+    this->assignment.assign(rows, -1);
+    for(int j=1; j <= cols; j++)
+        if(p[j] != 0)
+            this->assignment[p[j] - 1] = j - 1;
+}
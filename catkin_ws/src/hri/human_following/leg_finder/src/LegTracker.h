@@ -0,0 +1,56 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+//Multi-target tracker of leg hypothesis (positions wrt robot).
+//Every track is a constant velocity Kalman filter. Since the motion model and the measurement noise are the same
+//and independent for x and y, each axis is filtered separately with a 2x2 covariance (position, velocity).
+//Hypothesis are associated to tracks by global nearest neighbor: the assignment that minimizes the sum of
+//squared Mahalanobis distances (Hungarian method), only among pairs inside the gate. Hypothesis not assigned
+//and far from every track start new tracks. Tracks are confirmed after some consecutive hits and deleted after
+//some consecutive misses.
+class LegTrack
+{
+public:
+    int id;
+    float x, y, vx, vy;
+    float pxx, pxv, pvv;     //Covariance of the x axis
+    float pyy, pyv, pww;     //Covariance of the y axis
+    int hits;                //Total of associated scans
+    int misses;              //Consecutive scans without association
+    int inFrontCount;        //Consecutive scans in front of the robot, updated by the user of the tracker
+    bool confirmed;
+};
+
+class LegTracker
+{
+public:
+    LegTracker();
+    ~LegTracker();
+
+    float accelerationNoise;    //Std dev of the acceleration [m/s^2]
+    float measurementNoise;     //Std dev of the hypothesis position [m]
+    float gateDistance;         //Squared Mahalanobis distance of the gate
+    float maxGateRadius;        //Max euclidean distance between a track and its hypothesis [m]
+    float newTrackDistance;     //Unassigned hypothesis nearer than this to a track do not start new tracks [m]
+    int hitsToConfirm;
+    int missesToDeleteTentative;
+    int missesToDeleteConfirmed;
+
+    void Update(std::vector<float>& legs_x, std::vector<float>& legs_y, float dt);
+    void Reset();
+    std::vector<LegTrack>& GetTracks();
+    LegTrack* GetTrack(int id);
+
+private:
+    std::vector<LegTrack> tracks;
+    int nextId;
+    std::vector<float> costs;
+    std::vector<int> assignment;
+    std::vector<bool> hypAssigned;
+
+    void predict(LegTrack& track, float dt);
+    void correct(LegTrack& track, float z_x, float z_y);
+    float mahalanobis(LegTrack& track, float z_x, float z_y);
+    void solveAssignment(int rows, int cols);
+};
@@ -6,22 +6,60 @@
 #include <string.h>
 #include "ros/ros.h"
 #include "std_msgs/Float32MultiArray.h"
-#include "fft.h"
+#include "boost/atomic.hpp"
+#include "real_fft.h"
 
-#define NFRAMES 1024
+#define NFRAMES 1024                //Size of the Hann windows
+#define HOP_FRAMES (NFRAMES / 2)    //Windows overlap by half
+#define NBINS (NFRAMES / 2 + 1)     //Bins of the spectrum of a real window
 
 jack_port_t* input_port;
 jack_port_t* output_portL;
 jack_port_t* output_portR;
 jack_client_t* client;
 
-jack_default_audio_sample_t* last_window;
-jack_default_audio_sample_t* inter_window;
+jack_default_audio_sample_t* last_window;   //Last NFRAMES input samples
+jack_default_audio_sample_t* overlap;       //Second half of the last filtered window
 float* hann_window_values;
-float* equalizing_coeff;
-complex* last_freq;
-complex* inter_freq;
-complex* current_freq;
+float* filtered_window;
+complex* window_freq;
+RealFFT* fft;
+
+//Equalizing coefficients are double buffered. The ROS thread writes the new gains in pending_coeff
+//and sets pending_ready. The audio thread only reads active_coeff, and swaps both buffers at the
+//beginning of a period when pending_ready is set. Nothing is locked in the audio thread.
+float* active_coeff;
+float* pending_coeff;
+boost::atomic<bool> pending_ready(false);
+float band_gains[10];
+bool band_gains_changed = false;
+
+//Filters a hop of HOP_FRAMES samples: only one forward and one inverse transform per hop.
+//The output is the overlap-add of the current filtered window and the previous one.
+void process_hop(const jack_default_audio_sample_t* in, jack_default_audio_sample_t* out)
+{
+    memmove(last_window, last_window + HOP_FRAMES, HOP_FRAMES * sizeof(jack_default_audio_sample_t));
+    memcpy(last_window + HOP_FRAMES, in, HOP_FRAMES * sizeof(jack_default_audio_sample_t));
+
+    //We apply the Hann equation before transforming
+    for(int i=0; i < NFRAMES; i++)
+        filtered_window[i] = last_window[i] * hann_window_values[i];
+
+    fft->Forward(filtered_window, window_freq);
+
+    //This is the actual equalizer
+    for(int i=0; i < NBINS; i++)
+        window_freq[i] *= active_coeff[i];
+
+    fft->Inverse(window_freq, filtered_window);
+
+    //Overlaping of Hann-smoothed windows
+    for(int i=0; i < HOP_FRAMES; i++)
+    {
+        out[i] = overlap[i] + filtered_window[i];
+        overlap[i] = filtered_window[i + HOP_FRAMES];
+    }
+}
 
 int jack_callback (jack_nframes_t nframes, void *arg)
 {
@@ -31,48 +69,28 @@ int jack_callback (jack_nframes_t nframes, void *arg)
     outL = jack_port_get_buffer (output_portL, nframes);
     outR = jack_port_get_buffer (output_portR, nframes);
 
-    //We apply the Hann equation before transforming
-    for(int i=0; i < nframes; i++)
-    {
-        last_freq[i]    = last_window[i] * hann_window_values[i];
-        current_freq[i] = in[i] * hann_window_values[i];
-    }
-    int half_frames = NFRAMES / 2;
-    for(int i=0; i < half_frames; i++)
+    if(pending_ready.load(boost::memory_order_acquire))
     {
-        inter_freq[i] = last_window[i+half_frames] * hann_window_values[i];
-        inter_freq[i+half_frames] = in[i] * hann_window_values[i+half_frames];
+        float* temp = active_coeff;
+        active_coeff = pending_coeff;
+        pending_coeff = temp;
+        pending_ready.store(false, boost::memory_order_release);
     }
 
-    //Apply fft to the three windows
-    if(!CFFT::Forward(last_freq, nframes) || !CFFT::Forward(inter_freq, nframes) || !CFFT::Forward(current_freq, nframes))
-        std::cout << "FFT test node.->Cannot perform fast fourier transform :'(" << std::endl;
-
-    //This is the actual equalizer. We apply the filter to all windows
-    for(int i=0; i < nframes; i++)
+    //Period size is checked at startup. If the server changes it to a not supported one, audio is not equalized.
+    if(nframes % HOP_FRAMES != 0)
     {
-        last_freq[i] *= equalizing_coeff[i];
-        inter_freq[i] *= equalizing_coeff[i];
-        current_freq[i] *= equalizing_coeff[i];
+        memcpy (outR, in, nframes * sizeof (jack_default_audio_sample_t));
+        memcpy (outL, in, nframes * sizeof (jack_default_audio_sample_t));
+        return 0;
     }
 
-    //Inverse transform
-    if(!CFFT::Inverse(last_freq, nframes) || !CFFT::Inverse(inter_freq, nframes) || !CFFT::Inverse(current_freq, nframes))
-        std::cout << "FFT test node.->Cannot perform inverse fast fourier transform :'(" << std::endl;
+    for(int i=0; i < nframes; i += HOP_FRAMES)
+        process_hop(in + i, outR + i);
 
     //In the left speaker we put the original signal
     //memcpy (outL, in, nframes * sizeof (jack_default_audio_sample_t));
-
-    //Overlaping of Hann-smoothed windows
-    for(int i=0; i < half_frames; i++)
-    {
-        outR[i] = inter_freq[i].re() + last_freq[i+half_frames].re();
-        outR[i+half_frames] = inter_freq[i + half_frames].re() + current_freq[i].re();
-    }
     memcpy (outL, outR, nframes * sizeof (jack_default_audio_sample_t));
-
-    //The current window is now the last window
-    memcpy (last_window, in, nframes * sizeof (jack_default_audio_sample_t));
     
     return 0;
 }
@@ -82,6 +100,35 @@ void jack_shutdown (void *arg)
 	exit (1);
 }
 
+//Writes the last received gains in the pending coefficients. If the audio thread has not taken
+//the previous ones yet, it is tried again in the next iteration of the main loop.
+void publish_equalizer_gains()
+{
+    if(!band_gains_changed || pending_ready.load(boost::memory_order_acquire))
+        return;
+
+    pending_coeff[0] = band_gains[0];   //Banda de los 31.25
+    pending_coeff[1] = band_gains[1];   //Banda de los 62.5
+    pending_coeff[2] = band_gains[2];   //Banda de los 125
+    for(int i=3; i < 7; i++)            //Banda de los 250
+        pending_coeff[i] = band_gains[3];
+    for(int i=7; i < 15; i++)           //Banda de los 512 Hz
+        pending_coeff[i] = band_gains[4];
+    for(int i=15; i < 31; i++)          //Banda de los 1024 Hz
+        pending_coeff[i] = band_gains[5];
+    for(int i=31; i < 62; i++)          //Banda de los 2048 Hz
+        pending_coeff[i] = band_gains[6];
+    for(int i=62; i < 124; i++)         //Banda de los 4096 Hz
+        pending_coeff[i] = band_gains[7];
+    for(int i=124; i < 247; i++)        //Banda de los 8192 Hz
+        pending_coeff[i] = band_gains[8];
+    for(int i=247; i < NBINS; i++)      //Banda de los 16384 Hz
+        pending_coeff[i] = band_gains[9];
+
+    pending_ready.store(true, boost::memory_order_release);
+    band_gains_changed = false;
+}
+
 void callback_equalizer(const std_msgs::Float32MultiArray::ConstPtr& msg)
 {
     printf("Equalizer.->Gains: ");
@@ -89,26 +136,15 @@ void callback_equalizer(const std_msgs::Float32MultiArray::ConstPtr& msg)
         printf("%0.3f  ", msg->data[i]);
     std::cout << std::endl;
 
-    equalizing_coeff[0] = msg->data[0];   //Banda de los 31.25
-    equalizing_coeff[1] = msg->data[1];   //Banda de los 62.5
-    equalizing_coeff[2] = msg->data[2];   //Banda de los 125
-    for(int i=3; i < 7; i++)              //Banda de los 250
-        equalizing_coeff[i] = msg->data[3];
-    for(int i=7; i < 15; i++)             //Banda de los 512 Hz
-        equalizing_coeff[i] = msg->data[4];
-    for(int i=15; i < 31; i++)            //Banda de los 1024 Hz
-        equalizing_coeff[i] = msg->data[5];
-    for(int i=31; i < 62; i++)            //Banda de los 2048 Hz
-        equalizing_coeff[i] = msg->data[6];
-    for(int i=62; i < 124; i++)           //Banda de los 4096 Hz
-        equalizing_coeff[i] = msg->data[7];
-    for(int i=124; i < 247; i++)          //Banda de los 8192 Hz
-        equalizing_coeff[i] = msg->data[8];
-    for(int i=247; i < 512; i++)          //Banda de los 16384 Hz
-        equalizing_coeff[i] = msg->data[9];
-
-    for(int i=0; i < 512; i++)
-        equalizing_coeff[NFRAMES - i - 1] = equalizing_coeff[i];
+    if(msg->data.size() < 10)
+    {
+        std::cout << "Equalizer.->Ten gains are required. Gains are not changed." << std::endl;
+        return;
+    }
+    for(int i=0; i < 10; i++)
+        band_gains[i] = msg->data[i];
+    band_gains_changed = true;
+    publish_equalizer_gains();
 }
 
 int main (int argc, char *argv[])
@@ -123,23 +159,28 @@ int main (int argc, char *argv[])
 	jack_options_t options = JackNoStartServer;
 	jack_status_t status;
 
-    last_window  = (jack_default_audio_sample_t*)malloc(NFRAMES*sizeof(jack_default_audio_sample_t));
-    inter_window = (jack_default_audio_sample_t*)malloc(NFRAMES*sizeof(jack_default_audio_sample_t));
+    last_window = (jack_default_audio_sample_t*)malloc(NFRAMES*sizeof(jack_default_audio_sample_t));
+    overlap     = (jack_default_audio_sample_t*)malloc(HOP_FRAMES*sizeof(jack_default_audio_sample_t));
     hann_window_values = (float*)malloc(NFRAMES*sizeof(float));
-    equalizing_coeff = (float*)malloc(NFRAMES*sizeof(float));
-    last_freq    = new complex[NFRAMES];
-    inter_freq   = new complex[NFRAMES];
-    current_freq = new complex[NFRAMES];
+    filtered_window = (float*)malloc(NFRAMES*sizeof(float));
+    active_coeff  = (float*)malloc(NBINS*sizeof(float));
+    pending_coeff = (float*)malloc(NBINS*sizeof(float));
+    window_freq = new complex[NBINS];
+    fft = new RealFFT(NFRAMES);
     
     for(int i=0; i < NFRAMES; i++)
     {
         last_window[i] = 0;
-        inter_window[i] = 0;
-        last_freq[i] = 0;
-        inter_freq[i] = 0; 
-        current_freq[i] = 0;
+        filtered_window[i] = 0;
         hann_window_values[i] = 0.5*(1 - cos(2*M_PI*i/(NFRAMES-1)));
-        equalizing_coeff[i] = 1.0;
+    }
+    for(int i=0; i < HOP_FRAMES; i++)
+        overlap[i] = 0;
+    for(int i=0; i < NBINS; i++)
+    {
+        window_freq[i] = 0;
+        active_coeff[i] = 1.0;
+        pending_coeff[i] = 1.0;
     }
 
     client = jack_client_open (client_name, options, &status);
@@ -157,6 +198,9 @@ int main (int argc, char *argv[])
         std::cout << "Warning: other agent with the same name is running, " << client_name << " has been assigned to us." << std::endl;
 	}
 	
+    if(jack_get_buffer_size(client) % HOP_FRAMES != 0)
+        std::cout << "Warning: period size must be a multiple of " << HOP_FRAMES << " frames, audio will not be equalized." << std::endl;
+	
 	jack_set_process_callback (client, jack_callback, 0);
 	jack_on_shutdown (client, jack_shutdown, 0);
 
@@ -216,18 +260,20 @@ int main (int argc, char *argv[])
 	while(ros::ok())
     {
         ros::spinOnce();
+        publish_equalizer_gains();
         loop.sleep();
     }
 	
 	jack_client_close (client);
     std::cout << "Releasing buffer memory..." << std::endl;
     free(last_window);
-    free(inter_window);
+    free(overlap);
     free(hann_window_values);
-    free(equalizing_coeff);
-    delete last_freq;   
-    delete inter_freq;  
-    delete current_freq;
+    free(filtered_window);
+    free(active_coeff);
+    free(pending_coeff);
+    delete[] window_freq;
+    delete fft;
 	exit (0);
 }
 
@@ -0,0 +1,118 @@
+//   real_fft.cpp - fast Fourier transform of real signals
+
+#include "real_fft.h"
+#include <math.h>
+
+RealFFT::RealFFT(const unsigned int N)
+{
+    this->N = IsValidSize(N) ? N : 4;
+    this->M = this->N / 2;
+    this->bitReverse   = new unsigned int[this->M];
+    this->twiddles     = new complex[this->M / 2];
+    this->postTwiddles = new complex[this->M];
+    this->work         = new complex[this->M];
+
+    unsigned int bits = 0;
+    while((1u << bits) < this->M)
+        bits++;
+    for(unsigned int i = 0; i < this->M; i++)
+    {
+        unsigned int reversed = 0;
+        for(unsigned int b = 0; b < bits; b++)
+            if(i & (1u << b))
+                reversed |= 1u << (bits - 1 - b);
+        this->bitReverse[i] = reversed;
+    }
+    for(unsigned int k = 0; k < this->M / 2; k++)
+        this->twiddles[k] = complex(cos(2*M_PI*k/this->M), -sin(2*M_PI*k/this->M));
+    for(unsigned int k = 0; k < this->M; k++)
+        this->postTwiddles[k] = complex(cos(2*M_PI*k/this->N), -sin(2*M_PI*k/this->N));
+}
+
+RealFFT::~RealFFT()
+{
+    delete[] this->bitReverse;
+    delete[] this->twiddles;
+    delete[] this->postTwiddles;
+    delete[] this->work;
+}
+
+bool RealFFT::IsValidSize(const unsigned int N)
+{
+    return N >= 4 && !(N & (N - 1));
+}
+
+void RealFFT::Forward(const float *const Input, complex *const Output)
+{
+    //   Even samples as real part and odd samples as imaginary part
+    for(unsigned int n = 0; n < this->M; n++)
+        this->work[n] = complex(Input[2*n], Input[2*n + 1]);
+    Transform(this->work, false);
+
+    //   Z[k] = E[k] + i*O[k], where E and O are the spectrums of even and odd samples,
+    //   and X[k] = E[k] + exp(-2*pi*i*k/N)*O[k]
+    const complex halfMinusI(0, -0.5);
+    Output[0]       = complex(this->work[0].re() + this->work[0].im(), 0);
+    Output[this->M] = complex(this->work[0].re() - this->work[0].im(), 0);
+    for(unsigned int k = 1; k < this->M; k++)
+    {
+        const complex z  = this->work[k];
+        const complex zc = this->work[this->M - k].conjugate();
+        const complex even = (z + zc) * 0.5;
+        const complex odd  = (z - zc) * halfMinusI;
+        Output[k] = even + this->postTwiddles[k] * odd;
+    }
+}
+
+void RealFFT::Inverse(const complex *const Input, float *const Output)
+{
+    //   Inverse of the separation done by Forward
+    const complex imaginary(0, 1);
+    for(unsigned int k = 0; k < this->M; k++)
+    {
+        const complex x  = Input[k];
+        const complex xc = Input[this->M - k].conjugate();
+        const complex even = (x + xc) * 0.5;
+        const complex odd  = (x - xc) * 0.5 * this->postTwiddles[k].conjugate();
+        this->work[k] = even + imaginary * odd;
+    }
+    Transform(this->work, true);
+
+    const double scale = 1.0 / this->M;
+    for(unsigned int n = 0; n < this->M; n++)
+    {
+        Output[2*n]     = this->work[n].re() * scale;
+        Output[2*n + 1] = this->work[n].im() * scale;
+    }
+}
+
+//   Iterative radix-2 FFT of M points with precomputed twiddle factors. Inverse is not scaled.
+void RealFFT::Transform(complex *const Data, const bool Inverse)
+{
+    for(unsigned int i = 0; i < this->M; i++)
+    {
+        const unsigned int j = this->bitReverse[i];
+        if(j > i)
+        {
+            const complex temp(Data[i]);
+            Data[i] = Data[j];
+            Data[j] = temp;
+        }
+    }
+
+    for(unsigned int size = 2; size <= this->M; size <<= 1)
+    {
+        const unsigned int half = size >> 1;
+        const unsigned int step = this->M / size;
+        for(unsigned int start = 0; start < this->M; start += size)
+        {
+            for(unsigned int k = 0; k < half; k++)
+            {
+                const complex w = Inverse ? this->twiddles[k*step].conjugate() : this->twiddles[k*step];
+                const complex product(w * Data[start + k + half]);
+                Data[start + k + half] = Data[start + k] - product;
+                Data[start + k] += product;
+            }
+        }
+    }
+}
@@ -0,0 +1,50 @@
+//   real_fft.h - fast Fourier transform of real signals
+//
+//   A real signal of N samples is transformed with a complex FFT of N/2 points:
+//   even samples are taken as the real part and odd samples as the imaginary part,
+//   and both half spectrums are separated afterwards (twiddle post-processing).
+//   All tables and buffers are allocated by the constructor, thus Forward and Inverse
+//   do not allocate memory and can be called from a realtime thread.
+
+#ifndef _REAL_FFT_H_
+#define _REAL_FFT_H_
+
+#include "complex.h"
+
+class RealFFT
+{
+public:
+    //   N must be a power of two, at least 4
+    RealFFT(const unsigned int N);
+    ~RealFFT();
+
+    unsigned int Size() const { return N; }
+    unsigned int Bins() const { return N / 2 + 1; }
+
+    //   FORWARD FOURIER TRANSFORM
+    //     Input  - N real samples
+    //     Output - N/2 + 1 bins (bins above N/2 are the conjugates of these ones)
+    void Forward(const float *const Input, complex *const Output);
+
+    //   INVERSE FOURIER TRANSFORM
+    //     Input  - N/2 + 1 bins
+    //     Output - N real samples, scaled by 1/N
+    void Inverse(const complex *const Input, float *const Output);
+
+    static bool IsValidSize(const unsigned int N);
+
+private:
+    unsigned int N;
+    unsigned int M;                 //   Size of the complex FFT, N/2
+    unsigned int* bitReverse;       //   Bit reversed permutation of M points
+    complex* twiddles;              //   exp(-2*pi*i*k/M), k < M/2
+    complex* postTwiddles;          //   exp(-2*pi*i*k/N), k < M
+    complex* work;
+
+    void Transform(complex *const Data, const bool Inverse);
+
+    RealFFT(const RealFFT&);
+    RealFFT& operator= (const RealFFT&);
+};
+
+#endif
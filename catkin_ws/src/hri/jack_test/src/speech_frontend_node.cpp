@@ -0,0 +1,328 @@
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <jack/jack.h>
+#include <jack/ringbuffer.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ros/ros.h"
+#include "std_msgs/Bool.h"
+#include "std_msgs/Empty.h"
+#include "std_msgs/Float32MultiArray.h"
+#include "real_fft.h"
+
+#define FRAME_SIZE 1024                 //Samples per analysis frame
+#define HOP_SIZE (FRAME_SIZE / 2)       //Frames overlap by half
+#define NBINS (FRAME_SIZE / 2 + 1)
+#define NUM_MEL_BANDS 26
+#define MEL_MIN_FREQ 64.0
+#define MEL_MAX_FREQ 8000.0
+#define RINGBUFFER_SECONDS 2
+
+jack_port_t* input_port;
+jack_client_t* client;
+//Audio thread only copies samples into the ring buffer. Features are computed in the main thread.
+jack_ringbuffer_t* ringbuffer;
+volatile bool ringbuffer_overrun = false;
+
+float frame[FRAME_SIZE];
+float windowed_frame[FRAME_SIZE];
+float hann_window_values[FRAME_SIZE];
+float magnitudes[NBINS];
+float last_magnitudes[NBINS];
+complex frame_freq[NBINS];
+RealFFT fft(FRAME_SIZE);
+
+//Triangular mel filters. Each filter is defined by its first bin and the weights of the following bins.
+std::vector<int> mel_first_bin;
+std::vector<std::vector<float> > mel_weights;
+
+//Voice activity detection
+float margin_db = 10;           //Energy over the noise floor for a frame to be active
+float min_energy_db = -60;      //Frames below this energy are never active
+float min_speech_ms = 60;       //Active time before speech start is reported
+float hangover_ms = 300;        //Inactive time before speech end is reported
+int min_speech_frames;
+int hangover_frames;
+float noise_floor_db = 0;
+bool noise_floor_initialized = false;
+bool speaking = false;
+int active_count = 0;
+int inactive_count = 0;
+
+ros::Publisher pubSpeechStart;
+ros::Publisher pubSpeechEnd;
+ros::Publisher pubSpeaking;
+ros::Publisher pubFeatures;
+bool publish_features = false;
+
+int jack_callback (jack_nframes_t nframes, void *arg)
+{
+    jack_default_audio_sample_t* in = (jack_default_audio_sample_t*)jack_port_get_buffer (input_port, nframes);
+    size_t bytes = nframes * sizeof(jack_default_audio_sample_t);
+    //If the main thread is late, samples are dropped. Nothing can block here.
+    if(jack_ringbuffer_write_space(ringbuffer) < bytes)
+    {
+        ringbuffer_overrun = true;
+        return 0;
+    }
+    jack_ringbuffer_write(ringbuffer, (const char*)in, bytes);
+    return 0;
+}
+
+void jack_shutdown (void *arg)
+{
+	exit (1);
+}
+
+float hz_to_mel(float hz)
+{
+    return 2595.0 * log10(1.0 + hz / 700.0);
+}
+
+float mel_to_hz(float mel)
+{
+    return 700.0 * (pow(10.0, mel / 2595.0) - 1.0);
+}
+
+void init_mel_filters(float sample_rate)
+{
+    float max_freq = MEL_MAX_FREQ < sample_rate / 2 ? MEL_MAX_FREQ : sample_rate / 2;
+    float min_mel = hz_to_mel(MEL_MIN_FREQ);
+    float max_mel = hz_to_mel(max_freq);
+    //Center frequencies (in bins) of the filters plus both edges
+    float edges[NUM_MEL_BANDS + 2];
+    for(int i=0; i < NUM_MEL_BANDS + 2; i++)
+        edges[i] = mel_to_hz(min_mel + (max_mel - min_mel) * i / (NUM_MEL_BANDS + 1)) * FRAME_SIZE / sample_rate;
+
+    mel_first_bin.resize(NUM_MEL_BANDS);
+    mel_weights.resize(NUM_MEL_BANDS);
+    for(int i=0; i < NUM_MEL_BANDS; i++)
+    {
+        float left = edges[i], center = edges[i+1], right = edges[i+2];
+        mel_first_bin[i] = (int)ceil(left);
+        mel_weights[i].clear();
+        for(int bin = mel_first_bin[i]; bin <= right && bin < NBINS; bin++)
+        {
+            float w = bin <= center ? (bin - left) / (center - left) : (right - bin) / (right - center);
+            mel_weights[i].push_back(w > 0 ? w : 0);
+        }
+    }
+}
+
+void update_vad(float energy_db)
+{
+    if(!noise_floor_initialized)
+    {
+        noise_floor_db = energy_db;
+        noise_floor_initialized = true;
+    }
+    bool active = energy_db > min_energy_db && energy_db > noise_floor_db + margin_db;
+    //Noise floor follows quickly the decreases of energy and slowly the increases. It is not updated during speech.
+    if(!active && !speaking)
+        noise_floor_db += (energy_db < noise_floor_db ? 0.2 : 0.01) * (energy_db - noise_floor_db);
+
+    active_count = active ? active_count + 1 : 0;
+    inactive_count = active ? 0 : inactive_count + 1;
+    if(!speaking && active_count >= min_speech_frames)
+    {
+        speaking = true;
+        std::cout << "SpeechFrontend.->Speech start detected." << std::endl;
+        pubSpeechStart.publish(std_msgs::Empty());
+        std_msgs::Bool msg;
+        msg.data = true;
+        pubSpeaking.publish(msg);
+    }
+    else if(speaking && inactive_count >= hangover_frames)
+    {
+        speaking = false;
+        std::cout << "SpeechFrontend.->Speech end detected." << std::endl;
+        pubSpeechEnd.publish(std_msgs::Empty());
+        std_msgs::Bool msg;
+        msg.data = false;
+        pubSpeaking.publish(msg);
+    }
+}
+
+//Computes energy, spectral flux and log-mel energies of the current frame
+void process_frame()
+{
+    float mean_square = 0;
+    for(int i=0; i < FRAME_SIZE; i++)
+    {
+        mean_square += frame[i] * frame[i];
+        windowed_frame[i] = frame[i] * hann_window_values[i];
+    }
+    float energy_db = 10 * log10(mean_square / FRAME_SIZE + 1e-12);
+
+    fft.Forward(windowed_frame, frame_freq);
+    float flux = 0;
+    float magnitudes_sum = 0;
+    for(int i=0; i < NBINS; i++)
+    {
+        magnitudes[i] = sqrt(frame_freq[i].norm());
+        float diff = magnitudes[i] - last_magnitudes[i];
+        if(diff > 0)
+            flux += diff;
+        magnitudes_sum += magnitudes[i];
+        last_magnitudes[i] = magnitudes[i];
+    }
+    flux /= magnitudes_sum + 1e-9;
+
+    update_vad(energy_db);
+
+    if(!publish_features)
+        return;
+    std_msgs::Float32MultiArray msg;
+    msg.data.resize(3 + NUM_MEL_BANDS);
+    msg.data[0] = energy_db;
+    msg.data[1] = flux;
+    msg.data[2] = speaking ? 1 : 0;
+    for(int i=0; i < NUM_MEL_BANDS; i++)
+    {
+        float band_energy = 0;
+        for(size_t j=0; j < mel_weights[i].size(); j++)
+            band_energy += mel_weights[i][j] * frame_freq[mel_first_bin[i] + j].norm();
+        msg.data[3 + i] = log(band_energy + 1e-10);
+    }
+    pubFeatures.publish(msg);
+}
+
+bool parse_arg(int argc, char* argv[], int i, float& value)
+{
+    std::stringstream ss(i + 1 < argc ? argv[i+1] : "");
+    if(!(ss >> value))
+    {
+        std::cout << "SpeechFrontend.->Cannot parse argument " << argv[i] << " :'(" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main (int argc, char *argv[])
+{
+    for(int i=1; i < argc; i++)
+    {
+        std::string str(argv[i]);
+        if(str.compare("--margin") == 0)
+            parse_arg(argc, argv, i, margin_db);
+        if(str.compare("--min_energy") == 0)
+            parse_arg(argc, argv, i, min_energy_db);
+        if(str.compare("--min_speech") == 0)
+            parse_arg(argc, argv, i, min_speech_ms);
+        if(str.compare("--hangover") == 0)
+            parse_arg(argc, argv, i, hangover_ms);
+        if(str.compare("--features") == 0)
+            publish_features = true;
+    }
+
+    std::cout << "INITIALIZING SPEECH FRONTEND NODE ..." << std::endl;
+    ros::init(argc, argv, "speech_frontend");
+    ros::NodeHandle n;
+    pubSpeechStart = n.advertise<std_msgs::Empty>("/hri/speech_frontend/speech_start", 1);
+    pubSpeechEnd   = n.advertise<std_msgs::Empty>("/hri/speech_frontend/speech_end", 1);
+    pubSpeaking    = n.advertise<std_msgs::Bool>("/hri/speech_frontend/speaking", 1, true);
+    pubFeatures    = n.advertise<std_msgs::Float32MultiArray>("/hri/speech_frontend/features", 1);
+    ros::Rate loop(100);
+
+	const char *client_name = "speech_frontend";
+	jack_options_t options = JackNoStartServer;
+	jack_status_t status;
+
+    client = jack_client_open (client_name, options, &status);
+	if (client == NULL)
+    {
+        std::cout << "jack_client_open() failed, status = " << status << std::endl;
+		if (status & JackServerFailed)
+            std::cout << "Unable to connect to JACK server." << std::endl;
+		exit (1);
+	}
+	if (status & JackNameNotUnique)
+    {
+		client_name = jack_get_client_name(client);
+        std::cout << "Warning: other agent with the same name is running, " << client_name << " has been assigned to us." << std::endl;
+	}
+
+    float sample_rate = jack_get_sample_rate (client);
+    std::cout << "Engine sample rate: " << sample_rate << std::endl;
+    float hop_ms = 1000.0 * HOP_SIZE / sample_rate;
+    min_speech_frames = (int)ceil(min_speech_ms / hop_ms);
+    hangover_frames = (int)ceil(hangover_ms / hop_ms);
+    std::cout << "SpeechFrontend.->Margin: " << margin_db << " dB, min speech: " << min_speech_ms << " ms, hangover: ";
+    std::cout << hangover_ms << " ms, hop: " << hop_ms << " ms" << std::endl;
+
+    for(int i=0; i < FRAME_SIZE; i++)
+    {
+        frame[i] = 0;
+        hann_window_values[i] = 0.5*(1 - cos(2*M_PI*i/(FRAME_SIZE-1)));
+    }
+    for(int i=0; i < NBINS; i++)
+        last_magnitudes[i] = 0;
+    init_mel_filters(sample_rate);
+
+    ringbuffer = jack_ringbuffer_create(RINGBUFFER_SECONDS * (size_t)sample_rate * sizeof(jack_default_audio_sample_t));
+    jack_ringbuffer_mlock(ringbuffer);
+
+	jack_set_process_callback (client, jack_callback, 0);
+	jack_on_shutdown (client, jack_shutdown, 0);
+
+	input_port = jack_port_register (client, "input", JACK_DEFAULT_AUDIO_TYPE,JackPortIsInput, 0);
+	if (input_port == NULL)
+    {
+        std::cout << "Could not create agent ports. Have we reached the maximum amount of JACK agent ports?" << std::endl;
+		exit (1);
+	}
+	if (jack_activate (client))
+    {
+        std::cout << "Cannot activate client." << std::endl;
+		exit (1);
+	}
+
+    std::cout << "Agent activated. (Y)" << std::endl;
+    std::cout << "Connecting ports... " << std::endl;
+
+	const char **serverports_names;
+	serverports_names = jack_get_ports (client, NULL, NULL, JackPortIsPhysical|JackPortIsOutput);
+	if (serverports_names == NULL)
+    {
+        std::cout << "No available physical capture (server output) ports." << std::endl;
+		exit (1);
+	}
+	if (jack_connect (client, serverports_names[0], jack_port_name (input_port)))
+    {
+        std::cout << "Cannot connect input port." << std::endl;
+		exit (1);
+	}
+	free (serverports_names);
+
+    std::cout << "I think everything is ok (Y)" << std::endl;
+    std_msgs::Bool msgSpeaking;
+    msgSpeaking.data = false;
+    pubSpeaking.publish(msgSpeaking);
+
+    const size_t hop_bytes = HOP_SIZE * sizeof(jack_default_audio_sample_t);
+	while(ros::ok())
+    {
+        //Every complete hop in the ring buffer is a new frame
+        while(jack_ringbuffer_read_space(ringbuffer) >= hop_bytes)
+        {
+            memmove(frame, frame + HOP_SIZE, (FRAME_SIZE - HOP_SIZE) * sizeof(float));
+            jack_ringbuffer_read(ringbuffer, (char*)(frame + FRAME_SIZE - HOP_SIZE), hop_bytes);
+            process_frame();
+        }
+        if(ringbuffer_overrun)
+        {
+            std::cout << "SpeechFrontend.->Ring buffer overrun, some samples were dropped." << std::endl;
+            ringbuffer_overrun = false;
+        }
+        ros::spinOnce();
+        loop.sleep();
+    }
+
+	jack_client_close (client);
+    jack_ringbuffer_free(ringbuffer);
+	exit (0);
+}
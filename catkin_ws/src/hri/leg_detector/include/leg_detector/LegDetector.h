@@ -0,0 +1,46 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include "sensor_msgs/LaserScan.h"
+#include "visualization_msgs/Marker.h"
+
+//Leg hypothesis (positions wrt the laser frame) from a laser scan.
+//Ranges are smoothed and segmented in flanks (jumps between consecutive readings) in a single pass. Segments
+//with the width of one leg are paired with a near one, segments with the width of two legs are taken directly.
+//Cosine and sine of every beam are computed only when angle_min, angle_increment or the number of readings
+//change, and all the buffers (filtered ranges, x and y of readings, flanks) are kept between scans as structure
+//of arrays, thus no memory is allocated per scan once the sizes are stable.
+class LegDetector
+{
+public:
+    LegDetector();
+    ~LegDetector();
+
+    void FindLegHypothesis(const std::vector<float>& ranges, float angle_min, float angle_increment,
+                           std::vector<float>& legs_x, std::vector<float>& legs_y);
+    void FindLegHypothesis(const sensor_msgs::LaserScan& scan, std::vector<float>& legs_x, std::vector<float>& legs_y);
+
+    static visualization_msgs::Marker GetHypothesisMarker(std::vector<float>& legs_x, std::vector<float>& legs_y,
+                                                          std::string frame_id = "base_link");
+
+private:
+    //Trigonometric table
+    std::vector<float> beamCos;
+    std::vector<float> beamSin;
+    float tableAngleMin;
+    float tableAngleIncrement;
+    //Per reading buffers
+    std::vector<float> filtered;
+    std::vector<float> laserX;
+    std::vector<float> laserY;
+    //Per flank buffers
+    std::vector<float> flankX;
+    std::vector<float> flankY;
+    std::vector<unsigned char> flankPaired;
+
+    void updateTrigTable(float angle_min, float angle_increment, size_t size);
+    void addSegment(int first, int last, float sum_x, float sum_y, std::vector<float>& legs_x, std::vector<float>& legs_y);
+    void pairFlanks(int i, int j, std::vector<float>& legs_x, std::vector<float>& legs_y);
+    bool isLeg(float x1, float y1, float x2, float y2);
+};
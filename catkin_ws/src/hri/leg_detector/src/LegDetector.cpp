@@ -0,0 +1,204 @@
+#include "leg_detector/LegDetector.h"
+
+//Constants to find leg hypothesis
+#define FILTER_THRESHOLD  .081
+#define FLANK_THRESHOLD  .04
+#define MIN_RANGE  0.4
+#define HORIZON_THRESHOLD  25
+#define MAX_FLOAT  57295779500
+#define PIERNA_DELGADA  0.006241//7.9CM,0.006241,6241
+#define PIERNA_GRUESA  0.037//19.23CM,0.037,37000
+#define DOS_PIERNAS_DELGADAS  0.056644//23.8CM,0.056644,56644
+#define DOS_PIERNAS_GRUESAS  0.25//50CM,0.25,250000
+#define DOS_PIERNAS_CERCAS  0.022201//14.9CM,0.022201,22201
+#define DOS_PIERNAS_LEJOS  0.16//40CM,0.16,160000
+
+LegDetector::LegDetector()
+{
+    this->tableAngleMin = 0;
+    this->tableAngleIncrement = 0;
+}
+
+LegDetector::~LegDetector()
+{
+}
+
+void LegDetector::FindLegHypothesis(const sensor_msgs::LaserScan& scan, std::vector<float>& legs_x, std::vector<float>& legs_y)
+{
+    this->FindLegHypothesis(scan.ranges, scan.angle_min, scan.angle_increment, legs_x, legs_y);
+}
+
+void LegDetector::FindLegHypothesis(const std::vector<float>& ranges, float angle_min, float angle_increment,
+                                    std::vector<float>& legs_x, std::vector<float>& legs_y)
+{
+    legs_x.clear();
+    legs_y.clear();
+    this->flankX.clear();
+    this->flankY.clear();
+    this->flankPaired.clear();
+    int n = ranges.size();
+    if(n < 3)
+        return;
+    this->updateTrigTable(angle_min, angle_increment, n);
+    this->filtered.resize(n);
+    this->laserX.resize(n);
+    this->laserY.resize(n);
+
+    const float* r = &ranges[0];
+    float* f  = &this->filtered[0];
+    float* lx = &this->laserX[0];
+    float* ly = &this->laserY[0];
+    const float* c = &this->beamCos[0];
+    const float* s = &this->beamSin[0];
+
+    //Single pass: reading i is smoothed with its neighbors, converted to x,y and compared with reading i-1
+    //to find flanks. Sums of the current segment are accumulated on the way.
+    f[0]  = 0;
+    lx[0] = 0;
+    ly[0] = 0;
+    int segment_start = 0;
+    float sum_x = 0;
+    float sum_y = 0;
+    for(int i=1; i < n; i++)
+    {
+        float fi = 0;
+        if(i < n - 1 && r[i] >= MIN_RANGE)
+        {
+            bool near_prev = fabs(r[i-1] - r[i]) < FILTER_THRESHOLD;
+            bool near_next = fabs(r[i] - r[i+1]) < FILTER_THRESHOLD;
+            if(near_prev && near_next)
+                fi = (r[i-1] + r[i] + r[i+1])/3.0;
+            else if(near_prev)
+                fi = (r[i-1] + r[i])/2.0;
+            else if(near_next)
+                fi = (r[i] + r[i+1])/2.0;
+        }
+        f[i]  = fi;
+        lx[i] = fi * c[i];
+        ly[i] = fi * s[i];
+
+        if(fabs(f[i] - f[i-1]) > FLANK_THRESHOLD)
+        {
+            int ant = segment_start;
+            if(this->isLeg(lx[ant], ly[ant], lx[i-1], ly[i-1]) ||
+               (i >= 2 && this->isLeg(lx[ant+1], ly[ant+1], lx[i-2], ly[i-2])))
+                this->addSegment(ant, i - 1, sum_x, sum_y, legs_x, legs_y);
+            segment_start = i;
+            sum_x = 0;
+            sum_y = 0;
+        }
+        sum_x += lx[i];
+        sum_y += ly[i];
+    }
+
+    //Pairs of single legs near each other
+    int noFlanks = this->flankX.size();
+    for(int i=0; i < noFlanks - 2; i++)
+        for(int j=1; j < 3; j++)
+            this->pairFlanks(i, i + j, legs_x, legs_y);
+    if(noFlanks > 1)
+        this->pairFlanks(noFlanks - 2, noFlanks - 1, legs_x, legs_y);
+
+    for(int i=0; i < noFlanks; i++)
+        if(!this->flankPaired[i])
+        {
+            legs_x.push_back(this->flankX[i]);
+            legs_y.push_back(this->flankY[i]);
+        }
+}
+
+//Segment from reading first to last (inclusive). If it has the width of one leg it is stored as a flank,
+//if it has the width of two legs it is a hypothesis.
+void LegDetector::addSegment(int first, int last, float sum_x, float sum_y, std::vector<float>& legs_x, std::vector<float>& legs_y)
+{
+    float dx = this->laserX[first] - this->laserX[last];
+    float dy = this->laserY[first] - this->laserY[last];
+    float d2 = dx*dx + dy*dy;
+    float count = last - first + 1;
+    if(d2 > PIERNA_DELGADA && d2 < PIERNA_GRUESA)
+    {
+        this->flankX.push_back(sum_x / count);
+        this->flankY.push_back(sum_y / count);
+        this->flankPaired.push_back(false);
+    }
+    else if(d2 > DOS_PIERNAS_DELGADAS && d2 < DOS_PIERNAS_GRUESAS)
+    {
+        legs_x.push_back(sum_x / count);
+        legs_y.push_back(sum_y / count);
+    }
+}
+
+void LegDetector::pairFlanks(int i, int j, std::vector<float>& legs_x, std::vector<float>& legs_y)
+{
+    float dx = this->flankX[i] - this->flankX[j];
+    float dy = this->flankY[i] - this->flankY[j];
+    float d2 = dx*dx + dy*dy;
+    if(d2 <= DOS_PIERNAS_CERCAS || d2 >= DOS_PIERNAS_LEJOS)
+        return;
+    float px = (this->flankX[i] + this->flankX[j])/2;
+    float py = (this->flankY[i] + this->flankY[j])/2;
+    if((px*px + py*py) >= HORIZON_THRESHOLD)
+        return;
+    legs_x.push_back(px);
+    legs_y.push_back(py);
+    this->flankPaired[i] = true;
+    this->flankPaired[j] = true;
+}
+
+bool LegDetector::isLeg(float x1, float y1, float x2, float y2)
+{
+    float m1, m2, px, py, angle;
+    px = (x1 + x2) / 2;
+    py = (y1 + y2) / 2;
+    if((px*px + py*py) >= HORIZON_THRESHOLD)
+        return false;
+    if(x1 != x2) m1 = (y1 - y2)/(x1 - x2);
+    else m1 = MAX_FLOAT;
+    if(px != 0) m2 = py / px;
+    else m2 = MAX_FLOAT;
+    angle = fabs((m2 - m1) / (1 + (m2*m1)));
+    return angle > 1.999;
+}
+
+void LegDetector::updateTrigTable(float angle_min, float angle_increment, size_t size)
+{
+    if(this->beamCos.size() == size && this->tableAngleMin == angle_min && this->tableAngleIncrement == angle_increment)
+        return;
+    this->beamCos.resize(size);
+    this->beamSin.resize(size);
+    for(size_t i=0; i < size; i++)
+    {
+        float theta = angle_min + i*angle_increment;
+        this->beamCos[i] = cos(theta);
+        this->beamSin[i] = sin(theta);
+    }
+    this->tableAngleMin = angle_min;
+    this->tableAngleIncrement = angle_increment;
+}
+
+visualization_msgs::Marker LegDetector::GetHypothesisMarker(std::vector<float>& legs_x, std::vector<float>& legs_y, std::string frame_id)
+{
+    visualization_msgs::Marker marker_legs;
+    marker_legs.header.stamp = ros::Time::now();
+    marker_legs.header.frame_id = frame_id;
+    marker_legs.ns = "leg_finder";
+    marker_legs.id = 0;
+    marker_legs.type = visualization_msgs::Marker::SPHERE_LIST;
+    marker_legs.action = visualization_msgs::Marker::ADD;
+    marker_legs.scale.x = 0.07;
+    marker_legs.scale.y = 0.07;
+    marker_legs.scale.z = 0.07;
+    marker_legs.color.a = 1.0;
+    marker_legs.color.r = 0;
+    marker_legs.color.g = 0.5;
+    marker_legs.color.b = 0;
+    marker_legs.points.resize(legs_y.size());
+    marker_legs.lifetime = ros::Duration(1.0);
+    for(size_t i=0; i < legs_y.size(); i++)
+    {
+        marker_legs.points[i].x = legs_x[i];
+        marker_legs.points[i].y = legs_y[i];
+        marker_legs.points[i].z = 0.3;
+    }
+    return marker_legs;
+}
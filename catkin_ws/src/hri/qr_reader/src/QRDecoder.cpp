@@ -11,9 +11,18 @@
 ** -------------------------------------------------------------------------*/
 
 #include "QRDecoder.h"
+#include <boost/bind.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
 using namespace qr_reader;
 
-QRDecoder::QRDecoder(): mainThread(NULL){
+// Images are downscaled by halves while they are at least twice this width
+#define MIN_SCAN_WIDTH 320
+// ROI hints older than this (seconds) are ignored
+#define ROI_HINT_TIMEOUT 2.0
+// While no code is found, one of every this many images is also scanned at full resolution
+#define FULL_SCAN_PERIOD 5
+
+QRDecoder::QRDecoder(): newImage(false){
 }
 
 QRDecoder::~QRDecoder(){
@@ -23,12 +32,32 @@ void QRDecoder::addTextRecognizedHandler(const stringFunctionType& handler){
 	textRecognized.connect(handler);
 }
 
+void QRDecoder::addTextDecodedHandler(const decodedFunctionType& handler){
+	textDecoded.connect(handler);
+}
+
 void QRDecoder::beginRecognize(cv_bridge::CvImageConstPtr& imgPtr){
-	boost::mutex::scoped_lock lock(mutex, boost::try_to_lock);
 	{
+		boost::mutex::scoped_lock lock(mutex);
+		// Latest image wins: a pending image not taken yet by any thread is dropped
 		sImgPtr = imgPtr;
-		condition.notify_one();
+		sImgReceived = ros::WallTime::now();
+		newImage = true;
 	}
+	condition.notify_one();
+}
+
+void QRDecoder::setRoiHint(const cv::Rect& roi){
+	boost::mutex::scoped_lock lock(roiMutex);
+	roiHint = roi;
+	roiHintReceived = ros::WallTime::now();
+}
+
+cv::Rect QRDecoder::getRoiHint(){
+	boost::mutex::scoped_lock lock(roiMutex);
+	if(roiHint.area() <= 0 || (ros::WallTime::now() - roiHintReceived).toSec() > ROI_HINT_TIMEOUT)
+		return cv::Rect();
+	return roiHint;
 }
 
 std::string QRDecoder::info(){
@@ -37,37 +66,81 @@ std::string QRDecoder::info(){
 	return s;
 }
 
-void QRDecoder::mainThreadTask(){
-	run();
+bool QRDecoder::scan(zbar::ImageScanner& scanner, const cv::Mat& grayImage, std::string& text, cv::Rect& location){
+	// zBar requires continuous data
+	cv::Mat gray = grayImage.isContinuous() ? grayImage : grayImage.clone();
+	// Wrap image data
+	zbar::Image image(gray.cols, gray.rows, "Y800", (unsigned char*)gray.data, gray.cols * gray.rows);
+	// Scan the image for barcodes
+	if(scanner.scan(image) < 1)
+		return false;
+	// Extract results
+	zbar::Image::SymbolIterator symbol = image.symbol_begin();
+	text = symbol->get_data();
+	// Bounding box of the location of the code
+	location = cv::Rect(0, 0, gray.cols, gray.rows);
+	if(symbol->get_location_size() > 0){
+		int minX = gray.cols, minY = gray.rows, maxX = 0, maxY = 0;
+		for(int i = 0; i < symbol->get_location_size(); ++i){
+			minX = std::min(minX, symbol->get_location_x(i));
+			minY = std::min(minY, symbol->get_location_y(i));
+			maxX = std::max(maxX, symbol->get_location_x(i));
+			maxY = std::max(maxY, symbol->get_location_y(i));
+		}
+		location = cv::Rect(minX, minY, maxX - minX + 1, maxY - minY + 1);
+	}
+	return true;
 }
 
-bool QRDecoder::decode(cv_bridge::CvImageConstPtr& imgPtr, std::string& text){
-	cv::Mat gray;
-	int width = imgPtr->image.cols;
-	int height = imgPtr->image.rows;
+bool QRDecoder::decode(zbar::ImageScanner& scanner, const cv::Mat& bgrImage, cv::Rect roi, std::string& text, bool fullResolution){
+	cv::Rect imageRect(0, 0, bgrImage.cols, bgrImage.rows);
+	roi &= imageRect;
+	if(roi.area() <= 0)
+		roi = imageRect;
 
 	try{
-		// Convert image to grayscale
-		cvtColor(imgPtr->image, gray, CV_BGR2GRAY);
-		// Wrap image data
-		zbar::Image image(width, height, "Y800", (unsigned char*)gray.data, width * height);
-		// Scan the image for barcodes
-		int n = scanner.scan(image);
-		if(n < 1)
-			return false;
-		// Extract results
-		zbar::Image::SymbolIterator symbol = image.symbol_begin();
-		text = symbol->get_data();
-		return true;
-		for(; symbol != image.symbol_end(); ++symbol) {
-			/*
-			* symbol->get_type_name() tells teh type (barcode or QRcode)
-			* symbol->get_data() fetch the data
-			* symbol->get_location_size() fetch the size of the code
-			* symbol->get_location_x(i) x-coordinate of the code
-			* symbol->get_location_y(i) y-coordinate of the code
-			*/
+		cv::Mat bgr = bgrImage(roi);
+		// Downscaled image is converted to grayscale, not the full resolution one
+		int scale = 1;
+		cv::Mat small = bgr;
+		while(small.cols >= 2 * MIN_SCAN_WIDTH){
+			cv::Mat half;
+			cv::pyrDown(small, half);
+			small = half;
+			scale *= 2;
 		}
+		cv::Mat gray;
+		cvtColor(small, gray, CV_BGR2GRAY);
+
+		cv::Rect candidate;
+		std::string smallText;
+		if(!scan(scanner, gray, smallText, candidate)){
+			// Small or distant codes may be lost when downscaling, the ROI is scanned at full resolution then
+			if(scale == 1 || !fullResolution)
+				return false;
+			cv::Rect location;
+			cv::Mat fullGray;
+			cvtColor(bgr, fullGray, CV_BGR2GRAY);
+			return scan(scanner, fullGray, text, location);
+		}
+		text = smallText;
+		if(scale == 1)
+			return true;
+
+		// Candidate region at full resolution, with a margin for the quiet zone of the code
+		int margin = std::max(candidate.width, candidate.height) / 4 + 4;
+		cv::Rect region(scale * (candidate.x - margin), scale * (candidate.y - margin),
+			scale * (candidate.width + 2 * margin), scale * (candidate.height + 2 * margin));
+		region &= cv::Rect(0, 0, bgr.cols, bgr.rows);
+		if(region.area() <= 0)
+			return true;
+		cv::Mat regionGray;
+		cvtColor(bgr(region), regionGray, CV_BGR2GRAY);
+		cv::Rect location;
+		std::string fullText;
+		if(scan(scanner, regionGray, fullText, location))
+			text = fullText;
+		return true;
 	}
 	catch ( ... ){
 		return false;
@@ -75,26 +148,55 @@ bool QRDecoder::decode(cv_bridge::CvImageConstPtr& imgPtr, std::string& text){
 }
 
 bool QRDecoder::recognize(cv_bridge::CvImageConstPtr& imgPtr, std::string& text){
-	if(!decode(imgPtr, text))
+	zbar::ImageScanner scanner;
+	if(!decode(scanner, imgPtr->image, getRoiHint(), text, true))
 		return false;
 	std::cout << "QR Text: " << text << std::flush << std::endl;
 	return true;
 }
 
 void QRDecoder::run(){
+	// zBar scanners are not thread safe, every thread uses its own one
+	zbar::ImageScanner scanner;
+	int misses = 0;
 	while(true){
-		boost::mutex::scoped_lock lock(mutex);
+		cv_bridge::CvImageConstPtr imgPtr;
+		ros::WallTime received;
 		{
-			condition.wait(lock);
-			std::string text;
-			if(recognize(sImgPtr, text) && !textRecognized.empty())
-				textRecognized(text);
+			boost::mutex::scoped_lock lock(mutex);
+			while(!newImage)
+				condition.wait(lock);
+			imgPtr = sImgPtr;
+			received = sImgReceived;
+			sImgPtr.reset();
+			newImage = false;
 		}
+
+		std::string text;
+		if(!imgPtr)
+			continue;
+		bool fullResolution = (misses + 1) % FULL_SCAN_PERIOD == 0;
+		if(!decode(scanner, imgPtr->image, getRoiHint(), text, fullResolution)){
+			misses++;
+			continue;
+		}
+		misses = 0;
+
+		// Latency is measured from the capture of the image when it is stamped
+		double latency = (ros::WallTime::now() - received).toSec();
+		if(!imgPtr->header.stamp.isZero())
+			latency = (ros::Time::now() - imgPtr->header.stamp).toSec();
+		std::cout << "QR Text: " << text << " (latency " << latency << " s)" << std::flush << std::endl;
+		if(!textRecognized.empty())
+			textRecognized(text);
+		if(!textDecoded.empty())
+			textDecoded(text, latency);
 	}
 }
 
-void QRDecoder::runAsync(){
-	if(mainThread != NULL)
+void QRDecoder::runAsync(int noThreads){
+	if(workers.size() > 0)
 		return;
-	mainThread = new boost::thread(&QRDecoder::mainThreadTask, this);
+	for(int i = 0; i < std::max(noThreads, 1); ++i)
+		workers.create_thread(boost::bind(&QRDecoder::run, this));
 }
\ No newline at end of file
@@ -26,26 +26,41 @@ namespace qr_reader{
 
 	typedef void (*stringCallback)(const std::string&);
 
+	// Images are passed to the decoding threads through a mailbox of one image:
+	// if all threads are busy, a new image replaces the pending one, so the
+	// decoder always works on the latest images instead of lagging behind.
+	// Each image is first scanned at a downscaled resolution (restricted to the
+	// ROI hint when there is one) and only the region where a code was found
+	// is scanned again at full resolution. While nothing is found, the ROI of one
+	// of every few images is also scanned at full resolution for small codes.
 	class QRDecoder{
 		public:
 			QRDecoder();
 			virtual ~QRDecoder();
 			void addTextRecognizedHandler(const stringFunctionType& handler);
+			void addTextDecodedHandler(const decodedFunctionType& handler);
 			void beginRecognize(cv_bridge::CvImageConstPtr& imgPtr);
+			void setRoiHint(const cv::Rect& roi);
 			std::string info();
 			bool recognize(cv_bridge::CvImageConstPtr& imgPtr, std::string& text);
 			void run();
-			void runAsync();
+			void runAsync(int noThreads = 1);
 
 		private:
-			zbar::ImageScanner scanner;
 			stringFunction textRecognized;
+			decodedFunction textDecoded;
 			cv_bridge::CvImageConstPtr sImgPtr;
+			ros::WallTime sImgReceived;
+			bool newImage;
+			cv::Rect roiHint;
+			ros::WallTime roiHintReceived;
 			boost::mutex mutex;
+			boost::mutex roiMutex;
 			boost::condition_variable condition;
-			boost::thread *mainThread;
-			void mainThreadTask();
-			bool decode(cv_bridge::CvImageConstPtr& imgPtr, std::string& text);
+			boost::thread_group workers;
+			bool decode(zbar::ImageScanner& scanner, const cv::Mat& bgrImage, cv::Rect roi, std::string& text, bool fullResolution);
+			bool scan(zbar::ImageScanner& scanner, const cv::Mat& grayImage, std::string& text, cv::Rect& location);
+			cv::Rect getRoiHint();
 	};
 
 } /* namespace qr_reader */
@@ -13,6 +13,7 @@
 #include "RosNode.h"
 #include <boost/bind.hpp>
 #include <std_msgs/String.h>
+#include <std_msgs/Float32.h>
 #include "justina_tools/JustinaTools.h"
 
 using namespace qr_reader;
@@ -21,8 +22,10 @@ RosNode::RosNode(int argc, char** argv, const std::string& image_src, const std:
 		mainThread(NULL),
 		it(nh){
 	text_publisher = nh.advertise<std_msgs::String>(recognized_text, 1);
+	latency_publisher = nh.advertise<std_msgs::Float32>(recognized_text + "_latency", 1);
 	this->image_src = image_src;
 	subQRStart = nh.subscribe("/vision/qr/start_qr", 1, &RosNode::imageQRStartCallback ,this);
+	subRoiHint = nh.subscribe("/vision/qr/roi_hint", 1, &RosNode::roiHintCallback ,this);
 	//subPointCloud = nh.subscribe(image_src, 1, &RosNode::imageCallback ,this);
 	JustinaTools::setNodeHandle(&nh);
 }
@@ -31,12 +34,22 @@ void RosNode::addImageReceivedHandler(const cvImgFunctionType& handler){
 	imageReceived.connect(handler);
 }
 
+void RosNode::addRoiHintReceivedHandler(const roiFunctionType& handler){
+	roiHintReceived.connect(handler);
+}
+
 void RosNode::publishRecognizedText(const std::string& text){
 	std_msgs::String msg;
 	msg.data = text;
 	text_publisher.publish(msg);
 }
 
+void RosNode::publishDecodeLatency(const std::string& text, double latency){
+	std_msgs::Float32 msg;
+	msg.data = latency;
+	latency_publisher.publish(msg);
+}
+
 void RosNode::imageCallback(const sensor_msgs::PointCloud2::ConstPtr& msg){
 	if(imageReceived.empty())
 		return;
@@ -73,6 +86,13 @@ void RosNode::imageQRStartCallback(const std_msgs::Bool::ConstPtr& msg){
 	}
 }
 
+// Region of the image where codes are expected. An empty region removes the hint.
+void RosNode::roiHintCallback(const sensor_msgs::RegionOfInterest::ConstPtr& msg){
+	if(roiHintReceived.empty())
+		return;
+	roiHintReceived(cv::Rect(msg->x_offset, msg->y_offset, msg->width, msg->height));
+}
+
 void RosNode::mainThreadTask(){
 	ros::spin();
 }
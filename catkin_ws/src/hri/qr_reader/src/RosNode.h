@@ -22,6 +22,7 @@
 #include <boost/signals2/signal.hpp>
 #include <image_transport/image_transport.h>
 #include <std_msgs/Bool.h>
+#include <sensor_msgs/RegionOfInterest.h>
 #include "Types.h"
 #include "sensor_msgs/PointCloud2.h"
 
@@ -32,23 +33,29 @@ namespace qr_reader{
 		RosNode(int argc, char** argv, const std::string& image_src, const std::string& recognized_text);
 
 		void addImageReceivedHandler(const cvImgFunctionType& handler);
+		void addRoiHintReceivedHandler(const roiFunctionType& handler);
 		void publishRecognizedText(const std::string& text);
+		void publishDecodeLatency(const std::string& text, double latency);
 		void runAsyncSpin();
 		void spin();
 
 	private:
 		ros::NodeHandle nh;
 		ros::Publisher text_publisher;
+		ros::Publisher latency_publisher;
 		image_transport::Subscriber image_subscriber;
 		image_transport::ImageTransport it;
 		ros::Subscriber subPointCloud;
 		ros::Subscriber subQRStart;
+		ros::Subscriber subRoiHint;
 		cvImgFunction imageReceived;
+		roiFunction roiHintReceived;
 		boost::thread *mainThread;
 		std::string image_src;
 
 		void imageCallback(const sensor_msgs::PointCloud2::ConstPtr& msg);
 		void imageQRStartCallback(const std_msgs::Bool::ConstPtr& msg);
+		void roiHintCallback(const sensor_msgs::RegionOfInterest::ConstPtr& msg);
 		void mainThreadTask();
 	};
 
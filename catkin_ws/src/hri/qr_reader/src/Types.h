@@ -24,6 +24,13 @@ typedef stringFunction::slot_type stringFunctionType;
 typedef boost::signals2::signal<void (cv_bridge::CvImageConstPtr& imgPtr)> cvImgFunction;
 typedef cvImgFunction::slot_type cvImgFunctionType;
 
+// Decoded text along with the latency in seconds from the capture of the image
+typedef boost::signals2::signal<void (const std::string&, double)> decodedFunction;
+typedef decodedFunction::slot_type decodedFunctionType;
+
+typedef boost::signals2::signal<void (const cv::Rect&)> roiFunction;
+typedef roiFunction::slot_type roiFunctionType;
+
 } /* namespace qr_reader */
 
 #endif /* __TYPES_H__ */
\ No newline at end of file
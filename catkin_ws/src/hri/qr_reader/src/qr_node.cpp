@@ -14,6 +14,9 @@
 // Topic for publishing recognized text in QR codes.
 #define RECOGNIZED_TEXT "qr/recognized"
 
+// Default number of threads decoding images.
+#define DECODER_THREADS 2
+
 using namespace qr_reader;
 
 // void decodeAndSend(cv_bridge::CvImageConstPtr& imgPtr);
@@ -27,12 +30,18 @@ int main(int argc, char **argv) {
 	RosNode node(argc, argv, IMAGE_SOURCE, RECOGNIZED_TEXT);
 	node.addImageReceivedHandler(
 		boost::bind(&QRDecoder::beginRecognize, &decoder, _1));
+	node.addRoiHintReceivedHandler(
+		boost::bind(&QRDecoder::setRoiHint, &decoder, _1));
 	decoder.addTextRecognizedHandler(
 		boost::bind(&RosNode::publishRecognizedText, &node, _1));
+	decoder.addTextDecodedHandler(
+		boost::bind(&RosNode::publishDecodeLatency, &node, _1, _2));
 
-    std::cout << "ROS QR Reader using " << decoder.info() << std::endl;
+	int decoderThreads;
+	ros::param::param<int>("~decoder_threads", decoderThreads, DECODER_THREADS);
+    std::cout << "ROS QR Reader using " << decoder.info() << " with " << decoderThreads << " decoding threads" << std::endl;
 
-	decoder.runAsync();
+	decoder.runAsync(decoderThreads);
 	node.spin();
 
 	return 0;
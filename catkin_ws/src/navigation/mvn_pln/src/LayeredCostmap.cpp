@@ -0,0 +1,210 @@
+#include "LayeredCostmap.h"
+
+LayeredCostmap::LayeredCostmap()
+{
+    this->staticMapReady = false;
+    this->growDist = 0;
+    this->distOfInfluence = 0;
+    this->dirtyMinX = this->dirtyMinY = 0;
+    this->dirtyMaxX = this->dirtyMaxY = -1;
+    this->lastMinX = this->lastMinY = 0;
+    this->lastMaxX = this->lastMaxY = -1;
+    this->changedMinX = this->changedMinY = 0;
+    this->changedMaxX = this->changedMaxY = -1;
+}
+
+LayeredCostmap::~LayeredCostmap()
+{
+}
+
+bool LayeredCostmap::SetStaticMap(const nav_msgs::OccupancyGrid& map, float growDist, float distOfInfluence)
+{
+    std::cout << "LayeredCostmap.->Calculating static layer of a " << map.info.width << "x" << map.info.height << " map" << std::endl;
+    this->staticMapReady = false;
+    this->growDist = growDist;
+    this->distOfInfluence = distOfInfluence;
+    this->staticMap = map;
+    if(!DistanceTransform::Compute(this->staticMap, this->staticDistances))
+    {
+        std::cout << "LayeredCostmap.->Cannot calculate distance transform of static map." << std::endl;
+        return false;
+    }
+    float resolution = map.info.resolution;
+    this->staticGrown.resize(map.data.size());
+    this->staticNearness.resize(map.data.size());
+    for(size_t i=0; i < map.data.size(); i++)
+    {
+        float dist = this->staticDistances[i] - growDist;
+        this->staticGrown[i] = dist <= 0 ? 100 : map.data[i];
+        this->staticNearness[i] = PathCalculator::NearnessValue(dist, resolution, distOfInfluence);
+    }
+    this->grownMap.header = map.header;
+    this->grownMap.info = map.info;
+    this->grownMap.data = this->staticGrown;
+    this->nearness = this->staticNearness;
+    this->obstacleLayer.assign(map.data.size(), 0);
+    this->windowMap.info = map.info;
+    this->dirtyMinX = this->dirtyMinY = 0;
+    this->dirtyMaxX = this->dirtyMaxY = -1;
+    this->lastMinX = this->lastMinY = 0;
+    this->lastMaxX = this->lastMaxY = -1;
+    //Whole map has changed for any incremental planner using this costmap
+    this->changedMinX = this->changedMinY = 0;
+    this->changedMaxX = map.info.width - 1;
+    this->changedMaxY = map.info.height - 1;
+    this->staticMapReady = true;
+    return true;
+}
+
+bool LayeredCostmap::IsStaticMapReady()
+{
+    return this->staticMapReady;
+}
+
+void LayeredCostmap::ClearObstacles()
+{
+    int width = this->staticMap.info.width;
+    for(int y = this->dirtyMinY; y <= this->dirtyMaxY; y++)
+        for(int x = this->dirtyMinX; x <= this->dirtyMaxX; x++)
+            this->obstacleLayer[y*width + x] = 0;
+    this->dirtyMinX = this->dirtyMinY = 0;
+    this->dirtyMaxX = this->dirtyMaxY = -1;
+}
+
+void LayeredCostmap::AddObstacle(float x, float y, int increment)
+{
+    if(!this->staticMapReady)
+        return;
+    int cellX = (int)((x - this->staticMap.info.origin.position.x)/this->staticMap.info.resolution);
+    int cellY = (int)((y - this->staticMap.info.origin.position.y)/this->staticMap.info.resolution);
+    if(cellX < 0 || cellX >= (int)this->staticMap.info.width || cellY < 0 || cellY >= (int)this->staticMap.info.height)
+        return;
+    this->obstacleLayer[cellY*this->staticMap.info.width + cellX] += increment;
+    if(this->dirtyMaxX < this->dirtyMinX)
+    {
+        this->dirtyMinX = this->dirtyMaxX = cellX;
+        this->dirtyMinY = this->dirtyMaxY = cellY;
+        return;
+    }
+    if(cellX < this->dirtyMinX) this->dirtyMinX = cellX;
+    if(cellX > this->dirtyMaxX) this->dirtyMaxX = cellX;
+    if(cellY < this->dirtyMinY) this->dirtyMinY = cellY;
+    if(cellY > this->dirtyMaxY) this->dirtyMaxY = cellY;
+}
+
+bool LayeredCostmap::UpdateCosts()
+{
+    if(!this->staticMapReady)
+    {
+        std::cout << "LayeredCostmap.->Cannot update costs. Static layer has not been calculated." << std::endl;
+        return false;
+    }
+    this->restoreLastWindow();
+    if(this->dirtyMaxX < this->dirtyMinX)
+        return true;
+
+    //Obstacles affect cells up to growDist + distOfInfluence, thus, the window is the dirty rectangle plus that margin
+    int width  = this->staticMap.info.width;
+    int height = this->staticMap.info.height;
+    float resolution = this->staticMap.info.resolution;
+    int margin = (int)ceil((this->growDist + this->distOfInfluence)/resolution) + 1;
+    int minX = std::max(this->dirtyMinX - margin, 0);
+    int minY = std::max(this->dirtyMinY - margin, 0);
+    int maxX = std::min(this->dirtyMaxX + margin, width  - 1);
+    int maxY = std::min(this->dirtyMaxY + margin, height - 1);
+    int windowWidth  = maxX - minX + 1;
+    int windowHeight = maxY - minY + 1;
+
+    //Cells in the window have the static value plus the one added by sensors, as in the former augmented map
+    this->windowMap.info.width  = windowWidth;
+    this->windowMap.info.height = windowHeight;
+    this->windowMap.data.resize(windowWidth*windowHeight);
+    for(int y = 0; y < windowHeight; y++)
+        for(int x = 0; x < windowWidth; x++)
+        {
+            int idx = (y + minY)*width + x + minX;
+            int value = this->staticMap.data[idx];
+            if(this->obstacleLayer[idx] > 0)
+                value = std::min(std::max(value, 0) + this->obstacleLayer[idx], 100);
+            this->windowMap.data[y*windowWidth + x] = value;
+        }
+    if(!DistanceTransform::Compute(this->windowMap, this->windowDistances, 40, 1))
+    {
+        std::cout << "LayeredCostmap.->Cannot calculate distance transform of obstacle layer." << std::endl;
+        return false;
+    }
+
+    //Static obstacles outside the window are already considered in the static distances
+    for(int y = 0; y < windowHeight; y++)
+        for(int x = 0; x < windowWidth; x++)
+        {
+            int idx = (y + minY)*width + x + minX;
+            int wIdx = y*windowWidth + x;
+            float dist = std::min(this->windowDistances[wIdx], this->staticDistances[idx]) - this->growDist;
+            this->grownMap.data[idx] = dist <= 0 ? 100 : this->windowMap.data[wIdx];
+            this->nearness[idx] = PathCalculator::NearnessValue(dist, resolution, this->distOfInfluence);
+        }
+    this->lastMinX = minX;
+    this->lastMinY = minY;
+    this->lastMaxX = maxX;
+    this->lastMaxY = maxY;
+    this->addChangedRegion(minX, minY, maxX, maxY);
+    return true;
+}
+
+const nav_msgs::OccupancyGrid& LayeredCostmap::GetGrownMap()
+{
+    return this->grownMap;
+}
+
+const int* LayeredCostmap::GetNearness()
+{
+    return this->nearness.empty() ? 0 : &this->nearness[0];
+}
+
+bool LayeredCostmap::GetChangedRegion(int& minX, int& minY, int& maxX, int& maxY)
+{
+    minX = this->changedMinX;
+    minY = this->changedMinY;
+    maxX = this->changedMaxX;
+    maxY = this->changedMaxY;
+    return this->changedMaxX >= this->changedMinX;
+}
+
+void LayeredCostmap::ResetChangedRegion()
+{
+    this->changedMinX = this->changedMinY = 0;
+    this->changedMaxX = this->changedMaxY = -1;
+}
+
+void LayeredCostmap::addChangedRegion(int minX, int minY, int maxX, int maxY)
+{
+    if(this->changedMaxX < this->changedMinX)
+    {
+        this->changedMinX = minX;
+        this->changedMinY = minY;
+        this->changedMaxX = maxX;
+        this->changedMaxY = maxY;
+        return;
+    }
+    this->changedMinX = std::min(this->changedMinX, minX);
+    this->changedMinY = std::min(this->changedMinY, minY);
+    this->changedMaxX = std::max(this->changedMaxX, maxX);
+    this->changedMaxY = std::max(this->changedMaxY, maxY);
+}
+
+void LayeredCostmap::restoreLastWindow()
+{
+    if(this->lastMaxX >= this->lastMinX)
+        this->addChangedRegion(this->lastMinX, this->lastMinY, this->lastMaxX, this->lastMaxY);
+    int width = this->staticMap.info.width;
+    for(int y = this->lastMinY; y <= this->lastMaxY; y++)
+    {
+        int first = y*width + this->lastMinX;
+        int last  = y*width + this->lastMaxX + 1;
+        std::copy(this->staticGrown.begin() + first, this->staticGrown.begin() + last, this->grownMap.data.begin() + first);
+        std::copy(this->staticNearness.begin() + first, this->staticNearness.begin() + last, this->nearness.begin() + first);
+    }
+    this->lastMinX = this->lastMinY = 0;
+    this->lastMaxX = this->lastMaxY = -1;
+}
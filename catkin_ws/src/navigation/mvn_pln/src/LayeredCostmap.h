@@ -0,0 +1,58 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "ros/ros.h"
+#include "nav_msgs/OccupancyGrid.h"
+#include "path_calculator/PathCalculator.h"
+#include "path_calculator/DistanceTransform.h"
+
+//
+//Costmap made of a static layer and an obstacle layer.
+//The static layer (grown map and nearness to obstacles) is calculated only once, when the static map changes.
+//Obstacles detected with laser and kinect are added to the obstacle layer and only the rectangle containing them
+//(plus the distance of influence) is recalculated in UpdateCosts. The rectangle modified in the last update is
+//restored from the static layer in the next one, so, the full map is never copied nor transformed again.
+//
+class LayeredCostmap
+{
+public:
+    LayeredCostmap();
+    ~LayeredCostmap();
+
+    bool SetStaticMap(const nav_msgs::OccupancyGrid& map, float growDist, float distOfInfluence);
+    bool IsStaticMapReady();
+    void ClearObstacles();
+    void AddObstacle(float x, float y, int increment);
+    bool UpdateCosts();
+    const nav_msgs::OccupancyGrid& GetGrownMap();
+    const int* GetNearness();
+    //Rectangle of cells whose cost may have changed since the last reset. Used by incremental planners.
+    bool GetChangedRegion(int& minX, int& minY, int& maxX, int& maxY);
+    void ResetChangedRegion();
+
+private:
+    bool staticMapReady;
+    float growDist;
+    float distOfInfluence;
+    nav_msgs::OccupancyGrid staticMap;      //Map as received, used to merge obstacles
+    std::vector<float> staticDistances;     //Distance transform of the static map
+    std::vector<int8_t> staticGrown;        //Static layer: grown static map
+    std::vector<int> staticNearness;        //Static layer: nearness to static obstacles
+    std::vector<int> obstacleLayer;         //Values added by sensors since the last ClearObstacles
+    nav_msgs::OccupancyGrid grownMap;       //Resulting grown map: static layer + obstacle layer
+    std::vector<int> nearness;              //Resulting nearness to obstacles
+    nav_msgs::OccupancyGrid windowMap;      //Scratch grid to calculate the distance transform of the dirty window
+    std::vector<float> windowDistances;
+
+    //Rectangle containing all obstacles added since the last clear. Empty if dirtyMaxX < dirtyMinX.
+    int dirtyMinX, dirtyMinY, dirtyMaxX, dirtyMaxY;
+    //Rectangle of grownMap and nearness modified by the last update. Empty if lastMaxX < lastMinX.
+    int lastMinX, lastMinY, lastMaxX, lastMaxY;
+    //Union of all windows restored or modified since the last ResetChangedRegion. Empty if changedMaxX < changedMinX.
+    int changedMinX, changedMinY, changedMaxX, changedMaxY;
+
+    void restoreLastWindow();
+    void addChangedRegion(int minX, int minY, int maxX, int maxY);
+};
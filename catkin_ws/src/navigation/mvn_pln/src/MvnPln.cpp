@@ -8,6 +8,11 @@ MvnPln::MvnPln()
     this->stopReceived = false;
     this->isLastPathPublished = false;
     this->_allow_move_lateral = false;
+    this->_use_incremental = true;
+    this->_use_hierarchical = false;
+    this->_use_path_cache = true;
+    this->_use_local_planner = false;
+    this->pathCacheGoalsLoaded = false;
     this->max_attempts = 0;
 }
 
@@ -29,9 +34,9 @@ void MvnPln::initROSConnection(ros::NodeHandle* nh)
     this->subLaserScan = nh->subscribe("/hardware/scan", 1, &MvnPln::callbackLaserScan, this);
     this->subCollisionRisk = nh->subscribe("/navigation/obs_avoid/collision_risk", 10, &MvnPln::callbackCollisionRisk, this);
     this->subCollisionPoint = nh->subscribe("/navigation/obs_avoid/collision_point", 10, &MvnPln::callbackCollisionPoint, this);
+    this->subStaticMap = nh->subscribe("/navigation/localization/map", 1, &MvnPln::callbackStaticMap, this);
 
     this->cltGetMap = nh->serviceClient<nav_msgs::GetMap>("/navigation/localization/static_map");
-    this->cltPathFromMapAStar = nh->serviceClient<navig_msgs::PathFromMap>("/navigation/path_planning/path_calculator/a_star_from_map");
     this->cltGetRgbdWrtRobot = nh->serviceClient<point_cloud_manager::GetRgbd>("/hardware/point_cloud_man/get_rgbd_wrt_robot");
     tf_listener.waitForTransform("map", "base_link", ros::Time(0), ros::Duration(5.0));
 }
@@ -68,6 +73,8 @@ void MvnPln::spin()
                 currentState = SM_CALCULATE_PATH;
 		collision_detected_counter = 0;
             }
+            else if(this->_use_path_cache)
+                this->updatePathCache();
             break;
         case SM_CALCULATE_PATH:
             std::cout << "MvnPln.->Current state: " << currentState << ". Calculating path using map, kinect and laser" << std::endl;
@@ -99,10 +106,18 @@ void MvnPln::spin()
             break;
         case SM_START_MOVE_PATH:
             std::cout << "MvnPln.->Current state: " << currentState << ". Starting move path" << std::endl;
-            std::cout << "MvnPln.->Turning on collision detection..." << std::endl;
             this->collisionDetected = false;
-            JustinaNavigation::enableObstacleDetection(true);
-            JustinaNavigation::startMovePath(this->lastCalcPath);
+            if(this->_use_local_planner)
+            {
+                //Local planner goes around obstacles and signals the collision risk only if the path is blocked
+                JustinaNavigation::startMovePathLocalPlanner(this->lastCalcPath);
+            }
+            else
+            {
+                std::cout << "MvnPln.->Turning on collision detection..." << std::endl;
+                JustinaNavigation::enableObstacleDetection(true);
+                JustinaNavigation::startMovePath(this->lastCalcPath);
+            }
             currentState = SM_WAIT_FOR_MOVE_FINISHED;
             break;
         case SM_WAIT_FOR_MOVE_FINISHED:
@@ -223,6 +238,26 @@ void MvnPln::allow_move_lateral(bool _allow_move_lateral)
     this->_allow_move_lateral = _allow_move_lateral;
 }
 
+void MvnPln::use_incremental_planner(bool _use_incremental)
+{
+    this->_use_incremental = _use_incremental;
+}
+
+void MvnPln::use_hierarchical_planner(bool _use_hierarchical)
+{
+    this->_use_hierarchical = _use_hierarchical;
+}
+
+void MvnPln::use_path_cache(bool _use_path_cache)
+{
+    this->_use_path_cache = _use_path_cache;
+}
+
+void MvnPln::use_local_planner(bool _use_local_planner)
+{
+    this->_use_local_planner = _use_local_planner;
+}
+
 bool MvnPln::planPath(float startX, float startY, float goalX, float goalY, nav_msgs::Path& path)
 {
     //bool pathSuccess =  this->planPath(startX, startY, goalX, goalY, path, true, true, true);
@@ -243,37 +278,13 @@ bool MvnPln::planPath(float startX, float startY, float goalX, float goalY, nav_
                       bool useMap, bool useLaser, bool useKinect)
 { 
     std::cout << "MvnPln.->Calculating path with augmented map..." << std::endl;
-    nav_msgs::OccupancyGrid augmentedMap;
-
     //
-    //If use_map, then gets the map from map_server
-    if(useMap)
-    {
-        nav_msgs::GetMap srvGetMap;        
-        std::cout << "MvnPln.->Getting occupancy grid from map server... " << std::endl;
-        if(!this->cltGetMap.call(srvGetMap))
-        {
-            std::cout << "MvnPln.->Cannot get map from map_server." << std::endl;
-            return false;
-        }
-        augmentedMap = srvGetMap.response.map;
-    }
-    else
-    {
-        augmentedMap.header.frame_id = "base_link";
-        augmentedMap.info.resolution = 0.05;
-        augmentedMap.info.width = 1000;
-        augmentedMap.info.height = 1000;
-        augmentedMap.info.origin.position.x = -25.0;
-        augmentedMap.info.origin.position.y = -25.0;
-        augmentedMap.data.resize(augmentedMap.info.width*augmentedMap.info.height);
-        for (size_t i=0; i < augmentedMap.data.size(); i++)
-            augmentedMap.data[i] = 0;
-    }
-    float mapOriginX = augmentedMap.info.origin.position.x;
-    float mapOriginY = augmentedMap.info.origin.position.y;
-    float mapResolution = augmentedMap.info.resolution;
-    int mapWidth = augmentedMap.info.width;
+    //Static layers are calculated only the first time or when the map changes (see callbackStaticMap).
+    //Sensor readings are merged into the obstacle layer and only the region around them is recalculated.
+    if(!this->updateStaticLayers(useMap))
+        return false;
+    LayeredCostmap& costmap = useMap ? this->mapCostmap : this->emptyCostmap;
+    costmap.ClearObstacles();
 
     //
     //If use-laser, then set as occupied the corresponding cells
@@ -282,7 +293,6 @@ bool MvnPln::planPath(float startX, float startY, float goalX, float goalY, nav_
         std::cout << "MvnPln.->Merging laser scan with occupancy grid" << std::endl;
         float robotX, robotY, robotTheta;
         float angle, laserX, laserY;
-        int idx;
         JustinaNavigation::getRobotPose(robotX, robotY, robotTheta);
         for(int i=0; i < lastLaserScan.ranges.size(); i++)
         {
@@ -291,24 +301,10 @@ bool MvnPln::planPath(float startX, float startY, float goalX, float goalY, nav_
             angle = lastLaserScan.angle_min + i*lastLaserScan.angle_increment;
             if(fabs(angle) > 1.5708)
                 continue;
-            //For each range, cells are free between the robot and the end of the ray
-	    /*
-            for(float dist=0; dist < lastLaserScan.ranges[i]; dist+=0.05)
-            {
-                laserX = robotX + dist*cos(angle + robotTheta);
-                laserY = robotY + dist*sin(angle + robotTheta);
-                idx = (int)((laserY - mapOriginY)/mapResolution) * mapWidth + (int)((laserX - mapOriginX)/mapResolution);
-                if(idx >= augmentedMap.data.size() || idx < 0)
-                    continue;
-                augmentedMap.data[idx] = 0;
-            }*/
             //Only the end of the ray is occupied
             laserX = robotX + lastLaserScan.ranges[i]*cos(angle + robotTheta);
             laserY = robotY + lastLaserScan.ranges[i]*sin(angle + robotTheta);
-            idx = (int)((laserY - mapOriginY)/mapResolution) * mapWidth + (int)((laserX - mapOriginX)/mapResolution);
-            if(idx >= augmentedMap.data.size() || idx < 0)
-                continue;
-            augmentedMap.data[idx] = 100;
+            costmap.AddObstacle(laserX, laserY, 100);
         }
     }
 
@@ -334,44 +330,152 @@ bool MvnPln::planPath(float startX, float startY, float goalX, float goalY, nav_
         float maxX = 0.9;
         float minY = -0.35;
         float maxY = 0.35;
-        int counter = 0;
-        int idx;
         for(size_t i=0; i<cloudWrtRobot.points.size(); i++)
         {
             pcl::PointXYZRGBA pR = cloudWrtRobot.points[i];
             pcl::PointXYZRGBA pM = cloudWrtMap.points[i];
-            idx = (int)((pM.y - mapOriginY)/mapResolution)*mapWidth + (int)((pM.x - mapOriginX)/mapResolution);
-            if(pR.x > minX && pR.x < maxX && pR.y > minY && pR.y < maxY && idx < augmentedMap.data.size() && idx >= 0)
+            if(pR.x > minX && pR.x < maxX && pR.y > minY && pR.y < maxY && pR.z > 0.05 && pR.z < 1.0)
+                costmap.AddObstacle(pM.x, pM.y, 3);
+        }
+    }
+
+    bool success = costmap.UpdateCosts();
+    if(success)
+    {
+        geometry_msgs::Pose startPose;
+        geometry_msgs::Pose goalPose;
+        startPose.position.x = startX;
+        startPose.position.y = startY;
+        goalPose.position.x = goalX;
+        goalPose.position.y = goalY;
+        int startCell, goalCell;
+        std::vector<int> cachedCells;
+        if(useMap && this->_use_path_cache && this->pathCache.PositionToCell(startX, startY, startCell) &&
+           this->pathCache.PositionToCell(goalX, goalY, goalCell) && this->pathCache.IsGoalReady(goalCell) &&
+           this->pathCache.GetPath(startCell, goalCell, costmap.GetGrownMap(), costmap.GetNearness(), cachedCells))
+        {
+            //Cached path is still optimal since none of its cells was touched by the obstacles detected now
+            std::cout << "MvnPln.->Using cached path to known location with " << cachedCells.size() << " cells." << std::endl;
+            PathCalculator::CellsToPath(costmap.GetGrownMap(), cachedCells, path);
+        }
+        else if(useMap && this->_use_hierarchical)
+        {
+            //Coarse grid is only recalculated where the costs changed since the last plan
+            int minX, minY, maxX, maxY;
+            if(!costmap.GetChangedRegion(minX, minY, maxX, maxY))
             {
-                if(pR.z > 0.05 && pR.z < 1.0)
-                    if((augmentedMap.data[idx]+=3) > 100)
-                        augmentedMap.data[idx] = 100;
-                //else
-		//augmentedMap.data[idx] = 0;
+                minX = minY = 0;
+                maxX = maxY = -1;
             }
+            success = PathCalculator::HierarchicalOnGrownMap(costmap.GetGrownMap(), costmap.GetNearness(), startPose, goalPose,
+                                                             path, minX, minY, maxX, maxY);
+            costmap.ResetChangedRegion();
+        }
+        else if(useMap && this->_use_incremental)
+        {
+            //Replans to the same goal (e.g. after a collision risk) only repair the cells changed since the last plan
+            int minX, minY, maxX, maxY;
+            if(!costmap.GetChangedRegion(minX, minY, maxX, maxY))
+                minX = minY = maxX = maxY = 0;
+            success = PathCalculator::DStarLiteOnGrownMap(costmap.GetGrownMap(), costmap.GetNearness(), startPose, goalPose,
+                                                          path, minX, minY, maxX, maxY);
+            costmap.ResetChangedRegion();
         }
+        else
+            success = PathCalculator::AStarOnGrownMap(costmap.GetGrownMap(), costmap.GetNearness(), startPose, goalPose, path);
+    }
+    if(success)
+    {
+        path = PathCalculator::SmoothPath(path);
+        path.header.stamp = ros::Time::now();
+        std::cout << "MvnPln.->Path calculated succesfully by A* using cached costmap" << std::endl;
     }
-
-    navig_msgs::PathFromMap srvPathFromMap;
-    srvPathFromMap.request.map = augmentedMap;
-    srvPathFromMap.request.start_pose.position.x = startX;
-    srvPathFromMap.request.start_pose.position.y = startY;
-    srvPathFromMap.request.goal_pose.position.x = goalX;
-    srvPathFromMap.request.goal_pose.position.y = goalY;
-
-    bool success;
-    if((success = this->cltPathFromMapAStar.call(srvPathFromMap)))
-        std::cout << "MvnPln.->Path calculated succesfully by path_calculator using A* using map and laser" << std::endl;
     else
-        std::cout << "MvnPln.->Cannot calculate path by path_calculator using A* using map and laser" << std::endl;
-    ros::spinOnce();
+    {
+        path.poses.clear();
+        std::cout << "MvnPln.->Cannot calculate path by A* using cached costmap" << std::endl;
+    }
 
-    path = srvPathFromMap.response.path;
     this->lastCalcPath = path;
     this->isLastPathPublished = false;
     return success;
 }
 
+bool MvnPln::updateStaticLayers(bool useMap)
+{
+    if(useMap && !this->mapCostmap.IsStaticMapReady())
+    {
+        //Map is usually received through the latched map topic. Service is used only if it has not arrived.
+        nav_msgs::GetMap srvGetMap;        
+        std::cout << "MvnPln.->Getting occupancy grid from map server... " << std::endl;
+        if(!this->cltGetMap.call(srvGetMap))
+        {
+            std::cout << "MvnPln.->Cannot get map from map_server." << std::endl;
+            return false;
+        }
+        if(!this->mapCostmap.SetStaticMap(srvGetMap.response.map, MVN_PLN_GROW_DIST, MVN_PLN_DIST_OF_INFLUENCE))
+            return false;
+        PathCalculator::ResetIncremental();
+        this->pathCache.SetMap(this->mapCostmap.GetGrownMap(), this->mapCostmap.GetNearness());
+        this->updatePathCacheGoals();
+    }
+    if(!useMap && !this->emptyCostmap.IsStaticMapReady())
+    {
+        nav_msgs::OccupancyGrid emptyMap;
+        emptyMap.header.frame_id = "base_link";
+        emptyMap.info.resolution = 0.05;
+        emptyMap.info.width = 1000;
+        emptyMap.info.height = 1000;
+        emptyMap.info.origin.position.x = -25.0;
+        emptyMap.info.origin.position.y = -25.0;
+        emptyMap.data.assign(emptyMap.info.width*emptyMap.info.height, 0);
+        if(!this->emptyCostmap.SetStaticMap(emptyMap, MVN_PLN_GROW_DIST, MVN_PLN_DIST_OF_INFLUENCE))
+            return false;
+    }
+    return true;
+}
+
+void MvnPln::callbackStaticMap(const nav_msgs::OccupancyGrid::ConstPtr& msg)
+{
+    std::cout << "MvnPln.->New static map received. Recalculating static layer..." << std::endl;
+    if(!this->mapCostmap.SetStaticMap(*msg, MVN_PLN_GROW_DIST, MVN_PLN_DIST_OF_INFLUENCE))
+        return;
+    PathCalculator::ResetIncremental();
+    this->pathCache.SetMap(this->mapCostmap.GetGrownMap(), this->mapCostmap.GetNearness());
+    this->updatePathCacheGoals();
+}
+
+void MvnPln::updatePathCache()
+{
+    //Known locations are loaded once and again each time ltm reports they were updated.
+    //Each call expands a bounded number of cells of the pending navigation functions, so that a Dijkstra over
+    //the whole map is spread over several cycles and new tasks and callbacks are still attended.
+    if(!this->mapCostmap.IsStaticMapReady())
+        return;
+    bool updateKnownLoc;
+    JustinaKnowledge::getUpdateKnownLoc(updateKnownLoc);
+    if(updateKnownLoc || !this->pathCacheGoalsLoaded)
+    {
+        this->pathCacheGoalsLoaded = true;
+        this->locations.clear();
+        JustinaKnowledge::getKnownLocations(this->locations);
+        this->updatePathCacheGoals();
+    }
+    int pending = this->pathCache.GetPendingGoals();
+    if(this->pathCache.ComputeNext(MVN_PLN_PATH_CACHE_EXPANSIONS) && this->pathCache.GetPendingGoals() < pending)
+        std::cout << "MvnPln.->Path cache: " << this->pathCache.GetPendingGoals() << " known locations remaining." << std::endl;
+}
+
+void MvnPln::updatePathCacheGoals()
+{
+    std::vector<int> goalCells;
+    int cell;
+    for(std::map<std::string, std::vector<float> >::iterator it = this->locations.begin(); it != this->locations.end(); ++it)
+        if(it->second.size() >= 2 && this->pathCache.PositionToCell(it->second[0], it->second[1], cell))
+            goalCells.push_back(cell);
+    this->pathCache.SetGoals(goalCells);
+}
+
 void MvnPln::callbackRobotStop(const std_msgs::Empty::ConstPtr& msg)
 {
     this->stopReceived = true;
@@ -380,6 +484,7 @@ void MvnPln::callbackRobotStop(const std_msgs::Empty::ConstPtr& msg)
 bool MvnPln::callbackPlanPath(navig_msgs::PlanPath::Request& req, navig_msgs::PlanPath::Response& resp)
 {
 	JustinaKnowledge::getKnownLocations(locations);
+    this->updatePathCacheGoals();
     //If Id is "", then, the metric values are used
     std::cout << "MvnPln.->Plan Path from ";
     if(req.start_location_id.compare("") == 0)
@@ -433,6 +538,7 @@ void MvnPln::callbackClickedPoint(const geometry_msgs::PointStamped::ConstPtr& m
 void MvnPln::callbackGetCloseLoc(const std_msgs::String::ConstPtr& msg)
 {
 	JustinaKnowledge::getKnownLocations(locations);
+    this->updatePathCacheGoals();
     if(this->locations.find(msg->data) == this->locations.end())
     {
         std::cout << "MvnPln.->Cannot get close to \"" << msg->data << "\". It is not a known location. " << std::endl;
@@ -26,7 +26,6 @@
 #include "nav_msgs/OccupancyGrid.h"
 #include "nav_msgs/Path.h"
 #include "sensor_msgs/LaserScan.h"
-#include "navig_msgs/PathFromMap.h"
 #include "navig_msgs/PlanPath.h"
 #include "navig_msgs/Location.h"
 #include "justina_tools/JustinaNavigation.h"
@@ -34,6 +33,9 @@
 #include "justina_tools/JustinaHardware.h"
 #include "justina_tools/JustinaKnowledge.h"
 #include "point_cloud_manager/GetRgbd.h"
+#include "path_calculator/PathCalculator.h"
+#include "path_calculator/PathCache.h"
+#include "LayeredCostmap.h"
 
 #define SM_INIT 0
 #define SM_WAITING_FOR_NEW_TASK 1
@@ -45,6 +47,11 @@
 #define SM_WAIT_FOR_ANGLE_CORRECTED 7
 #define SM_FINAL
 
+//Same growth and distance of influence used by path_calculator for A*
+#define MVN_PLN_GROW_DIST 0.15
+#define MVN_PLN_DIST_OF_INFLUENCE 0.6
+#define MVN_PLN_PATH_CACHE_EXPANSIONS 20000 //Cells of a navigation function calculated per cycle while idle
+
 class MvnPln
 {
 public:
@@ -66,8 +73,13 @@ private:
     ros::Subscriber subCollisionPoint;
     //Ros stuff for path planning
     ros::ServiceClient cltGetMap;
-    ros::ServiceClient cltPathFromMapAStar; //Path calculation using only the occupancy grid
     ros::ServiceClient cltGetRgbdWrtRobot;
+    ros::Subscriber subStaticMap;
+    //Costmaps are kept between plans. Static layers are calculated only when the map changes.
+    LayeredCostmap mapCostmap;   //Static layer from map_server
+    LayeredCostmap emptyCostmap; //Static layer without obstacles, used when the map is not used
+    PathCache pathCache;         //Navigation functions to known locations, calculated while waiting for new tasks
+    bool pathCacheGoalsLoaded;
     tf::TransformListener tf_listener;
 
     bool newTask;
@@ -83,12 +95,20 @@ private:
     float collisionPointY;
     bool stopReceived;
     bool _allow_move_lateral;
+    bool _use_incremental;  //If true, paths on the static map are planned with D* Lite to repair the tree on replans
+    bool _use_hierarchical; //If true, paths on the static map are planned on a coarse grid first and refined in a corridor
+    bool _use_path_cache;   //If true, paths to known locations are taken from precalculated navigation functions
+    bool _use_local_planner;//If true, paths are followed by the local planner, which goes around obstacles
     sensor_msgs::LaserScan lastLaserScan;
 
 public:
     void initROSConnection(ros::NodeHandle* nh);
     void spin();
     void allow_move_lateral(bool _allow_move_lateral);
+    void use_incremental_planner(bool _use_incremental);
+    void use_hierarchical_planner(bool _use_hierarchical);
+    void use_path_cache(bool _use_path_cache);
+    void use_local_planner(bool _use_local_planner);
 
     int max_attempts;
 
@@ -101,6 +121,10 @@ private:
     void callbackClickedPoint(const geometry_msgs::PointStamped::ConstPtr& msg);
     void callbackGetCloseLoc(const std_msgs::String::ConstPtr& msg);
     void callbackGetCloseXYA(const std_msgs::Float32MultiArray::ConstPtr& msg);
+    bool updateStaticLayers(bool useMap);
+    void updatePathCache();
+    void updatePathCacheGoals();
+    void callbackStaticMap(const nav_msgs::OccupancyGrid::ConstPtr& msg);
     void callbackLaserScan(const sensor_msgs::LaserScan::ConstPtr& msg);
     void callbackCollisionRisk(const std_msgs::Bool::ConstPtr& msg);
     void callbackGoalReached(const std_msgs::Bool::ConstPtr& msg);
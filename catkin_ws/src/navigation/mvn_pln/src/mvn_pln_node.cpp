@@ -10,6 +10,10 @@ int main(int argc, char** argv)
 {
     std::string locationsFilePath = "";
     bool allow_move_lateral = false;
+    bool use_incremental = true;
+    bool use_hierarchical = false;
+    bool use_path_cache = true;
+    bool use_local_planner = false;
     int value;
     int max_attempts = 7;
     for(int i=0; i < argc; i++)
@@ -19,6 +23,14 @@ int main(int argc, char** argv)
             locationsFilePath = argv[++i];
         if(strParam.compare("--move_lateral") == 0)
             allow_move_lateral = true;
+        if(strParam.compare("--no_incremental") == 0)
+            use_incremental = false;
+        if(strParam.compare("--hierarchical") == 0)
+            use_hierarchical = true;
+        if(strParam.compare("--no_path_cache") == 0)
+            use_path_cache = false;
+        if(strParam.compare("--local_planner") == 0)
+            use_local_planner = true;
 	if(strParam.compare("--max_attempts") == 0)
 	{
 	    std::stringstream ss(argv[++i]);
@@ -37,6 +49,10 @@ int main(int argc, char** argv)
     JustinaKnowledge::setNodeHandle(&n);
     MvnPln mvnPln;
     mvnPln.allow_move_lateral(allow_move_lateral);
+    mvnPln.use_incremental_planner(use_incremental);
+    mvnPln.use_hierarchical_planner(use_hierarchical);
+    mvnPln.use_path_cache(use_path_cache);
+    mvnPln.use_local_planner(use_local_planner);
     mvnPln.initROSConnection(&n);
     mvnPln.max_attempts = max_attempts;
     mvnPln.spin();
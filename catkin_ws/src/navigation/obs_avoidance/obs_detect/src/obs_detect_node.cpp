@@ -1,5 +1,6 @@
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 #include "opencv2/core/core.hpp"
 #include "opencv2/highgui/highgui.hpp"
 #include "ros/ros.h"
@@ -15,8 +16,12 @@
 
 sensor_msgs::LaserScan laserScan;
 nav_msgs::Path lastPath;
+sensor_msgs::PointCloud2::ConstPtr lastCloudMsg; //xyzCloud is a view of this message buffer
 cv::Mat bgrImg;
+cv::Mat bgrView;
+int bgrChannel;
 cv::Mat xyzCloud;
+cv::Mat xyzDebug;
 int currentPathIdx = 0;
 bool enable = false;
 float current_speed_linear = 0;
@@ -30,6 +35,15 @@ float maxX = 0.9;
 float minY = -0.25;
 float maxY = 0.25;
 float z_threshold = 0.05;
+bool debug = false; //If true, the image with the floor removed is shown in a window. It costs CPU, use it only for debugging.
+
+//Pixels whose rays, from the kinect origin, can hit the search box. It depends only on the pose of the kinect wrt robot,
+//thus, it is recalculated when the head moves and periodically, to include pixels that had no depth the last time.
+cv::Rect searchRoi;
+bool searchRoiValid = false;
+int framesSinceRoi = 0;
+tf::Vector3 roiKinectOrigin;
+tf::Quaternion roiKinectRotation;
 
 void callbackLaserScan(const sensor_msgs::LaserScan::ConstPtr& msg)
 {
@@ -44,7 +58,16 @@ void callbackPath(const nav_msgs::Path::ConstPtr& msg)
 
 void callbackPointCloud(const sensor_msgs::PointCloud2::ConstPtr& msg)
 {
-    JustinaTools::PointCloud2Msg_ToCvMat(msg, bgrImg, xyzCloud);
+    //Points are read directly from the message. Color image is copied only to be shown.
+    lastCloudMsg = msg;
+    if(!JustinaTools::PointCloud2Msg_ToCvMatView(*msg, bgrView, xyzCloud, bgrChannel))
+    {
+        xyzCloud.release(); //It could be a view of the former message
+        JustinaTools::PointCloud2Msg_ToCvMat(msg, bgrImg, xyzCloud);
+    }
+    else if(debug)
+        JustinaTools::PointCloud2Msg_ToCvMat(msg, bgrImg, xyzDebug);
+    framesSinceRoi++;
     //std::cout << "ObsDetector.->Received: width: " << bgrImg.cols << " height: " << bgrImg.rows << std::endl;
     //cv::imshow("OBSTACLE DETECTOR BY MARCOSOFT", bgrImg);
 }
@@ -55,13 +78,15 @@ void callbackEnable(const std_msgs::Bool::ConstPtr& msg)
     {
         std::cout << "ObsDetector.->Starting obstacle detection using point cloud..." << std::endl;
         subPointCloud = nh->subscribe("/hardware/point_cloud_man/rgbd_wrt_robot_downsampled", 1, callbackPointCloud);
-        cv::namedWindow("OBSTACLE DETECTOR BY MARCOSOFT", cv::WINDOW_AUTOSIZE);
+        searchRoiValid = false;
+        if(debug)
+            cv::namedWindow("OBSTACLE DETECTOR BY MARCOSOFT", cv::WINDOW_AUTOSIZE);
     }
     else
     {
         std::cout << "ObsDetector.->Stopping obstacle detection using point cloud..." << std::endl;
         subPointCloud.shutdown();
-	try
+	if(debug) try
 	{
         	cv::destroyWindow("OBSTACLE DETECTOR BY MARCOSOFT");
 	}
@@ -142,59 +167,120 @@ bool collisionRiskWithLaser(int pointAheadIdx, float robotX, float robotY, float
     return counter >= minCounter;
 }
 
+bool rayHitsSearchBox(const tf::Vector3& origin, float pX, float pY, float pZ)
+{
+    //Slab test of the ray from the kinect origin through the point against the search box
+    float boxMin[3] = {minX, minY, z_threshold};
+    float boxMax[3] = {maxX, maxY, 1.0};
+    float o[3] = {(float)origin.x(), (float)origin.y(), (float)origin.z()};
+    float d[3] = {pX - o[0], pY - o[1], pZ - o[2]};
+    float tMin = 0;
+    float tMax = 1e10;
+    for(int k=0; k < 3; k++)
+    {
+        if(fabs(d[k]) < 1e-6)
+        {
+            if(o[k] < boxMin[k] || o[k] > boxMax[k])
+                return false;
+            continue;
+        }
+        float t1 = (boxMin[k] - o[k]) / d[k];
+        float t2 = (boxMax[k] - o[k]) / d[k];
+        if(t1 > t2) std::swap(t1, t2);
+        if(t1 > tMin) tMin = t1;
+        if(t2 < tMax) tMax = t2;
+        if(tMin > tMax)
+            return false;
+    }
+    return true;
+}
+
+void updateSearchRoi(const tf::StampedTransform& kinectWrtRobot)
+{
+    tf::Vector3 origin = kinectWrtRobot.getOrigin();
+    tf::Quaternion rotation = kinectWrtRobot.getRotation();
+    bool kinectMoved = origin.distance(roiKinectOrigin) > 0.005 || fabs(rotation.angleShortestPath(roiKinectRotation)) > 0.005;
+    if(searchRoiValid && !kinectMoved && framesSinceRoi < 30 &&
+       searchRoi.x + searchRoi.width <= xyzCloud.cols && searchRoi.y + searchRoi.height <= xyzCloud.rows)
+        return;
+
+    int roiMinX = xyzCloud.cols, roiMinY = xyzCloud.rows, roiMaxX = -1, roiMaxY = -1;
+    int validPoints = 0;
+    int stride = xyzCloud.channels();
+    for(int j=0; j < xyzCloud.rows; j++)
+    {
+        const float* p = xyzCloud.ptr<float>(j);
+        for(int i=0; i < xyzCloud.cols; i++, p+=stride)
+        {
+            if(p[0] != p[0] || (p[0] == 0 && p[1] == 0 && p[2] == 0)) //NaN or no data
+                continue;
+            validPoints++;
+            if(!rayHitsSearchBox(origin, p[0], p[1], p[2]))
+                continue;
+            if(i < roiMinX) roiMinX = i;
+            if(i > roiMaxX) roiMaxX = i;
+            if(j < roiMinY) roiMinY = j;
+            if(j > roiMaxY) roiMaxY = j;
+        }
+    }
+    //Rays change smoothly along the image, a margin covers the neighbor pixels that had no depth in this frame
+    if(validPoints == 0)
+        searchRoi = cv::Rect(0, 0, xyzCloud.cols, xyzCloud.rows);
+    else if(roiMaxX < 0)
+        searchRoi = cv::Rect();
+    else
+        searchRoi = cv::Rect(cv::Point(roiMinX - 2, roiMinY - 2), cv::Point(roiMaxX + 3, roiMaxY + 3)) &
+            cv::Rect(0, 0, xyzCloud.cols, xyzCloud.rows);
+    searchRoiValid = validPoints > 0;
+    framesSinceRoi = 0;
+    roiKinectOrigin = origin;
+    roiKinectRotation = rotation;
+}
+
 bool collisionRiskWithKinect(int pointAheadIdx, float robotX, float robotY, float robotTheta, float& collisionX, float& collisionY)
 {
-    if(bgrImg.cols < 1 || bgrImg.rows < 1)
+    if(xyzCloud.cols < 1 || xyzCloud.rows < 1)
         return false;
 
-    //std::cout << "ObsDetect.->Starting detection" << std::endl;
-    
-    //std::cout << "ObsDetect.->Point ahead calculated" << std::endl;
-    //Searchs for possibles collisions only when robot is already pointing to several points ahead in the current path
-    //i.e. when the error angle is around zero
-    //std::cout << "ObsDetect.->Point cloud size: " << xyzCloud.cols <<"x" << xyzCloud.rows<< std::endl;
-    //Since coordinates are wrt robot, it searches only in a rectangle in front of the robot
+    //Since coordinates are wrt robot, it searches only in a rectangle in front of the robot, and only in the pixels
+    //that can see that rectangle. Rows are scanned in memory order and the loop ends once enough points are found.
+    //Inner loop has no branches so that the compiler can vectorize it.
+    const int minPoints = 30;
+    cv::Rect roi = searchRoi & cv::Rect(0, 0, xyzCloud.cols, xyzCloud.rows);
+    int stride = xyzCloud.channels();
     int counter = 0;
     float meanX = 0;
     float meanY = 0;
-    for(int i=0; i< xyzCloud.cols; i++)
-        for(int j=0; j< xyzCloud.rows; j++)
+    for(int j = roi.y; j < roi.y + roi.height && counter <= minPoints; j++)
+    {
+        const float* p = xyzCloud.ptr<float>(j) + stride*roi.x;
+        for(int i=0; i < roi.width; i++, p+=stride)
         {
-            cv::Vec3f p = xyzCloud.at<cv::Vec3f>(j,i);
-            if(p[2] < z_threshold)
-            {
-                bgrImg.data[3*(j*bgrImg.cols + i)] = 0;
-                bgrImg.data[3*(j*bgrImg.cols + i) + 1] = 0;
-                bgrImg.data[3*(j*bgrImg.cols + i) + 2] = 0;
-            }
-            if(p[0] >= minX && p[0] <= maxX && p[1] >= minY && p[1] <= maxY && p[2] >= z_threshold && p[2] < 1.0) 
-            {
-                counter++;
-                meanX += p[0];
-                meanY += p[1];
-            }
+            int inBox = (p[0] >= minX) & (p[0] <= maxX) & (p[1] >= minY) & (p[1] <= maxY) & (p[2] >= z_threshold) & (p[2] < 1.0f);
+            counter += inBox;
+            meanX += inBox ? p[0] : 0;
+            meanY += inBox ? p[1] : 0;
         }
-    //std::cout << "ObsDetect.->Color modified" << std::endl;
-    cv::imshow("OBSTACLE DETECTOR BY MARCOSOFT", bgrImg);
-
-    //float aheadX = lastPath.poses[pointAheadIdx].pose.position.x;
-    //float aheadY = lastPath.poses[pointAheadIdx].pose.position.y;
-    //float errorX = aheadX - robotX;
-    //float errorY = aheadY - robotY;
-    //float errorAngle = atan2(errorY, errorX) - robotTheta;
-    //if(errorAngle > M_PI) errorAngle -= 2*M_PI;
-    //if(errorAngle <= -M_PI) errorAngle += 2*M_PI;
-
-    //if(fabs(errorAngle) > 0.17)
-    //    return false;
+    }
+    if(debug && bgrImg.rows == xyzCloud.rows && bgrImg.cols == xyzCloud.cols)
+    {
+        for(int j=0; j < xyzCloud.rows; j++)
+        {
+            const float* p = xyzCloud.ptr<float>(j);
+            unsigned char* pixel = bgrImg.ptr<unsigned char>(j);
+            for(int i=0; i < xyzCloud.cols; i++, p+=stride, pixel+=3)
+                if(p[2] < z_threshold)
+                    pixel[0] = pixel[1] = pixel[2] = 0;
+        }
+        cv::rectangle(bgrImg, roi, cv::Scalar(0, 255, 0));
+        cv::imshow("OBSTACLE DETECTOR BY MARCOSOFT", bgrImg);
+    }
 
-    //if(counter > 0)
-    //    std::cout << "ObsDetect.->Collision risk detected with kinect: angle-counting: " << errorAngle << "  " << counter << std::endl;
-    collisionX = counter > 30 ? meanX / counter : 0;
-    collisionY = counter > 30 ? meanY / counter : 0;
+    collisionX = counter > minPoints ? meanX / counter : 0;
+    collisionY = counter > minPoints ? meanY / counter : 0;
     if(current_speed_linear < 0.1)
 	return false;
-    return counter > 30;
+    return counter > minPoints;
 }
 
 void callback_cmd_vel(const geometry_msgs::Twist::ConstPtr& msg)
@@ -239,6 +325,8 @@ int main(int argc, char** argv)
             if(ss >> value)
                 z_threshold = value;
         }
+        if(strParam.compare("--debug") == 0)
+            debug = true;
     }
     
     std::cout << "INITIALIZING OBSTACLE DETECTOR (ONLY LASER) NODE BY MARCOSOFT... " << std::endl;
@@ -275,7 +363,8 @@ int main(int argc, char** argv)
     lastPath.poses.push_back(geometry_msgs::PoseStamped()); //Just to have something before the first callback
     tf_listener.waitForTransform("map", "base_link", ros::Time(0), ros::Duration(10.0));
 
-    while(ros::ok() && cv::waitKey(15) != 27)
+    tf::StampedTransform kinectWrtRobot;
+    while(ros::ok() && (!debug || cv::waitKey(15) != 27))
     {
         //Getting robot position
         tf_listener.lookupTransform("map", "base_link", ros::Time(0), tf);
@@ -290,6 +379,16 @@ int main(int argc, char** argv)
 
         if(enable)
         {
+            try{
+                tf_listener.lookupTransform("base_link", "kinect_link", ros::Time(0), kinectWrtRobot);
+                if(xyzCloud.cols > 0)
+                    updateSearchRoi(kinectWrtRobot);
+            }
+            catch(tf::TransformException ex){
+                //Without the kinect pose, the whole image is searched
+                searchRoi = cv::Rect(0, 0, xyzCloud.cols, xyzCloud.rows);
+                searchRoiValid = false;
+            }
 	    msgCollisionRisk.data = collisionRiskWithKinect(aheadIdx, robotX, robotY, robotTheta, collisionX, collisionY);
             //msgCollisionRisk.data = collisionRiskWithKinect(aheadIdx, robotX, robotY, robotTheta);
 	    msgCollisionPoint.point.x = collisionX;
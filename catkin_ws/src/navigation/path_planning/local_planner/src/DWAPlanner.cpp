@@ -0,0 +1,353 @@
+#include "DWAPlanner.h"
+#include <queue>
+#include <algorithm>
+
+DWAPlanner::DWAPlanner()
+{
+    this->maxLinear = 0.4;
+    this->maxAngular = 0.7;
+    this->maxLinearAccel = 0.4;
+    this->maxAngularAccel = 1.5;
+    this->controlPeriod = 0.1;
+    this->simTime = 1.5;
+    this->simStep = 0.1;
+    this->linearSamples = 6;
+    this->angularSamples = 15;
+    this->robotRadius = 0.28;
+    this->inflationDist = 0.3;
+    this->pathWeight = 0.4;
+    this->goalWeight = 1.0;
+    this->headingWeight = 0.2;
+    this->obstacleWeight = 0.4;
+    this->speedWeight = 0.4;
+    this->goalValid = false;
+    this->nearestValid = false;
+    this->unreachableDist = 0;
+    this->InitCostmap(4.0, 0.05);
+}
+
+DWAPlanner::~DWAPlanner()
+{
+}
+
+void DWAPlanner::InitCostmap(float size, float resolution)
+{
+    int cells = (int)(size / resolution);
+    this->obstacleGrid.info.resolution = resolution;
+    this->obstacleGrid.info.width  = cells;
+    this->obstacleGrid.info.height = cells;
+    this->obstacleGrid.info.origin.position.x = -cells * resolution / 2;
+    this->obstacleGrid.info.origin.position.y = -cells * resolution / 2;
+    this->obstacleGrid.info.origin.orientation.w = 1;
+    this->obstacleGrid.header.frame_id = "base_link";
+    this->obstacleGrid.data.assign(cells*cells, 0);
+    this->obstacleDistances.assign(cells*cells, size);
+    this->pathDistances.assign(cells*cells, size);
+    this->goalDistances.assign(cells*cells, size);
+    this->pathCells.clear();
+    this->goalValid = false;
+    this->nearestValid = false;
+}
+
+void DWAPlanner::ClearObstacles()
+{
+    std::fill(this->obstacleGrid.data.begin(), this->obstacleGrid.data.end(), 0);
+    this->nearestValid = false;
+}
+
+void DWAPlanner::AddObstacle(float x, float y)
+{
+    int idx;
+    if(!this->cellIndex(x, y, idx))
+        return;
+    this->obstacleGrid.data[idx] = 100;
+    if(x > 0 && (!this->nearestValid || x*x + y*y < this->nearestX*this->nearestX + this->nearestY*this->nearestY))
+    {
+        this->nearestX = x;
+        this->nearestY = y;
+        this->nearestValid = true;
+    }
+}
+
+void DWAPlanner::AddLaserScan(const sensor_msgs::LaserScan& scan, float minRange, float maxRange)
+{
+    for(size_t i=0; i < scan.ranges.size(); i++)
+    {
+        float r = scan.ranges[i];
+        if(!(r > minRange && r < maxRange))
+            continue;
+        float angle = scan.angle_min + i*scan.angle_increment;
+        this->AddObstacle(r*cos(angle), r*sin(angle));
+    }
+}
+
+void DWAPlanner::SetPath(const std::vector<float>& path_x, const std::vector<float>& path_y)
+{
+    //Segments between consecutive points are rasterized, thus, sparse paths also give a continuous wavefront
+    this->pathCells.clear();
+    float step = this->obstacleGrid.info.resolution / 2;
+    int idx;
+    for(size_t i=0; i < path_x.size(); i++)
+    {
+        float prevX = i == 0 ? path_x[0] : path_x[i-1];
+        float prevY = i == 0 ? path_y[0] : path_y[i-1];
+        float dx = path_x[i] - prevX;
+        float dy = path_y[i] - prevY;
+        int n = (int)(sqrt(dx*dx + dy*dy) / step) + 1;
+        for(int k=1; k <= n; k++)
+            if(this->cellIndex(prevX + dx*k/n, prevY + dy*k/n, idx) &&
+               (this->pathCells.size() == 0 || this->pathCells.back() != idx))
+                this->pathCells.push_back(idx);
+    }
+}
+
+void DWAPlanner::UpdateCosts()
+{
+    //Local grid is small, a single thread is faster than splitting it
+    DistanceTransform::Compute(this->obstacleGrid, this->obstacleDistances, 40, 1);
+
+    //Wavefronts from the free path cells and from the farthest of them, the local goal
+    float freeClearance = std::min(this->robotRadius, this->GetClearance(0, 0));
+    std::vector<int> sources;
+    for(size_t i=0; i < this->pathCells.size(); i++)
+        if(this->obstacleDistances[this->pathCells[i]] >= freeClearance)
+            sources.push_back(this->pathCells[i]);
+    this->goalValid = sources.size() > 0;
+    this->propagateDistances(sources, this->pathDistances);
+    if(this->goalValid)
+    {
+        int goal = sources.back();
+        int width = this->obstacleGrid.info.width;
+        this->goalX = this->obstacleGrid.info.origin.position.x + (goal % width + 0.5) * this->obstacleGrid.info.resolution;
+        this->goalY = this->obstacleGrid.info.origin.position.y + (goal / width + 0.5) * this->obstacleGrid.info.resolution;
+        sources.assign(1, goal);
+    }
+    this->propagateDistances(sources, this->goalDistances);
+    //Local goal behind obstacles that close the way (a doorway blocked by people): it is better to replan
+    int robotIdx;
+    if(this->goalValid && this->cellIndex(0, 0, robotIdx))
+        this->goalValid = this->goalDistances[robotIdx] < this->unreachableDist;
+}
+
+//Dijkstra over the 8-connected grid, only through cells where the robot fits (or, if it is already too near to
+//something, cells not nearer than the robot cell). Unreachable cells keep a distance larger than any reachable one.
+void DWAPlanner::propagateDistances(const std::vector<int>& sources, std::vector<float>& distances)
+{
+    int width  = this->obstacleGrid.info.width;
+    int height = this->obstacleGrid.info.height;
+    float res  = this->obstacleGrid.info.resolution;
+    float diag = res * (float)M_SQRT2;
+    float freeClearance = std::min(this->robotRadius, this->GetClearance(0, 0));
+    this->unreachableDist = 2*(width + height)*res;
+    distances.assign(width*height, this->unreachableDist);
+    std::priority_queue<std::pair<float, int>, std::vector<std::pair<float, int> >, std::greater<std::pair<float, int> > > open;
+    for(size_t i=0; i < sources.size(); i++)
+    {
+        distances[sources[i]] = 0;
+        open.push(std::make_pair(0.0f, sources[i]));
+    }
+    int   neighborCol[8]  = {1, -1, 0, 0, 1, 1, -1, -1};
+    int   neighborRow[8]  = {0, 0, 1, -1, 1, -1, 1, -1};
+    float neighborDist[8] = {res, res, res, res, diag, diag, diag, diag};
+    while(!open.empty())
+    {
+        float d = open.top().first;
+        int idx = open.top().second;
+        open.pop();
+        if(d > distances[idx])
+            continue;
+        int col = idx % width;
+        int row = idx / width;
+        for(int k=0; k < 8; k++)
+        {
+            int c = col + neighborCol[k];
+            int r = row + neighborRow[k];
+            if(c < 0 || r < 0 || c >= width || r >= height)
+                continue;
+            int n = r*width + c;
+            if(this->obstacleDistances[n] < freeClearance || d + neighborDist[k] >= distances[n])
+                continue;
+            distances[n] = d + neighborDist[k];
+            open.push(std::make_pair(distances[n], n));
+        }
+    }
+}
+
+bool DWAPlanner::ComputeVelocities(float currentLinear, float currentAngular, float& linear, float& angular)
+{
+    //Dynamic window: speeds reachable from the current ones within a control period
+    float minV = std::max(0.0f, std::min(currentLinear, this->maxLinear) - this->maxLinearAccel*this->controlPeriod);
+    float maxV = std::min(this->maxLinear, std::max(currentLinear, 0.0f) + this->maxLinearAccel*this->controlPeriod);
+    float minW = std::max(-this->maxAngular, currentAngular - this->maxAngularAccel*this->controlPeriod);
+    float maxW = std::min( this->maxAngular, currentAngular + this->maxAngularAccel*this->controlPeriod);
+    if(maxV < minV) maxV = minV;
+    if(maxW < minW) maxW = minW;
+    int nv = this->linearSamples  > 1 ? this->linearSamples  : 1;
+    int nw = this->angularSamples > 1 ? this->angularSamples : 1;
+    float startClearance = this->GetClearance(0, 0);
+
+    bool found = false;
+    float bestCost = 0;
+    this->bestX.clear();
+    this->bestY.clear();
+    //If every free point of the path is blocked, only the global planner can find another way
+    for(int i=0; i < nv && this->goalValid; i++)
+    {
+        float v = nv > 1 ? minV + (maxV - minV)*i/(nv - 1) : maxV;
+        for(int j=0; j < nw; j++)
+        {
+            float w = nw > 1 ? minW + (maxW - minW)*j/(nw - 1) : 0;
+            float cost;
+            if(!this->scoreTrajectory(v, w, startClearance, cost))
+                continue;
+            if(!found || cost < bestCost)
+            {
+                found = true;
+                bestCost = cost;
+                linear = v;
+                angular = w;
+                this->bestX.swap(this->trajX);
+                this->bestY.swap(this->trajY);
+            }
+        }
+    }
+    if(!found)
+    {
+        linear = 0;
+        angular = 0;
+    }
+    return found;
+}
+
+bool DWAPlanner::scoreTrajectory(float linear, float angular, float startClearance, float& cost)
+{
+    //If the robot is already nearer than its radius to something (noise, a person approaching), it is allowed to
+    //move as long as it does not get even nearer.
+    float minAllowed = std::min(this->robotRadius, startClearance);
+    float minClearance = this->robotRadius + this->inflationDist;
+    int steps = (int)(this->simTime / this->simStep + 0.5);
+    float x = 0;
+    float y = 0;
+    float t = 0;
+    int idx = 0;
+    int lastIdx = 0;
+    this->cellIndex(0, 0, lastIdx);
+    this->trajX.clear();
+    this->trajY.clear();
+    for(int k=0; k < steps; k++)
+    {
+        //Midpoint integration of the unicycle model
+        float tm = t + angular*this->simStep/2;
+        x += linear*cos(tm)*this->simStep;
+        y += linear*sin(tm)*this->simStep;
+        t += angular*this->simStep;
+        if(!this->cellIndex(x, y, idx))
+            break;
+        float c = this->obstacleDistances[idx];
+        if(c < minAllowed)
+            return false;
+        if(c < minClearance)
+            minClearance = c;
+        lastIdx = idx;
+        this->trajX.push_back(x);
+        this->trajY.push_back(y);
+    }
+
+    float pathDist = this->pathDistances[lastIdx];
+    float goalDist = this->goalDistances[lastIdx];
+    //Heading is compared with the direction in which the goal wavefront decreases the most, so, turning
+    //towards the way around an obstacle is rewarded even before moving
+    float heading = 0;
+    float descentX, descentY;
+    if(goalDist > this->robotRadius && this->descentDirection(lastIdx, descentX, descentY))
+    {
+        heading = atan2(descentY, descentX) - t;
+        while(heading >   M_PI) heading -= 2*M_PI;
+        while(heading <= -M_PI) heading += 2*M_PI;
+        heading = fabs(heading);
+    }
+    float obstacleCost = (this->robotRadius + this->inflationDist - minClearance) / this->inflationDist;
+    if(obstacleCost < 0) obstacleCost = 0;
+    if(obstacleCost > 1) obstacleCost = 1;
+    float speedCost = this->maxLinear > 0 ? (this->maxLinear - linear) / this->maxLinear : 0;
+
+    cost = this->pathWeight*pathDist + this->goalWeight*goalDist + this->headingWeight*heading +
+        this->obstacleWeight*obstacleCost + this->speedWeight*speedCost;
+    return true;
+}
+
+bool DWAPlanner::descentDirection(int idx, float& dx, float& dy)
+{
+    int width  = this->obstacleGrid.info.width;
+    int height = this->obstacleGrid.info.height;
+    int col = idx % width;
+    int row = idx / width;
+    float best = this->goalDistances[idx];
+    bool found = false;
+    for(int r = row - 1; r <= row + 1; r++)
+        for(int c = col - 1; c <= col + 1; c++)
+        {
+            if(c < 0 || r < 0 || c >= width || r >= height || this->goalDistances[r*width + c] >= best)
+                continue;
+            best = this->goalDistances[r*width + c];
+            dx = c - col;
+            dy = r - row;
+            found = true;
+        }
+    return found;
+}
+
+bool DWAPlanner::GetLocalGoal(float& x, float& y)
+{
+    x = this->goalX;
+    y = this->goalY;
+    return this->goalValid;
+}
+
+float DWAPlanner::GetClearance(float x, float y)
+{
+    int idx;
+    if(!this->cellIndex(x, y, idx))
+        return this->robotRadius + this->inflationDist;
+    return this->obstacleDistances[idx];
+}
+
+bool DWAPlanner::GetNearestObstacleInFront(float& x, float& y)
+{
+    x = this->nearestX;
+    y = this->nearestY;
+    return this->nearestValid;
+}
+
+const nav_msgs::OccupancyGrid& DWAPlanner::GetCostmap()
+{
+    this->obstacleGrid.header.stamp = ros::Time::now();
+    return this->obstacleGrid;
+}
+
+nav_msgs::Path DWAPlanner::GetBestTrajectory(std::string frame_id)
+{
+    nav_msgs::Path path;
+    path.header.frame_id = frame_id;
+    path.header.stamp = ros::Time::now();
+    path.poses.resize(this->bestX.size());
+    for(size_t i=0; i < this->bestX.size(); i++)
+    {
+        path.poses[i].header.frame_id = frame_id;
+        path.poses[i].pose.position.x = this->bestX[i];
+        path.poses[i].pose.position.y = this->bestY[i];
+        path.poses[i].pose.orientation.w = 1;
+    }
+    return path;
+}
+
+bool DWAPlanner::cellIndex(float x, float y, int& idx)
+{
+    int col = (int)((x - this->obstacleGrid.info.origin.position.x) / this->obstacleGrid.info.resolution);
+    int row = (int)((y - this->obstacleGrid.info.origin.position.y) / this->obstacleGrid.info.resolution);
+    if(x < this->obstacleGrid.info.origin.position.x || y < this->obstacleGrid.info.origin.position.y ||
+       col >= (int)this->obstacleGrid.info.width || row >= (int)this->obstacleGrid.info.height)
+        return false;
+    idx = row * this->obstacleGrid.info.width + col;
+    return true;
+}
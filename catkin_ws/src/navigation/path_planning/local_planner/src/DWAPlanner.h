@@ -0,0 +1,80 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include "ros/ros.h"
+#include "nav_msgs/OccupancyGrid.h"
+#include "nav_msgs/Path.h"
+#include "sensor_msgs/LaserScan.h"
+#include "path_calculator/DistanceTransform.h"
+
+//
+//Dynamic window local planner. Everything is expressed wrt robot (base_link), the robot is always at the origin.
+//A rolling costmap, centered on the robot, is rebuilt every cycle with the last laser scan and point cloud. Clearance
+//of every cell is the distance transform of the obstacles. Distances to the global path and to the local goal (last
+//free point of the given path) are propagated as wavefronts only through cells where the robot fits, thus, going
+//around an obstacle that blocks the path reduces them while going straight to it does not.
+//Pairs (linear, angular) reachable within one control period are sampled and simulated at constant speed during
+//simTime. Trajectories passing nearer than robotRadius to an obstacle are discarded, the rest are scored by distance
+//to the path, distance and heading to the local goal, nearness to obstacles and speed. The lowest cost is chosen.
+//
+class DWAPlanner
+{
+public:
+    DWAPlanner();
+    ~DWAPlanner();
+
+    float maxLinear;            //[m/s]
+    float maxAngular;           //[rad/s]
+    float maxLinearAccel;       //[m/s^2]
+    float maxAngularAccel;      //[rad/s^2]
+    float controlPeriod;        //Time to reach the sampled speeds [s]
+    float simTime;              //Time each trajectory is simulated [s]
+    float simStep;              //[s]
+    int   linearSamples;
+    int   angularSamples;
+    float robotRadius;          //Trajectories nearer than this to an obstacle are not admissible [m]
+    float inflationDist;        //Obstacle cost decreases from 1 at robotRadius to 0 at robotRadius + inflationDist [m]
+    float pathWeight;           //Cost per meter (through free cells) from the end of the trajectory to the global path
+    float goalWeight;           //Cost per meter (through free cells) from the end of the trajectory to the local goal
+    float headingWeight;        //Cost per radian between the final heading and the way to the local goal
+    float obstacleWeight;
+    float speedWeight;          //Cost of not going at max linear speed
+
+    void InitCostmap(float size, float resolution);
+    void ClearObstacles();
+    void AddObstacle(float x, float y);
+    void AddLaserScan(const sensor_msgs::LaserScan& scan, float minRange, float maxRange);
+    void SetPath(const std::vector<float>& path_x, const std::vector<float>& path_y);
+    void UpdateCosts();
+    bool ComputeVelocities(float currentLinear, float currentAngular, float& linear, float& angular);
+    bool GetLocalGoal(float& x, float& y);
+    float GetClearance(float x, float y);
+    bool GetNearestObstacleInFront(float& x, float& y);
+    const nav_msgs::OccupancyGrid& GetCostmap();
+    nav_msgs::Path GetBestTrajectory(std::string frame_id = "base_link");
+
+private:
+    nav_msgs::OccupancyGrid obstacleGrid;
+    std::vector<float> obstacleDistances;
+    std::vector<float> pathDistances;
+    std::vector<float> goalDistances;
+    std::vector<int> pathCells;         //Cells of the rasterized path, in order
+    float unreachableDist;              //Distance given to cells not reached by a wavefront
+    bool goalValid;
+    float goalX;
+    float goalY;
+    bool nearestValid;
+    float nearestX;
+    float nearestY;
+    //Poses of the trajectory being simulated and of the best one, structure of arrays
+    std::vector<float> trajX;
+    std::vector<float> trajY;
+    std::vector<float> bestX;
+    std::vector<float> bestY;
+
+    bool cellIndex(float x, float y, int& idx);
+    void propagateDistances(const std::vector<int>& sources, std::vector<float>& distances);
+    bool descentDirection(int idx, float& dx, float& dy);
+    bool scoreTrajectory(float linear, float angular, float startClearance, float& cost);
+};
@@ -0,0 +1,405 @@
+#include <iostream>
+#include <algorithm>
+#include "ros/ros.h"
+#include "geometry_msgs/Twist.h"
+#include "geometry_msgs/PointStamped.h"
+#include "nav_msgs/Path.h"
+#include "nav_msgs/Odometry.h"
+#include "nav_msgs/OccupancyGrid.h"
+#include "sensor_msgs/LaserScan.h"
+#include "sensor_msgs/PointCloud2.h"
+#include "std_msgs/Bool.h"
+#include "std_msgs/Empty.h"
+#include "std_msgs/Float32MultiArray.h"
+#include "tf/transform_listener.h"
+#include "justina_tools/JustinaTools.h"
+#include "DWAPlanner.h"
+
+#define LP_GOAL_TOLERANCE 0.08
+#define LP_ROTATE_IN_PLACE_ANGLE 1.2     //If the local goal is at a larger angle, robot turns without moving
+#define LP_CLOSEST_SEARCH_DIST 1.0       //Closest point is searched only this far ahead of the last one
+#define LP_SENSOR_TIMEOUT 0.5
+#define LP_ODOMETRY_TIMEOUT 0.5
+
+//Global path, in map frame, as arrays of coordinates and arc length
+nav_msgs::Path goal_path;
+std::vector<float> path_x;
+std::vector<float> path_y;
+std::vector<float> path_s;
+int   closest_idx = 0;
+bool  new_path = false;
+bool  stop     = false;
+bool  active   = false;
+bool  move_head = false;
+
+sensor_msgs::LaserScan laser_scan;
+ros::Time laser_time;
+sensor_msgs::PointCloud2::ConstPtr cloud_msg;
+ros::Time cloud_time;
+cv::Mat bgr_cloud;
+cv::Mat xyz_cloud;
+int bgr_channel;
+float current_linear  = 0;
+float current_angular = 0;
+bool  odom_has_twist  = false;  //Base drivers that only publish the pose leave the twist in zero
+ros::Time odom_time;
+
+//Parameters
+float lookahead_dist  = 1.5;    //Local goal is taken this far along the path, inside the rolling costmap
+float laser_min_range = 0.2;
+float laser_max_range = 2.5;
+float cloud_min_z     = 0.05;   //Points below are considered floor
+float cloud_max_z     = 1.6;    //Points above do not touch the robot
+float blocked_timeout = 2.0;    //Time without an admissible trajectory before reporting the collision risk
+
+DWAPlanner dwa;
+ros::Subscriber sub_cloud;
+ros::Publisher pub_goal_reached;
+ros::Publisher pub_cmd_vel;
+ros::Publisher pub_head;
+ros::Publisher pub_collision_risk;
+ros::Publisher pub_collision_point;
+ros::Publisher pub_local_costmap;
+ros::Publisher pub_local_plan;
+
+void callback_robot_stop(const std_msgs::Empty::ConstPtr& msg)
+{
+    std::cout << "LocalPlanner.->Stop signal received" << std::endl;
+    stop     = true;
+    new_path = false;
+}
+
+void callback_goal_path(const nav_msgs::Path::ConstPtr& msg)
+{
+    std::cout << "LocalPlanner.->New path received with " << msg->poses.size() << " points" << std::endl;
+    goal_path = *msg;
+    new_path = true;
+    stop     = false;
+}
+
+void callback_laser_scan(const sensor_msgs::LaserScan::ConstPtr& msg)
+{
+    laser_scan = *msg;
+    laser_time = ros::Time::now();
+}
+
+void callback_point_cloud(const sensor_msgs::PointCloud2::ConstPtr& msg)
+{
+    cloud_msg  = msg;
+    cloud_time = ros::Time::now();
+}
+
+void callback_odometry(const nav_msgs::Odometry::ConstPtr& msg)
+{
+    current_linear  = msg->twist.twist.linear.x;
+    current_angular = msg->twist.twist.angular.z;
+    if(current_linear != 0 || current_angular != 0 || msg->twist.twist.linear.y != 0)
+        odom_has_twist = true;
+    odom_time = ros::Time::now();
+}
+
+void prepare_path()
+{
+    int n = goal_path.poses.size();
+    path_x.resize(n);
+    path_y.resize(n);
+    path_s.resize(n);
+    for(int i=0; i < n; i++)
+    {
+        path_x[i] = goal_path.poses[i].pose.position.x;
+        path_y[i] = goal_path.poses[i].pose.position.y;
+        path_s[i] = i == 0 ? 0 : path_s[i-1] + sqrt((path_x[i]-path_x[i-1])*(path_x[i]-path_x[i-1]) + (path_y[i]-path_y[i-1])*(path_y[i]-path_y[i-1]));
+    }
+    closest_idx = 0;
+    std::cout << "LocalPlanner.->Following path of " << (n > 0 ? path_s[n-1] : 0) << " m" << std::endl;
+}
+
+void finish_path(bool goal_reached)
+{
+    std_msgs::Bool msg_goal_reached;
+    geometry_msgs::Twist zero_twist;
+    msg_goal_reached.data = goal_reached;
+    active = false;
+    current_linear  = 0;
+    current_angular = 0;
+    sub_cloud.shutdown();
+    cloud_msg.reset();
+    pub_cmd_vel.publish(zero_twist);
+    pub_goal_reached.publish(msg_goal_reached);
+}
+
+bool get_robot_position_wrt_map(tf::TransformListener& tf_listener, float& robot_x, float& robot_y, float& robot_t)
+{
+    tf::StampedTransform transform;
+    try
+    {
+        tf_listener.lookupTransform("map", "base_link", ros::Time(0), transform);
+    }
+    catch(...)
+    {
+        return false;
+    }
+    robot_x = transform.getOrigin().x();
+    robot_y = transform.getOrigin().y();
+    tf::Quaternion q = transform.getRotation();
+    robot_t = atan2((float)q.z(), (float)q.w()) * 2;
+    return true;
+}
+
+void update_closest_idx(float robot_x, float robot_y)
+{
+    int n = path_x.size();
+    float min_dist = (path_x[closest_idx]-robot_x)*(path_x[closest_idx]-robot_x) + (path_y[closest_idx]-robot_y)*(path_y[closest_idx]-robot_y);
+    int closest = closest_idx;
+    for(int i=closest_idx + 1; i < n && path_s[i] - path_s[closest_idx] < LP_CLOSEST_SEARCH_DIST; i++)
+    {
+        float dist = (path_x[i]-robot_x)*(path_x[i]-robot_x) + (path_y[i]-robot_y)*(path_y[i]-robot_y);
+        if(dist < min_dist)
+        {
+            min_dist = dist;
+            closest = i;
+        }
+    }
+    closest_idx = closest;
+}
+
+void add_point_cloud()
+{
+    if(cloud_msg == NULL || (ros::Time::now() - cloud_time).toSec() > LP_SENSOR_TIMEOUT)
+        return;
+    //Points are read directly from the message when possible
+    if(!JustinaTools::PointCloud2Msg_ToCvMatView(*cloud_msg, bgr_cloud, xyz_cloud, bgr_channel))
+    {
+        xyz_cloud.release();
+        JustinaTools::PointCloud2Msg_ToCvMat(cloud_msg, bgr_cloud, xyz_cloud);
+    }
+    //A view has a whole point per element, x,y,z are its first three floats
+    int stride = xyz_cloud.channels();
+    for(int i=0; i < xyz_cloud.rows; i++)
+    {
+        const float* p = xyz_cloud.ptr<float>(i);
+        for(int j=0; j < xyz_cloud.cols; j++, p+=stride)
+        {
+            if(!(p[2] > cloud_min_z && p[2] < cloud_max_z))
+                continue;
+            dwa.AddObstacle(p[0], p[1]);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    for(int i=0; i < argc; i++)
+    {
+        std::string str_param(argv[i]);
+        if(str_param.compare("--move_head") == 0)
+            move_head = true;
+    }
+    std::cout << "INITIALIZING LOCAL PLANNER (DYNAMIC WINDOW) NODE..." << std::endl;
+    ros::init(argc, argv, "local_planner");
+    ros::NodeHandle n;
+    pub_goal_reached    = n.advertise<std_msgs::Bool>("/navigation/goal_reached", 1);
+    pub_cmd_vel         = n.advertise<geometry_msgs::Twist>("/hardware/mobile_base/cmd_vel", 1);
+    pub_head            = n.advertise<std_msgs::Float32MultiArray>("/manipulation/manip_pln/hd_goto_angles", 1);
+    pub_collision_risk  = n.advertise<std_msgs::Bool>("/navigation/obs_avoid/collision_risk", 1);
+    pub_collision_point = n.advertise<geometry_msgs::PointStamped>("/navigation/obs_avoid/collision_point", 1);
+    pub_local_costmap   = n.advertise<nav_msgs::OccupancyGrid>("/navigation/path_planning/local_planner/local_costmap", 1);
+    pub_local_plan      = n.advertise<nav_msgs::Path>("/navigation/path_planning/local_planner/local_plan", 1);
+    ros::Subscriber sub_robot_stop = n.subscribe("/hardware/robot_state/stop", 1, callback_robot_stop);
+    ros::Subscriber sub_goal_path  = n.subscribe("/navigation/path_planning/local_planner/goal_path", 1, callback_goal_path);
+    ros::Subscriber sub_laser_scan = n.subscribe("/hardware/scan", 1, callback_laser_scan);
+    ros::Subscriber sub_odometry   = n.subscribe("/hardware/mobile_base/odometry", 1, callback_odometry);
+    tf::TransformListener tf_listener;
+
+    ros::NodeHandle n_private("~");
+    float costmap_size = 4.0;
+    float costmap_resolution = 0.05;
+    n_private.param<float>("max_linear_speed",  dwa.maxLinear, dwa.maxLinear);
+    n_private.param<float>("max_angular_speed", dwa.maxAngular, dwa.maxAngular);
+    n_private.param<float>("max_linear_accel",  dwa.maxLinearAccel, dwa.maxLinearAccel);
+    n_private.param<float>("max_angular_accel", dwa.maxAngularAccel, dwa.maxAngularAccel);
+    n_private.param<float>("sim_time",          dwa.simTime, dwa.simTime);
+    n_private.param<int>  ("linear_samples",    dwa.linearSamples, dwa.linearSamples);
+    n_private.param<int>  ("angular_samples",   dwa.angularSamples, dwa.angularSamples);
+    n_private.param<float>("robot_radius",      dwa.robotRadius, dwa.robotRadius);
+    n_private.param<float>("inflation_dist",    dwa.inflationDist, dwa.inflationDist);
+    n_private.param<float>("path_weight",       dwa.pathWeight, dwa.pathWeight);
+    n_private.param<float>("goal_weight",       dwa.goalWeight, dwa.goalWeight);
+    n_private.param<float>("heading_weight",    dwa.headingWeight, dwa.headingWeight);
+    n_private.param<float>("obstacle_weight",   dwa.obstacleWeight, dwa.obstacleWeight);
+    n_private.param<float>("speed_weight",      dwa.speedWeight, dwa.speedWeight);
+    n_private.param<float>("costmap_size",      costmap_size, costmap_size);
+    n_private.param<float>("costmap_resolution",costmap_resolution, costmap_resolution);
+    n_private.param<float>("lookahead_dist",    lookahead_dist, lookahead_dist);
+    n_private.param<float>("blocked_timeout",   blocked_timeout, blocked_timeout);
+    dwa.InitCostmap(costmap_size, costmap_resolution);
+    float max_linear = dwa.maxLinear;
+    //Local goal must be inside the rolling costmap
+    lookahead_dist = std::min(lookahead_dist, costmap_size/2 - dwa.robotRadius);
+    std::cout << "LocalPlanner.->Max speeds: " << dwa.maxLinear << " m/s, " << dwa.maxAngular << " rad/s. Costmap of ";
+    std::cout << costmap_size << " m with resolution " << costmap_resolution << std::endl;
+
+    ros::Rate loop(1.0 / dwa.controlPeriod);
+    try
+    {
+        tf_listener.waitForTransform("map", "base_link", ros::Time(0), ros::Duration(10.0));
+    }
+    catch(...)
+    {
+        std::cout << "LocalPlanner.->Cannot get tranforms for robot's pose calculation... :'(" << std::endl;
+        return -1;
+    }
+
+    float robot_x = 0;
+    float robot_y = 0;
+    float robot_t = 0;
+    float last_linear  = 0;
+    float last_angular = 0;
+    ros::Time last_admissible;
+    std::vector<float> local_x;
+    std::vector<float> local_y;
+    geometry_msgs::Twist twist;
+    std_msgs::Float32MultiArray msg_head;
+    msg_head.data.resize(2);
+
+    while(ros::ok())
+    {
+        if(stop)
+        {
+            stop = false;
+            if(active)
+                finish_path(false);
+        }
+        if(new_path)
+        {
+            new_path = false;
+            prepare_path();
+            if(path_x.size() == 0)
+                finish_path(true);
+            else
+            {
+                active = true;
+                last_linear  = 0;
+                last_angular = 0;
+                last_admissible = ros::Time::now();
+                sub_cloud = n.subscribe("/hardware/point_cloud_man/rgbd_wrt_robot_downsampled", 1, callback_point_cloud);
+            }
+        }
+        if(active && get_robot_position_wrt_map(tf_listener, robot_x, robot_y, robot_t))
+        {
+            int path_size = path_x.size();
+            update_closest_idx(robot_x, robot_y);
+            float goal_dx = path_x[path_size-1] - robot_x;
+            float goal_dy = path_y[path_size-1] - robot_y;
+            if(sqrt(goal_dx*goal_dx + goal_dy*goal_dy) < LP_GOAL_TOLERANCE)
+            {
+                std::cout << "LocalPlanner.->Path succesfully executed. (Y)" << std::endl;
+                finish_path(true);
+            }
+            else if((ros::Time::now() - laser_time).toSec() > LP_SENSOR_TIMEOUT)
+            {
+                std::cout << "LocalPlanner.->Laser scan is too old. Waiting for a new one before moving." << std::endl;
+                pub_cmd_vel.publish(geometry_msgs::Twist());
+                last_linear = 0;
+                last_angular = 0;
+            }
+            else
+            {
+                //Path from the closest point to the lookahead distance, wrt robot. Its last free point is the local goal.
+                float cos_t = cos(robot_t);
+                float sin_t = sin(robot_t);
+                local_x.clear();
+                local_y.clear();
+                for(int i=closest_idx; i < path_size && path_s[i] - path_s[closest_idx] <= lookahead_dist; i++)
+                {
+                    float dx = path_x[i] - robot_x;
+                    float dy = path_y[i] - robot_y;
+                    local_x.push_back( dx*cos_t + dy*sin_t);
+                    local_y.push_back(-dx*sin_t + dy*cos_t);
+                }
+                float goal_x, goal_y;
+
+                dwa.ClearObstacles();
+                dwa.AddLaserScan(laser_scan, laser_min_range, laser_max_range);
+                add_point_cloud();
+                dwa.SetPath(local_x, local_y);
+                dwa.UpdateCosts();
+                bool goal_valid = dwa.GetLocalGoal(goal_x, goal_y);
+                if(!goal_valid)
+                {
+                    goal_x = local_x.back();
+                    goal_y = local_y.back();
+                }
+
+                //Speed is limited to stop at the end of the path
+                float remaining = std::max(path_s[path_size-1] - path_s[closest_idx], (float)sqrt(goal_dx*goal_dx + goal_dy*goal_dy));
+                dwa.maxLinear = std::min(max_linear, std::max(0.05f, (float)sqrt(remaining*dwa.maxLinearAccel)));
+                //Measured speeds are used to center the dynamic window, the commanded ones if odometry
+                //is not received or does not report speeds
+                float linear  = last_linear;
+                float angular = last_angular;
+                if(odom_has_twist && (ros::Time::now() - odom_time).toSec() < LP_ODOMETRY_TIMEOUT)
+                {
+                    linear  = current_linear;
+                    angular = current_angular;
+                }
+                float goal_angle = atan2(goal_y, goal_x);
+                bool admissible;
+                if(goal_valid && fabs(goal_angle) > LP_ROTATE_IN_PLACE_ANGLE && linear < 0.05)
+                {
+                    //A round robot can always turn in place
+                    twist.linear.x  = 0;
+                    twist.angular.z = std::max(-dwa.maxAngular, std::min(dwa.maxAngular, goal_angle));
+                    admissible = true;
+                }
+                else
+                {
+                    float v, w;
+                    admissible = dwa.ComputeVelocities(linear, angular, v, w);
+                    twist.linear.x  = v;
+                    twist.angular.z = w;
+                    admissible = admissible && (v > 0.01 || fabs(w) > 0.01);
+                }
+                twist.linear.y = 0;
+                if(admissible)
+                    last_admissible = ros::Time::now();
+                last_linear  = twist.linear.x;
+                last_angular = twist.angular.z;
+                pub_cmd_vel.publish(twist);
+
+                if(!admissible && (ros::Time::now() - last_admissible).toSec() > blocked_timeout)
+                {
+                    //Path is blocked: the global planner is notified as if the obstacle detector had found it
+                    std::cout << "LocalPlanner.->No admissible trajectory for " << blocked_timeout << " s. Path is blocked." << std::endl;
+                    std_msgs::Bool msg_collision_risk;
+                    geometry_msgs::PointStamped msg_collision_point;
+                    msg_collision_point.header.frame_id = "base_link";
+                    msg_collision_point.header.stamp = ros::Time::now();
+                    float obs_x, obs_y;
+                    if(dwa.GetNearestObstacleInFront(obs_x, obs_y))
+                    {
+                        msg_collision_point.point.x = obs_x;
+                        msg_collision_point.point.y = obs_y;
+                    }
+                    msg_collision_risk.data = true;
+                    pub_collision_point.publish(msg_collision_point);
+                    pub_collision_risk.publish(msg_collision_risk);
+                    finish_path(false);
+                }
+                if(move_head)
+                {
+                    msg_head.data[0] = goal_angle;
+                    msg_head.data[1] = -0.9;
+                    pub_head.publish(msg_head);
+                }
+                if(pub_local_plan.getNumSubscribers() > 0)
+                    pub_local_plan.publish(dwa.GetBestTrajectory());
+                if(pub_local_costmap.getNumSubscribers() > 0)
+                    pub_local_costmap.publish(dwa.GetCostmap());
+            }
+        }
+        ros::spinOnce();
+        loop.sleep();
+    }
+    return 0;
+}
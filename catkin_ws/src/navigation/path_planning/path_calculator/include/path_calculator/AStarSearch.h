@@ -0,0 +1,67 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include "nav_msgs/OccupancyGrid.h"
+
+//Cost of moving to an orthogonal and to a diagonal neighbor. Costs are scaled by 10 to keep
+//integer arithmetic and still approximate sqrt(2) for diagonal moves (octile distance).
+#define ASTAR_STRAIGHT_COST 10
+#define ASTAR_DIAGONAL_COST 14
+
+//
+//A* search over an occupancy grid using an indexed binary min-heap as open list.
+//An object of this class keeps all its scratch buffers (g-values, parents, heap, etc) between
+//calls to Search, so, it is intended to live as long as the node does. Buffers are resized only
+//when a bigger map arrives and are never cleared completely: each search uses a new 'stamp'
+//and a cell is considered as not-yet-visited if its stamp is different from the current one.
+//
+class AStarSearch
+{
+public:
+    AStarSearch();
+    ~AStarSearch();
+
+    //Cells with values greater than 'occupiedThreshold' or unknown (negative) are not traversable.
+    //'extraCosts' can be null or must have map.data.size() elements. It is added (multiplied by
+    //ASTAR_STRAIGHT_COST) to the cost of entering each cell, e.g., nearness to obstacles.
+    bool Search(const nav_msgs::OccupancyGrid& map, const int* extraCosts, int startCell, int goalCell,
+                std::vector<int>& resultCells);
+    void SetEightConnectivity(bool eightConnectivity);
+    bool GetEightConnectivity();
+    //Restricts the search to the cells whose coarse cell (cellX/factor, cellY/factor) is not zero in 'coarseMask'.
+    //Mask is not copied, it must remain valid while searching. Use a null mask to search the whole map.
+    void SetCorridor(const unsigned char* coarseMask, int factor, int coarseWidth);
+    int GetLastExpandedCells();
+    int GetLastPathCost();
+
+    int occupiedThreshold;
+
+private:
+    bool eightConnectivity;
+    unsigned int currentStamp;
+    int lastExpandedCells;
+    int lastPathCost;
+    const unsigned char* corridorMask;
+    int corridorFactor;
+    int corridorWidth;
+
+    std::vector<int> g_values;
+    std::vector<int> f_values;
+    std::vector<int> previous;
+    std::vector<unsigned int> stamps;   //Stamp of the search in which the cell was reached for the last time
+    std::vector<bool> closed;           //Only meaningful if stamps[cell] == currentStamp
+    std::vector<int> heap;              //Open list. Binary min-heap of cell indices ordered by f_value
+    std::vector<int> heapPositions;     //Position of each cell in the heap, -1 if it is not in the open list
+
+    void prepareBuffers(size_t mapSize);
+    int heuristic(int cellX, int cellY, int goalX, int goalY);
+    bool isFree(const nav_msgs::OccupancyGrid& map, int cell);
+    bool lessThan(int cellA, int cellB);
+    void heapPush(int cell);
+    int heapPop();
+    void heapSiftUp(int pos);
+    void heapSiftDown(int pos);
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include "nav_msgs/OccupancyGrid.h"
+#include "path_calculator/AStarSearch.h"
+
+#define DSTAR_INFINITY (INT_MAX/4)
+
+//
+//D* Lite (Koenig & Likhachev, optimized version) over an occupancy grid.
+//Search goes backwards, from goal to start, thus, the search tree remains valid when the robot moves
+//and only the vertices affected by cells whose cost changed need to be repaired. The tree is kept
+//between calls to Plan while the goal and the map geometry remain the same.
+//Edge costs are the same as in AStarSearch: ASTAR_STRAIGHT_COST or ASTAR_DIAGONAL_COST plus
+//ASTAR_STRAIGHT_COST times the extra cost of the entered cell. Occupied cells cannot be entered nor left.
+//
+class DStarLite
+{
+public:
+    DStarLite();
+    ~DStarLite();
+
+    //Changed rectangle limits the cells compared against the last known costs. If minX < 0, the whole map is compared.
+    bool Plan(const nav_msgs::OccupancyGrid& map, const int* extraCosts, int startCell, int goalCell,
+              std::vector<int>& resultCells, int changedMinX = -1, int changedMinY = -1, int changedMaxX = -1, int changedMaxY = -1);
+    void Reset();
+    void SetEightConnectivity(bool eightConnectivity);
+    int GetLastExpandedCells();
+    int GetLastUpdatedCells();
+
+    int occupiedThreshold;
+
+private:
+    bool initialized;
+    bool eightConnectivity;
+    int width;
+    int height;
+    int goalCell;
+    int startCell;
+    int km;
+    int lastExpandedCells;
+    int lastUpdatedCells;
+
+    std::vector<int> cellCosts;     //Extra cost of entering each cell, -1 if it is occupied
+    std::vector<int> g_values;
+    std::vector<int> rhs_values;
+    std::vector<int> keys1;         //Keys of the cells in the open list
+    std::vector<int> keys2;
+    std::vector<int> heap;
+    std::vector<int> heapPositions; //-1 if cell is not in the open list
+    int dx[8];
+    int dy[8];
+
+    void initialize(const nav_msgs::OccupancyGrid& map, const int* extraCosts, int startCell, int goalCell);
+    int updateCosts(const nav_msgs::OccupancyGrid& map, const int* extraCosts, int minX, int minY, int maxX, int maxY);
+    void updateNeighborhood(int cell);
+    void computeShortestPath();
+    void updateVertex(int cell);
+    int bestSuccessorCost(int cell, int& bestSuccessor);
+    int cost(int fromCell, int toCell);
+    int heuristic(int cellA, int cellB);
+    void calculateKey(int cell, int& k1, int& k2);
+    bool keyLess(int a1, int a2, int b1, int b2);
+    bool heapLess(int cellA, int cellB);
+    void heapPush(int cell);
+    void heapRemove(int cell);
+    void heapUpdate(int cell);
+    void heapSiftUp(int pos);
+    void heapSiftDown(int pos);
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <boost/thread.hpp>
+#include "nav_msgs/OccupancyGrid.h"
+
+//
+//Exact euclidean distance transform of an occupancy grid in linear time (Felzenszwalb-Huttenlocher / Meijster).
+//First, each row is scanned forwards and backwards to get the distance to the nearest obstacle in the same row,
+//then, each column computes the lower envelope of the parabolas given by the row distances.
+//Rows and columns are independent, so, both passes are split in strips among several threads.
+//Resulting distances are given in meters from each cell to the nearest cell with value > occupiedThreshold.
+//
+class DistanceTransform
+{
+public:
+    static bool Compute(const nav_msgs::OccupancyGrid& map, std::vector<float>& resultDistances,
+                        int occupiedThreshold = 40, int numThreads = 0);
+
+private:
+    static void rowsPass(const nav_msgs::OccupancyGrid* map, float* squaredRowDist, int occupiedThreshold,
+                         int firstRow, int lastRow);
+    static void columnsPass(float* squaredRowDist, float* resultDistances, int width, int height, float resolution,
+                            int firstCol, int lastCol);
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include "nav_msgs/OccupancyGrid.h"
+#include "path_calculator/AStarSearch.h"
+
+//
+//Two-level planner for large maps. A coarse grid, where each cell summarizes a block of coarseFactor x coarseFactor
+//cells of the grown map, is built once per static map and updated only in the regions where the costs change.
+//A route is first found on the coarse grid and then refined by A* on the fine grid, restricted to a corridor of
+//corridorRadius coarse cells around the coarse route. Thus, CPU per plan depends on the path length instead of the
+//map area. If the refinement fails inside the corridor (coarse cells are optimistic: a block is traversable if any
+//of its cells is free), the corridor is widened once and then the whole map is searched.
+//
+class HierarchicalPlanner
+{
+public:
+    HierarchicalPlanner();
+    ~HierarchicalPlanner();
+
+    bool Build(const nav_msgs::OccupancyGrid& grownMap, const int* nearness);
+    bool Update(const nav_msgs::OccupancyGrid& grownMap, const int* nearness, int minX, int minY, int maxX, int maxY);
+    bool Plan(const nav_msgs::OccupancyGrid& grownMap, const int* nearness, int startCell, int goalCell,
+              std::vector<int>& resultCells);
+    bool IsBuilt();
+    void Reset();
+    void SetEightConnectivity(bool eightConnectivity);
+    int GetLastExpandedCells();
+
+    int coarseFactor;
+    int corridorRadius;
+
+private:
+    bool built;
+    int fineWidth;
+    int fineHeight;
+    int lastExpandedCells;
+    nav_msgs::OccupancyGrid coarseMap;
+    std::vector<int> coarseCosts;
+    std::vector<unsigned char> corridor;
+    std::vector<int> corridorCells;   //Coarse cells set in the corridor mask, used to clear it without a full pass
+    std::vector<int> coarseRoute;
+    AStarSearch coarseSearch;
+    AStarSearch fineSearch;
+
+    void updateCoarseCell(const nav_msgs::OccupancyGrid& grownMap, const int* nearness, int coarseX, int coarseY);
+    void markCorridor(int radius);
+    void clearCorridor();
+};
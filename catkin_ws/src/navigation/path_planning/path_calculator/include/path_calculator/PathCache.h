@@ -0,0 +1,62 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <map>
+#include <queue>
+#include <functional>
+#include "nav_msgs/OccupancyGrid.h"
+#include "path_calculator/AStarSearch.h"
+
+//
+//Cache of navigation functions towards a set of goal cells (usually, the known locations).
+//For each goal, a backwards Dijkstra over the static grown map stores, for every cell, the direction to the next
+//cell of the optimal path to that goal (one byte per cell). Thus, a path from any start cell to a cached goal is
+//obtained by following directions, in time proportional to the path length. Edge costs are the same as in AStarSearch.
+//Fields are calculated one by one with ComputeNext, so that the caller can do it while it is idle. Each call expands
+//at most a given number of cells, thus, a Dijkstra over a large map is spread over several calls.
+//Since dynamic obstacles only increase costs, a cached path is still optimal if none of its cells changed its cost.
+//GetPath checks this against the current costs and fails if the path is touched by obstacles.
+//
+class PathCache
+{
+public:
+    PathCache();
+    ~PathCache();
+
+    //Map and costs are copied. All fields are discarded and every goal must be calculated again.
+    void SetMap(const nav_msgs::OccupancyGrid& grownMap, const int* nearness);
+    //Fields of goals in the new set are kept. New goals are queued to be calculated by ComputeNext.
+    void SetGoals(const std::vector<int>& goalCells);
+    //Expands at most maxExpansions cells of the pending fields. Returns false if there is nothing left to calculate.
+    bool ComputeNext(int maxExpansions);
+    bool IsGoalReady(int goalCell);
+    int GetPendingGoals();
+    bool PositionToCell(float x, float y, int& cell);
+    bool GetPath(int startCell, int goalCell, const nav_msgs::OccupancyGrid& currentMap, const int* currentNearness,
+                 std::vector<int>& resultCells);
+    void Clear();
+    void SetEightConnectivity(bool eightConnectivity);
+
+    int occupiedThreshold;
+
+private:
+    bool eightConnectivity;
+    nav_msgs::OccupancyGrid map;
+    std::vector<int> extraCosts;
+    std::map<int, std::vector<unsigned char> > fields; //Direction to the next cell for each goal, 255 if goal is unreachable
+    std::vector<int> pendingGoals;
+    //State of the Dijkstra in progress, currentGoal is -1 if there is none
+    int currentGoal;
+    std::vector<unsigned char> currentField;
+    std::vector<int> costs;
+    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int> >, std::greater<std::pair<int, int> > > open;
+    int expandedCells;
+    int dx[8];
+    int dy[8];
+
+    void requeueGoals();
+    void cancelField();
+    void startField(int goalCell);
+    bool expandField(int maxExpansions);
+    bool isFree(int cell);
+};
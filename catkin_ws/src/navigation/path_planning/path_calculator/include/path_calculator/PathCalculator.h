@@ -0,0 +1,60 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include "ros/ros.h"
+#include "geometry_msgs/PoseStamped.h"
+#include "geometry_msgs/Pose.h"
+#include "nav_msgs/Path.h"
+#include "nav_msgs/OccupancyGrid.h"
+#include "path_calculator/AStarSearch.h"
+#include "path_calculator/DStarLite.h"
+#include "path_calculator/DistanceTransform.h"
+#include "path_calculator/HierarchicalPlanner.h"
+
+class PathCalculator
+{
+public:
+    PathCalculator();
+    ~PathCalculator();
+
+    static bool WaveFront(nav_msgs::OccupancyGrid& map, geometry_msgs::Pose& startPose, geometry_msgs::Pose& goalPose,
+                          nav_msgs::Path& resultPath);
+    static bool WaveFront(nav_msgs::OccupancyGrid& map, geometry_msgs::Pose& startPose, geometry_msgs::Pose& goalPose,
+                          int*& resulWaveFront);
+    static bool AStar(nav_msgs::OccupancyGrid& map, geometry_msgs::Pose& startPose, geometry_msgs::Pose& goalPose,
+                         nav_msgs::Path& resultPath);
+    static bool AStarOnGrownMap(const nav_msgs::OccupancyGrid& map, const int* nearnessToObstacles,
+                                geometry_msgs::Pose& startPose, geometry_msgs::Pose& goalPose, nav_msgs::Path& resultPath);
+    static bool DStarLiteFromMap(nav_msgs::OccupancyGrid& map, geometry_msgs::Pose& startPose, geometry_msgs::Pose& goalPose,
+                                 nav_msgs::Path& resultPath);
+    static bool DStarLiteOnGrownMap(const nav_msgs::OccupancyGrid& map, const int* nearnessToObstacles,
+                                    geometry_msgs::Pose& startPose, geometry_msgs::Pose& goalPose, nav_msgs::Path& resultPath,
+                                    int changedMinX = -1, int changedMinY = -1, int changedMaxX = -1, int changedMaxY = -1);
+    static bool HierarchicalOnGrownMap(const nav_msgs::OccupancyGrid& map, const int* nearnessToObstacles,
+                                       geometry_msgs::Pose& startPose, geometry_msgs::Pose& goalPose, nav_msgs::Path& resultPath,
+                                       int changedMinX = -1, int changedMinY = -1, int changedMaxX = -1, int changedMaxY = -1);
+    static void ResetIncremental();
+    static void CellsToPath(const nav_msgs::OccupancyGrid& map, std::vector<int>& cells, nav_msgs::Path& resultPath);
+    static bool GrowObstacles(nav_msgs::OccupancyGrid& map, float growDist);
+    static bool NearnessToObstacles(nav_msgs::OccupancyGrid& map, float distOfInfluence, int*& resultPotentials);
+    static bool GrowObstaclesAndNearness(nav_msgs::OccupancyGrid& map, float growDist, float distOfInfluence, int* resultPotentials);
+    static int NearnessValue(float distToObstacle, float resolution, float distOfInfluence);
+    static nav_msgs::Path SmoothPath(nav_msgs::Path& path, float weight_data = 0.1, float weight_smooth = 0.9, float tolerance = 0.00001);
+    static void SetEightConnectivity(bool eightConnectivity);
+
+private:
+    //A* engine and nearness buffer are kept between requests to avoid allocating full-map arrays in each call
+    static AStarSearch aStarSearch;
+    static DStarLite dStarLite;   //Keeps its search tree between calls with the same goal
+    static HierarchicalPlanner hierarchicalPlanner; //Keeps its coarse grid between calls with the same map
+    static std::vector<int> nearnessBuffer;
+    static std::vector<float> distanceBuffer; //Last calculated distance transform, shared by grow and nearness
+
+    static bool getStartAndGoalCells(const nav_msgs::OccupancyGrid& map, geometry_msgs::Pose& startPose,
+                                     geometry_msgs::Pose& goalPose, int& startCell, int& goalCell);
+    static bool applyDistances(nav_msgs::OccupancyGrid& map, float growDist, float distOfInfluence, int* resultPotentials);
+};
@@ -0,0 +1,261 @@
+#include "path_calculator/AStarSearch.h"
+
+AStarSearch::AStarSearch()
+{
+    this->occupiedThreshold = 40;
+    this->eightConnectivity = false;
+    this->currentStamp = 0;
+    this->lastExpandedCells = 0;
+    this->lastPathCost = 0;
+    this->corridorMask = 0;
+    this->corridorFactor = 1;
+    this->corridorWidth = 0;
+}
+
+AStarSearch::~AStarSearch()
+{
+}
+
+void AStarSearch::SetEightConnectivity(bool eightConnectivity)
+{
+    this->eightConnectivity = eightConnectivity;
+}
+
+bool AStarSearch::GetEightConnectivity()
+{
+    return this->eightConnectivity;
+}
+
+void AStarSearch::SetCorridor(const unsigned char* coarseMask, int factor, int coarseWidth)
+{
+    this->corridorMask = coarseMask;
+    this->corridorFactor = factor > 0 ? factor : 1;
+    this->corridorWidth = coarseWidth;
+}
+
+int AStarSearch::GetLastExpandedCells()
+{
+    return this->lastExpandedCells;
+}
+
+int AStarSearch::GetLastPathCost()
+{
+    return this->lastPathCost;
+}
+
+bool AStarSearch::Search(const nav_msgs::OccupancyGrid& map, const int* extraCosts, int startCell, int goalCell,
+                         std::vector<int>& resultCells)
+{
+    resultCells.clear();
+    this->lastExpandedCells = 0;
+    this->lastPathCost = 0;
+    int width  = map.info.width;
+    int height = map.info.height;
+    int mapSize = map.data.size();
+    if(width <= 0 || height <= 0 || width*height != mapSize)
+    {
+        std::cout << "AStarSearch.->Cannot search path: map has invalid dimensions." << std::endl;
+        return false;
+    }
+    if(startCell < 0 || startCell >= mapSize || goalCell < 0 || goalCell >= mapSize)
+    {
+        std::cout << "AStarSearch.->Cannot search path: start or goal cell is outside the map." << std::endl;
+        return false;
+    }
+    if(!isFree(map, startCell) || !isFree(map, goalCell))
+    {
+        std::cout << "AStarSearch.->Cannot search path: start or goal cell is not free." << std::endl;
+        return false;
+    }
+
+    prepareBuffers(mapSize);
+    int goalX = goalCell % width;
+    int goalY = goalCell / width;
+
+    //Offsets of the neighbors. First four are the 4-connectivity ones, next four are the diagonals.
+    //Diagonal i (i=4..7) can only be taken if both orthogonal neighbors diagOrth[i-4] are free (no corner cutting).
+    const int dx[8] = { 0, -1, 1, 0, -1,  1, -1, 1};
+    const int dy[8] = {-1,  0, 0, 1, -1, -1,  1, 1};
+    const int diagOrthA[4] = {0, 0, 3, 3};
+    const int diagOrthB[4] = {1, 2, 1, 2};
+    int numNeighbors = this->eightConnectivity ? 8 : 4;
+    bool orthFree[4];
+
+    this->stamps[startCell] = this->currentStamp;
+    this->g_values[startCell] = 0;
+    this->f_values[startCell] = heuristic(startCell % width, startCell / width, goalX, goalY);
+    this->previous[startCell] = -1;
+    this->closed[startCell] = false;
+    heapPush(startCell);
+
+    bool success = false;
+    while(!this->heap.empty())
+    {
+        int currentCell = heapPop();
+        this->closed[currentCell] = true;
+        this->lastExpandedCells++;
+        if(currentCell == goalCell)
+        {
+            success = true;
+            break;
+        }
+        int currentX = currentCell % width;
+        int currentY = currentCell / width;
+        for(int i=0; i < numNeighbors; i++)
+        {
+            int nX = currentX + dx[i];
+            int nY = currentY + dy[i];
+            bool valid = nX >= 0 && nX < width && nY >= 0 && nY < height;
+            int neighbor = nY*width + nX;
+            valid = valid && isFree(map, neighbor);
+            if(valid && this->corridorMask != 0)
+                valid = this->corridorMask[(nY/this->corridorFactor)*this->corridorWidth + nX/this->corridorFactor] != 0;
+            if(i < 4)
+                orthFree[i] = valid;
+            else
+                valid = valid && orthFree[diagOrthA[i-4]] && orthFree[diagOrthB[i-4]];
+            if(!valid)
+                continue;
+
+            bool reached = this->stamps[neighbor] == this->currentStamp;
+            if(reached && this->closed[neighbor])
+                continue;
+            //g_value is accumulated distance + nearness to obstacles
+            int g_value = this->g_values[currentCell] + (i < 4 ? ASTAR_STRAIGHT_COST : ASTAR_DIAGONAL_COST);
+            if(extraCosts != 0)
+                g_value += ASTAR_STRAIGHT_COST * extraCosts[neighbor];
+            if(reached && g_value >= this->g_values[neighbor])
+                continue;
+
+            this->g_values[neighbor] = g_value;
+            this->f_values[neighbor] = g_value + heuristic(nX, nY, goalX, goalY);
+            this->previous[neighbor] = currentCell;
+            if(!reached)
+            {
+                this->stamps[neighbor] = this->currentStamp;
+                this->closed[neighbor] = false;
+                heapPush(neighbor);
+            }
+            else
+                heapSiftUp(this->heapPositions[neighbor]);
+        }
+    }
+    //Cells remaining in the heap must be marked as out of the open list for the next search
+    for(size_t i=0; i < this->heap.size(); i++)
+        this->heapPositions[this->heap[i]] = -1;
+    this->heap.clear();
+
+    if(!success)
+        return false;
+
+    this->lastPathCost = this->g_values[goalCell];
+    for(int cell = goalCell; cell != -1; cell = this->previous[cell])
+        resultCells.push_back(cell);
+    for(size_t i=0, j=resultCells.size()-1; i < j; i++, j--)
+        std::swap(resultCells[i], resultCells[j]);
+    return true;
+}
+
+void AStarSearch::prepareBuffers(size_t mapSize)
+{
+    if(this->stamps.size() != mapSize)
+    {
+        this->g_values.resize(mapSize);
+        this->f_values.resize(mapSize);
+        this->previous.resize(mapSize);
+        this->closed.resize(mapSize);
+        this->stamps.assign(mapSize, 0);
+        this->heapPositions.assign(mapSize, -1);
+        this->heap.reserve(mapSize / 8);
+        this->currentStamp = 0;
+    }
+    //When the stamp counter overflows, all stamps are cleared to avoid false positives
+    if(++this->currentStamp == 0)
+    {
+        this->stamps.assign(mapSize, 0);
+        this->currentStamp = 1;
+    }
+}
+
+int AStarSearch::heuristic(int cellX, int cellY, int goalX, int goalY)
+{
+    int diffX = abs(cellX - goalX);
+    int diffY = abs(cellY - goalY);
+    if(!this->eightConnectivity) //Manhattan distance
+        return ASTAR_STRAIGHT_COST * (diffX + diffY);
+    //Octile distance
+    int minDiff = diffX < diffY ? diffX : diffY;
+    return ASTAR_STRAIGHT_COST * (diffX + diffY) + (ASTAR_DIAGONAL_COST - 2*ASTAR_STRAIGHT_COST) * minDiff;
+}
+
+bool AStarSearch::isFree(const nav_msgs::OccupancyGrid& map, int cell)
+{
+    return map.data[cell] >= 0 && map.data[cell] <= this->occupiedThreshold;
+}
+
+bool AStarSearch::lessThan(int cellA, int cellB)
+{
+    //Ties are broken in favor of the greatest g_value (the deepest cell) to expand less cells
+    if(this->f_values[cellA] != this->f_values[cellB])
+        return this->f_values[cellA] < this->f_values[cellB];
+    return this->g_values[cellA] > this->g_values[cellB];
+}
+
+void AStarSearch::heapPush(int cell)
+{
+    this->heap.push_back(cell);
+    this->heapPositions[cell] = this->heap.size() - 1;
+    heapSiftUp(this->heap.size() - 1);
+}
+
+int AStarSearch::heapPop()
+{
+    int top = this->heap[0];
+    this->heapPositions[top] = -1;
+    int last = this->heap.back();
+    this->heap.pop_back();
+    if(!this->heap.empty())
+    {
+        this->heap[0] = last;
+        this->heapPositions[last] = 0;
+        heapSiftDown(0);
+    }
+    return top;
+}
+
+void AStarSearch::heapSiftUp(int pos)
+{
+    int cell = this->heap[pos];
+    while(pos > 0)
+    {
+        int parent = (pos - 1) / 2;
+        if(!lessThan(cell, this->heap[parent]))
+            break;
+        this->heap[pos] = this->heap[parent];
+        this->heapPositions[this->heap[pos]] = pos;
+        pos = parent;
+    }
+    this->heap[pos] = cell;
+    this->heapPositions[cell] = pos;
+}
+
+void AStarSearch::heapSiftDown(int pos)
+{
+    int size = this->heap.size();
+    int cell = this->heap[pos];
+    while(true)
+    {
+        int child = 2*pos + 1;
+        if(child >= size)
+            break;
+        if(child + 1 < size && lessThan(this->heap[child + 1], this->heap[child]))
+            child++;
+        if(!lessThan(this->heap[child], cell))
+            break;
+        this->heap[pos] = this->heap[child];
+        this->heapPositions[this->heap[pos]] = pos;
+        pos = child;
+    }
+    this->heap[pos] = cell;
+    this->heapPositions[cell] = pos;
+}
@@ -0,0 +1,412 @@
+#include "path_calculator/DStarLite.h"
+
+DStarLite::DStarLite()
+{
+    this->occupiedThreshold = 40;
+    this->eightConnectivity = false;
+    this->initialized = false;
+    this->width = 0;
+    this->height = 0;
+    this->goalCell = -1;
+    this->startCell = -1;
+    this->km = 0;
+    this->lastExpandedCells = 0;
+    this->lastUpdatedCells = 0;
+    //First four neighbors are the 4-connectivity ones, next four are the diagonals
+    const int offsetsX[8] = { 0, -1, 1, 0, -1,  1, -1, 1};
+    const int offsetsY[8] = {-1,  0, 0, 1, -1, -1,  1, 1};
+    for(int i=0; i < 8; i++)
+    {
+        this->dx[i] = offsetsX[i];
+        this->dy[i] = offsetsY[i];
+    }
+}
+
+DStarLite::~DStarLite()
+{
+}
+
+void DStarLite::Reset()
+{
+    this->initialized = false;
+}
+
+void DStarLite::SetEightConnectivity(bool eightConnectivity)
+{
+    if(this->eightConnectivity != eightConnectivity)
+        this->initialized = false;
+    this->eightConnectivity = eightConnectivity;
+}
+
+int DStarLite::GetLastExpandedCells()
+{
+    return this->lastExpandedCells;
+}
+
+int DStarLite::GetLastUpdatedCells()
+{
+    return this->lastUpdatedCells;
+}
+
+bool DStarLite::Plan(const nav_msgs::OccupancyGrid& map, const int* extraCosts, int startCell, int goalCell,
+                     std::vector<int>& resultCells, int changedMinX, int changedMinY, int changedMaxX, int changedMaxY)
+{
+    resultCells.clear();
+    this->lastExpandedCells = 0;
+    this->lastUpdatedCells = 0;
+    int mapSize = map.data.size();
+    if(map.info.width <= 0 || map.info.height <= 0 || (int)(map.info.width*map.info.height) != mapSize)
+    {
+        std::cout << "DStarLite.->Cannot plan: map has invalid dimensions." << std::endl;
+        return false;
+    }
+    if(startCell < 0 || startCell >= mapSize || goalCell < 0 || goalCell >= mapSize)
+    {
+        std::cout << "DStarLite.->Cannot plan: start or goal cell is outside the map." << std::endl;
+        return false;
+    }
+
+    if(!this->initialized || goalCell != this->goalCell || (int)map.info.width != this->width ||
+       (int)map.info.height != this->height)
+    {
+        //New goal or new map geometry: the whole search tree must be built again
+        this->initialize(map, extraCosts, startCell, goalCell);
+    }
+    else
+    {
+        //The robot has moved, thus, keys already in the open list are corrected by km instead of being recalculated
+        this->km += this->heuristic(this->startCell, startCell);
+        this->startCell = startCell;
+        if(changedMinX < 0)
+        {
+            changedMinX = 0;
+            changedMinY = 0;
+            changedMaxX = this->width - 1;
+            changedMaxY = this->height - 1;
+        }
+        this->lastUpdatedCells = this->updateCosts(map, extraCosts, changedMinX, changedMinY, changedMaxX, changedMaxY);
+    }
+
+    if(this->cellCosts[startCell] < 0 || this->cellCosts[goalCell] < 0)
+    {
+        std::cout << "DStarLite.->Cannot plan: start or goal cell is not free." << std::endl;
+        return false;
+    }
+    this->computeShortestPath();
+    if(this->rhs_values[startCell] >= DSTAR_INFINITY)
+        return false;
+
+    //Path is obtained by following the successor with the minimum cost-to-goal
+    int current = startCell;
+    resultCells.push_back(current);
+    while(current != goalCell)
+    {
+        int next;
+        if(this->bestSuccessorCost(current, next) >= DSTAR_INFINITY || (int)resultCells.size() > mapSize)
+        {
+            resultCells.clear();
+            return false;
+        }
+        current = next;
+        resultCells.push_back(current);
+    }
+    return true;
+}
+
+void DStarLite::initialize(const nav_msgs::OccupancyGrid& map, const int* extraCosts, int startCell, int goalCell)
+{
+    this->width = map.info.width;
+    this->height = map.info.height;
+    this->goalCell = goalCell;
+    this->startCell = startCell;
+    this->km = 0;
+    size_t mapSize = map.data.size();
+    this->cellCosts.resize(mapSize);
+    for(size_t i=0; i < mapSize; i++)
+    {
+        bool occupied = map.data[i] < 0 || map.data[i] > this->occupiedThreshold;
+        this->cellCosts[i] = occupied ? -1 : (extraCosts != 0 ? extraCosts[i] : 0);
+    }
+    this->g_values.assign(mapSize, DSTAR_INFINITY);
+    this->rhs_values.assign(mapSize, DSTAR_INFINITY);
+    this->keys1.resize(mapSize);
+    this->keys2.resize(mapSize);
+    this->heapPositions.assign(mapSize, -1);
+    this->heap.clear();
+    this->rhs_values[goalCell] = 0;
+    this->calculateKey(goalCell, this->keys1[goalCell], this->keys2[goalCell]);
+    this->heapPush(goalCell);
+    this->initialized = true;
+}
+
+int DStarLite::updateCosts(const nav_msgs::OccupancyGrid& map, const int* extraCosts, int minX, int minY, int maxX, int maxY)
+{
+    minX = std::max(minX, 0);
+    minY = std::max(minY, 0);
+    maxX = std::min(maxX, this->width - 1);
+    maxY = std::min(maxY, this->height - 1);
+    int changed = 0;
+    for(int y = minY; y <= maxY; y++)
+        for(int x = minX; x <= maxX; x++)
+        {
+            int cell = y*this->width + x;
+            bool occupied = map.data[cell] < 0 || map.data[cell] > this->occupiedThreshold;
+            int newCost = occupied ? -1 : (extraCosts != 0 ? extraCosts[cell] : 0);
+            if(newCost == this->cellCosts[cell])
+                continue;
+            this->cellCosts[cell] = newCost;
+            this->updateNeighborhood(cell);
+            changed++;
+        }
+    return changed;
+}
+
+void DStarLite::updateNeighborhood(int cell)
+{
+    //A cell whose cost changes modifies the edges entering and leaving it and the diagonal edges
+    //cutting its corners. All of them start at the cell itself or at one of its eight neighbors.
+    int x = cell % this->width;
+    int y = cell / this->width;
+    if(cell != this->goalCell)
+    {
+        int best;
+        this->rhs_values[cell] = this->bestSuccessorCost(cell, best);
+        this->updateVertex(cell);
+    }
+    for(int i=0; i < 8; i++)
+    {
+        int nX = x + this->dx[i];
+        int nY = y + this->dy[i];
+        if(nX < 0 || nX >= this->width || nY < 0 || nY >= this->height)
+            continue;
+        int neighbor = nY*this->width + nX;
+        if(neighbor == this->goalCell)
+            continue;
+        int best;
+        this->rhs_values[neighbor] = this->bestSuccessorCost(neighbor, best);
+        this->updateVertex(neighbor);
+    }
+}
+
+void DStarLite::computeShortestPath()
+{
+    int numNeighbors = this->eightConnectivity ? 8 : 4;
+    int startK1, startK2;
+    this->calculateKey(this->startCell, startK1, startK2);
+    while(!this->heap.empty())
+    {
+        int u = this->heap[0];
+        if(!this->keyLess(this->keys1[u], this->keys2[u], startK1, startK2) &&
+           this->rhs_values[this->startCell] == this->g_values[this->startCell])
+            break;
+        this->lastExpandedCells++;
+        int newK1, newK2;
+        this->calculateKey(u, newK1, newK2);
+        int x = u % this->width;
+        int y = u / this->width;
+        if(this->keyLess(this->keys1[u], this->keys2[u], newK1, newK2))
+        {
+            this->keys1[u] = newK1;
+            this->keys2[u] = newK2;
+            this->heapUpdate(u);
+        }
+        else if(this->g_values[u] > this->rhs_values[u])
+        {
+            //Cell becomes consistent. Its predecessors can improve their rhs through it.
+            this->g_values[u] = this->rhs_values[u];
+            this->heapRemove(u);
+            for(int i=0; i < numNeighbors; i++)
+            {
+                int nX = x + this->dx[i];
+                int nY = y + this->dy[i];
+                if(nX < 0 || nX >= this->width || nY < 0 || nY >= this->height)
+                    continue;
+                int s = nY*this->width + nX;
+                int c = this->cost(s, u);
+                if(s == this->goalCell || c >= DSTAR_INFINITY)
+                    continue;
+                if(c + this->g_values[u] < this->rhs_values[s])
+                {
+                    this->rhs_values[s] = c + this->g_values[u];
+                    this->updateVertex(s);
+                }
+            }
+        }
+        else
+        {
+            //Cell was underconsistent (its cost increased). Predecessors that used it must look for another successor.
+            int g_old = this->g_values[u];
+            this->g_values[u] = DSTAR_INFINITY;
+            for(int i=0; i < numNeighbors; i++)
+            {
+                int nX = x + this->dx[i];
+                int nY = y + this->dy[i];
+                if(nX < 0 || nX >= this->width || nY < 0 || nY >= this->height)
+                    continue;
+                int s = nY*this->width + nX;
+                int c = this->cost(s, u);
+                if(s == this->goalCell || c >= DSTAR_INFINITY || this->rhs_values[s] != c + g_old)
+                    continue;
+                int best;
+                this->rhs_values[s] = this->bestSuccessorCost(s, best);
+                this->updateVertex(s);
+            }
+            if(u != this->goalCell)
+            {
+                int best;
+                this->rhs_values[u] = this->bestSuccessorCost(u, best);
+            }
+            this->updateVertex(u);
+        }
+        this->calculateKey(this->startCell, startK1, startK2);
+    }
+}
+
+void DStarLite::updateVertex(int cell)
+{
+    bool inHeap = this->heapPositions[cell] >= 0;
+    if(this->g_values[cell] != this->rhs_values[cell])
+    {
+        this->calculateKey(cell, this->keys1[cell], this->keys2[cell]);
+        if(inHeap)
+            this->heapUpdate(cell);
+        else
+            this->heapPush(cell);
+    }
+    else if(inHeap)
+        this->heapRemove(cell);
+}
+
+int DStarLite::bestSuccessorCost(int cell, int& bestSuccessor)
+{
+    int numNeighbors = this->eightConnectivity ? 8 : 4;
+    int x = cell % this->width;
+    int y = cell / this->width;
+    int best = DSTAR_INFINITY;
+    bestSuccessor = -1;
+    for(int i=0; i < numNeighbors; i++)
+    {
+        int nX = x + this->dx[i];
+        int nY = y + this->dy[i];
+        if(nX < 0 || nX >= this->width || nY < 0 || nY >= this->height)
+            continue;
+        int s = nY*this->width + nX;
+        int c = this->cost(cell, s);
+        if(c >= DSTAR_INFINITY || this->g_values[s] >= DSTAR_INFINITY)
+            continue;
+        if(c + this->g_values[s] < best)
+        {
+            best = c + this->g_values[s];
+            bestSuccessor = s;
+        }
+    }
+    return best;
+}
+
+int DStarLite::cost(int fromCell, int toCell)
+{
+    if(this->cellCosts[fromCell] < 0 || this->cellCosts[toCell] < 0)
+        return DSTAR_INFINITY;
+    int fromX = fromCell % this->width;
+    int fromY = fromCell / this->width;
+    int diffX = toCell % this->width - fromX;
+    int diffY = toCell / this->width - fromY;
+    if(diffX == 0 || diffY == 0)
+        return ASTAR_STRAIGHT_COST + ASTAR_STRAIGHT_COST * this->cellCosts[toCell];
+    //Diagonal moves are not allowed to cut the corner of an occupied cell
+    if(this->cellCosts[fromY*this->width + fromX + diffX] < 0 || this->cellCosts[(fromY + diffY)*this->width + fromX] < 0)
+        return DSTAR_INFINITY;
+    return ASTAR_DIAGONAL_COST + ASTAR_STRAIGHT_COST * this->cellCosts[toCell];
+}
+
+int DStarLite::heuristic(int cellA, int cellB)
+{
+    int diffX = abs(cellA % this->width - cellB % this->width);
+    int diffY = abs(cellA / this->width - cellB / this->width);
+    if(!this->eightConnectivity)
+        return ASTAR_STRAIGHT_COST * (diffX + diffY);
+    int minDiff = diffX < diffY ? diffX : diffY;
+    return ASTAR_STRAIGHT_COST * (diffX + diffY) + (ASTAR_DIAGONAL_COST - 2*ASTAR_STRAIGHT_COST) * minDiff;
+}
+
+void DStarLite::calculateKey(int cell, int& k1, int& k2)
+{
+    k2 = std::min(this->g_values[cell], this->rhs_values[cell]);
+    k1 = k2 >= DSTAR_INFINITY ? DSTAR_INFINITY : k2 + this->heuristic(this->startCell, cell) + this->km;
+}
+
+bool DStarLite::keyLess(int a1, int a2, int b1, int b2)
+{
+    return a1 < b1 || (a1 == b1 && a2 < b2);
+}
+
+bool DStarLite::heapLess(int cellA, int cellB)
+{
+    return this->keyLess(this->keys1[cellA], this->keys2[cellA], this->keys1[cellB], this->keys2[cellB]);
+}
+
+void DStarLite::heapPush(int cell)
+{
+    this->heap.push_back(cell);
+    this->heapPositions[cell] = this->heap.size() - 1;
+    this->heapSiftUp(this->heap.size() - 1);
+}
+
+void DStarLite::heapRemove(int cell)
+{
+    int pos = this->heapPositions[cell];
+    if(pos < 0)
+        return;
+    this->heapPositions[cell] = -1;
+    int last = this->heap.back();
+    this->heap.pop_back();
+    if(pos >= (int)this->heap.size())
+        return;
+    this->heap[pos] = last;
+    this->heapPositions[last] = pos;
+    this->heapSiftUp(pos);
+    this->heapSiftDown(this->heapPositions[last]);
+}
+
+void DStarLite::heapUpdate(int cell)
+{
+    this->heapSiftUp(this->heapPositions[cell]);
+    this->heapSiftDown(this->heapPositions[cell]);
+}
+
+void DStarLite::heapSiftUp(int pos)
+{
+    int cell = this->heap[pos];
+    while(pos > 0)
+    {
+        int parent = (pos - 1) / 2;
+        if(!this->heapLess(cell, this->heap[parent]))
+            break;
+        this->heap[pos] = this->heap[parent];
+        this->heapPositions[this->heap[pos]] = pos;
+        pos = parent;
+    }
+    this->heap[pos] = cell;
+    this->heapPositions[cell] = pos;
+}
+
+void DStarLite::heapSiftDown(int pos)
+{
+    int size = this->heap.size();
+    int cell = this->heap[pos];
+    while(true)
+    {
+        int child = 2*pos + 1;
+        if(child >= size)
+            break;
+        if(child + 1 < size && this->heapLess(this->heap[child + 1], this->heap[child]))
+            child++;
+        if(!this->heapLess(this->heap[child], cell))
+            break;
+        this->heap[pos] = this->heap[child];
+        this->heapPositions[this->heap[pos]] = pos;
+        pos = child;
+    }
+    this->heap[pos] = cell;
+    this->heapPositions[cell] = pos;
+}
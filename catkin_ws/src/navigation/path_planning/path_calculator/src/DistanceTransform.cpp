@@ -0,0 +1,114 @@
+#include "path_calculator/DistanceTransform.h"
+
+bool DistanceTransform::Compute(const nav_msgs::OccupancyGrid& map, std::vector<float>& resultDistances,
+                                int occupiedThreshold, int numThreads)
+{
+    int width  = map.info.width;
+    int height = map.info.height;
+    if(width <= 0 || height <= 0 || (size_t)(width*height) != map.data.size())
+    {
+        std::cout << "DistanceTransform.->Cannot compute distance transform: map has invalid dimensions." << std::endl;
+        return false;
+    }
+    if(numThreads <= 0)
+        numThreads = boost::thread::hardware_concurrency();
+    if(numThreads <= 0)
+        numThreads = 1;
+    //It is not worth to launch a thread for a few rows
+    if(numThreads > height / 64) numThreads = height / 64;
+    if(numThreads < 1) numThreads = 1;
+
+    resultDistances.resize(map.data.size());
+    std::vector<float> squaredRowDist(map.data.size());
+
+    //
+    //First pass: squared distance to the nearest obstacle in the same row
+    boost::thread_group threads;
+    int rowsPerThread = (height + numThreads - 1) / numThreads;
+    for(int i=1; i < numThreads; i++)
+        threads.create_thread(boost::bind(&DistanceTransform::rowsPass, &map, &squaredRowDist[0], occupiedThreshold,
+                                          i*rowsPerThread, std::min((i+1)*rowsPerThread, height)));
+    DistanceTransform::rowsPass(&map, &squaredRowDist[0], occupiedThreshold, 0, std::min(rowsPerThread, height));
+    threads.join_all();
+
+    //
+    //Second pass: lower envelope of parabolas along each column
+    int colsPerThread = (width + numThreads - 1) / numThreads;
+    for(int i=1; i < numThreads; i++)
+        threads.create_thread(boost::bind(&DistanceTransform::columnsPass, &squaredRowDist[0], &resultDistances[0],
+                                          width, height, map.info.resolution,
+                                          std::min(i*colsPerThread, width), std::min((i+1)*colsPerThread, width)));
+    DistanceTransform::columnsPass(&squaredRowDist[0], &resultDistances[0], width, height, map.info.resolution,
+                                   0, std::min(colsPerThread, width));
+    threads.join_all();
+    return true;
+}
+
+void DistanceTransform::rowsPass(const nav_msgs::OccupancyGrid* map, float* squaredRowDist, int occupiedThreshold,
+                                 int firstRow, int lastRow)
+{
+    int width  = map->info.width;
+    //A distance greater than any possible distance inside the map is used as infinity. A finite value
+    //is required to compute intersections of parabolas in the second pass without overflow.
+    int infinity = map->info.width + map->info.height;
+    for(int row = firstRow; row < lastRow; row++)
+    {
+        const int8_t* data = &map->data[row*width];
+        float* rowDist = squaredRowDist + row*width;
+        //Forward scan: distance to the nearest obstacle at the left
+        int dist = infinity;
+        for(int i=0; i < width; i++)
+        {
+            dist = data[i] > occupiedThreshold ? 0 : std::min(dist + 1, infinity);
+            rowDist[i] = dist;
+        }
+        //Backward scan: distance to the nearest obstacle at the right
+        dist = infinity;
+        for(int i=width-1; i >= 0; i--)
+        {
+            dist = rowDist[i] == 0 ? 0 : std::min(dist + 1, infinity);
+            if(dist < rowDist[i])
+                rowDist[i] = dist;
+            rowDist[i] *= rowDist[i];
+        }
+    }
+}
+
+void DistanceTransform::columnsPass(float* squaredRowDist, float* resultDistances, int width, int height, float resolution,
+                                    int firstCol, int lastCol)
+{
+    std::vector<double> f(height);    //Squared row distances of the current column
+    std::vector<int> v(height);       //Locations of the parabolas in the lower envelope
+    std::vector<double> z(height + 1);//Boundaries between parabolas
+    for(int col = firstCol; col < lastCol; col++)
+    {
+        for(int i=0; i < height; i++)
+            f[i] = squaredRowDist[i*width + col];
+
+        int k = 0;
+        v[0] = 0;
+        z[0] = -1e20;
+        z[1] =  1e20;
+        for(int q=1; q < height; q++)
+        {
+            double s = ((f[q] + q*q) - (f[v[k]] + v[k]*v[k])) / (2.0*q - 2.0*v[k]);
+            while(s <= z[k])
+            {
+                k--;
+                s = ((f[q] + q*q) - (f[v[k]] + v[k]*v[k])) / (2.0*q - 2.0*v[k]);
+            }
+            k++;
+            v[k] = q;
+            z[k] = s;
+            z[k+1] = 1e20;
+        }
+        k = 0;
+        for(int q=0; q < height; q++)
+        {
+            while(z[k+1] < q)
+                k++;
+            double d = (q - v[k])*(q - v[k]) + f[v[k]];
+            resultDistances[q*width + col] = std::sqrt(d) * resolution;
+        }
+    }
+}
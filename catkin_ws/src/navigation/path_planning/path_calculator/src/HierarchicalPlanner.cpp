@@ -0,0 +1,174 @@
+#include "path_calculator/HierarchicalPlanner.h"
+
+HierarchicalPlanner::HierarchicalPlanner()
+{
+    this->coarseFactor = 8;
+    this->corridorRadius = 2;
+    this->built = false;
+    this->fineWidth = 0;
+    this->fineHeight = 0;
+    this->lastExpandedCells = 0;
+}
+
+HierarchicalPlanner::~HierarchicalPlanner()
+{
+}
+
+bool HierarchicalPlanner::IsBuilt()
+{
+    return this->built;
+}
+
+void HierarchicalPlanner::Reset()
+{
+    this->built = false;
+}
+
+void HierarchicalPlanner::SetEightConnectivity(bool eightConnectivity)
+{
+    this->coarseSearch.SetEightConnectivity(eightConnectivity);
+    this->fineSearch.SetEightConnectivity(eightConnectivity);
+}
+
+int HierarchicalPlanner::GetLastExpandedCells()
+{
+    return this->lastExpandedCells;
+}
+
+bool HierarchicalPlanner::Build(const nav_msgs::OccupancyGrid& grownMap, const int* nearness)
+{
+    this->built = false;
+    if(this->coarseFactor < 1 || grownMap.info.width == 0 || grownMap.info.height == 0 ||
+       grownMap.info.width*grownMap.info.height != grownMap.data.size())
+    {
+        std::cout << "HierarchicalPlanner.->Cannot build coarse grid: invalid map or coarse factor." << std::endl;
+        return false;
+    }
+    this->fineWidth = grownMap.info.width;
+    this->fineHeight = grownMap.info.height;
+    this->coarseMap.info = grownMap.info;
+    this->coarseMap.info.resolution = grownMap.info.resolution * this->coarseFactor;
+    this->coarseMap.info.width  = (this->fineWidth  + this->coarseFactor - 1) / this->coarseFactor;
+    this->coarseMap.info.height = (this->fineHeight + this->coarseFactor - 1) / this->coarseFactor;
+    int coarseSize = this->coarseMap.info.width * this->coarseMap.info.height;
+    this->coarseMap.data.resize(coarseSize);
+    this->coarseCosts.resize(coarseSize);
+    this->corridor.assign(coarseSize, 0);
+    this->corridorCells.clear();
+    for(int y=0; y < (int)this->coarseMap.info.height; y++)
+        for(int x=0; x < (int)this->coarseMap.info.width; x++)
+            this->updateCoarseCell(grownMap, nearness, x, y);
+    this->built = true;
+    std::cout << "HierarchicalPlanner.->Coarse grid of " << this->coarseMap.info.width << "x" << this->coarseMap.info.height;
+    std::cout << " cells built." << std::endl;
+    return true;
+}
+
+bool HierarchicalPlanner::Update(const nav_msgs::OccupancyGrid& grownMap, const int* nearness, int minX, int minY, int maxX, int maxY)
+{
+    if(!this->built || (int)grownMap.info.width != this->fineWidth || (int)grownMap.info.height != this->fineHeight)
+        return this->Build(grownMap, nearness);
+    if(maxX < minX || maxY < minY)
+        return true;
+    int coarseMaxX = std::min(maxX / this->coarseFactor, (int)this->coarseMap.info.width - 1);
+    int coarseMaxY = std::min(maxY / this->coarseFactor, (int)this->coarseMap.info.height - 1);
+    for(int y = std::max(minY, 0) / this->coarseFactor; y <= coarseMaxY; y++)
+        for(int x = std::max(minX, 0) / this->coarseFactor; x <= coarseMaxX; x++)
+            this->updateCoarseCell(grownMap, nearness, x, y);
+    return true;
+}
+
+bool HierarchicalPlanner::Plan(const nav_msgs::OccupancyGrid& grownMap, const int* nearness, int startCell, int goalCell,
+                               std::vector<int>& resultCells)
+{
+    resultCells.clear();
+    this->lastExpandedCells = 0;
+    if(!this->built || (int)grownMap.info.width != this->fineWidth || (int)grownMap.info.height != this->fineHeight)
+    {
+        std::cout << "HierarchicalPlanner.->Cannot plan: coarse grid has not been built for this map." << std::endl;
+        return false;
+    }
+    int coarseWidth = this->coarseMap.info.width;
+    int coarseStart = (startCell / this->fineWidth / this->coarseFactor) * coarseWidth + (startCell % this->fineWidth) / this->coarseFactor;
+    int coarseGoal  = (goalCell  / this->fineWidth / this->coarseFactor) * coarseWidth + (goalCell  % this->fineWidth) / this->coarseFactor;
+
+    //
+    //Coarse route. If it cannot be found, the fine search is done over the whole map.
+    bool coarseSuccess = this->coarseSearch.Search(this->coarseMap, &this->coarseCosts[0], coarseStart, coarseGoal, this->coarseRoute);
+    this->lastExpandedCells += this->coarseSearch.GetLastExpandedCells();
+    if(coarseSuccess)
+    {
+        //Refinement inside the corridor, widened once if the corridor is too narrow
+        for(int attempt = 0; attempt < 2; attempt++)
+        {
+            this->markCorridor(this->corridorRadius * (attempt + 1));
+            this->fineSearch.SetCorridor(&this->corridor[0], this->coarseFactor, coarseWidth);
+            bool success = this->fineSearch.Search(grownMap, nearness, startCell, goalCell, resultCells);
+            this->lastExpandedCells += this->fineSearch.GetLastExpandedCells();
+            this->fineSearch.SetCorridor(0, 1, 0);
+            this->clearCorridor();
+            if(success)
+                return true;
+        }
+        std::cout << "HierarchicalPlanner.->Cannot refine coarse route. Searching the whole map." << std::endl;
+    }
+    else
+        std::cout << "HierarchicalPlanner.->Cannot find a coarse route. Searching the whole map." << std::endl;
+    bool success = this->fineSearch.Search(grownMap, nearness, startCell, goalCell, resultCells);
+    this->lastExpandedCells += this->fineSearch.GetLastExpandedCells();
+    return success;
+}
+
+void HierarchicalPlanner::updateCoarseCell(const nav_msgs::OccupancyGrid& grownMap, const int* nearness, int coarseX, int coarseY)
+{
+    //A coarse cell is free if any of its fine cells is free. Its cost is the mean nearness of its free cells
+    //plus a penalty proportional to the fraction of occupied cells, so that routes prefer open blocks.
+    int firstX = coarseX * this->coarseFactor;
+    int firstY = coarseY * this->coarseFactor;
+    int lastX = std::min(firstX + this->coarseFactor, this->fineWidth);
+    int lastY = std::min(firstY + this->coarseFactor, this->fineHeight);
+    int freeCells = 0;
+    int totalCells = 0;
+    int nearnessSum = 0;
+    for(int y = firstY; y < lastY; y++)
+        for(int x = firstX; x < lastX; x++)
+        {
+            int idx = y*this->fineWidth + x;
+            totalCells++;
+            if(grownMap.data[idx] < 0 || grownMap.data[idx] > this->fineSearch.occupiedThreshold)
+                continue;
+            freeCells++;
+            if(nearness != 0)
+                nearnessSum += nearness[idx];
+        }
+    int coarseIdx = coarseY * this->coarseMap.info.width + coarseX;
+    this->coarseMap.data[coarseIdx] = freeCells > 0 ? 0 : 100;
+    this->coarseCosts[coarseIdx] = freeCells > 0 ? nearnessSum/freeCells + (4*(totalCells - freeCells))/totalCells : 0;
+}
+
+void HierarchicalPlanner::markCorridor(int radius)
+{
+    int coarseWidth  = this->coarseMap.info.width;
+    int coarseHeight = this->coarseMap.info.height;
+    for(size_t i=0; i < this->coarseRoute.size(); i++)
+    {
+        int cX = this->coarseRoute[i] % coarseWidth;
+        int cY = this->coarseRoute[i] / coarseWidth;
+        for(int y = std::max(cY - radius, 0); y <= std::min(cY + radius, coarseHeight - 1); y++)
+            for(int x = std::max(cX - radius, 0); x <= std::min(cX + radius, coarseWidth - 1); x++)
+            {
+                int idx = y*coarseWidth + x;
+                if(this->corridor[idx] != 0)
+                    continue;
+                this->corridor[idx] = 1;
+                this->corridorCells.push_back(idx);
+            }
+    }
+}
+
+void HierarchicalPlanner::clearCorridor()
+{
+    for(size_t i=0; i < this->corridorCells.size(); i++)
+        this->corridor[this->corridorCells[i]] = 0;
+    this->corridorCells.clear();
+}
@@ -0,0 +1,228 @@
+#include "path_calculator/PathCache.h"
+
+#define PATH_CACHE_NO_DIRECTION 255
+
+PathCache::PathCache()
+{
+    this->occupiedThreshold = 40;
+    this->eightConnectivity = false;
+    this->currentGoal = -1;
+    this->expandedCells = 0;
+    //Same neighbor order as AStarSearch: four orthogonal neighbors, then four diagonals
+    const int offsetsX[8] = { 0, -1, 1, 0, -1,  1, -1, 1};
+    const int offsetsY[8] = {-1,  0, 0, 1, -1, -1,  1, 1};
+    for(int i=0; i < 8; i++)
+    {
+        this->dx[i] = offsetsX[i];
+        this->dy[i] = offsetsY[i];
+    }
+}
+
+PathCache::~PathCache()
+{
+}
+
+void PathCache::SetMap(const nav_msgs::OccupancyGrid& grownMap, const int* nearness)
+{
+    this->map = grownMap;
+    if(nearness != 0)
+        this->extraCosts.assign(nearness, nearness + grownMap.data.size());
+    else
+        this->extraCosts.assign(grownMap.data.size(), 0);
+    //Fields of the previous map are no longer valid, but goals must be calculated again on the new one
+    this->requeueGoals();
+}
+
+void PathCache::SetGoals(const std::vector<int>& goalCells)
+{
+    std::map<int, std::vector<unsigned char> > keptFields;
+    std::vector<int> newPending;
+    for(size_t i=0; i < goalCells.size(); i++)
+    {
+        if(goalCells[i] < 0 || goalCells[i] >= (int)this->map.data.size() || keptFields.count(goalCells[i]) > 0)
+            continue;
+        std::map<int, std::vector<unsigned char> >::iterator it = this->fields.find(goalCells[i]);
+        if(it != this->fields.end())
+            keptFields[goalCells[i]].swap(it->second);
+        else if(goalCells[i] != this->currentGoal &&
+                std::find(newPending.begin(), newPending.end(), goalCells[i]) == newPending.end())
+            newPending.push_back(goalCells[i]);
+    }
+    //Field in progress goes on only if its goal is still required
+    if(this->currentGoal >= 0 && std::find(goalCells.begin(), goalCells.end(), this->currentGoal) == goalCells.end())
+        this->cancelField();
+    this->fields.swap(keptFields);
+    this->pendingGoals.swap(newPending);
+}
+
+bool PathCache::ComputeNext(int maxExpansions)
+{
+    while(this->currentGoal < 0)
+    {
+        if(this->pendingGoals.empty())
+            return false;
+        int goalCell = this->pendingGoals.back();
+        this->pendingGoals.pop_back();
+        if(goalCell < (int)this->map.data.size() && this->isFree(goalCell))
+            this->startField(goalCell);
+        else
+            std::cout << "PathCache.->Goal cell " << goalCell << " is not free. It will not be cached." << std::endl;
+    }
+    if(this->expandField(maxExpansions))
+    {
+        std::cout << "PathCache.->Navigation function to cell " << this->currentGoal << " calculated. Expanded cells: " << this->expandedCells << std::endl;
+        this->fields[this->currentGoal].swap(this->currentField);
+        this->cancelField();
+    }
+    return true;
+}
+
+bool PathCache::IsGoalReady(int goalCell)
+{
+    return this->fields.find(goalCell) != this->fields.end();
+}
+
+int PathCache::GetPendingGoals()
+{
+    return this->pendingGoals.size() + (this->currentGoal >= 0 ? 1 : 0);
+}
+
+bool PathCache::PositionToCell(float x, float y, int& cell)
+{
+    //No map has been set yet
+    if(this->map.info.resolution <= 0 || this->map.data.empty())
+        return false;
+    int cellX = (int)((x - this->map.info.origin.position.x)/this->map.info.resolution);
+    int cellY = (int)((y - this->map.info.origin.position.y)/this->map.info.resolution);
+    if(cellX < 0 || cellX >= (int)this->map.info.width || cellY < 0 || cellY >= (int)this->map.info.height)
+        return false;
+    cell = cellY*this->map.info.width + cellX;
+    return true;
+}
+
+bool PathCache::GetPath(int startCell, int goalCell, const nav_msgs::OccupancyGrid& currentMap, const int* currentNearness,
+                        std::vector<int>& resultCells)
+{
+    resultCells.clear();
+    std::map<int, std::vector<unsigned char> >::iterator it = this->fields.find(goalCell);
+    if(it == this->fields.end() || currentMap.data.size() != this->map.data.size() ||
+       startCell < 0 || startCell >= (int)this->map.data.size())
+        return false;
+    std::vector<unsigned char>& field = it->second;
+    int width = this->map.info.width;
+    int cell = startCell;
+    //Path can never be longer than the number of cells, this bound only protects against a corrupted field
+    for(size_t steps = 0; steps < field.size(); steps++)
+    {
+        if(currentMap.data[cell] != this->map.data[cell] ||
+           (currentNearness != 0 && currentNearness[cell] != this->extraCosts[cell]))
+        {
+            resultCells.clear();
+            return false;
+        }
+        resultCells.push_back(cell);
+        if(cell == goalCell)
+            return true;
+        if(field[cell] == PATH_CACHE_NO_DIRECTION)
+            break;
+        cell += this->dy[field[cell]]*width + this->dx[field[cell]];
+    }
+    resultCells.clear();
+    return false;
+}
+
+void PathCache::Clear()
+{
+    this->cancelField();
+    this->fields.clear();
+    this->pendingGoals.clear();
+}
+
+void PathCache::SetEightConnectivity(bool eightConnectivity)
+{
+    if(this->eightConnectivity == eightConnectivity)
+        return;
+    this->eightConnectivity = eightConnectivity;
+    //Fields calculated with the other connectivity are no longer optimal
+    this->requeueGoals();
+}
+
+void PathCache::requeueGoals()
+{
+    if(this->currentGoal >= 0)
+        this->pendingGoals.push_back(this->currentGoal);
+    this->cancelField();
+    for(std::map<int, std::vector<unsigned char> >::iterator it = this->fields.begin(); it != this->fields.end(); ++it)
+        if(std::find(this->pendingGoals.begin(), this->pendingGoals.end(), it->first) == this->pendingGoals.end())
+            this->pendingGoals.push_back(it->first);
+    this->fields.clear();
+}
+
+void PathCache::cancelField()
+{
+    this->currentGoal = -1;
+    this->open = std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int> >, std::greater<std::pair<int, int> > >();
+}
+
+void PathCache::startField(int goalCell)
+{
+    //Dijkstra from the goal. Cost of moving from a cell to the expanded one is the cost of entering the expanded cell,
+    //thus, costs are the same as the ones of a forward search. Open list uses lazy deletion.
+    int mapSize = this->map.data.size();
+    this->currentGoal = goalCell;
+    this->currentField.assign(mapSize, PATH_CACHE_NO_DIRECTION);
+    this->costs.assign(mapSize, INT_MAX);
+    this->costs[goalCell] = 0;
+    this->open.push(std::make_pair(0, goalCell));
+    this->expandedCells = 0;
+}
+
+//Returns true when the field is complete
+bool PathCache::expandField(int maxExpansions)
+{
+    int width  = this->map.info.width;
+    int height = this->map.info.height;
+    const int diagOrthA[4] = {0, 0, 3, 3};
+    const int diagOrthB[4] = {1, 2, 1, 2};
+    int numNeighbors = this->eightConnectivity ? 8 : 4;
+    bool orthFree[4];
+    std::vector<unsigned char>& field = this->currentField;
+    for(int expansions = 0; !this->open.empty() && expansions < maxExpansions; )
+    {
+        int currentCost = this->open.top().first;
+        int currentCell = this->open.top().second;
+        this->open.pop();
+        if(currentCost > this->costs[currentCell])
+            continue;
+        expansions++;
+        this->expandedCells++;
+        int enterCost = ASTAR_STRAIGHT_COST * this->extraCosts[currentCell];
+        int currentX = currentCell % width;
+        int currentY = currentCell / width;
+        for(int i=0; i < numNeighbors; i++)
+        {
+            int nX = currentX + this->dx[i];
+            int nY = currentY + this->dy[i];
+            int neighbor = nY*width + nX;
+            bool valid = nX >= 0 && nX < width && nY >= 0 && nY < height && this->isFree(neighbor);
+            if(i < 4)
+                orthFree[i] = valid;
+            else
+                valid = valid && orthFree[diagOrthA[i-4]] && orthFree[diagOrthB[i-4]];
+            if(!valid)
+                continue;
+            int cost = currentCost + (i < 4 ? ASTAR_STRAIGHT_COST : ASTAR_DIAGONAL_COST) + enterCost;
+            if(cost >= this->costs[neighbor])
+                continue;
+            this->costs[neighbor] = cost;
+            field[neighbor] = i < 4 ? 3 - i : 11 - i; //Opposite offset: from the neighbor back to the current cell
+            this->open.push(std::make_pair(cost, neighbor));
+        }
+    }
+    return this->open.empty();
+}
+
+bool PathCache::isFree(int cell)
+{
+    return this->map.data[cell] >= 0 && this->map.data[cell] <= this->occupiedThreshold;
+}
@@ -1,4 +1,10 @@
-#include "PathCalculator.h"
+#include "path_calculator/PathCalculator.h"
+
+AStarSearch PathCalculator::aStarSearch;
+DStarLite PathCalculator::dStarLite;
+HierarchicalPlanner PathCalculator::hierarchicalPlanner;
+std::vector<int> PathCalculator::nearnessBuffer;
+std::vector<float> PathCalculator::distanceBuffer;
 
 bool PathCalculator::WaveFront(nav_msgs::OccupancyGrid& map, geometry_msgs::Pose& startPose, geometry_msgs::Pose& goalPose,
                                nav_msgs::Path& resultPath)
@@ -16,7 +22,7 @@ bool PathCalculator::WaveFront(nav_msgs::OccupancyGrid& map, geometry_msgs::Pose
     int goalCell = goalCellY * map.info.width + goalCellX;
 
     //First, we grow the map the half the diameter of the robot
-    map = PathCalculator::GrowObstacles(map, 0.25);
+    PathCalculator::GrowObstacles(map, 0.25);
     
     //Cells in req.map have values in [0,100]. 0 are the completely free cells and 100 are the occupied ones.
     /*Cells are uint8 values, but, since map could be really big, wave_front can assign
@@ -176,212 +182,181 @@ bool PathCalculator::WaveFront(nav_msgs::OccupancyGrid& map, geometry_msgs::Pose
 bool PathCalculator::AStar(nav_msgs::OccupancyGrid& map, geometry_msgs::Pose& startPose, geometry_msgs::Pose& goalPose,
                          nav_msgs::Path& resultPath)
 {
-    //HAY UN MEGABUG EN ESTE ALGORITMO PORQUE NO ESTOY TOMANDO EN CUENTA QUE EN LOS BORDES DEL
-    //MAPA NO SE PUEDE APLICAR CONECTIVIDAD CUATRO NI OCHO. FALTA RESTRINGIR EL RECORRIDO A LOS BORDES MENOS UNO.
-    //POR AHORA FUNCIONA XQ CONFÍO EN QUE EL MAPA ES MUCHO MÁS GRANDE QUE EL ÁREA REAL DE NAVEGACIÓN
-    std::cout << "PathCalculator.-> Calculating by A* from " << startPose.position.x << "  ";
-    std::cout << startPose.position.y << "  to " << goalPose.position.x << "  " << goalPose.position.y << std::endl;
-    int startCellX = (int)((startPose.position.x - map.info.origin.position.x)/map.info.resolution);
-    int startCellY = (int)((startPose.position.y - map.info.origin.position.y)/map.info.resolution);
-    int goalCellX = (int)((goalPose.position.x - map.info.origin.position.x)/map.info.resolution);
-    int goalCellY = (int)((goalPose.position.y - map.info.origin.position.y)/map.info.resolution);
-    int startCell = startCellY * map.info.width + startCellX;
-    int goalCell = goalCellY * map.info.width + goalCellX;
-
-    map = PathCalculator::GrowObstacles(map, 0.15);
-    
-    if(map.data[goalCell] > 40 || map.data[goalCell] < 0)
+    //Map is grown and nearness to obstacles is calculated with the same distance transform
+    PathCalculator::nearnessBuffer.resize(map.data.size());
+    int* nearnessToObstacles = &PathCalculator::nearnessBuffer[0];
+    if(!PathCalculator::GrowObstaclesAndNearness(map, 0.15, 0.6, nearnessToObstacles))
     {
-        std::cout << "PathCalculator.-> Cannot calculate path: goal point is inside occupied space" << std::endl;
+        std::cout << "PathCalculator.->Cannot calculate nearness to obstacles u.u" << std::endl;
         return false;
     }
-    if(map.data[startCell] > 40 || map.data[startCell] < 0)
+    return PathCalculator::AStarOnGrownMap(map, nearnessToObstacles, startPose, goalPose, resultPath);
+}
+
+bool PathCalculator::DStarLiteFromMap(nav_msgs::OccupancyGrid& map, geometry_msgs::Pose& startPose, geometry_msgs::Pose& goalPose,
+                                      nav_msgs::Path& resultPath)
+{
+    //Same growth and nearness as A*, but the search tree is kept if the goal is the same as in the last call
+    PathCalculator::nearnessBuffer.resize(map.data.size());
+    int* nearnessToObstacles = &PathCalculator::nearnessBuffer[0];
+    if(!PathCalculator::GrowObstaclesAndNearness(map, 0.15, 0.6, nearnessToObstacles))
     {
-        std::cout << "PathCalculator.-> Cannot calculate path: start point is inside occupied space" << std::endl;
+        std::cout << "PathCalculator.->Cannot calculate nearness to obstacles u.u" << std::endl;
         return false;
     }
+    return PathCalculator::DStarLiteOnGrownMap(map, nearnessToObstacles, startPose, goalPose, resultPath);
+}
 
-    //std::cout << "Creating arrays for dijkstra data" << std::endl;
-    bool* isKnown = new bool[map.data.size()];
-    int* g_values = new int[map.data.size()];
-    int* f_values = new int[map.data.size()];
-    int* previous = new int[map.data.size()];
-    bool* visited = new bool[map.data.size()];
-    int* neighbors = new int[map.data.size()];
-    int* waveFrontPotentials = new int[map.data.size()];
-    int* nearnessToObstacles = new int[map.data.size()];
-    std::vector<int> visitedAndNotKnown;
-    
-    int currentCell = startCell;
+bool PathCalculator::AStarOnGrownMap(const nav_msgs::OccupancyGrid& map, const int* nearnessToObstacles,
+                                     geometry_msgs::Pose& startPose, geometry_msgs::Pose& goalPose, nav_msgs::Path& resultPath)
+{
+    //Map must be already grown, e.g., by GrowObstaclesAndNearness or by a cached costmap
+    std::cout << "PathCalculator.-> Calculating by A* from " << startPose.position.x << "  ";
+    std::cout << startPose.position.y << "  to " << goalPose.position.x << "  " << goalPose.position.y << std::endl;
+    int startCell, goalCell;
+    if(!PathCalculator::getStartAndGoalCells(map, startPose, goalPose, startCell, goalCell))
+        return false;
 
-    //std::cout << "Initializing aux arrays for dijkstra" << std::endl;
-    //std::cout << "Map data size: " << map.data.size() << std::endl;
-    
-    if(!PathCalculator::NearnessToObstacles(map, 0.6, nearnessToObstacles))
+    std::vector<int> pathCells;
+    if(!PathCalculator::aStarSearch.Search(map, nearnessToObstacles, startCell, goalCell, pathCells))
     {
-        std::cout << "PathCalculator.->Cannot calculate nearness to obstacles u.u" << std::endl;
+        std::cout << "PathCalculator.-> Cannot find path to goal point by A* :'(" << std::endl;
         return false;
     }
+    //std::cout << "PathCalculator.->A* expanded " << PathCalculator::aStarSearch.GetLastExpandedCells() << " cells" << std::endl;
+    PathCalculator::CellsToPath(map, pathCells, resultPath);
+    std::cout << "PathCalculator.->Resulting path by A* has " << resultPath.poses.size() << " points." << std::endl;
+    return true;
+}
 
-    for(int i=0; i< map.data.size(); i++)
-    {
-        isKnown[i] = map.data[i] > 40 || map.data[i] < 0;
-        g_values[i] = INT_MAX;
-        f_values[i] = INT_MAX;
-        previous[i] = -1;
-        visited[i] = map.data[i] > 40 || map.data[i] < 0;
-    }
-    for(int i=0; i< 8; i++)
-        neighbors[i] = 0;
+bool PathCalculator::DStarLiteOnGrownMap(const nav_msgs::OccupancyGrid& map, const int* nearnessToObstacles,
+                                         geometry_msgs::Pose& startPose, geometry_msgs::Pose& goalPose, nav_msgs::Path& resultPath,
+                                         int changedMinX, int changedMinY, int changedMaxX, int changedMaxY)
+{
+    //Search tree is kept between calls with the same goal and map size. Only cells inside the given rectangle
+    //are compared against the last known costs. A negative rectangle means the whole map must be compared.
+    std::cout << "PathCalculator.-> Calculating by D* Lite from " << startPose.position.x << "  ";
+    std::cout << startPose.position.y << "  to " << goalPose.position.x << "  " << goalPose.position.y << std::endl;
+    int startCell, goalCell;
+    if(!PathCalculator::getStartAndGoalCells(map, startPose, goalPose, startCell, goalCell))
+        return false;
 
-    //std::cout << "First acc dist: " << accDist[0] << std::endl;
-    //std::cout << "Setting start node.." << std::endl;
-    isKnown[currentCell] = true;
-    g_values[currentCell] = 0;
-    bool fail = false;
-    int attempts = 0;
-    //std::cout << "Starting search.." << std::endl;
-    //std::cout << "GoalCellX: " << goalCellX << " GoalCellY: " << goalCellY << std::endl;
-    while(currentCell != goalCell && !fail && attempts < map.data.size())
+    std::vector<int> pathCells;
+    if(!PathCalculator::dStarLite.Plan(map, nearnessToObstacles, startCell, goalCell, pathCells,
+                                       changedMinX, changedMinY, changedMaxX, changedMaxY))
     {
-        //std::cout << "Current cell: " << currentCell << std::endl;
-        //4-connectivity
-        neighbors[0] = currentCell - map.info.width;
-        neighbors[1] = currentCell - 1;
-        neighbors[2] = currentCell + 1;
-        neighbors[3] = currentCell + map.info.width;
-        //8-connectivity
-        //neighbors[4] = currentCell - map.info.width - 1;
-        //neighbors[5] = currentCell - map.info.width + 1;
-        //neighbors[6] = currentCell + map.info.width - 1;
-        //neighbors[7] = currentCell + map.info.width + 1;
-        //for (int i=0; i< 8; i++)
-        for(int i=0; i<4; i++) //Only check neighbors with 4-connectivity
-        {
-            if(isKnown[neighbors[i]]) continue;
-            //g_value is accumulated distance + nearness to obstacles
-            int g_value = g_values[currentCell] + 1 + nearnessToObstacles[neighbors[i]]; 
-            //h_value is the manhattan distance from the cell to the goal
-            int h_value = abs((neighbors[i]%map.info.width) - goalCellX) + abs((neighbors[i]/map.info.width) - goalCellY);
-            //std::cout<<"n:"<<neighbors[i]<<" nX: "<<neighborX<<" nY: "<<neighborY<<" g: "<<g_value<<" h: "<<h_value<<" f: "<<(h_value+g_value)<< std::endl;
-            if(g_value < g_values[neighbors[i]])
-            {
-                //std::cout << "Assigning acc dist " << tempDist << " to cell: " << neighbors[i] << std::endl;
-                g_values[neighbors[i]] = g_value;
-                f_values[neighbors[i]] = g_value + h_value;
-                previous[neighbors[i]] = currentCell;
-            }
-            if(!visited[neighbors[i]])
-                visitedAndNotKnown.push_back(neighbors[i]);
-            visited[neighbors[i]] = true;
-        }
-        int min_f_value_idx = -1;
-        int min_f_value = std::numeric_limits<int>::max();
-        //std::cout << "Acc distances: ";
-        for(int i=0; i< visitedAndNotKnown.size(); i++)
-        {
-            //std::cout << visitedAndNotKnown[i] << ":" <<  accDist[visitedAndNotKnown[i]] << "  ";
-            if(f_values[visitedAndNotKnown[i]] < min_f_value)
-            {
-                min_f_value_idx = i;
-                min_f_value = f_values[visitedAndNotKnown[i]];
-            }
-        }
-        //std::cout << std::endl;
-        if(min_f_value_idx >= 0)
-        {
-            currentCell = visitedAndNotKnown[min_f_value_idx];
-            isKnown[currentCell] = true;
-            //std::cout << "New current cell: " << currentCell << std::endl;
-            visitedAndNotKnown.erase(visitedAndNotKnown.begin() + min_f_value_idx);
-        }
-        else fail = true;
-        
-        attempts++;
+        std::cout << "PathCalculator.-> Cannot find path to goal point by D* Lite :'(" << std::endl;
+        return false;
     }
-    //std::cout << "PathCalculator.->A* finished after " << attempts << " attempts" << std::endl;
-    if(fail)
+    PathCalculator::CellsToPath(map, pathCells, resultPath);
+    std::cout << "PathCalculator.->Resulting path by D* Lite has " << resultPath.poses.size() << " points. ";
+    std::cout << "Updated cells: " << PathCalculator::dStarLite.GetLastUpdatedCells() << ". Expanded cells: ";
+    std::cout << PathCalculator::dStarLite.GetLastExpandedCells() << std::endl;
+    return true;
+}
+
+bool PathCalculator::HierarchicalOnGrownMap(const nav_msgs::OccupancyGrid& map, const int* nearnessToObstacles,
+                                            geometry_msgs::Pose& startPose, geometry_msgs::Pose& goalPose, nav_msgs::Path& resultPath,
+                                            int changedMinX, int changedMinY, int changedMaxX, int changedMaxY)
+{
+    //Coarse grid is kept between calls and only the coarse cells inside the given rectangle are recalculated.
+    //A negative rectangle means the whole coarse grid must be rebuilt.
+    std::cout << "PathCalculator.-> Calculating by hierarchical A* from " << startPose.position.x << "  ";
+    std::cout << startPose.position.y << "  to " << goalPose.position.x << "  " << goalPose.position.y << std::endl;
+    int startCell, goalCell;
+    if(!PathCalculator::getStartAndGoalCells(map, startPose, goalPose, startCell, goalCell))
+        return false;
+
+    bool coarseReady;
+    if(changedMinX < 0)
+        coarseReady = PathCalculator::hierarchicalPlanner.Build(map, nearnessToObstacles);
+    else
+        coarseReady = PathCalculator::hierarchicalPlanner.Update(map, nearnessToObstacles, changedMinX, changedMinY,
+                                                                 changedMaxX, changedMaxY);
+    std::vector<int> pathCells;
+    if(!coarseReady || !PathCalculator::hierarchicalPlanner.Plan(map, nearnessToObstacles, startCell, goalCell, pathCells))
     {
-        std::cout << "PathCalculator.-> Cannot find path to goal point by A* :'(" << std::endl;
+        std::cout << "PathCalculator.-> Cannot find path to goal point by hierarchical A* :'(" << std::endl;
         return false;
     }
-    //std::cout << "PathCalculator.->Total path cost: " << g_values[goalCell] << std::endl;
+    PathCalculator::CellsToPath(map, pathCells, resultPath);
+    std::cout << "PathCalculator.->Resulting path by hierarchical A* has " << resultPath.poses.size() << " points. ";
+    std::cout << "Expanded cells: " << PathCalculator::hierarchicalPlanner.GetLastExpandedCells() << std::endl;
+    return true;
+}
 
+void PathCalculator::ResetIncremental()
+{
+    PathCalculator::dStarLite.Reset();
+    PathCalculator::hierarchicalPlanner.Reset();
+}
+
+void PathCalculator::CellsToPath(const nav_msgs::OccupancyGrid& map, std::vector<int>& cells, nav_msgs::Path& resultPath)
+{
     geometry_msgs::PoseStamped p;
-    currentCell = goalCell;
-    p.pose.position.x = (currentCell % map.info.width)*map.info.resolution + map.info.origin.position.x;
-    p.pose.position.y = (currentCell / map.info.width)*map.info.resolution + map.info.origin.position.y;
     p.pose.orientation.w = 1;
     p.header.frame_id = "map";
     resultPath.header.frame_id = "map";
-    resultPath.poses.clear();
-    resultPath.poses.push_back(p);
-
-    while(previous[currentCell] != -1)
+    resultPath.poses.resize(cells.size());
+    for(size_t i=0; i < cells.size(); i++)
     {
-        currentCell = previous[currentCell];
-        p.pose.position.x = (currentCell % map.info.width)*map.info.resolution + map.info.origin.position.x;
-        p.pose.position.y = (currentCell / map.info.width)*map.info.resolution + map.info.origin.position.y;
-        resultPath.poses.insert(resultPath.poses.begin(), p);
+        p.pose.position.x = (cells[i] % map.info.width)*map.info.resolution + map.info.origin.position.x;
+        p.pose.position.y = (cells[i] / map.info.width)*map.info.resolution + map.info.origin.position.y;
+        resultPath.poses[i] = p;
     }
+}
 
-    delete[] isKnown;
-    delete[] g_values;
-    delete[] f_values;
-    delete[] previous;
-    delete[] neighbors;
-    delete[] visited;
+bool PathCalculator::getStartAndGoalCells(const nav_msgs::OccupancyGrid& map, geometry_msgs::Pose& startPose,
+                                          geometry_msgs::Pose& goalPose, int& startCell, int& goalCell)
+{
+    int startCellX = (int)((startPose.position.x - map.info.origin.position.x)/map.info.resolution);
+    int startCellY = (int)((startPose.position.y - map.info.origin.position.y)/map.info.resolution);
+    int goalCellX = (int)((goalPose.position.x - map.info.origin.position.x)/map.info.resolution);
+    int goalCellY = (int)((goalPose.position.y - map.info.origin.position.y)/map.info.resolution);
+    if(startCellX < 0 || startCellX >= (int)map.info.width || startCellY < 0 || startCellY >= (int)map.info.height ||
+       goalCellX  < 0 || goalCellX  >= (int)map.info.width || goalCellY  < 0 || goalCellY  >= (int)map.info.height)
+    {
+        std::cout << "PathCalculator.-> Cannot calculate path: start or goal point is outside the map" << std::endl;
+        return false;
+    }
+    startCell = startCellY * map.info.width + startCellX;
+    goalCell = goalCellY * map.info.width + goalCellX;
 
-    std::cout << "PathCalculator.->Resulting path by A* has " << resultPath.poses.size() << " points." << std::endl;
+    if(map.data[goalCell] > 40 || map.data[goalCell] < 0)
+    {
+        std::cout << "PathCalculator.-> Cannot calculate path: goal point is inside occupied space" << std::endl;
+        return false;
+    }
+    if(map.data[startCell] > 40 || map.data[startCell] < 0)
+    {
+        std::cout << "PathCalculator.-> Cannot calculate path: start point is inside occupied space" << std::endl;
+        return false;
+    }
     return true;
 }
 
-nav_msgs::OccupancyGrid PathCalculator::GrowObstacles(nav_msgs::OccupancyGrid& map, float growDist)
+void PathCalculator::SetEightConnectivity(bool eightConnectivity)
 {
-    //HAY UN MEGABUG EN ESTE ALGORITMO PORQUE NO ESTOY TOMANDO EN CUENTA QUE EN LOS BORDES DEL
-    //MAPA NO SE PUEDE APLICAR CONECTIVIDAD CUATRO NI OCHO. FALTA RESTRINGIR EL RECORRIDO A LOS BORDES MENOS UNO.
-    //POR AHORA FUNCIONA XQ CONFÍO EN QUE EL MAPA ES MUCHO MÁS GRANDE QUE EL ÁREA REAL DE NAVEGACIÓN
+    PathCalculator::aStarSearch.SetEightConnectivity(eightConnectivity);
+    PathCalculator::dStarLite.SetEightConnectivity(eightConnectivity);
+    PathCalculator::hierarchicalPlanner.SetEightConnectivity(eightConnectivity);
+}
+
+bool PathCalculator::GrowObstacles(nav_msgs::OccupancyGrid& map, float growDist)
+{
+    //Obstacles are grown in place using the distance transform, thus, the grown region is a circle of radius
+    //growDist around each occupied cell and the cost does not depend on the growth distance.
     if(growDist <= 0)
     {
         std::cout << "PathCalculator.->Cannot grow map. Grow dist must be greater than zero." << std::endl;
-        return map;
+        return false;
     }
-    nav_msgs::OccupancyGrid newMap = map;
-    
-    int growSteps = (int)(growDist / map.info.resolution);
-    int boxSize = (2*growSteps + 1) * (2*growSteps + 1);
-    int* neighbors = new int[boxSize];
-    int counter = 0;
-
-    //std::cout << "PathCalculator.->Growing map " << growSteps << " steps" << std::endl;
-    for(int i=-growSteps; i<=growSteps; i++)
-        for(int j=-growSteps; j<=growSteps; j++)
-        {
-            neighbors[counter] = j*map.info.width + i;
-            counter++;
-        }
-    /*
-    std::cout << "Calculation of neighbors finished: " << std::endl;
-    for(int i=0; i <boxSize; i++)
-        std::cout << neighbors[i] << std::endl;
-    */
-    int startIdx = growSteps*map.info.width + growSteps;
-    int endIdx = map.data.size() - growSteps*map.info.width - growSteps;
-
-    if(endIdx <= 0)
+    if(!DistanceTransform::Compute(map, PathCalculator::distanceBuffer))
     {
-        std::cout << "PathCalculator.->Cannot grow map. Map is smaller than desired growth." << std::endl;
-        return map;
+        std::cout << "PathCalculator.->Cannot grow map. Distance transform failed." << std::endl;
+        return false;
     }
-
-    for(int i=startIdx; i < endIdx; i++)
-        if(map.data[i] > 40) //Then, is an occupied cell
-            for(int j=0; j < boxSize; j++) //If it is occupied, mark as occupied all neighbors in the neighbor-box
-                newMap.data[i+neighbors[j]] = 100;
-
-    delete[] neighbors;
-    //std::cout << "PathCalculator.->Map-growth finished." << std::endl;
-    return newMap;
+    return PathCalculator::applyDistances(map, growDist, -1, 0);
 }
 
 bool PathCalculator::NearnessToObstacles(nav_msgs::OccupancyGrid& map, float distOfInfluence, int*& resultPotentials)
@@ -399,55 +374,67 @@ bool PathCalculator::NearnessToObstacles(nav_msgs::OccupancyGrid& map, float dis
     if(distOfInfluence < 0)
     {
         std::cout << "PathCalculator.->Cannot calc brushfire. DistOfIncluence must be greater than zero." << std::endl;
+        return false;
     }
     if(resultPotentials == 0)
     {
         std::cout << "PathCalculator.->Cannot calc brushfire. 'resultPotentials' param must be not null." << std::endl;
         return false;
     }
-    
-    int steps = (int)(distOfInfluence / map.info.resolution);
-    //std::cout << "PathCalculator.->Calculating nearness with " << steps << " steps. " << std::endl;
-    
-    int boxSize = (steps*2 + 1) * (steps*2 + 1);
-    int* distances = new int[boxSize];
-    int* neighbors = new int[boxSize];
-    int startIdx = steps*map.info.width + steps;
-    int endIdx = map.data.size() - steps*map.info.width - steps;
-    if(endIdx <= 0)
+    if(!DistanceTransform::Compute(map, PathCalculator::distanceBuffer))
     {
-        std::cout << "PathCalculator.->Cannot calc brushfire. There is an error in index calculation. Sorry." << std::endl;
+        std::cout << "PathCalculator.->Cannot calc brushfire. Distance transform failed." << std::endl;
         return false;
     }
-    int counter = 0;
-    for(int i=-steps; i<=steps; i++)
-        for(int j=-steps; j<=steps; j++)
-        {
-            neighbors[counter] = i*map.info.width + j;
-            distances[counter] = (steps - std::max(std::abs(i), std::abs(j)) + 1)/2; //Use value/2 just for getting a smaller value
-            counter++;
-        }
-
-    //std::cout << "Nearness values to be used: " << std::endl;
-    //for(int i=0; i < boxSize; i++)
-    //    std::cout << distances[i] << " ";
-    //std::cout << std::endl;
+    return PathCalculator::applyDistances(map, 0, distOfInfluence, resultPotentials);
+}
 
-    for(int i=0; i < map.data.size(); i++)
-        resultPotentials[i] = 0;
-    
-    for(int i=startIdx; i < endIdx; i++)
-        if(map.data[i] > 40)
-            for(int j = 0; j < boxSize; j++)
-                if(resultPotentials[i+neighbors[j]] < distances[j])
-                    resultPotentials[i+neighbors[j]] = distances[j];
+bool PathCalculator::GrowObstaclesAndNearness(nav_msgs::OccupancyGrid& map, float growDist, float distOfInfluence,
+                                              int* resultPotentials)
+{
+    //Both, the grown map and the nearness to obstacles, are obtained from the same distance transform.
+    //Nearness is measured from the border of the grown obstacles, as if it were calculated over the grown map.
+    if(growDist < 0 || distOfInfluence < 0 || resultPotentials == 0)
+    {
+        std::cout << "PathCalculator.->Cannot grow map and calc nearness. Invalid parameters." << std::endl;
+        return false;
+    }
+    if(!DistanceTransform::Compute(map, PathCalculator::distanceBuffer))
+    {
+        std::cout << "PathCalculator.->Cannot grow map and calc nearness. Distance transform failed." << std::endl;
+        return false;
+    }
+    return PathCalculator::applyDistances(map, growDist, distOfInfluence, resultPotentials);
+}
 
-    delete[] distances;
-    delete[] neighbors;
-    //std::cout << "PathCalculator.->Finished, calculation of nearness to obstacles :D" << std::endl;
+bool PathCalculator::applyDistances(nav_msgs::OccupancyGrid& map, float growDist, float distOfInfluence, int* resultPotentials)
+{
+    //Uses the last calculated distance transform to mark as occupied all cells nearer than growDist and,
+    //if resultPotentials is not null, to assign nearness values that decrease linearly with the distance
+    //to the grown obstacles. Nearness values are the same as with the old box-based brushfire: (steps - d + 1)/2
+    if(PathCalculator::distanceBuffer.size() != map.data.size())
+        return false;
+    float resolution = map.info.resolution;
+    const float* distances = &PathCalculator::distanceBuffer[0];
+    for(size_t i=0; i < map.data.size(); i++)
+    {
+        float dist = distances[i] - growDist;
+        if(dist <= 0 && growDist > 0)
+            map.data[i] = 100;
+        if(resultPotentials == 0)
+            continue;
+        resultPotentials[i] = PathCalculator::NearnessValue(dist, resolution, distOfInfluence);
+    }
     return true;
 }
 
+int PathCalculator::NearnessValue(float distToObstacle, float resolution, float distOfInfluence)
+{
+    float cells = distToObstacle / resolution;
+    float steps = distOfInfluence / resolution;
+    return cells <= steps ? (int)(steps - cells + 1) / 2 : 0;
+}
+
 nav_msgs::Path PathCalculator::SmoothPath(nav_msgs::Path& path, float weight_data, float weight_smooth, float tolerance)
 {
     nav_msgs::Path newPath;
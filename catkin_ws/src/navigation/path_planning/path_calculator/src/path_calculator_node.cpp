@@ -7,7 +7,7 @@
 #include "geometry_msgs/PoseStamped.h"
 #include "nav_msgs/Path.h"
 #include "tf/tf.h"
-#include "PathCalculator.h"
+#include "path_calculator/PathCalculator.h"
 
 bool callbackWaveFrontFromMap(navig_msgs::PathFromMap::Request &req, navig_msgs::PathFromMap::Response &resp)
 {
@@ -24,13 +24,35 @@ bool callbackAStarFromMap(navig_msgs::PathFromMap::Request &req, navig_msgs::Pat
     return success;
 }
 
+bool callbackDStarLiteFromMap(navig_msgs::PathFromMap::Request &req, navig_msgs::PathFromMap::Response &resp)
+{
+    bool success = PathCalculator::DStarLiteFromMap(req.map, req.start_pose, req.goal_pose, resp.path);
+    if(success)
+    {
+        resp.path = PathCalculator::SmoothPath(resp.path);
+    }
+    return success;
+}
+
 int main(int argc, char** argv)
 {
+    bool eightConnectivity = false;
+    for(int i=0; i < argc; i++)
+    {
+        std::string strParam(argv[i]);
+        if(strParam.compare("--eight_connectivity") == 0)
+            eightConnectivity = true;
+    }
+
     std::cout << "INITIALIZING PATH CALCULATOR BY MARCOSOFT..." << std::endl;
     ros::init(argc, argv, "path_calculator");
     ros::NodeHandle n;
+    PathCalculator::SetEightConnectivity(eightConnectivity);
+    if(eightConnectivity)
+        std::cout << "PathCalculator.->A* will use 8-connectivity" << std::endl;
     ros::ServiceServer srvPathWaveFrontFromMap = n.advertiseService("path_calculator/wave_front_from_map", callbackWaveFrontFromMap);
     ros::ServiceServer srvPathAStarFromMap = n.advertiseService("path_calculator/a_star_from_map", callbackAStarFromMap);
+    ros::ServiceServer srvPathDStarLiteFromMap = n.advertiseService("path_calculator/d_star_lite_from_map", callbackDStarLiteFromMap);
     ros::Rate loop(10);
 
     while(ros::ok())
@@ -1,13 +1,16 @@
 #include <iostream>
+#include <algorithm>
 #include "ros/ros.h"
 #include "geometry_msgs/Pose2D.h"
 #include "geometry_msgs/Twist.h"
 #include "nav_msgs/Path.h"
+#include "nav_msgs/Odometry.h"
 #include "std_msgs/Float32.h"
 #include "std_msgs/Float32MultiArray.h"
 #include "std_msgs/Bool.h"
 #include "std_msgs/Empty.h"
 #include "tf/transform_listener.h"
+#include "ros/callback_queue.h"
 
 #define SM_INIT 0
 #define SM_GOAL_POSE_ACCEL 1
@@ -20,6 +23,16 @@
 #define SM_GOAL_PATH_DECCEL 7
 #define SM_GOAL_PATH_FINISH 8
 #define SM_COLLISION_RISK 9
+#define SM_GOAL_PATH_TRACKING 11
+
+//Constants for pure pursuit path tracking
+#define PP_CURVATURE_WINDOW 0.2         //Curvature is estimated with the points at this arc length before and after
+#define PP_GOAL_TOLERANCE 0.05
+#define PP_MIN_SPEED 0.05
+#define PP_ROTATE_IN_PLACE_ANGLE 1.0    //If the lookahead point is at a larger angle, robot turns without moving
+#define PP_CLOSEST_SEARCH_DIST 1.0      //Closest point is searched only this far ahead of the last one
+#define PP_MAP_CORRECTION_PERIOD 0.2
+#define PP_ODOMETRY_TIMEOUT 1.0
 
 float goal_distance  = 0;
 float goal_angle     = 0;
@@ -29,6 +42,39 @@ bool  new_path       = false;
 bool  collision_risk = false;
 nav_msgs::Path goal_path;
 bool stop = false;
+bool move_head = false;
+ros::Publisher pub_goal_reached;
+ros::Publisher pub_cmd_vel;
+ros::Publisher pub_head;
+tf::TransformListener* tf_listener_ptr;
+
+//Pure pursuit on the arc length parameterized path. The speed profile is computed once per path and
+//control is done on every odometry message instead of the fixed loop.
+bool  use_pure_pursuit     = false;
+float pp_max_linear        = 0.5;
+float pp_max_angular       = 0.7;
+float pp_max_accel         = 0.3;
+float pp_max_decel         = 0.3;
+float pp_max_lateral_accel = 0.25;
+float pp_min_lookahead     = 0.3;
+float pp_max_lookahead     = 0.8;
+float pp_lookahead_gain    = 0.8;
+bool  pp_active = false;
+std::vector<float> pp_x;
+std::vector<float> pp_y;
+std::vector<float> pp_s;        //Arc length
+std::vector<float> pp_v;        //Speed profile
+int   pp_closest_idx = 0;
+float pp_last_speed  = 0;
+ros::Time pp_last_stamp;
+ros::Time pp_last_odom_time;
+ros::Time pp_start_time;
+//Transform from the frame of odometry messages to map, updated every PP_MAP_CORRECTION_PERIOD
+bool  pp_correction_valid = false;
+float pp_correction_x = 0;
+float pp_correction_y = 0;
+float pp_correction_t = 0;
+ros::Time pp_correction_stamp;
 
 void callback_robot_stop(const std_msgs::Empty::ConstPtr& msg)
 {
@@ -218,14 +264,204 @@ void get_head_angles(float robot_x, float robot_y, float robot_t, int next_pose_
     head_tilt = -0.9;
 }
 
+void prepare_pure_pursuit_path()
+{
+    int n = goal_path.poses.size();
+    pp_x.resize(n);
+    pp_y.resize(n);
+    pp_s.resize(n);
+    pp_v.resize(n);
+    for(int i=0; i < n; i++)
+    {
+        pp_x[i] = goal_path.poses[i].pose.position.x;
+        pp_y[i] = goal_path.poses[i].pose.position.y;
+        pp_s[i] = i == 0 ? 0 : pp_s[i-1] + sqrt((pp_x[i]-pp_x[i-1])*(pp_x[i]-pp_x[i-1]) + (pp_y[i]-pp_y[i-1])*(pp_y[i]-pp_y[i-1]));
+    }
+
+    //Curvature limit: circle through the points PP_CURVATURE_WINDOW before and after each point
+    int prev = 0;
+    int next = 0;
+    for(int i=0; i < n; i++)
+    {
+        pp_v[i] = pp_max_linear;
+        while(prev < i && pp_s[i] - pp_s[prev + 1] >= PP_CURVATURE_WINDOW) prev++;
+        if(next < i) next = i;
+        while(next < n - 1 && pp_s[next] - pp_s[i] < PP_CURVATURE_WINDOW) next++;
+        if(pp_s[i] - pp_s[prev] < PP_CURVATURE_WINDOW/2 || pp_s[next] - pp_s[i] < PP_CURVATURE_WINDOW/2)
+            continue;
+        float ax = pp_x[i] - pp_x[prev], ay = pp_y[i] - pp_y[prev];
+        float bx = pp_x[next] - pp_x[i], by = pp_y[next] - pp_y[i];
+        float cx = pp_x[next] - pp_x[prev], cy = pp_y[next] - pp_y[prev];
+        float curvature = 2*fabs(ax*by - ay*bx) / sqrt((ax*ax + ay*ay)*(bx*bx + by*by)*(cx*cx + cy*cy));
+        if(curvature > 1e-3)
+            pp_v[i] = std::min(pp_v[i], (float)sqrt(pp_max_lateral_accel / curvature));
+    }
+    //Deceleration to stop at the goal and acceleration from the current speed
+    if(n > 0) pp_v[n-1] = 0;
+    for(int i=n-2; i >= 0; i--)
+        pp_v[i] = std::min(pp_v[i], (float)sqrt(pp_v[i+1]*pp_v[i+1] + 2*pp_max_decel*(pp_s[i+1] - pp_s[i])));
+    if(n > 0) pp_v[0] = std::min(pp_v[0], pp_last_speed);
+    for(int i=1; i < n; i++)
+        pp_v[i] = std::min(pp_v[i], (float)sqrt(pp_v[i-1]*pp_v[i-1] + 2*pp_max_accel*(pp_s[i] - pp_s[i-1])));
+    pp_closest_idx = 0;
+    pp_correction_valid = false;
+    std::cout << "SimpleMove.->Pure pursuit path of " << (n > 0 ? pp_s[n-1] : 0) << " m" << std::endl;
+}
+
+bool update_map_correction(float odom_x, float odom_y, float odom_t, ros::Time stamp)
+{
+    if(pp_correction_valid && (stamp - pp_correction_stamp).toSec() < PP_MAP_CORRECTION_PERIOD)
+        return true;
+    tf::StampedTransform transform;
+    try
+    {
+        if(tf_listener_ptr->canTransform("map", "base_link", stamp))
+            tf_listener_ptr->lookupTransform("map", "base_link", stamp, transform);
+        else
+            tf_listener_ptr->lookupTransform("map", "base_link", ros::Time(0), transform);
+    }
+    catch(...)
+    {
+        return pp_correction_valid;
+    }
+    tf::Quaternion q = transform.getRotation();
+    float map_t = atan2((float)q.z(), (float)q.w()) * 2;
+    //correction = map_pose * inverse(odom_pose)
+    pp_correction_t = map_t - odom_t;
+    pp_correction_x = transform.getOrigin().x() - (odom_x*cos(pp_correction_t) - odom_y*sin(pp_correction_t));
+    pp_correction_y = transform.getOrigin().y() - (odom_x*sin(pp_correction_t) + odom_y*cos(pp_correction_t));
+    pp_correction_stamp = stamp;
+    pp_correction_valid = true;
+    return true;
+}
+
+void finish_pure_pursuit(bool goal_reached)
+{
+    std_msgs::Bool msg_goal_reached;
+    geometry_msgs::Twist zero_twist;
+    msg_goal_reached.data = goal_reached;
+    pp_active = false;
+    pp_last_speed = 0;
+    pub_cmd_vel.publish(zero_twist);
+    pub_goal_reached.publish(msg_goal_reached);
+}
+
+void callback_odometry(const nav_msgs::Odometry::ConstPtr& msg)
+{
+    pp_last_odom_time = ros::Time::now();
+    if(!pp_active || stop || new_path || new_pose)
+        return;
+    float odom_x = msg->pose.pose.position.x;
+    float odom_y = msg->pose.pose.position.y;
+    float odom_t = atan2((float)msg->pose.pose.orientation.z, (float)msg->pose.pose.orientation.w) * 2;
+    ros::Time stamp = msg->header.stamp.isZero() ? pp_last_odom_time : msg->header.stamp;
+    if(!update_map_correction(odom_x, odom_y, odom_t, stamp))
+        return;
+    float robot_x = pp_correction_x + odom_x*cos(pp_correction_t) - odom_y*sin(pp_correction_t);
+    float robot_y = pp_correction_y + odom_x*sin(pp_correction_t) + odom_y*cos(pp_correction_t);
+    float robot_t = odom_t + pp_correction_t;
+    float dt = (stamp - pp_last_stamp).toSec();
+    if(pp_last_stamp.isZero() || dt < 0.01 || dt > 0.2) dt = 0.05;
+    pp_last_stamp = stamp;
+
+    if(collision_risk)
+    {
+        std::cout << "SimpleMove.->Collision risk detected!!!!!!" << std::endl;
+        finish_pure_pursuit(false);
+        return;
+    }
+
+    int n = pp_x.size();
+    if(n == 0)
+    {
+        finish_pure_pursuit(true);
+        return;
+    }
+    float min_dist = (pp_x[pp_closest_idx]-robot_x)*(pp_x[pp_closest_idx]-robot_x) + (pp_y[pp_closest_idx]-robot_y)*(pp_y[pp_closest_idx]-robot_y);
+    int closest = pp_closest_idx;
+    for(int i=pp_closest_idx + 1; i < n && pp_s[i] - pp_s[pp_closest_idx] < PP_CLOSEST_SEARCH_DIST; i++)
+    {
+        float dist = (pp_x[i]-robot_x)*(pp_x[i]-robot_x) + (pp_y[i]-robot_y)*(pp_y[i]-robot_y);
+        if(dist < min_dist)
+        {
+            min_dist = dist;
+            closest = i;
+        }
+    }
+    pp_closest_idx = closest;
+
+    float goal_dx = pp_x[n-1] - robot_x;
+    float goal_dy = pp_y[n-1] - robot_y;
+    float goal_error = sqrt(goal_dx*goal_dx + goal_dy*goal_dy);
+    bool goal_behind = goal_dx*cos(robot_t) + goal_dy*sin(robot_t) < 0;
+    if(goal_error < PP_GOAL_TOLERANCE || (pp_closest_idx == n-1 && goal_behind && goal_error < 3*PP_GOAL_TOLERANCE))
+    {
+        std::cout << "SimpleMove.->Path succesfully executed. (Y)" << std::endl;
+        finish_pure_pursuit(true);
+        return;
+    }
+
+    //Lookahead point at arc length s(closest) + L, interpolated between path points
+    float lookahead = std::max(pp_min_lookahead, std::min(pp_max_lookahead, pp_min_lookahead + pp_lookahead_gain*pp_last_speed));
+    float target_s = pp_s[pp_closest_idx] + lookahead;
+    float target_x = pp_x[n-1];
+    float target_y = pp_y[n-1];
+    for(int i=pp_closest_idx + 1; i < n; i++)
+        if(pp_s[i] >= target_s)
+        {
+            float ds = pp_s[i] - pp_s[i-1];
+            float w = ds > 0 ? (target_s - pp_s[i-1]) / ds : 1;
+            target_x = pp_x[i-1] + w*(pp_x[i] - pp_x[i-1]);
+            target_y = pp_y[i-1] + w*(pp_y[i] - pp_y[i-1]);
+            break;
+        }
+    float dx = target_x - robot_x;
+    float dy = target_y - robot_y;
+    float target_robot_x =  dx*cos(robot_t) + dy*sin(robot_t);
+    float target_robot_y = -dx*sin(robot_t) + dy*cos(robot_t);
+    float target_angle = atan2(target_robot_y, target_robot_x);
+
+    geometry_msgs::Twist twist;
+    if(fabs(target_angle) > PP_ROTATE_IN_PLACE_ANGLE)
+        twist = calculate_speeds(robot_t, robot_t + target_angle);
+    else
+    {
+        //Regulated pure pursuit: speed of the profile, limited by the curvature of the arc to the lookahead point
+        float curvature = 2*target_robot_y / (target_robot_x*target_robot_x + target_robot_y*target_robot_y);
+        float speed = pp_v[pp_closest_idx];
+        if(fabs(curvature) > 1e-3)
+            speed = std::min(speed, (float)sqrt(pp_max_lateral_accel / fabs(curvature)));
+        speed = std::min(speed, pp_last_speed + pp_max_accel*dt);
+        speed = std::max(speed, (float)PP_MIN_SPEED);
+        float angular = speed * curvature;
+        if(fabs(angular) > pp_max_angular)
+        {
+            speed *= pp_max_angular / fabs(angular);
+            angular = angular > 0 ? pp_max_angular : -pp_max_angular;
+        }
+        twist.linear.x  = speed;
+        twist.angular.z = angular;
+    }
+    pp_last_speed = twist.linear.x;
+    pub_cmd_vel.publish(twist);
+    if(move_head)
+    {
+        std_msgs::Float32MultiArray msg_head;
+        msg_head.data.resize(2);
+        get_head_angles(robot_x, robot_y, robot_t, pp_closest_idx, msg_head.data[0], msg_head.data[1]);
+        pub_head.publish(msg_head);
+    }
+}
+
 int main(int argc, char** argv)
 {
-    bool move_head = false;
     for(int i=0; i < argc; i++)
     {
         std::string str_param(argv[i]);
         if(str_param.compare("--move_head") == 0)
             move_head = true;
+        if(str_param.compare("--pure_pursuit") == 0)
+            use_pure_pursuit = true;
     }
     std::cout << "INITIALIZING A REALLY GOOD SIMPLE MOVE NODE BY MARCOSOFT..." << std::endl;
 
@@ -233,17 +469,29 @@ int main(int argc, char** argv)
     //VARIABLES FOR ROS CONNECTION
     ros::init(argc, argv, "simple_move");
     ros::NodeHandle n;
-    ros::Publisher  pub_goal_reached     = n.advertise<std_msgs::Bool>("/navigation/goal_reached", 1);                           
+    pub_goal_reached                     = n.advertise<std_msgs::Bool>("/navigation/goal_reached", 1);                           
     ros::Publisher  pub_speeds           = n.advertise<std_msgs::Float32MultiArray>("/hardware/mobile_base/speeds", 1);          
-    ros::Publisher  pub_cmd_vel          = n.advertise<geometry_msgs::Twist>("/hardware/mobile_base/cmd_vel", 1);  
-    ros::Publisher  pub_head             = n.advertise<std_msgs::Float32MultiArray>("/manipulation/manip_pln/hd_goto_angles", 1); 
+    pub_cmd_vel                          = n.advertise<geometry_msgs::Twist>("/hardware/mobile_base/cmd_vel", 1);  
+    pub_head                             = n.advertise<std_msgs::Float32MultiArray>("/manipulation/manip_pln/hd_goto_angles", 1); 
     ros::Subscriber sub_robotStop        = n.subscribe("/hardware/robot_state/stop", 1, callback_robot_stop);               
     ros::Subscriber sub_goalDistance     = n.subscribe("simple_move/goal_dist", 1, callback_goal_dist);                     
     ros::Subscriber sub_goalDistAngle    = n.subscribe("simple_move/goal_dist_angle", 1, callback_goal_dist_angle);          
     ros::Subscriber sub_goalPath         = n.subscribe("simple_move/goal_path", 1, callback_goal_path);                     
     ros::Subscriber sub_goalLateralDist  = n.subscribe("simple_move/goal_lateral", 1, callback_goal_lateral_dist);           
     ros::Subscriber sub_gollisionRisk    = n.subscribe("/navigation/obs_avoid/collision_risk", 10, callback_collision_risk);
+    ros::Subscriber sub_odometry         = n.subscribe("/hardware/mobile_base/odometry", 1, callback_odometry);
     tf::TransformListener tf_listener;
+    tf_listener_ptr = &tf_listener;
+    ros::NodeHandle n_private("~");
+    n_private.param<float>("max_linear_speed",  pp_max_linear, pp_max_linear);
+    n_private.param<float>("max_angular_speed", pp_max_angular, pp_max_angular);
+    n_private.param<float>("max_accel",         pp_max_accel, pp_max_accel);
+    n_private.param<float>("max_decel",         pp_max_decel, pp_max_decel);
+    n_private.param<float>("max_lateral_accel", pp_max_lateral_accel, pp_max_lateral_accel);
+    n_private.param<float>("min_lookahead",     pp_min_lookahead, pp_min_lookahead);
+    n_private.param<float>("max_lookahead",     pp_max_lookahead, pp_max_lookahead);
+    if(use_pure_pursuit)
+        std::cout << "SimpleMove.->Paths will be followed by pure pursuit with max speed " << pp_max_linear << std::endl;
     ros::Rate loop(20);
 
     tf::StampedTransform transform;
@@ -289,6 +537,8 @@ int main(int argc, char** argv)
         {
             stop = false;
             state = SM_INIT;
+            pp_active = false;
+            pp_last_speed = 0;
             msg_goal_reached.data = false;
             pub_cmd_vel.publish(zero_twist);
             pub_goal_reached.publish(msg_goal_reached);
@@ -313,6 +563,14 @@ int main(int argc, char** argv)
                 next_pose_idx = 0;
                 global_goal_x = goal_path.poses[goal_path.poses.size() - 1].pose.position.x;
                 global_goal_y = goal_path.poses[goal_path.poses.size() - 1].pose.position.y;
+                if(use_pure_pursuit)
+                {
+                    prepare_pure_pursuit_path();
+                    pp_last_stamp = ros::Time();
+                    pp_start_time = ros::Time::now();
+                    pp_active = true;
+                    state = SM_GOAL_PATH_TRACKING;
+                }
             }
             break;
 
@@ -480,6 +738,24 @@ int main(int argc, char** argv)
             break;
 
 
+        case SM_GOAL_PATH_TRACKING:
+            //Control is done by callback_odometry. If a new goal arrives, current path is aborted.
+            if(new_pose || new_path)
+            {
+                pp_active = false;
+                state = SM_INIT;
+            }
+            else if(!pp_active)
+                state = SM_INIT;
+            else if((ros::Time::now() - std::max(pp_last_odom_time, pp_start_time)).toSec() > PP_ODOMETRY_TIMEOUT)
+            {
+                std::cout << "SimpleMove.->No odometry received. Following path with the fixed loop." << std::endl;
+                pp_active = false;
+                state = SM_GOAL_PATH_ACCEL;
+            }
+            break;
+
+
         case SM_GOAL_PATH_FINISH:
             std::cout << "SimpleMove.->Path succesfully executed. (Y)" << std::endl;
             msg_goal_reached.data = true;
@@ -492,8 +768,13 @@ int main(int argc, char** argv)
             std::cout << "SimpleMove.->A VERY STUPID PERSON PROGRAMMED THIS SHIT. SORRY. :'(" << std::endl;
             return -1;
         }
-        ros::spinOnce();
-        loop.sleep();
+        if(state == SM_GOAL_PATH_TRACKING)
+            ros::getGlobalCallbackQueue()->callAvailable(ros::WallDuration(0.05));
+        else
+        {
+            ros::spinOnce();
+            loop.sleep();
+        }
     }
     return 0;
 }
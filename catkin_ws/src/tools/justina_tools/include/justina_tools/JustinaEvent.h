@@ -0,0 +1,47 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include "ros/ros.h"
+#include "ros/callback_queue.h"
+#include <boost/thread/recursive_mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+//
+//Condition set by ROS callbacks and awaited by tasks. Callbacks that signal events are subscribed through
+//GetNodeHandle(), whose callback queue is attended by a dedicated AsyncSpinner, thus, they run as soon as the
+//message arrives and a waiting task wakes inmediately instead of in the next cycle of a polling loop.
+//All events share a mutex and a condition variable, so, a task can wait for the first of several events
+//(e.g. goal reached OR stop OR collision). While waiting, the global queue is still spun every 100 ms, as
+//the former polling loops did, for the callbacks that are not attended by the spinner.
+//Data received together with an event must be written and read holding GetMutex().
+//
+class JustinaEvent
+{
+public:
+    JustinaEvent();
+    ~JustinaEvent();
+
+    void Set(bool value = true);
+    void Reset();
+    bool IsSet();
+    //True if the event is set before the timeout
+    bool Wait(int timeOut_ms);
+
+    //Index of the first set event or -1 on timeout
+    static int WaitAny(std::vector<JustinaEvent*>& events, int timeOut_ms);
+    static int WaitAny(JustinaEvent& event1, JustinaEvent& event2, int timeOut_ms);
+    static int WaitAny(JustinaEvent& event1, JustinaEvent& event2, JustinaEvent& event3, int timeOut_ms);
+
+    static bool SetNodeHandle(ros::NodeHandle* nh);
+    static ros::NodeHandle* GetNodeHandle();
+    static boost::recursive_mutex& GetMutex();
+
+private:
+    bool value;
+
+    static ros::NodeHandle* nh;
+    static ros::CallbackQueue* queue;
+    static ros::AsyncSpinner* spinner;
+    static boost::recursive_mutex mutex;
+    static boost::condition_variable_any condition;
+};
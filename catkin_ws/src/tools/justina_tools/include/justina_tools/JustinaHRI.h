@@ -12,6 +12,7 @@
 #include "boost/thread/thread.hpp"
 #include "bbros_bridge/Default_ROS_BB_Bridge.h"
 #include "hri_msgs/RecognizedSpeech.h"
+#include "justina_tools/JustinaEvent.h"
 
 class JustinaHRI
 {
@@ -23,6 +24,9 @@ private:
     static ros::Publisher pubFakeSprHypothesis;
     static ros::Subscriber subSprRecognized;
     static ros::Subscriber subSprHypothesis;
+    static ros::Subscriber subSpeechStart;
+    static ros::Subscriber subSpeechEnd;
+    static ros::Subscriber subSpeaking;
     static ros::ServiceClient cltSpgSay;
     static ros::ServiceClient cltSprStatus;
     static ros::ServiceClient cltSprGrammar;
@@ -37,9 +41,11 @@ private:
     static std::string _lastRecoSpeech;
     static std::vector<std::string> _lastSprHypothesis;
     static std::vector<float> _lastSprConfidences;
-    static bool newSprRecognizedReceived;
-    static bool _legsFound;
-    static bool _legsRearFound;
+    static JustinaEvent newSprRecognizedReceived;
+    static JustinaEvent _userSilent;
+    static JustinaEvent newSpeechStartReceived;
+    static JustinaEvent _legsFound;
+    static JustinaEvent _legsRearFound;
     //Variabeles for qr reader
     static ros::Subscriber subQRReader;
     static boost::posix_time::ptime timeLastQRReceived;
@@ -84,6 +90,11 @@ public:
     static void startSay(std::string strToSay);
     static void say(std::string strToSay);
     static bool waitAfterSay(std::string strToSay, int timeout);
+    //Voice activity reported by the speech frontend (jack_test/speech_frontend)
+    static bool isSpeechFrontendRunning();
+    static bool isUserSpeaking();
+    static bool waitForUserSpeechStart(int timeOut_ms);
+    static bool waitForUserSpeechEnd(int timeOut_ms);
     static void playSound(); 
     //Methods for human following
     static void startFollowHuman();
@@ -92,12 +103,17 @@ public:
     static void enableLegFinderRear(bool enable);
     static bool frontalLegsFound();
     static bool rearLegsFound();
+    static bool waitForFrontalLegsFound(int timeOut_ms);
+    static bool waitForRearLegsFound(int timeOut_ms);
     static void initRoiTracker();
 
 private:
     //Speech recog and synthesis
     static void callbackSprRecognized(const std_msgs::String::ConstPtr& msg);
     static void callbackSprHypothesis(const hri_msgs::RecognizedSpeech::ConstPtr& msg);
+    static void callbackSpeechStart(const std_msgs::Empty::ConstPtr& msg);
+    static void callbackSpeechEnd(const std_msgs::Empty::ConstPtr& msg);
+    static void callbackSpeaking(const std_msgs::Bool::ConstPtr& msg);
     //human following
     static void callbackLegsFound(const std_msgs::Bool::ConstPtr& msg);
     static void callbackLegsRearFound(const std_msgs::Bool::ConstPtr& msg);
@@ -14,6 +14,7 @@
 #include "tf/transform_listener.h"
 #include "tf/transform_datatypes.h"
 #include "justina_tools/JustinaKnowledge.h"
+#include "justina_tools/JustinaEvent.h"
 #include "manip_msgs/InverseKinematicsFloatArray.h"
 #include "manip_msgs/InverseKinematicsPath.h"
 #include "manip_msgs/InverseKinematicsPose.h"
@@ -66,11 +67,11 @@ private:
     static ros::Publisher pubTorsoDown;
 
 
-    static bool _isLaGoalReached;
-    static bool _isRaGoalReached;
-    static bool _isHdGoalReached;
-    static bool _isTrGoalReached;
-    static bool _stopReceived;
+    static JustinaEvent _isLaGoalReached;
+    static JustinaEvent _isRaGoalReached;
+    static JustinaEvent _isHdGoalReached;
+    static JustinaEvent _isTrGoalReached;
+    static JustinaEvent _stopReceived;
     static bool _isObjOnRightHand;
     static bool _isObjOnLeftHand;
 
@@ -18,6 +18,7 @@
 #include "navig_msgs/Location.h"
 #include "point_cloud_manager/GetRgbd.h"
 #include "tf/transform_listener.h"
+#include "justina_tools/JustinaEvent.h"
 
 class JustinaNavigation
 {
@@ -34,6 +35,8 @@ private:
     static ros::Publisher pubSimpleMoveGoalPath;
     static ros::Publisher pubSimpleMoveGoalPose;
     static ros::Publisher pubSimpleMoveGoalRelPose;
+    //Publisher for the local planner node
+    static ros::Publisher pubLocalPlannerGoalPath;
     //Services for path calculator
     static ros::ServiceClient cltGetMap;
     static ros::ServiceClient cltGetPointCloud;
@@ -56,11 +59,11 @@ private:
     static float currentRobotY;
     static float currentRobotTheta;
     static nav_msgs::Path lastCalcPath;
-    static bool _isGoalReached;
-    static bool _isGlobalGoalReached;
-    static bool _stopReceived;
-    static bool _obstacleInFront;
-    static bool _collisionRisk;
+    static JustinaEvent _isGoalReached;
+    static JustinaEvent _isGlobalGoalReached;
+    static JustinaEvent _stopReceived;
+    static JustinaEvent _obstacleInFront;
+    static JustinaEvent _collisionRisk;
 
 public:
     //
@@ -73,6 +76,8 @@ public:
     static bool isGlobalGoalReached();
     static bool waitForGoalReached(int timeOut_ms);
     static bool waitForGlobalGoalReached(int timeOut_ms);
+    //Also returns as soon as there is risk of collision
+    static bool waitForGoalReachedOrCollisionRisk(int timeOut_ms);
     static void getRobotPose(float& currentX, float& currentY, float& currentTheta);
     static void getRobotPoseFromOdom(float& currentX, float& currentY, float& currentTheta);
     //Methods for obstacle avoidance
@@ -83,6 +88,8 @@ public:
     static void startMoveDist(float distance);
     static void startMoveDistAngle(float distance, float angle);
     static void startMovePath(nav_msgs::Path& path);
+    //Path is followed by the local planner, which avoids obstacles instead of stopping
+    static void startMovePathLocalPlanner(nav_msgs::Path& path);
     static void startMoveLateral(float distance);
     static void startGoToPose(float x, float y, float angle);
     static void startGoToRelPose(float relX, float relY, float relTheta);
@@ -0,0 +1,275 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <opencv2/core/core.hpp>
+
+//
+//RANSAC shared by the plane and line finders.
+//Points are stored as structure of arrays (contiguous x, y and z), so that consensus is evaluated by tight loops
+//over float arrays that the compiler vectorizes. Scoring of a hypothesis is done by blocks and stops as soon as it
+//cannot beat the best one. The number of iterations adapts to the inlier ratio of the best hypothesis found so far.
+//Optionally (sortedByQuality), points are assumed sorted best first and samples are drawn from a growing prefix
+//of the list (a simplified PROSAC).
+//Models must provide: SampleSize, FromSample, Refine, CountInliers and GetInliers (see RansacPlane).
+//
+class RansacPoints
+{
+public:
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+
+	void Clear() { x.clear(); y.clear(); z.clear(); }
+	void Reserve(size_t n) { x.reserve(n); y.reserve(n); z.reserve(n); }
+	void Add(float px, float py, float pz = 0) { x.push_back(px); y.push_back(py); z.push_back(pz); }
+	int Size() const { return x.size(); }
+	//Removes the points whose flag is not zero, keeping the order of the rest. Returns the number of points kept.
+	int RemoveFlagged(const std::vector<unsigned char>& flags);
+};
+
+//Plane a*x + b*y + c*z + d = 0 with unitary normal (a, b, c)
+class RansacPlane
+{
+public:
+	enum { SampleSize = 3 };
+	float a, b, c, d;
+
+	RansacPlane();
+	bool FromSample(const RansacPoints& points, const int* sample);
+	bool Refine(const RansacPoints& points, const std::vector<int>& inliers);
+	void GetInliers(const RansacPoints& points, float threshold, std::vector<int>& inliers) const;
+	int CountInliers(const RansacPoints& points, int first, int last, float threshold) const
+	{
+		const float* px = &points.x[0];
+		const float* py = &points.y[0];
+		const float* pz = &points.z[0];
+		int count = 0;
+		for(int i = first; i < last; i++)
+			count += std::fabs(a*px[i] + b*py[i] + c*pz[i] + d) < threshold;
+		return count;
+	}
+};
+
+//Line a*x + b*y + c = 0 with unitary normal (a, b). Only x and y of the points are used.
+class RansacLine2D
+{
+public:
+	enum { SampleSize = 2 };
+	float a, b, c;
+
+	RansacLine2D();
+	bool FromSample(const RansacPoints& points, const int* sample);
+	bool Refine(const RansacPoints& points, const std::vector<int>& inliers);
+	void GetInliers(const RansacPoints& points, float threshold, std::vector<int>& inliers) const;
+	int CountInliers(const RansacPoints& points, int first, int last, float threshold) const
+	{
+		const float* px = &points.x[0];
+		const float* py = &points.y[0];
+		int count = 0;
+		for(int i = first; i < last; i++)
+			count += std::fabs(a*px[i] + b*py[i] + c) < threshold;
+		return count;
+	}
+};
+
+//Line through point (px, py, pz) with unitary direction (ux, uy, uz)
+class RansacLine3D
+{
+public:
+	enum { SampleSize = 2 };
+	float px, py, pz;
+	float ux, uy, uz;
+
+	RansacLine3D();
+	bool FromSample(const RansacPoints& points, const int* sample);
+	bool Refine(const RansacPoints& points, const std::vector<int>& inliers);
+	void GetInliers(const RansacPoints& points, float threshold, std::vector<int>& inliers) const;
+	int CountInliers(const RansacPoints& points, int first, int last, float threshold) const
+	{
+		const float* qx = &points.x[0];
+		const float* qy = &points.y[0];
+		const float* qz = &points.z[0];
+		float threshold2 = threshold*threshold;
+		int count = 0;
+		for(int i = first; i < last; i++)
+		{
+			//Squared distance to the line: |q - p|^2 - ((q - p).u)^2
+			float dx = qx[i] - px;
+			float dy = qy[i] - py;
+			float dz = qz[i] - pz;
+			float proj = dx*ux + dy*uy + dz*uz;
+			count += dx*dx + dy*dy + dz*dz - proj*proj < threshold2;
+		}
+		return count;
+	}
+};
+
+template <class Model>
+class Ransac
+{
+public:
+	float threshold;                         //Max distance from a point to the model to be an inlier
+	int maxIterations;
+	int minInliers;                          //Hypotheses with fewer inliers are never accepted
+	double confidence;                       //Probability of having drawn at least one outlier-free sample
+	float minSampleDistance;                 //Samples with two points closer than this are discarded
+	bool sortedByQuality;                    //Points are sorted best first: draw samples from a growing prefix
+	bool refine;                             //Least squares fit on the inliers of the best hypothesis
+	bool (*isValidModel)(const Model& model);//Optional check of hypotheses (e.g. horizontal planes only)
+
+	Ransac()
+	{
+		this->threshold = 0.01f;
+		this->maxIterations = 1000;
+		this->minInliers = 0;
+		this->confidence = 0.99;
+		this->minSampleDistance = 0;
+		this->sortedByQuality = false;
+		this->refine = true;
+		this->isValidModel = 0;
+		this->rngState = 2463534242u;
+		this->lastIterations = 0;
+	}
+
+	void Seed(unsigned int seed)
+	{
+		this->rngState = seed != 0 ? seed : 2463534242u;
+	}
+
+	int GetLastIterations()
+	{
+		return this->lastIterations;
+	}
+
+	//Returns false if no hypothesis with at least minInliers inliers was found.
+	//Inliers are indexes in the points list.
+	bool Estimate(const RansacPoints& points, Model& model, std::vector<int>& inliers)
+	{
+		inliers.clear();
+		this->lastIterations = 0;
+		int n = points.Size();
+		if(n < (int)Model::SampleSize || n < this->minInliers)
+			return false;
+
+		int bestScore = -1;
+		int iterationsBound = this->maxIterations;
+		int it = 0;
+		for(; it < iterationsBound; it++)
+		{
+			int poolSize = this->sortedByQuality ? this->prosacPoolSize(it, n) : n;
+			if(!this->drawSample(points, poolSize))
+				continue;
+			Model candidate;
+			if(!candidate.FromSample(points, this->sample))
+				continue;
+			if(this->isValidModel != 0 && !this->isValidModel(candidate))
+				continue;
+			int score = this->score(candidate, points, std::max(bestScore, this->minInliers - 1));
+			if(score <= bestScore || score < this->minInliers)
+				continue;
+			bestScore = score;
+			model = candidate;
+			iterationsBound = std::min(this->maxIterations, this->adaptiveIterations((double)bestScore / n));
+		}
+		this->lastIterations = it;
+		if(bestScore < 0)
+			return false;
+
+		model.GetInliers(points, this->threshold, inliers);
+		if(this->refine)
+		{
+			Model refined = model;
+			if(refined.Refine(points, inliers) && (this->isValidModel == 0 || this->isValidModel(refined)))
+			{
+				refined.GetInliers(points, this->threshold, this->refinedInliers);
+				if((int)this->refinedInliers.size() >= (int)inliers.size())
+				{
+					model = refined;
+					inliers.swap(this->refinedInliers);
+				}
+			}
+		}
+		return true;
+	}
+
+private:
+	unsigned int rngState;
+	int lastIterations;
+	int sample[Model::SampleSize];
+	std::vector<int> refinedInliers;
+
+	unsigned int nextRandom()
+	{
+		//xorshift32
+		this->rngState ^= this->rngState << 13;
+		this->rngState ^= this->rngState >> 17;
+		this->rngState ^= this->rngState << 5;
+		return this->rngState;
+	}
+
+	bool drawSample(const RansacPoints& points, int poolSize)
+	{
+		for(int i = 0; i < (int)Model::SampleSize; i++)
+		{
+			bool repeated;
+			do
+			{
+				this->sample[i] = this->nextRandom() % poolSize;
+				repeated = false;
+				for(int j = 0; j < i; j++)
+					repeated = repeated || this->sample[j] == this->sample[i];
+			}
+			while(repeated);
+		}
+		if(this->minSampleDistance <= 0)
+			return true;
+		float minDist2 = this->minSampleDistance * this->minSampleDistance;
+		for(int i = 0; i < (int)Model::SampleSize; i++)
+			for(int j = i + 1; j < (int)Model::SampleSize; j++)
+			{
+				float dx = points.x[this->sample[i]] - points.x[this->sample[j]];
+				float dy = points.y[this->sample[i]] - points.y[this->sample[j]];
+				float dz = points.z[this->sample[i]] - points.z[this->sample[j]];
+				if(dx*dx + dy*dy + dz*dz < minDist2)
+					return false;
+			}
+		return true;
+	}
+
+	//Counts inliers by blocks. Returns -1 as soon as the hypothesis cannot get more than scoreToBeat inliers.
+	int score(const Model& candidate, const RansacPoints& points, int scoreToBeat)
+	{
+		const int blockSize = 4096;
+		int n = points.Size();
+		int count = 0;
+		for(int first = 0; first < n; first += blockSize)
+		{
+			int last = std::min(first + blockSize, n);
+			count += candidate.CountInliers(points, first, last, this->threshold);
+			if(count + (n - last) <= scoreToBeat)
+				return -1;
+		}
+		return count;
+	}
+
+	int adaptiveIterations(double inlierRatio)
+	{
+		double allInliers = std::pow(inlierRatio, (int)Model::SampleSize);
+		if(allInliers >= 1.0)
+			return 1;
+		if(allInliers <= 1e-9)
+			return this->maxIterations;
+		double iterations = std::log(1.0 - this->confidence) / std::log(1.0 - allInliers);
+		return iterations < this->maxIterations ? (int)std::ceil(iterations) : this->maxIterations;
+	}
+
+	int prosacPoolSize(int iteration, int n)
+	{
+		//Prefix grows linearly and covers all points after half of the iterations
+		int growth = std::max(this->maxIterations / 2, 1);
+		long pool = (int)Model::SampleSize + (long)(n - (int)Model::SampleSize) * (iteration + 1) / growth;
+		return (int)std::min(pool, (long)n);
+	}
+};
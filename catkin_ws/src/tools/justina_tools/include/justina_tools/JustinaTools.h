@@ -30,6 +30,8 @@ private:
 	static tf::TransformListener* tf_listener;
 	static int counter;
 
+	static void getPointCloud2Offsets(const sensor_msgs::PointCloud2& pc_msg, int& xOffset, int& rgbOffset);
+
 public:
 	static bool setNodeHandle(ros::NodeHandle* nh);
 	static void laserScanToStdVectors(sensor_msgs::LaserScan& readings, std::vector<float>& robotX, std::vector<float>& robotY, std::vector<float>& mapX, std::vector<float>& mapY);
@@ -39,6 +41,13 @@ public:
 
 	static void PointCloud2Msg_ToCvMat(sensor_msgs::PointCloud2& pc_msg, cv::Mat& bgr_dest, cv::Mat& pc_dest);
 	static void PointCloud2Msg_ToCvMat(const sensor_msgs::PointCloud2::ConstPtr& pc_msg, cv::Mat& bgr_dest, cv::Mat& pc_dest);
+	//Copies into bgr_dest (CV_8UC3) and pc_dest (CV_32FC3). They are reallocated only when the cloud size changes.
+	static void PointCloud2Msg_ToCvMat(const sensor_msgs::PointCloud2& pc_msg, cv::Mat& bgr_dest, cv::Mat& pc_dest);
+	//Non-owning views over the message buffer (valid while the message lives). Each element is exactly one point,
+	//so views can be cloned or copied: xyz_view is CV_32FC(point_step/4) with x,y,z in its first three channels and
+	//bgr_view is CV_8UC(point_step) with b,g,r in channels bgr_channel to bgr_channel+2. Fails (use the copying
+	//version) if x is not at the beginning of the point.
+	static bool PointCloud2Msg_ToCvMatView(const sensor_msgs::PointCloud2& pc_msg, cv::Mat& bgr_view, cv::Mat& xyz_view, int& bgr_channel);
 	static bool transformPoint(std::string src_frame, float inX, float inY, float inZ, std::string dest_frame, float& outX, float& outY, float& outZ);
 	static bool transformPose(std::string src_frame, float inX, float inY, float inZ, float inRoll, float inPitch, float inYaw,
                               std::string dest_frame, float& outX, float& outY, float& outZ, float& outRoll, float& outPitch, float& outYaw);
@@ -0,0 +1,114 @@
+#include "justina_tools/JustinaEvent.h"
+
+ros::NodeHandle* JustinaEvent::nh = 0;
+ros::CallbackQueue* JustinaEvent::queue = 0;
+ros::AsyncSpinner* JustinaEvent::spinner = 0;
+boost::recursive_mutex JustinaEvent::mutex;
+boost::condition_variable_any JustinaEvent::condition;
+
+JustinaEvent::JustinaEvent()
+{
+    this->value = false;
+}
+
+JustinaEvent::~JustinaEvent()
+{
+}
+
+bool JustinaEvent::SetNodeHandle(ros::NodeHandle* nh)
+{
+    if(JustinaEvent::nh != 0)
+        return true;
+    if(nh == 0)
+        return false;
+
+    std::cout << "JustinaEvent.->Starting spinner for event callbacks..." << std::endl;
+    JustinaEvent::queue = new ros::CallbackQueue();
+    JustinaEvent::nh = new ros::NodeHandle(*nh);
+    JustinaEvent::nh->setCallbackQueue(JustinaEvent::queue);
+    JustinaEvent::spinner = new ros::AsyncSpinner(1, JustinaEvent::queue);
+    JustinaEvent::spinner->start();
+    return true;
+}
+
+//Subscriptions made with this node handle are attended by the event spinner, not by ros::spinOnce()
+ros::NodeHandle* JustinaEvent::GetNodeHandle()
+{
+    return JustinaEvent::nh;
+}
+
+boost::recursive_mutex& JustinaEvent::GetMutex()
+{
+    return JustinaEvent::mutex;
+}
+
+void JustinaEvent::Set(bool value)
+{
+    boost::recursive_mutex::scoped_lock lock(JustinaEvent::mutex);
+    this->value = value;
+    if(value)
+        JustinaEvent::condition.notify_all();
+}
+
+void JustinaEvent::Reset()
+{
+    this->Set(false);
+}
+
+bool JustinaEvent::IsSet()
+{
+    boost::recursive_mutex::scoped_lock lock(JustinaEvent::mutex);
+    return this->value;
+}
+
+bool JustinaEvent::Wait(int timeOut_ms)
+{
+    std::vector<JustinaEvent*> events;
+    events.push_back(this);
+    return JustinaEvent::WaitAny(events, timeOut_ms) == 0;
+}
+
+int JustinaEvent::WaitAny(JustinaEvent& event1, JustinaEvent& event2, int timeOut_ms)
+{
+    std::vector<JustinaEvent*> events;
+    events.push_back(&event1);
+    events.push_back(&event2);
+    return JustinaEvent::WaitAny(events, timeOut_ms);
+}
+
+int JustinaEvent::WaitAny(JustinaEvent& event1, JustinaEvent& event2, JustinaEvent& event3, int timeOut_ms)
+{
+    std::vector<JustinaEvent*> events;
+    events.push_back(&event1);
+    events.push_back(&event2);
+    events.push_back(&event3);
+    return JustinaEvent::WaitAny(events, timeOut_ms);
+}
+
+//The mutex must not be held by the caller, otherwise, callbacks cannot set the events while waiting.
+int JustinaEvent::WaitAny(std::vector<JustinaEvent*>& events, int timeOut_ms)
+{
+    ros::Time deadline = ros::Time::now() + ros::Duration(timeOut_ms / 1000.0);
+    while(ros::ok())
+    {
+        {
+            boost::recursive_mutex::scoped_lock lock(JustinaEvent::mutex);
+            for(size_t i=0; i < events.size(); i++)
+                if(events[i]->value)
+                    return i;
+            ros::Duration remaining = deadline - ros::Time::now();
+            if(remaining <= ros::Duration(0))
+                return -1;
+            //Wait is sliced to attend the global queue at the same rate the former polling loops did
+            int slice_ms = remaining.toNSec() / 1000000 + 1;
+            if(slice_ms > 100)
+                slice_ms = 100;
+            JustinaEvent::condition.timed_wait(lock, boost::posix_time::milliseconds(slice_ms));
+            for(size_t i=0; i < events.size(); i++)
+                if(events[i]->value)
+                    return i;
+        }
+        ros::spinOnce();
+    }
+    return -1;
+}
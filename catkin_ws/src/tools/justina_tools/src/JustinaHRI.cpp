@@ -7,6 +7,9 @@ ros::Publisher JustinaHRI::pubFakeSprRecognized;
 ros::Publisher JustinaHRI::pubFakeSprHypothesis;
 ros::Subscriber JustinaHRI::subSprRecognized; 
 ros::Subscriber JustinaHRI::subSprHypothesis;
+ros::Subscriber JustinaHRI::subSpeechStart;
+ros::Subscriber JustinaHRI::subSpeechEnd;
+ros::Subscriber JustinaHRI::subSpeaking;
 ros::ServiceClient JustinaHRI::cltSpgSay;
 ros::ServiceClient JustinaHRI::cltSprStatus;
 ros::ServiceClient JustinaHRI::cltSprGrammar;
@@ -21,9 +24,11 @@ ros::Subscriber JustinaHRI::subLegsRearFound;
 std::string JustinaHRI::_lastRecoSpeech = "";
 std::vector<std::string> JustinaHRI::_lastSprHypothesis;
 std::vector<float> JustinaHRI::_lastSprConfidences;
-bool JustinaHRI::newSprRecognizedReceived = false;
-bool JustinaHRI::_legsFound;
-bool JustinaHRI::_legsRearFound;
+JustinaEvent JustinaHRI::newSprRecognizedReceived;
+JustinaEvent JustinaHRI::_userSilent;
+JustinaEvent JustinaHRI::newSpeechStartReceived;
+JustinaEvent JustinaHRI::_legsFound;
+JustinaEvent JustinaHRI::_legsRearFound;
 sound_play::SoundClient * JustinaHRI::sc;
 
 //Variabeles for qr reader
@@ -47,10 +52,17 @@ bool JustinaHRI::setNodeHandle(ros::NodeHandle* nh)
     pathDeviceScript = ros::package::getPath("justina_tools");
     std::cout << "JustinaHRI.->PathDeviceScript:" << pathDeviceScript << std::endl;
 
+    //Callbacks of speech and legs signal events, they are attended by the event spinner
+    JustinaEvent::SetNodeHandle(nh);
+    ros::NodeHandle* nhEvents = JustinaEvent::GetNodeHandle();
+    _userSilent.Set();
     pubFakeSprHypothesis = nh->advertise<hri_msgs::RecognizedSpeech>("/recognizedSpeech", 1);
     pubFakeSprRecognized = nh->advertise<std_msgs::String>("/hri/sp_rec/recognized", 1);
-    subSprHypothesis = nh->subscribe("/recognizedSpeech", 1, &JustinaHRI::callbackSprHypothesis);
-    subSprRecognized = nh->subscribe("/hri/sp_rec/recognized", 1, &JustinaHRI::callbackSprRecognized);
+    subSprHypothesis = nhEvents->subscribe("/recognizedSpeech", 1, &JustinaHRI::callbackSprHypothesis);
+    subSprRecognized = nhEvents->subscribe("/hri/sp_rec/recognized", 1, &JustinaHRI::callbackSprRecognized);
+    subSpeechStart = nhEvents->subscribe("/hri/speech_frontend/speech_start", 1, &JustinaHRI::callbackSpeechStart);
+    subSpeechEnd = nhEvents->subscribe("/hri/speech_frontend/speech_end", 1, &JustinaHRI::callbackSpeechEnd);
+    subSpeaking = nhEvents->subscribe("/hri/speech_frontend/speaking", 1, &JustinaHRI::callbackSpeaking);
     cltSpgSay = nh->serviceClient<bbros_bridge::Default_ROS_BB_Bridge>("/spg_say");
     cltSprStatus = nh->serviceClient<bbros_bridge::Default_ROS_BB_Bridge>("/spr_status");
     cltSprGrammar = nh->serviceClient<bbros_bridge::Default_ROS_BB_Bridge>("/spr_grammar");
@@ -59,8 +71,8 @@ bool JustinaHRI::setNodeHandle(ros::NodeHandle* nh)
     pubFollowStartStop = nh->advertise<std_msgs::Bool>("/hri/human_following/start_follow", 1);
     pubLegsEnable = nh->advertise<std_msgs::Bool>("/hri/leg_finder/enable", 1);
     pubLegsRearEnable = nh->advertise<std_msgs::Bool>("/hri/leg_finder/enable_rear", 1);
-    subLegsFound = nh->subscribe("/hri/leg_finder/legs_found", 1, &JustinaHRI::callbackLegsFound);
-    subLegsRearFound = nh->subscribe("/hri/leg_finder/legs_found_rear", 1, &JustinaHRI::callbackLegsRearFound);
+    subLegsFound = nhEvents->subscribe("/hri/leg_finder/legs_found", 1, &JustinaHRI::callbackLegsFound);
+    subLegsRearFound = nhEvents->subscribe("/hri/leg_finder/legs_found_rear", 1, &JustinaHRI::callbackLegsRearFound);
     std::cout << "JustinaHRI.->Setting ros node..." << std::endl;
     //JustinaHRI::cltSpGenSay = nh->serviceClient<bbros_bridge>("
     subQRReader = nh->subscribe("/hri/qr/recognized", 1, &JustinaHRI::callbackQRRecognized);
@@ -175,16 +187,10 @@ void JustinaHRI::enableSpeechRecognized(bool enable){
 //Methos for speech synthesis and recognition
 bool JustinaHRI::waitForSpeechRecognized(std::string& recognizedSentence, int timeOut_ms)
 {
-    newSprRecognizedReceived = false;
-    int attempts = timeOut_ms / 100;
-    ros::Rate loop(10);
-    while(ros::ok() && !newSprRecognizedReceived && --attempts > 0)
-    {
-        ros::spinOnce();
-        loop.sleep();
-    }
-    if(newSprRecognizedReceived)
+    newSprRecognizedReceived.Reset();
+    if(newSprRecognizedReceived.Wait(timeOut_ms))
     {
+        boost::recursive_mutex::scoped_lock lock(JustinaEvent::GetMutex());
         recognizedSentence = _lastRecoSpeech;
         return true;
     }
@@ -197,16 +203,10 @@ bool JustinaHRI::waitForSpeechRecognized(std::string& recognizedSentence, int ti
 
 bool JustinaHRI::waitForSpeechHypothesis(std::vector<std::string>& sentences, std::vector<float>& confidences, int timeOut_ms)
 {
-    newSprRecognizedReceived = false;
-    int attempts = timeOut_ms / 100;
-    ros::Rate loop(10);
-    while(ros::ok() && !newSprRecognizedReceived && --attempts > 0)
-    {
-        ros::spinOnce();
-        loop.sleep();
-    }
-    if(newSprRecognizedReceived)
+    newSprRecognizedReceived.Reset();
+    if(newSprRecognizedReceived.Wait(timeOut_ms))
     {
+        boost::recursive_mutex::scoped_lock lock(JustinaEvent::GetMutex());
         sentences = _lastSprHypothesis;
         confidences = _lastSprConfidences;
         return true;
@@ -319,6 +319,7 @@ bool JustinaHRI::waitForUserConfirmation(bool& confirmation, int timeOut_ms)
 
 std::string JustinaHRI::lastRecogSpeech()
 {
+    boost::recursive_mutex::scoped_lock lock(JustinaEvent::GetMutex());
     return _lastRecoSpeech;
 }
 
@@ -365,7 +366,7 @@ void JustinaHRI::enableLegFinder(bool enable)
 {
     if(!enable)
     {
-        JustinaHRI::_legsFound = false;
+        JustinaHRI::_legsFound.Reset();
         std::cout << "JustinaHRI.->Leg_finder disabled. " << std::endl;
     }
     else
@@ -391,18 +392,30 @@ void JustinaHRI::enableLegFinderRear(bool enable)
 
 bool JustinaHRI::frontalLegsFound()
 {
-    return JustinaHRI::_legsFound;
+    return JustinaHRI::_legsFound.IsSet();
 }
 
 bool JustinaHRI::rearLegsFound()
 {
-    return JustinaHRI::_legsRearFound;
+    return JustinaHRI::_legsRearFound.IsSet();
+}
+
+//Returns true as soon as legs are found (inmediately if they are already found), false on timeout
+bool JustinaHRI::waitForFrontalLegsFound(int timeOut_ms)
+{
+    return JustinaHRI::_legsFound.Wait(timeOut_ms);
+}
+
+bool JustinaHRI::waitForRearLegsFound(int timeOut_ms)
+{
+    return JustinaHRI::_legsRearFound.Wait(timeOut_ms);
 }
 
 void JustinaHRI::callbackSprRecognized(const std_msgs::String::ConstPtr& msg)
 {
+    boost::recursive_mutex::scoped_lock lock(JustinaEvent::GetMutex());
     _lastRecoSpeech = msg->data;
-    newSprRecognizedReceived = true;
+    newSprRecognizedReceived.Set();
     std::cout << "JustinaHRI.->Received recognized speech: " << msg->data << std::endl;
 }
 
@@ -413,23 +426,24 @@ void JustinaHRI::callbackSprHypothesis(const hri_msgs::RecognizedSpeech::ConstPt
         std::cout << "JustinaHRI.->Invalid speech recog hypothesis: msg is empty" << std::endl;
         return;
     }
+    boost::recursive_mutex::scoped_lock lock(JustinaEvent::GetMutex());
     _lastRecoSpeech = msg->hypothesis[0];
     _lastSprHypothesis = msg->hypothesis;
     _lastSprConfidences = msg->confidences;
     std::cout << "JustinaHRI.->Last reco speech: " << _lastRecoSpeech << std::endl;
-    newSprRecognizedReceived = true;
+    newSprRecognizedReceived.Set();
 }
 
 void JustinaHRI::callbackLegsFound(const std_msgs::Bool::ConstPtr& msg)
 {
     std::cout << "JustinaHRI.->Legs found signal received!" << std::endl;
-    JustinaHRI::_legsFound = msg->data;
+    JustinaHRI::_legsFound.Set(msg->data);
 }
 
 void JustinaHRI::callbackLegsRearFound(const std_msgs::Bool::ConstPtr& msg)
 {
     //std::cout << "JustinaHRI.->Legs rear found signal received!" << std::endl;
-    JustinaHRI::_legsRearFound = msg->data;
+    JustinaHRI::_legsRearFound.Set(msg->data);
 }
 
 //Methods for qr reader
@@ -453,13 +467,65 @@ bool JustinaHRI::waitAfterSay(std::string strToSay, int timeout) {
     bbros_bridge::Default_ROS_BB_Bridge srv;
     srv.request.parameters = strToSay;
     srv.request.timeout = timeout;
+    newSpeechStartReceived.Reset();
     if (cltSpgSay.call(srv)) {
-        boost::this_thread::sleep(boost::posix_time::milliseconds(1000));
+        //If the speech frontend is running, it waits only until the voice of the robot is no longer heard.
+        //Voice onset is detected with some latency, so, the start is awaited first (at most the former guard time)
+        if(isSpeechFrontendRunning())
+        {
+            newSpeechStartReceived.Wait(1000);
+            waitForUserSpeechEnd(1000);
+        }
+        else
+            boost::this_thread::sleep(boost::posix_time::milliseconds(1000));
         return true;
     }
     return false;
 }
 
+bool JustinaHRI::isSpeechFrontendRunning()
+{
+    return subSpeechStart.getNumPublishers() > 0;
+}
+
+bool JustinaHRI::isUserSpeaking()
+{
+    return !_userSilent.IsSet();
+}
+
+//Returns true as soon as someone starts speaking, false on timeout
+bool JustinaHRI::waitForUserSpeechStart(int timeOut_ms)
+{
+    newSpeechStartReceived.Reset();
+    return newSpeechStartReceived.Wait(timeOut_ms);
+}
+
+//Returns true as soon as nobody is speaking (inmediately if nobody was speaking), false on timeout
+bool JustinaHRI::waitForUserSpeechEnd(int timeOut_ms)
+{
+    return _userSilent.Wait(timeOut_ms);
+}
+
+void JustinaHRI::callbackSpeechStart(const std_msgs::Empty::ConstPtr& msg)
+{
+    _userSilent.Reset();
+    newSpeechStartReceived.Set();
+}
+
+void JustinaHRI::callbackSpeechEnd(const std_msgs::Empty::ConstPtr& msg)
+{
+    _userSilent.Set();
+}
+
+//Latched state, it gives the current state to nodes started in the middle of an utterance
+void JustinaHRI::callbackSpeaking(const std_msgs::Bool::ConstPtr& msg)
+{
+    if(msg->data)
+        _userSilent.Reset();
+    else
+        _userSilent.Set();
+}
+
 void JustinaHRI::playSound()
 {
     std::cout << "JudtinsHRI.->Playing sound!" << std::endl;
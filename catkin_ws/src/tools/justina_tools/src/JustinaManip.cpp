@@ -41,13 +41,13 @@ ros::Publisher JustinaManip::pubTrGoToRelPose;
 ros::Publisher JustinaManip::pubTorsoUp;
 ros::Publisher JustinaManip::pubTorsoDown;
 //
-bool JustinaManip::_isLaGoalReached = false;
-bool JustinaManip::_isRaGoalReached = false;
-bool JustinaManip::_isHdGoalReached = false;
-bool JustinaManip::_isTrGoalReached = false;
+JustinaEvent JustinaManip::_isLaGoalReached;
+JustinaEvent JustinaManip::_isRaGoalReached;
+JustinaEvent JustinaManip::_isHdGoalReached;
+JustinaEvent JustinaManip::_isTrGoalReached;
 bool JustinaManip::_isObjOnRightHand = false;
 bool JustinaManip::_isObjOnLeftHand = false;
-bool JustinaManip::_stopReceived = false;
+JustinaEvent JustinaManip::_stopReceived;
 
 std::vector<float> JustinaManip::_laCurrentPos;
 std::vector<float> JustinaManip::_raCurrentPos;
@@ -60,22 +60,25 @@ bool JustinaManip::setNodeHandle(ros::NodeHandle* nh)
     if(nh == 0)
         return false;
     std::cout << "JustinaManip.->Setting ros node..." << std::endl;
+    //Callbacks of goal reached and stop signal events, they are attended by the event spinner
+    JustinaEvent::SetNodeHandle(nh);
+    ros::NodeHandle* nhEvents = JustinaEvent::GetNodeHandle();
     JustinaManip::cltIKFloatArray = nh->serviceClient<manip_msgs::InverseKinematicsFloatArray>("/manipulation/ik_geometric/ik_float_array");
     JustinaManip::cltIKPath = nh->serviceClient<manip_msgs::InverseKinematicsPath>("/manipulation/ik_geometric/ik_path");
     JustinaManip::cltIKPose = nh->serviceClient<manip_msgs::InverseKinematicsPose>("/manipulation/ik_geometric/ik_pose");
     JustinaManip::cltDK = nh->serviceClient<manip_msgs::DirectKinematics>("/manipulation/ik_geometric/direct_kinematics");
     //Subscribers for indicating that a goal pose has been reached
-    JustinaManip::subLaGoalReached = nh->subscribe("/manipulation/la_goal_reached", 1, &JustinaManip::callbackLaGoalReached);
-    JustinaManip::subRaGoalReached = nh->subscribe("/manipulation/ra_goal_reached", 1, &JustinaManip::callbackRaGoalReached);
-    JustinaManip::subHdGoalReached = nh->subscribe("/manipulation/hd_goal_reached", 1, &JustinaManip::callbackHdGoalReached);
-    JustinaManip::subTrGoalReached = nh->subscribe("/hardware/torso/goal_reached", 1, &JustinaManip::callbackTrGoalReached);
+    JustinaManip::subLaGoalReached = nhEvents->subscribe("/manipulation/la_goal_reached", 1, &JustinaManip::callbackLaGoalReached);
+    JustinaManip::subRaGoalReached = nhEvents->subscribe("/manipulation/ra_goal_reached", 1, &JustinaManip::callbackRaGoalReached);
+    JustinaManip::subHdGoalReached = nhEvents->subscribe("/manipulation/hd_goal_reached", 1, &JustinaManip::callbackHdGoalReached);
+    JustinaManip::subTrGoalReached = nhEvents->subscribe("/hardware/torso/goal_reached", 1, &JustinaManip::callbackTrGoalReached);
     JustinaManip::subObjOnRightHand = nh->subscribe("/hardware/right_arm/object_on_hand", 1, &JustinaManip::callbackObjOnRightHand);
     JustinaManip::subObjOnLeftHand = nh->subscribe("/hardware/left_arm/object_on_hand", 1, &JustinaManip::callbackObjOnLeftHand);
     JustinaManip::subLaCurrentPos = nh->subscribe("/hardware/left_arm/current_pose", 1, &JustinaManip::callbackLaCurrentPos);
     JustinaManip::subRaCurrentPos = nh->subscribe("/hardware/right_arm/current_pose", 1, &JustinaManip::callbackRaCurrentPos);
     JustinaManip::subTorsoCurrentPos = nh->subscribe("/hardware/torso/current_pose", 1, &JustinaManip::callbackTorsoCurrentPos);
 
-    JustinaManip::subStopRobot = nh->subscribe("/hardware/robot_state/stop", 1, &JustinaManip::callbackRobotStop);
+    JustinaManip::subStopRobot = nhEvents->subscribe("/hardware/robot_state/stop", 1, &JustinaManip::callbackRobotStop);
     //Publishers for the commands executed by this node
     JustinaManip::pubLaGoToAngles = nh->advertise<std_msgs::Float32MultiArray>("/manipulation/manip_pln/la_goto_angles", 1);
     JustinaManip::pubRaGoToAngles = nh->advertise<std_msgs::Float32MultiArray>("/manipulation/manip_pln/ra_goto_angles", 1);
@@ -112,84 +115,56 @@ bool JustinaManip::setNodeHandle(ros::NodeHandle* nh)
 
 bool JustinaManip::isLaGoalReached()
 {
-    return JustinaManip::_isLaGoalReached;
+    return JustinaManip::_isLaGoalReached.IsSet();
 }
 
 bool JustinaManip::isRaGoalReached()
 {
-    return JustinaManip::_isRaGoalReached;
+    return JustinaManip::_isRaGoalReached.IsSet();
 }
 
 bool JustinaManip::isHdGoalReached()
 {
     //std::cout << "JustinaManip.-> isHdGoalReached: " << JustinaManip::_isHdGoalReached << std::endl;
-    return JustinaManip::_isHdGoalReached;
+    return JustinaManip::_isHdGoalReached.IsSet();
 }
 
 bool JustinaManip::isTorsoGoalReached()
 {
-    return JustinaManip::_isTrGoalReached;
+    return JustinaManip::_isTrGoalReached.IsSet();
 }
 
 bool JustinaManip::waitForLaGoalReached(int timeOut_ms)
 {
-    int attempts = timeOut_ms / 100;
-    ros::Rate loop(10);
-    JustinaManip::_stopReceived = false;
-    JustinaManip::_isLaGoalReached = false;
-    while(ros::ok() && !JustinaManip::_isLaGoalReached && !JustinaManip::_stopReceived && attempts-- >= 0)
-    {
-        ros::spinOnce();
-        loop.sleep();
-    }
-    JustinaManip::_stopReceived = false; //This flag is set True in the subscriber callback
-    return JustinaManip::_isLaGoalReached;
+    JustinaManip::_stopReceived.Reset();
+    JustinaEvent::WaitAny(JustinaManip::_isLaGoalReached, JustinaManip::_stopReceived, timeOut_ms);
+    JustinaManip::_stopReceived.Reset(); //This flag is set True in the subscriber callback
+    return JustinaManip::_isLaGoalReached.IsSet();
 }
 
 bool JustinaManip::waitForRaGoalReached(int timeOut_ms)
 {
-    int attempts = timeOut_ms / 100;
-    ros::Rate loop(10);
-    JustinaManip::_stopReceived = false;
-    JustinaManip::_isRaGoalReached = false;
-    while(ros::ok() && !JustinaManip::_isRaGoalReached && !JustinaManip::_stopReceived && attempts-- >= 0)
-    {
-        ros::spinOnce();
-        loop.sleep();
-    }
-    JustinaManip::_stopReceived = false; //This flag is set True in the subscriber callback
-    return JustinaManip::_isRaGoalReached;
+    JustinaManip::_stopReceived.Reset();
+    JustinaEvent::WaitAny(JustinaManip::_isRaGoalReached, JustinaManip::_stopReceived, timeOut_ms);
+    JustinaManip::_stopReceived.Reset(); //This flag is set True in the subscriber callback
+    return JustinaManip::_isRaGoalReached.IsSet();
 }
 
 bool JustinaManip::waitForHdGoalReached(int timeOut_ms)
 {
-    int attempts = timeOut_ms / 100;
-    ros::Rate loop(10);
-    JustinaManip::_stopReceived = false;
-    JustinaManip::_isHdGoalReached = false;
-    while(ros::ok() && !JustinaManip::_isHdGoalReached && !JustinaManip::_stopReceived && attempts-- >= 0)
-    {
-        ros::spinOnce();
-        loop.sleep();
-    }
-    JustinaManip::_stopReceived = false; //This flag is set True in the subscriber callback
-    return JustinaManip::_isHdGoalReached;
+    JustinaManip::_stopReceived.Reset();
+    JustinaEvent::WaitAny(JustinaManip::_isHdGoalReached, JustinaManip::_stopReceived, timeOut_ms);
+    JustinaManip::_stopReceived.Reset(); //This flag is set True in the subscriber callback
+    return JustinaManip::_isHdGoalReached.IsSet();
 }
 
 
 bool JustinaManip::waitForTorsoGoalReached(int timeOut_ms)
 {
-    int attempts = timeOut_ms / 100;
-    ros::Rate loop(10);
-    JustinaManip::_stopReceived = false;
-    JustinaManip::_isTrGoalReached = false;
-    while(ros::ok() && !JustinaManip::_isTrGoalReached && !JustinaManip::_stopReceived && attempts-- >= 0)
-    {
-        ros::spinOnce();
-        loop.sleep();
-    }
-    JustinaManip::_stopReceived = false; //This flag is set True in the subscriber callback
-    return JustinaManip::_isTrGoalReached;
+    JustinaManip::_stopReceived.Reset();
+    JustinaEvent::WaitAny(JustinaManip::_isTrGoalReached, JustinaManip::_stopReceived, timeOut_ms);
+    JustinaManip::_stopReceived.Reset(); //This flag is set True in the subscriber callback
+    return JustinaManip::_isTrGoalReached.IsSet();
 }
 
 bool JustinaManip::inverseKinematics(std::vector<float>& cartesian, std::vector<float>& articular)
@@ -247,6 +222,7 @@ void JustinaManip::startLaGoToArticular(std::vector<float>& articular)
 {
     std_msgs::Float32MultiArray msg;
     msg.data = articular;
+    JustinaManip::_isLaGoalReached.Reset();
     JustinaManip::pubLaGoToAngles.publish(msg);
 }
 
@@ -254,6 +230,7 @@ void JustinaManip::startLaGoToCartesian(std::vector<float>& cartesian)
 {
     std_msgs::Float32MultiArray msg;
     msg.data = cartesian;
+    JustinaManip::_isLaGoalReached.Reset();
     JustinaManip::pubLaGoToPoseWrtArm.publish(msg);
 }
 
@@ -267,6 +244,7 @@ void JustinaManip::startLaGoToCartesian(float x, float y, float z, float roll, f
     msg.data.push_back(pitch);
     msg.data.push_back(yaw);
     msg.data.push_back(elbow);
+    JustinaManip::_isLaGoalReached.Reset();
     JustinaManip::pubLaGoToPoseWrtArm.publish(msg);
 }
 
@@ -276,6 +254,7 @@ void JustinaManip::startLaGoToCartesian(float x, float y, float z)
     msg.data.push_back(x);
     msg.data.push_back(y);
     msg.data.push_back(z);
+    JustinaManip::_isLaGoalReached.Reset();
     JustinaManip::pubLaGoToPoseWrtArm.publish(msg);
 }
 
@@ -283,6 +262,7 @@ void JustinaManip::startLaGoToCartesianWrtRobot(std::vector<float>& cartesian)
 {
     std_msgs::Float32MultiArray msg;
     msg.data = cartesian;
+    JustinaManip::_isLaGoalReached.Reset();
     JustinaManip::pubLaGoToPoseWrtRobot.publish(msg);
 }
 
@@ -296,6 +276,7 @@ void JustinaManip::startLaGoToCartesianWrtRobot(float x, float y, float z, float
     msg.data.push_back(pitch);
     msg.data.push_back(yaw);
     msg.data.push_back(elbow);
+    JustinaManip::_isLaGoalReached.Reset();
     JustinaManip::pubLaGoToPoseWrtRobot.publish(msg);
 }
 
@@ -303,6 +284,7 @@ void JustinaManip::startLaGoTo(std::string location)
 {
     std_msgs::String msg;
     msg.data = location;
+    JustinaManip::_isLaGoalReached.Reset();
     JustinaManip::pubLaGoToLoc.publish(msg);
 
 }
@@ -311,6 +293,7 @@ void JustinaManip::startLaMove(std::string movement)
 {
     std_msgs::String msg;
     msg.data = movement;
+    JustinaManip::_isLaGoalReached.Reset();
     JustinaManip::pubLaMove.publish(msg);
 }
 
@@ -334,6 +317,7 @@ void JustinaManip::startRaGoToArticular(std::vector<float>& articular)
 {
     std_msgs::Float32MultiArray msg;
     msg.data = articular;
+    JustinaManip::_isRaGoalReached.Reset();
     JustinaManip::pubRaGoToAngles.publish(msg);
 }
 
@@ -341,6 +325,7 @@ void JustinaManip::startRaGoToCartesian(std::vector<float>& cartesian)
 {
     std_msgs::Float32MultiArray msg;
     msg.data = cartesian;
+    JustinaManip::_isRaGoalReached.Reset();
     JustinaManip::pubRaGoToPoseWrtArm.publish(msg);
 }
 
@@ -354,6 +339,7 @@ void JustinaManip::startRaGoToCartesian(float x, float y, float z, float roll, f
     msg.data.push_back(pitch);
     msg.data.push_back(yaw);
     msg.data.push_back(elbow);
+    JustinaManip::_isRaGoalReached.Reset();
     JustinaManip::pubRaGoToPoseWrtArm.publish(msg);
 }
 
@@ -363,6 +349,7 @@ void JustinaManip::startRaGoToCartesian(float x, float y, float z)
     msg.data.push_back(x);
     msg.data.push_back(y);
     msg.data.push_back(z);
+    JustinaManip::_isRaGoalReached.Reset();
     JustinaManip::pubRaGoToPoseWrtArm.publish(msg);
 }
 
@@ -370,6 +357,7 @@ void JustinaManip::startRaGoToCartesianWrtRobot(std::vector<float>& cartesian)
 {
     std_msgs::Float32MultiArray msg;
     msg.data = cartesian;
+    JustinaManip::_isRaGoalReached.Reset();
     JustinaManip::pubRaGoToPoseWrtRobot.publish(msg);
 }
 
@@ -383,6 +371,7 @@ void JustinaManip::startRaGoToCartesianWrtRobot(float x, float y, float z, float
     msg.data.push_back(pitch);
     msg.data.push_back(yaw);
     msg.data.push_back(elbow);
+    JustinaManip::_isRaGoalReached.Reset();
     JustinaManip::pubRaGoToPoseWrtRobot.publish(msg);
 }
 
@@ -390,6 +379,7 @@ void JustinaManip::startRaGoTo(std::string location)
 {
     std_msgs::String msg;
     msg.data = location;
+    JustinaManip::_isRaGoalReached.Reset();
     JustinaManip::pubRaGoToLoc.publish(msg);
 }
 
@@ -397,6 +387,7 @@ void JustinaManip::startRaMove(std::string movement)
 {
     std_msgs::String msg;
     msg.data = movement;
+    JustinaManip::_isRaGoalReached.Reset();
     JustinaManip::pubRaMove.publish(msg);
 }
 
@@ -421,6 +412,7 @@ void JustinaManip::startHdGoTo(float pan, float tilt)
     std_msgs::Float32MultiArray msg;
     msg.data.push_back(pan);
     msg.data.push_back(tilt);
+    JustinaManip::_isHdGoalReached.Reset();
     JustinaManip::pubHdGoToAngles.publish(msg);
 }
 
@@ -428,6 +420,7 @@ void JustinaManip::startHdGoTo(std::string location)
 {
     std_msgs::String msg;
     msg.data = location;
+    JustinaManip::_isHdGoalReached.Reset();
     JustinaManip::pubHdGoToLoc.publish(msg);
 }
 
@@ -435,6 +428,7 @@ void JustinaManip::startHdMove(std::string movement)
 {
     std_msgs::String msg;
     msg.data = movement;
+    JustinaManip::_isHdGoalReached.Reset();
     JustinaManip::pubHdMove.publish(msg);
 }
 
@@ -444,6 +438,7 @@ void JustinaManip::startTorsoGoTo(float goalSpine, float goalWaist, float goalSh
     msg.data.push_back(goalSpine);
     msg.data.push_back(goalWaist);
     msg.data.push_back(goalShoulders);
+    JustinaManip::_isTrGoalReached.Reset();
     JustinaManip::pubTrGoToPose.publish(msg);
 }
 
@@ -453,6 +448,7 @@ void JustinaManip::startTorsoGoToRel(float goalRelSpine, float goalRelWaist, flo
     msg.data.push_back(goalRelSpine);
     msg.data.push_back(goalRelWaist);
     msg.data.push_back(goalRelShoulders);
+    JustinaManip::_isTrGoalReached.Reset();
     JustinaManip::pubTrGoToRelPose.publish(msg);
 }
 
@@ -618,27 +614,27 @@ void JustinaManip::getLeftHandPosition(float &x, float &y, float &z){
 //
 void JustinaManip::callbackRobotStop(const std_msgs::Empty::ConstPtr& msg)
 {
-    JustinaManip::_stopReceived = true;
+    JustinaManip::_stopReceived.Set();
 }
 
 void JustinaManip::callbackLaGoalReached(const std_msgs::Bool::ConstPtr& msg)
 {
-    JustinaManip::_isLaGoalReached = msg->data;
+    JustinaManip::_isLaGoalReached.Set(msg->data);
 }
 
 void JustinaManip::callbackRaGoalReached(const std_msgs::Bool::ConstPtr& msg)
 {
-    JustinaManip::_isRaGoalReached = msg->data;
+    JustinaManip::_isRaGoalReached.Set(msg->data);
 }
 
 void JustinaManip::callbackHdGoalReached(const std_msgs::Bool::ConstPtr& msg)
 {
-    JustinaManip::_isHdGoalReached = msg->data;
+    JustinaManip::_isHdGoalReached.Set(msg->data);
 }
 
 void JustinaManip::callbackTrGoalReached(const std_msgs::Bool::ConstPtr& msg)
 {
-    JustinaManip::_isTrGoalReached = msg->data;
+    JustinaManip::_isTrGoalReached.Set(msg->data);
 }
 
 void JustinaManip::callbackObjOnRightHand(const std_msgs::Bool::ConstPtr& msg)
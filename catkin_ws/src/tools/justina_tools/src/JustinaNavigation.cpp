@@ -10,6 +10,7 @@ ros::Publisher JustinaNavigation::pubSimpleMoveDist;
 ros::Publisher JustinaNavigation::pubSimpleMoveDistAngle;
 ros::Publisher JustinaNavigation::pubSimpleMoveLateral;
 ros::Publisher JustinaNavigation::pubSimpleMoveGoalPath;
+ros::Publisher JustinaNavigation::pubLocalPlannerGoalPath;
 ros::Publisher JustinaNavigation::pubSimpleMoveGoalPose;
 ros::Publisher JustinaNavigation::pubSimpleMoveGoalRelPose;
 //Services for path calculator
@@ -34,11 +35,11 @@ float JustinaNavigation::currentRobotX = 0;
 float JustinaNavigation::currentRobotY = 0;
 float JustinaNavigation::currentRobotTheta = 0;
 nav_msgs::Path JustinaNavigation::lastCalcPath;
-bool JustinaNavigation::_isGoalReached = 0;
-bool JustinaNavigation::_isGlobalGoalReached = 0;
-bool JustinaNavigation::_stopReceived = false;
-bool JustinaNavigation::_obstacleInFront = false;
-bool JustinaNavigation::_collisionRisk;
+JustinaEvent JustinaNavigation::_isGoalReached;
+JustinaEvent JustinaNavigation::_isGlobalGoalReached;
+JustinaEvent JustinaNavigation::_stopReceived;
+JustinaEvent JustinaNavigation::_obstacleInFront;
+JustinaEvent JustinaNavigation::_collisionRisk;
 
 //
 //The startSomething functions, only publish the goal pose or path and return inmediately after starting movement
@@ -53,16 +54,20 @@ bool JustinaNavigation::setNodeHandle(ros::NodeHandle* nh)
         return false;
 
     std::cout << "JustinaNavigation.->Setting ros node..." << std::endl;
+    //Callbacks of goal reached, stop and obstacles signal events, they are attended by the event spinner
+    JustinaEvent::SetNodeHandle(nh);
+    ros::NodeHandle* nhEvents = JustinaEvent::GetNodeHandle();
     //Subscriber for checking goal-pose-reached signal
     tf_listener = new tf::TransformListener();
-    subGoalReached = nh->subscribe("/navigation/goal_reached", 1, &JustinaNavigation::callbackGoalReached);
-    subGlobalGoalReached = nh->subscribe("/navigation/global_goal_reached", 1, &JustinaNavigation::callbackGlobalGoalReached);
-    subStopRobot = nh->subscribe("/hardware/robot_state/stop", 1, &JustinaNavigation::callbackRobotStop);
+    subGoalReached = nhEvents->subscribe("/navigation/goal_reached", 1, &JustinaNavigation::callbackGoalReached);
+    subGlobalGoalReached = nhEvents->subscribe("/navigation/global_goal_reached", 1, &JustinaNavigation::callbackGlobalGoalReached);
+    subStopRobot = nhEvents->subscribe("/hardware/robot_state/stop", 1, &JustinaNavigation::callbackRobotStop);
     //Publishers and subscribers for operating the simple_move node
     pubSimpleMoveDist = nh->advertise<std_msgs::Float32>("/navigation/path_planning/simple_move/goal_dist", 1);
     pubSimpleMoveDistAngle=nh->advertise<std_msgs::Float32MultiArray>("/navigation/path_planning/simple_move/goal_dist_angle",1);
     pubSimpleMoveLateral = nh->advertise<std_msgs::Float32>("/navigation/path_planning/simple_move/goal_lateral", 1);
     pubSimpleMoveGoalPath = nh->advertise<nav_msgs::Path>("/navigation/path_planning/simple_move/goal_path", 1);
+    pubLocalPlannerGoalPath = nh->advertise<nav_msgs::Path>("/navigation/path_planning/local_planner/goal_path", 1);
     pubSimpleMoveGoalPose = nh->advertise<geometry_msgs::Pose2D>("/navigation/path_planning/simple_move/goal_pose", 1);
     pubSimpleMoveGoalRelPose = nh->advertise<geometry_msgs::Pose2D>("/navigation/path_planning/simple_move/goal_rel_pose", 1);
     //Services for path calculator
@@ -76,8 +81,8 @@ bool JustinaNavigation::setNodeHandle(ros::NodeHandle* nh)
     pubMvnPlnGetCloseXYA = nh->advertise<std_msgs::Float32MultiArray>("/navigation/mvn_pln/get_close_xya", 1);
     //Subscribers and publishers for obstacle avoidance
     pubObsAvoidEnable = nh->advertise<std_msgs::Bool>("/navigation/obs_avoid/enable", 1);
-    subObsInFront = nh->subscribe("/navigation/obs_avoid/obs_in_front", 1, &JustinaNavigation::callbackObstacleInFront);
-    subCollisionRisk = nh->subscribe("/navigation/obs_avoid/collision_risk", 1, &JustinaNavigation::callbackCollisionRisk);
+    subObsInFront = nhEvents->subscribe("/navigation/obs_avoid/obs_in_front", 1, &JustinaNavigation::callbackObstacleInFront);
+    subCollisionRisk = nhEvents->subscribe("/navigation/obs_avoid/collision_risk", 1, &JustinaNavigation::callbackCollisionRisk);
     //Publishers and subscribers for localization
     subCurrentRobotPose = nh->subscribe("/navigation/localization/current_pose", 1, &JustinaNavigation::callbackCurrentRobotPose);
     tf_listener->waitForTransform("map", "base_link", ros::Time(0), ros::Duration(5.0));
@@ -89,41 +94,38 @@ bool JustinaNavigation::setNodeHandle(ros::NodeHandle* nh)
 bool JustinaNavigation::isGoalReached()
 {
     //std::cout << "JustinaNavigation.->Goal reched: " << JustinaNavigation::_isGoalReached << std::endl;
-    return JustinaNavigation::_isGoalReached;
+    return JustinaNavigation::_isGoalReached.IsSet();
 }
 
 bool JustinaNavigation::isGlobalGoalReached()
 {
     //std::cout << "JustinaNavigation.->Goal reched: " << JustinaNavigation::_isGoalReached << std::endl;
-    return JustinaNavigation::_isGlobalGoalReached;
+    return JustinaNavigation::_isGlobalGoalReached.IsSet();
 }
 
 bool JustinaNavigation::waitForGoalReached(int timeOut_ms)
 {
-    int attempts = timeOut_ms / 100;
-    ros::Rate loop(10);
-    JustinaNavigation::_stopReceived = false;
-    while(ros::ok() && !JustinaNavigation::_isGoalReached && !JustinaNavigation::_stopReceived && attempts-- >= 0)
-    {
-        ros::spinOnce();
-        loop.sleep();
-    }
-    JustinaNavigation::_stopReceived = false; //This flag is set True in the subscriber callback
-    return JustinaNavigation::_isGoalReached;
+    JustinaNavigation::_stopReceived.Reset();
+    JustinaEvent::WaitAny(JustinaNavigation::_isGoalReached, JustinaNavigation::_stopReceived, timeOut_ms);
+    JustinaNavigation::_stopReceived.Reset(); //This flag is set True in the subscriber callback
+    return JustinaNavigation::_isGoalReached.IsSet();
 }
 
 bool JustinaNavigation::waitForGlobalGoalReached(int timeOut_ms)
 {
-    int attempts = timeOut_ms / 100;
-    ros::Rate loop(10);
-    JustinaNavigation::_stopReceived = false;
-    while(ros::ok() && !JustinaNavigation::_isGlobalGoalReached && !JustinaNavigation::_stopReceived && attempts-- >= 0)
-    {
-        ros::spinOnce();
-        loop.sleep();
-    }
-    JustinaNavigation::_stopReceived = false; //This flag is set True in the subscriber callback
-    return JustinaNavigation::_isGlobalGoalReached;
+    JustinaNavigation::_stopReceived.Reset();
+    JustinaEvent::WaitAny(JustinaNavigation::_isGlobalGoalReached, JustinaNavigation::_stopReceived, timeOut_ms);
+    JustinaNavigation::_stopReceived.Reset(); //This flag is set True in the subscriber callback
+    return JustinaNavigation::_isGlobalGoalReached.IsSet();
+}
+
+bool JustinaNavigation::waitForGoalReachedOrCollisionRisk(int timeOut_ms)
+{
+    JustinaNavigation::_stopReceived.Reset();
+    JustinaEvent::WaitAny(JustinaNavigation::_isGoalReached, JustinaNavigation::_stopReceived,
+                          JustinaNavigation::_collisionRisk, timeOut_ms);
+    JustinaNavigation::_stopReceived.Reset();
+    return JustinaNavigation::_isGoalReached.IsSet();
 }
 
 void JustinaNavigation::getRobotPose(float& currentX, float& currentY, float& currentTheta)
@@ -157,12 +159,12 @@ void JustinaNavigation::getRobotPoseFromOdom(float& currentX, float& currentY,
 //Methods for obstacle avoidance
 bool JustinaNavigation::obstacleInFront()
 {
-    return JustinaNavigation::_obstacleInFront;
+    return JustinaNavigation::_obstacleInFront.IsSet();
 }
 
 bool JustinaNavigation::collisionRisk()
 {
-    return JustinaNavigation::_collisionRisk;
+    return JustinaNavigation::_collisionRisk.IsSet();
 }
 
 void JustinaNavigation::enableObstacleDetection(bool enable)
@@ -181,7 +183,7 @@ void JustinaNavigation::startMoveDist(float distance)
 {
     std_msgs::Float32 msg;
     msg.data = distance;
-    JustinaNavigation::_isGoalReached = false;
+    JustinaNavigation::_isGoalReached.Reset();
     pubSimpleMoveDist.publish(msg);
 }
 
@@ -190,7 +192,7 @@ void JustinaNavigation::startMoveDistAngle(float distance, float angle)
     std_msgs::Float32MultiArray msg;
     msg.data.push_back(distance);
     msg.data.push_back(angle);
-    JustinaNavigation::_isGoalReached = false;
+    JustinaNavigation::_isGoalReached.Reset();
     pubSimpleMoveDistAngle.publish(msg);
 }
 
@@ -199,24 +201,31 @@ void JustinaNavigation::startMoveLateral(float distance)
     std::cout << "JustinaNavigation.->Publishing goal lateral distance: " << distance << std::endl;
     std_msgs::Float32 msg;
     msg.data = distance;
-    JustinaNavigation::_isGoalReached = false;
+    JustinaNavigation::_isGoalReached.Reset();
     JustinaNavigation::pubSimpleMoveLateral.publish(msg);
 }
 
 void JustinaNavigation::startMovePath(nav_msgs::Path& path)
 {
     std::cout << "JustinaNavigation.->Publishing goal path.." << std::endl;
-    JustinaNavigation::_isGoalReached = false;
+    JustinaNavigation::_isGoalReached.Reset();
     JustinaNavigation::pubSimpleMoveGoalPath.publish(path);
 }
 
+void JustinaNavigation::startMovePathLocalPlanner(nav_msgs::Path& path)
+{
+    std::cout << "JustinaNavigation.->Publishing goal path to local planner.." << std::endl;
+    JustinaNavigation::_isGoalReached.Reset();
+    JustinaNavigation::pubLocalPlannerGoalPath.publish(path);
+}
+
 void JustinaNavigation::startGoToPose(float x, float y, float angle)
 {
     geometry_msgs::Pose2D msg;
     msg.x = x;
     msg.y = y;
     msg.theta = angle;
-    JustinaNavigation::_isGoalReached = false;
+    JustinaNavigation::_isGoalReached.Reset();
     pubSimpleMoveGoalPose.publish(msg);
 }
 
@@ -226,7 +235,7 @@ void JustinaNavigation::startGoToRelPose(float relX, float relY, float relTheta)
     msg.x = relX;
     msg.y = relY;
     msg.theta = relTheta;
-    JustinaNavigation::_isGoalReached = false;
+    JustinaNavigation::_isGoalReached.Reset();
     pubSimpleMoveGoalRelPose.publish(msg);
 }
 
@@ -341,7 +350,7 @@ void JustinaNavigation::startGetClose(float x, float y)
     std_msgs::Float32MultiArray msg;
     msg.data.push_back(x);
     msg.data.push_back(y);
-    JustinaNavigation::_isGlobalGoalReached = false;
+    JustinaNavigation::_isGlobalGoalReached.Reset();
     pubMvnPlnGetCloseXYA.publish(msg);
 }
 
@@ -351,7 +360,7 @@ void JustinaNavigation::startGetClose(float x, float y, float angle)
     msg.data.push_back(x);
     msg.data.push_back(y);
     msg.data.push_back(angle);
-    JustinaNavigation::_isGlobalGoalReached = false;
+    JustinaNavigation::_isGlobalGoalReached.Reset();
     pubMvnPlnGetCloseXYA.publish(msg);
 }
 
@@ -359,7 +368,7 @@ void JustinaNavigation::startGetClose(std::string location)
 {
     std_msgs::String msg;
     msg.data = location;
-    JustinaNavigation::_isGlobalGoalReached = false;
+    JustinaNavigation::_isGlobalGoalReached.Reset();
     pubMvnPlnGetCloseLoc.publish(msg);
 }
 
@@ -478,18 +487,18 @@ void JustinaNavigation::callbackCurrentRobotPose(const geometry_msgs::PoseWithCo
 
 void JustinaNavigation::callbackRobotStop(const std_msgs::Empty::ConstPtr& msg)
 {
-    JustinaNavigation::_stopReceived = true;
+    JustinaNavigation::_stopReceived.Set();
 }
 
 void JustinaNavigation::callbackGoalReached(const std_msgs::Bool::ConstPtr& msg)
 {
-    JustinaNavigation::_isGoalReached = msg->data;
+    JustinaNavigation::_isGoalReached.Set(msg->data);
     //std::cout << "JustinaNavigation.->Received goal reached: " << int(msg->data) << std::endl;
 }
 
 void JustinaNavigation::callbackGlobalGoalReached(const std_msgs::Bool::ConstPtr& msg)
 {
-    JustinaNavigation::_isGlobalGoalReached = msg->data;
+    JustinaNavigation::_isGlobalGoalReached.Set(msg->data);
     //std::cout << "JustinaNavigation.->Received global goal reached: " << int(msg->data) << std::endl;
 }
 
@@ -497,11 +506,11 @@ void JustinaNavigation::callbackGlobalGoalReached(const std_msgs::Bool::ConstPtr
 //Callbacks for obstacle avoidance
 void JustinaNavigation::callbackObstacleInFront(const std_msgs::Bool::ConstPtr& msg)
 {
-    JustinaNavigation::_obstacleInFront = msg->data;
+    JustinaNavigation::_obstacleInFront.Set(msg->data);
 }
 
 void JustinaNavigation::callbackCollisionRisk(const std_msgs::Bool::ConstPtr& msg)
 {
     //std::cout << "JustinaNvigation.-<CollisionRisk: " << int(msg->data) << std::endl;
-    JustinaNavigation::_collisionRisk = msg->data;
+    JustinaNavigation::_collisionRisk.Set(msg->data);
 }
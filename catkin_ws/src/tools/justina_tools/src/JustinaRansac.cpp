@@ -0,0 +1,205 @@
+#include "justina_tools/JustinaRansac.h"
+
+int RansacPoints::RemoveFlagged(const std::vector<unsigned char>& flags)
+{
+	int kept = 0;
+	for(size_t i = 0; i < this->x.size(); i++)
+	{
+		if(flags[i] != 0)
+			continue;
+		this->x[kept] = this->x[i];
+		this->y[kept] = this->y[i];
+		this->z[kept] = this->z[i];
+		kept++;
+	}
+	this->x.resize(kept);
+	this->y.resize(kept);
+	this->z.resize(kept);
+	return kept;
+}
+
+//Mean and covariance of the inliers, used by the least squares refinements
+static bool inliersCovariance(const RansacPoints& points, const std::vector<int>& inliers, int dims, cv::Vec3d& mean, cv::Mat& cov)
+{
+	if(inliers.size() < 2)
+		return false;
+	double s[3] = {0, 0, 0};
+	double ss[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+	for(size_t i = 0; i < inliers.size(); i++)
+	{
+		double p[3] = {points.x[inliers[i]], points.y[inliers[i]], points.z[inliers[i]]};
+		for(int r = 0; r < dims; r++)
+		{
+			s[r] += p[r];
+			for(int c = r; c < dims; c++)
+				ss[r][c] += p[r]*p[c];
+		}
+	}
+	double n = inliers.size();
+	mean = cv::Vec3d(s[0]/n, s[1]/n, s[2]/n);
+	cov.create(dims, dims, CV_64F);
+	for(int r = 0; r < dims; r++)
+		for(int c = r; c < dims; c++)
+			cov.at<double>(r, c) = cov.at<double>(c, r) = ss[r][c]/n - mean[r]*mean[c];
+	return true;
+}
+
+RansacPlane::RansacPlane()
+{
+	this->a = 0;
+	this->b = 0;
+	this->c = 1;
+	this->d = 0;
+}
+
+bool RansacPlane::FromSample(const RansacPoints& points, const int* sample)
+{
+	float x1 = points.x[sample[1]] - points.x[sample[0]];
+	float y1 = points.y[sample[1]] - points.y[sample[0]];
+	float z1 = points.z[sample[1]] - points.z[sample[0]];
+	float x2 = points.x[sample[2]] - points.x[sample[0]];
+	float y2 = points.y[sample[2]] - points.y[sample[0]];
+	float z2 = points.z[sample[2]] - points.z[sample[0]];
+	float nx = y1*z2 - z1*y2;
+	float ny = z1*x2 - x1*z2;
+	float nz = x1*y2 - y1*x2;
+	float norm = std::sqrt(nx*nx + ny*ny + nz*nz);
+	if(norm < 1e-9f)
+		return false;
+	this->a = nx / norm;
+	this->b = ny / norm;
+	this->c = nz / norm;
+	this->d = -(this->a*points.x[sample[0]] + this->b*points.y[sample[0]] + this->c*points.z[sample[0]]);
+	return true;
+}
+
+bool RansacPlane::Refine(const RansacPoints& points, const std::vector<int>& inliers)
+{
+	//Normal is the eigenvector with the smallest eigenvalue of the covariance
+	cv::Vec3d mean;
+	cv::Mat cov, eigenValues, eigenVectors;
+	if(inliers.size() < 3 || !inliersCovariance(points, inliers, 3, mean, cov) || !cv::eigen(cov, eigenValues, eigenVectors))
+		return false;
+	double nx = eigenVectors.at<double>(2, 0);
+	double ny = eigenVectors.at<double>(2, 1);
+	double nz = eigenVectors.at<double>(2, 2);
+	//Keeps the orientation of the sampled plane
+	if(nx*this->a + ny*this->b + nz*this->c < 0)
+	{
+		nx = -nx;
+		ny = -ny;
+		nz = -nz;
+	}
+	this->a = nx;
+	this->b = ny;
+	this->c = nz;
+	this->d = -(nx*mean[0] + ny*mean[1] + nz*mean[2]);
+	return true;
+}
+
+void RansacPlane::GetInliers(const RansacPoints& points, float threshold, std::vector<int>& inliers) const
+{
+	inliers.clear();
+	for(int i = 0; i < points.Size(); i++)
+		if(std::fabs(this->a*points.x[i] + this->b*points.y[i] + this->c*points.z[i] + this->d) < threshold)
+			inliers.push_back(i);
+}
+
+RansacLine2D::RansacLine2D()
+{
+	this->a = 0;
+	this->b = 1;
+	this->c = 0;
+}
+
+bool RansacLine2D::FromSample(const RansacPoints& points, const int* sample)
+{
+	float dx = points.x[sample[1]] - points.x[sample[0]];
+	float dy = points.y[sample[1]] - points.y[sample[0]];
+	float norm = std::sqrt(dx*dx + dy*dy);
+	if(norm < 1e-9f)
+		return false;
+	this->a = -dy / norm;
+	this->b =  dx / norm;
+	this->c = -(this->a*points.x[sample[0]] + this->b*points.y[sample[0]]);
+	return true;
+}
+
+bool RansacLine2D::Refine(const RansacPoints& points, const std::vector<int>& inliers)
+{
+	//Normal is the eigenvector with the smallest eigenvalue of the covariance
+	cv::Vec3d mean;
+	cv::Mat cov, eigenValues, eigenVectors;
+	if(!inliersCovariance(points, inliers, 2, mean, cov) || !cv::eigen(cov, eigenValues, eigenVectors))
+		return false;
+	this->a = eigenVectors.at<double>(1, 0);
+	this->b = eigenVectors.at<double>(1, 1);
+	this->c = -(this->a*mean[0] + this->b*mean[1]);
+	return true;
+}
+
+void RansacLine2D::GetInliers(const RansacPoints& points, float threshold, std::vector<int>& inliers) const
+{
+	inliers.clear();
+	for(int i = 0; i < points.Size(); i++)
+		if(std::fabs(this->a*points.x[i] + this->b*points.y[i] + this->c) < threshold)
+			inliers.push_back(i);
+}
+
+RansacLine3D::RansacLine3D()
+{
+	this->px = 0;
+	this->py = 0;
+	this->pz = 0;
+	this->ux = 1;
+	this->uy = 0;
+	this->uz = 0;
+}
+
+bool RansacLine3D::FromSample(const RansacPoints& points, const int* sample)
+{
+	float dx = points.x[sample[1]] - points.x[sample[0]];
+	float dy = points.y[sample[1]] - points.y[sample[0]];
+	float dz = points.z[sample[1]] - points.z[sample[0]];
+	float norm = std::sqrt(dx*dx + dy*dy + dz*dz);
+	if(norm < 1e-9f)
+		return false;
+	this->px = points.x[sample[0]];
+	this->py = points.y[sample[0]];
+	this->pz = points.z[sample[0]];
+	this->ux = dx / norm;
+	this->uy = dy / norm;
+	this->uz = dz / norm;
+	return true;
+}
+
+bool RansacLine3D::Refine(const RansacPoints& points, const std::vector<int>& inliers)
+{
+	//Direction is the eigenvector with the largest eigenvalue of the covariance
+	cv::Vec3d mean;
+	cv::Mat cov, eigenValues, eigenVectors;
+	if(!inliersCovariance(points, inliers, 3, mean, cov) || !cv::eigen(cov, eigenValues, eigenVectors))
+		return false;
+	this->px = mean[0];
+	this->py = mean[1];
+	this->pz = mean[2];
+	this->ux = eigenVectors.at<double>(0, 0);
+	this->uy = eigenVectors.at<double>(0, 1);
+	this->uz = eigenVectors.at<double>(0, 2);
+	return true;
+}
+
+void RansacLine3D::GetInliers(const RansacPoints& points, float threshold, std::vector<int>& inliers) const
+{
+	inliers.clear();
+	float threshold2 = threshold*threshold;
+	for(int i = 0; i < points.Size(); i++)
+	{
+		float dx = points.x[i] - this->px;
+		float dy = points.y[i] - this->py;
+		float dz = points.z[i] - this->pz;
+		float proj = dx*this->ux + dy*this->uy + dz*this->uz;
+		if(dx*dx + dy*dy + dz*dz - proj*proj < threshold2)
+			inliers.push_back(i);
+	}
+}
@@ -1267,11 +1267,8 @@ bool JustinaTasks::findAndFollowPersonToLoc(std::string goalLocation) {
 
     JustinaHRI::enableLegFinder(true);
 
-    while (ros::ok() && !JustinaHRI::frontalLegsFound()) {
+    while (ros::ok() && !JustinaHRI::waitForFrontalLegsFound(1000))
         std::cout << "Not found a legs try to found." << std::endl;
-        boost::this_thread::sleep(boost::posix_time::milliseconds(1000));
-        ros::spinOnce();
-    }
 
     JustinaHRI::startFollowHuman();
 
@@ -2213,7 +2210,7 @@ bool JustinaTasks::followAPersonAndRecogStop(std::string stopRecog){
                 break;
             case SM_WAIT_FOR_LEGS_FOUND:
                 std::cout << "State machine: SM_WAIT_FOR_LEGS_FOUND" << std::endl;
-                if(JustinaHRI::frontalLegsFound()){
+                if(JustinaHRI::waitForFrontalLegsFound(1000)){
                     std::cout << "NavigTest.->Frontal legs found!" << std::endl;
                     JustinaHRI::startFollowHuman();
                     JustinaHRI::waitAfterSay("I found you, i will start to follow you human, please walk and tell me, stop follow me, when we reached the goal location", 10000);
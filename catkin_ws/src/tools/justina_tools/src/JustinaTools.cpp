@@ -1,4 +1,5 @@
 #include "justina_tools/JustinaTools.h"
+#include <cstring>
 
 bool JustinaTools::is_node_set = false;
 tf::TransformListener* JustinaTools::tf_listener;
@@ -59,97 +60,90 @@ void JustinaTools::laserScanToPclCylindrical(const sensor_msgs::LaserScan::Const
 
 void JustinaTools::PointCloud2Msg_ToCvMat(sensor_msgs::PointCloud2& pc_msg, cv::Mat& bgr_dest, cv::Mat& pc_dest)
 {
-  /*
-	//std::cout << "ObjectDetectorNode.-> Transforming from PointCloud2 ros message to cv::Mat type" << std::endl;
-	//std::cout << "ObjectDetectorNode.-> Width= " << pc_msg.width << "  height= " << pc_msg.height << std::endl;
-	pcl::PointCloud<pcl::PointXYZRGBA> pc_pcl;
-	pcl::fromROSMsg(pc_msg, pc_pcl);  //Transform from PointCloud2 msg to pointCloud (from pcl) type
-
-	if(!pc_pcl.isOrganized())
-	{
-		std::cout << "ObjectDetectorNode.->Point cloud is not organized!! O M G!!!!" << std::endl;
-		return;
-	}
-	//std::cout << "ObjectDetectorNode.-> Pcl_w= " << pc_pcl.width << "  pcl_h= " << pc_pcl.height << std::endl;
-	bgr_dest = cv::Mat::zeros(pc_pcl.height, pc_pcl.width, CV_8UC3);
-	pc_dest = cv::Mat::zeros(pc_pcl.height, pc_pcl.width, CV_32FC3);
-	
-	pcl::PointXYZRGBA p_ = pc_pcl.at(320, 240);
-	//std::cout<<"ObjectDetectorNode: Middle point: "<<p_.x << " " <<p_.y <<" "<<p_.z <<" "<< p_.r<<" "<<p_.g<<" "<< p_.b << std::endl;
-	for (int h=0; h<bgr_dest.rows; h++)
-		for (int w=0; w<bgr_dest.cols; w++)
-		{
-			pcl::PointXYZRGBA p = pc_pcl.at(w, h);
+    JustinaTools::PointCloud2Msg_ToCvMat((const sensor_msgs::PointCloud2&)pc_msg, bgr_dest, pc_dest);
+}
 
-			bgr_dest.data[h*bgr_dest.step + w*3] = (unsigned char)p.b;
-			bgr_dest.data[h*bgr_dest.step + w*3 + 1] = (unsigned char)p.g;
-			bgr_dest.data[h*bgr_dest.step + w*3 + 2] = (unsigned char)p.r;
-			pc_dest.at<cv::Vec3f>(h,w)[0] = isnan(p.x) ? 0.0 : p.x;
-			pc_dest.at<cv::Vec3f>(h,w)[1] = isnan(p.y) ? 0.0 : p.y;
-			pc_dest.at<cv::Vec3f>(h,w)[2] = isnan(p.z) ? 0.0 : p.z;
-		}
-	*/
-	bgr_dest = cv::Mat::zeros(pc_msg.height, pc_msg.width, CV_8UC3);
-	pc_dest  = cv::Mat::zeros(pc_msg.height, pc_msg.width, CV_32FC3);
-	for(int i=0; i < bgr_dest.cols; i++)
-	  for(int j=0; j < bgr_dest.rows; j++)
-	    {
-	      float* x = (float*)&pc_msg.data[(j*pc_msg.width + i)*16];
-	      float* y = (float*)&pc_msg.data[(j*pc_msg.width + i)*16 + 4];
-	      float* z = (float*)&pc_msg.data[(j*pc_msg.width + i)*16 + 8];
-	      pc_dest.at<cv::Vec3f>(j, i)[0] = *x;
-	      pc_dest.at<cv::Vec3f>(j, i)[1] = *y;
-	      pc_dest.at<cv::Vec3f>(j, i)[2] = *z;
-	      bgr_dest.data[j*bgr_dest.step + i*3]     = pc_msg.data[(j*pc_msg.width + i)*16 + 12];
-	      bgr_dest.data[j*bgr_dest.step + i*3 + 1] = pc_msg.data[(j*pc_msg.width + i)*16 + 13];
-	      bgr_dest.data[j*bgr_dest.step + i*3 + 2] = pc_msg.data[(j*pc_msg.width + i)*16 + 14];
-	    }
+void JustinaTools::PointCloud2Msg_ToCvMat(const sensor_msgs::PointCloud2::ConstPtr& pc_msg, cv::Mat& bgr_dest, cv::Mat& pc_dest)
+{
+    JustinaTools::PointCloud2Msg_ToCvMat(*pc_msg, bgr_dest, pc_dest);
 }
 
+void JustinaTools::PointCloud2Msg_ToCvMat(const sensor_msgs::PointCloud2& pc_msg, cv::Mat& bgr_dest, cv::Mat& pc_dest)
+{
+    //Destination matrices are reallocated only if size changes, so, callers keeping them between frames do not allocate.
+    //Every pixel is written, thus, there is no need to clear them.
+    bgr_dest.create(pc_msg.height, pc_msg.width, CV_8UC3);
+    pc_dest.create(pc_msg.height, pc_msg.width, CV_32FC3);
+    int xOffset, rgbOffset;
+    JustinaTools::getPointCloud2Offsets(pc_msg, xOffset, rgbOffset);
+    if(pc_msg.data.size() < (size_t)pc_msg.height * pc_msg.row_step || xOffset < 0)
+    {
+        bgr_dest.setTo(0);
+        pc_dest.setTo(0);
+        return;
+    }
+    for(int j=0; j < bgr_dest.rows; j++)
+    {
+        const unsigned char* src = &pc_msg.data[j*pc_msg.row_step];
+        float* xyz = pc_dest.ptr<float>(j);
+        unsigned char* bgr = bgr_dest.ptr<unsigned char>(j);
+        for(int i=0; i < bgr_dest.cols; i++, src += pc_msg.point_step, xyz += 3, bgr += 3)
+        {
+            memcpy(xyz, src + xOffset, 3*sizeof(float));
+            if(rgbOffset >= 0)
+                memcpy(bgr, src + rgbOffset, 3);
+            else
+                bgr[0] = bgr[1] = bgr[2] = 0;
+        }
+    }
+}
 
-void JustinaTools::PointCloud2Msg_ToCvMat(const sensor_msgs::PointCloud2::ConstPtr& pc_msg, cv::Mat& bgr_dest, cv::Mat& pc_dest)
+bool JustinaTools::PointCloud2Msg_ToCvMatView(const sensor_msgs::PointCloud2& pc_msg, cv::Mat& bgr_view, cv::Mat& xyz_view, int& bgr_channel)
 {
-  /*pcl::PointCloud<pcl::PointXYZRGB> pc_pcl;
-	pcl::fromROSMsg(*pc_msg, pc_pcl);  //Transform from PointCloud2 msg to pointCloud (from pcl) type
+    //Headers point to the message buffer, no pixel is copied. Both views start at the first byte of each point and
+    //element of pixel (i,j) is the whole point, thus, no element goes beyond the end of the buffer. x,y,z are the
+    //first three floats of xyz_view.ptr<float>(j) + i*xyz_view.channels() and b,g,r are the bytes from
+    //bgr_view.ptr<unsigned char>(j) + i*bgr_view.channels() + bgr_channel.
+    int xOffset, rgbOffset;
+    JustinaTools::getPointCloud2Offsets(pc_msg, xOffset, rgbOffset);
+    if(xOffset != 0 || rgbOffset < 0 || rgbOffset + 3 > (int)pc_msg.point_step || pc_msg.point_step % 4 != 0 ||
+       pc_msg.point_step > CV_CN_MAX || pc_msg.width == 0 || pc_msg.height == 0 ||
+       pc_msg.row_step < pc_msg.width * pc_msg.point_step || pc_msg.data.size() < (size_t)pc_msg.height * pc_msg.row_step)
+    {
+        std::cout << "JustinaTools.->Cannot create view of point cloud: unexpected point layout." << std::endl;
+        bgr_view.release();
+        xyz_view.release();
+        return false;
+    }
+    unsigned char* data = (unsigned char*)&pc_msg.data[0];
+    xyz_view = cv::Mat(pc_msg.height, pc_msg.width, CV_32FC(pc_msg.point_step/4), data, pc_msg.row_step);
+    bgr_view = cv::Mat(pc_msg.height, pc_msg.width, CV_8UC(pc_msg.point_step), data, pc_msg.row_step);
+    bgr_channel = rgbOffset;
+    return true;
+}
 
-	if(!pc_pcl.isOrganized())
-	{
-		std::cout << "ObjectDetectorNode.->Point cloud is not organized!! O M G!!!!" << std::endl;
-		return;
-	}
-	//std::cout << "ObjectDetectorNode.-> Pcl_w= " << pc_pcl.width << "  pcl_h= " << pc_pcl.height << std::endl;
-	bgr_dest = cv::Mat::zeros(pc_pcl.height, pc_pcl.width, CV_8UC3);
-	pc_dest = cv::Mat::zeros(pc_pcl.height, pc_pcl.width, CV_32FC3);
-	
-	//pcl::PointXYZRGB p_ = pc_pcl.at(320, 240);
-	//std::cout<<"ObjectDetectorNode: Middle point: "<<p_.x << " " <<p_.y <<" "<<p_.z <<" "<< p_.r<<" "<<p_.g<<" "<< p_.b << std::endl;
-	for (int h=0; h<bgr_dest.rows; h++)
-		for (int w=0; w<bgr_dest.cols; w++)
-		{
-			pcl::PointXYZRGB p = pc_pcl.at(w,h);
-			bgr_dest.data[h*bgr_dest.step + w*3] = (unsigned char)p.b;
-			bgr_dest.data[h*bgr_dest.step + w*3 + 1] = (unsigned char)p.g;
-			bgr_dest.data[h*bgr_dest.step + w*3 + 2] = (unsigned char)p.r;
-			pc_dest.at<cv::Vec3f>(h,w)[0] = isnan(p.x) ? 0.0 : p.x;
-			pc_dest.at<cv::Vec3f>(h,w)[1] = isnan(p.y) ? 0.0 : p.y;
-			pc_dest.at<cv::Vec3f>(h,w)[2] = isnan(p.z) ? 0.0 : p.z;
-		}
-  */
-        bgr_dest = cv::Mat::zeros(pc_msg->height, pc_msg->width, CV_8UC3);
-	pc_dest  = cv::Mat::zeros(pc_msg->height, pc_msg->width, CV_32FC3);
-	for(int i=0; i < bgr_dest.cols; i++)
-	  for(int j=0; j < bgr_dest.rows; j++)
-	    {
-	      float* x = (float*)&pc_msg->data[(j*pc_msg->width + i)*16];
-	      float* y = (float*)&pc_msg->data[(j*pc_msg->width + i)*16 + 4];
-	      float* z = (float*)&pc_msg->data[(j*pc_msg->width + i)*16 + 8];
-	      pc_dest.at<cv::Vec3f>(j, i)[0] = *x;
-	      pc_dest.at<cv::Vec3f>(j, i)[1] = *y;
-	      pc_dest.at<cv::Vec3f>(j, i)[2] = *z;
-	      bgr_dest.data[j*bgr_dest.step + i*3]     = pc_msg->data[(j*pc_msg->width + i)*16 + 12];
-	      bgr_dest.data[j*bgr_dest.step + i*3 + 1] = pc_msg->data[(j*pc_msg->width + i)*16 + 13];
-	      bgr_dest.data[j*bgr_dest.step + i*3 + 2] = pc_msg->data[(j*pc_msg->width + i)*16 + 14];
-	    }
+void JustinaTools::getPointCloud2Offsets(const sensor_msgs::PointCloud2& pc_msg, int& xOffset, int& rgbOffset)
+{
+    //Offsets are taken from the message fields. x, y and z must be consecutive floats.
+    //Messages without fields are assumed to have the former hardcoded layout: 16-byte points with color at byte 12.
+    if(pc_msg.fields.empty())
+    {
+        xOffset = pc_msg.point_step >= 16 ? 0 : -1;
+        rgbOffset = pc_msg.point_step >= 16 ? 12 : -1;
+        return;
+    }
+    int yOffset = -1, zOffset = -1;
+    xOffset = rgbOffset = -1;
+    for(size_t i=0; i < pc_msg.fields.size(); i++)
+    {
+        const sensor_msgs::PointField& f = pc_msg.fields[i];
+        if(f.name == "x" && f.datatype == sensor_msgs::PointField::FLOAT32) xOffset = f.offset;
+        else if(f.name == "y" && f.datatype == sensor_msgs::PointField::FLOAT32) yOffset = f.offset;
+        else if(f.name == "z" && f.datatype == sensor_msgs::PointField::FLOAT32) zOffset = f.offset;
+        else if(f.name == "rgb" || f.name == "rgba") rgbOffset = f.offset;
+    }
+    if(xOffset < 0 || yOffset != xOffset + 4 || zOffset != xOffset + 8 || xOffset % 4 != 0)
+        xOffset = -1;
 }
 
 bool JustinaTools::transformPoint(std::string src_frame, float inX, float inY, float inZ, std::string dest_frame, float& outX, float& outY, float& outZ)
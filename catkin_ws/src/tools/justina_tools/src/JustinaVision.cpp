@@ -45,6 +45,7 @@ ros::ServiceClient JustinaVision::cltGetRgbdWrtRobot;
 //Detect objects
 ros::ServiceClient JustinaVision::cltDetectObjects;
 ros::ServiceClient JustinaVision::cltDetectAllObjects;
+ros::ServiceClient JustinaVision::cltDetectPersons;
 ros::Publisher JustinaVision::pubObjStartRecog;
 ros::Publisher JustinaVision::pubObjStopRecog;
 ros::Publisher JustinaVision::pubObjStartWin;
@@ -123,6 +124,7 @@ bool JustinaVision::setNodeHandle(ros::NodeHandle* nh)
     //Detect objects
     JustinaVision::cltDetectObjects         = nh->serviceClient<vision_msgs::DetectObjects>("/vision/obj_reco/det_objs");
     JustinaVision::cltDetectAllObjects      = nh->serviceClient<vision_msgs::DetectObjects>("/vision/obj_reco/det_all_objs");
+    JustinaVision::cltDetectPersons         = nh->serviceClient<vision_msgs::DetectObjects>("/vision/obj_reco/det_persons");
     JustinaVision::pubObjStartWin           = nh->advertise<std_msgs::Bool>("/vision/obj_reco/enableDetectWindow", 1);
     JustinaVision::pubObjStopWin            = nh->advertise<std_msgs::Bool>("/vision/obj_reco/enableDetectWindow", 0);
     JustinaVision::pubObjStartRecog         = nh->advertise<std_msgs::Bool>("/vision/obj_reco/enableRecognizeTopic", 1);
@@ -445,6 +447,21 @@ bool JustinaVision::detectAllObjects(std::vector<vision_msgs::VisionObject>& rec
     return true;
 }
 
+bool JustinaVision::detectPersons(std::vector<vision_msgs::VisionObject>& personList, bool saveFiles)
+{
+    std::cout << "JustinaVision.->Trying to detect persons... " << std::endl;
+    vision_msgs::DetectObjects srv;
+    srv.request.saveFiles = saveFiles;
+    if(!cltDetectPersons.call(srv))
+    {
+        std::cout << "JustinaVision.->Cannot call person detector service" << std::endl;
+        return false;
+    }
+    personList = srv.response.recog_objects;
+    std::cout << "JustinaVision.->Detected " << int(personList.size()) << " persons" << std::endl;
+    return personList.size() > 0;
+}
+
 //Methods for move the train object and move the tranining base
 void JustinaVision::trainObject(const std::string name)
 {
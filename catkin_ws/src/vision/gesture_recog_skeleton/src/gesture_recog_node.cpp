@@ -3,6 +3,7 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <map>
 #include "vision_msgs/Skeletons.h"
 #include "vision_msgs/GestureSkeleton.h"
 #include "vision_msgs/GestureSkeletons.h"
@@ -10,161 +11,217 @@
 #include "vision_msgs/HandSkeletonPos.h"
 #include <visualization_msgs/Marker.h>
 
+#define HISTORY_SIZE 45          //Samples kept per user, 1.5 s at 30 fps
+#define STATIC_WINDOW 10         //Samples used to decide pointing and rised hands
+#define ENTER_RATIO 0.7          //Fraction of the window a pose must hold to start a gesture
+#define EXIT_RATIO 0.3           //Fraction of the window under which a gesture ends
+#define WAVE_AMPLITUDE 0.06      //Min lateral displacement (m) of the hand wrt the elbow between reversals
+#define WAVE_REVERSALS 3         //Reversals of the hand within the history to consider waving
+#define USER_TIMEOUT 2.0         //Histories of users not seen for this time (s) are removed
+
+enum Gesture { POINTING_RIGHT = 0, POINTING_LEFT, RIGHT_HAND_RISED, LEFT_HAND_RISED, WAVING, NUM_GESTURES };
+const char* gestureNames[NUM_GESTURES] = { "pointing_right", "pointing_left", "right_hand_rised", "left_hand_rised", "waving" };
+
+//Per frame pose of a user
+struct SkeletonSample
+{
+	ros::Time stamp;
+	bool poses[NUM_GESTURES];    //Single frame conditions of the static gestures
+	float rightHandLateral;      //Lateral position of the hands wrt the elbows, used for waving
+	float leftHandLateral;
+	bool rightHandUp;
+	bool leftHandUp;
+};
+
+//Fixed size ring buffer of the last samples of a user and state of each gesture
+struct UserHistory
+{
+	SkeletonSample samples[HISTORY_SIZE];
+	int head;                    //Index of the newest sample
+	int count;
+	bool active[NUM_GESTURES];
+	ros::Time lastSeen;
+
+	UserHistory() : head(-1), count(0)
+	{
+		for(int i = 0; i < NUM_GESTURES; i++)
+			active[i] = false;
+	}
+
+	void Add(const SkeletonSample& sample)
+	{
+		head = (head + 1) % HISTORY_SIZE;
+		samples[head] = sample;
+		if(count < HISTORY_SIZE)
+			count++;
+		lastSeen = sample.stamp;
+	}
+
+	//Age 0 is the newest sample
+	const SkeletonSample& Get(int age) const
+	{
+		return samples[(head - age + HISTORY_SIZE) % HISTORY_SIZE];
+	}
+};
+
 ros::Publisher pubGestures;
 ros::Publisher pubRHnadPos;
 ros::Publisher pubLHnadPos;
 ros::Publisher pubTorsoPos;
+std::map<int, UserHistory> usersHistory;
 
-void callbackGetGesture(const vision_msgs::Skeletons& msg)
+SkeletonSample getSample(const vision_msgs::Skeleton& skeleton, const ros::Time& stamp)
 {
-    vision_msgs::Skeletons skeletons;
-	vision_msgs::Skeleton skeleton;
-
-    skeletons = msg;
-    
-    vision_msgs::GestureSkeletons gestures_detected;
-
-    while (!skeletons.skeletons.empty())
-  	{
-    	skeleton = skeletons.skeletons.back();
+	SkeletonSample sample;
+	sample.stamp = stamp;
+	sample.poses[POINTING_RIGHT] = skeleton.right_hand.position.y > (skeleton.right_hip.position.y + 0.20) &&
+		skeleton.right_hand.position.z > skeleton.right_hip.position.z &&
+		skeleton.right_hand.position.z < skeleton.neck.position.z;
+	sample.poses[POINTING_LEFT] = skeleton.left_hand.position.y < (skeleton.left_hip.position.y - 0.20) &&
+		skeleton.left_hand.position.z > skeleton.left_hip.position.z &&
+		skeleton.left_hand.position.z < skeleton.neck.position.z;
+	sample.poses[RIGHT_HAND_RISED] = skeleton.right_hand.position.z > skeleton.neck.position.z;
+	sample.poses[LEFT_HAND_RISED] = skeleton.left_hand.position.z > skeleton.neck.position.z;
+	sample.poses[WAVING] = false;
+	sample.rightHandLateral = skeleton.right_hand.position.y - skeleton.right_elbow.position.y;
+	sample.leftHandLateral = skeleton.left_hand.position.y - skeleton.left_elbow.position.y;
+	sample.rightHandUp = skeleton.right_hand.position.z > skeleton.right_elbow.position.z;
+	sample.leftHandUp = skeleton.left_hand.position.z > skeleton.left_elbow.position.z;
+	return sample;
+}
 
-		if(skeleton.right_hand.position.y > (skeleton.right_hip.position.y + 0.20) && 
-		   skeleton.right_hand.position.z > skeleton.right_hip.position.z && 
-		   skeleton.right_hand.position.z < skeleton.neck.position.z)
+//Counts the reversals of the lateral motion of a hand held over its elbow, ignoring motions smaller than WAVE_AMPLITUDE
+int countWaveReversals(const UserHistory& history, bool right)
+{
+	int reversals = 0;
+	int direction = 0;
+	float extreme = 0;
+	for(int age = history.count - 1; age >= 0; age--)
+	{
+		const SkeletonSample& sample = history.Get(age);
+		if(!(right ? sample.rightHandUp : sample.leftHandUp))
 		{
-			vision_msgs::GestureSkeleton gesture_detected;
-
-			gesture_detected.id = skeleton.user_id;
-			gesture_detected.gesture = "pointing_right";
-			gesture_detected.gesture_centroid.x = skeleton.torso.position.x;
-			gesture_detected.gesture_centroid.y = skeleton.torso.position.y;
-			gesture_detected.gesture_centroid.z = skeleton.torso.position.z;
-			//pubGesture.publish(gesture_detected);
-			gestures_detected.recog_gestures.push_back(gesture_detected);
- 			std::cout << "User: " << skeleton.user_id << " Pointing right" << std::endl;
+			direction = 0;
+			reversals = 0;
+			continue;
 		}
-
-		if(skeleton.left_hand.position.y < (skeleton.left_hip.position.y - 0.20) && 
-		   skeleton.left_hand.position.z > skeleton.left_hip.position.z && 
-		   skeleton.left_hand.position.z < skeleton.neck.position.z)
+		float lateral = right ? sample.rightHandLateral : sample.leftHandLateral;
+		if(direction == 0)
 		{
-			vision_msgs::GestureSkeleton gesture_detected;
-
-			gesture_detected.id = skeleton.user_id;
-			gesture_detected.gesture = "pointing_left";
-			gesture_detected.gesture_centroid.x = skeleton.torso.position.x;
-			gesture_detected.gesture_centroid.y = skeleton.torso.position.y;
-			gesture_detected.gesture_centroid.z = skeleton.torso.position.z;
-			//pubGesture.publish(gesture_detected);
-			gestures_detected.recog_gestures.push_back(gesture_detected);
-			std::cout << "User: " << skeleton.user_id << " Pointing left" << std::endl;
+			extreme = lateral;
+			direction = 2;   //Unknown direction, waiting for the first displacement
+			continue;
 		}
-
-    	if(skeleton.right_hand.position.z > skeleton.neck.position.z)
-    	{
-			vision_msgs::GestureSkeleton gesture_detected;
-
-			gesture_detected.id = skeleton.user_id;
-			gesture_detected.gesture = "right_hand_rised";
-			gesture_detected.gesture_centroid.x = skeleton.torso.position.x;
-			gesture_detected.gesture_centroid.y = skeleton.torso.position.y;
-			gesture_detected.gesture_centroid.z = skeleton.torso.position.z;
-			//pubGesture.publish(gesture_detected);
-			gestures_detected.recog_gestures.push_back(gesture_detected);
-			std::cout << "User: " << skeleton.user_id << " Right hand rised" << std::endl;
-    	}
-
-    	if(skeleton.left_hand.position.z  > skeleton.neck.position.z)
-    	{
-			vision_msgs::GestureSkeleton gesture_detected;
-
-			gesture_detected.id = skeleton.user_id;
-			gesture_detected.gesture = "left_hand_rised";
-			gesture_detected.gesture_centroid.x = skeleton.torso.position.x;
-			gesture_detected.gesture_centroid.y = skeleton.torso.position.y;
-			gesture_detected.gesture_centroid.z = skeleton.torso.position.z;
-			//pubGesture.publish(gesture_detected);
-			gestures_detected.recog_gestures.push_back(gesture_detected);
-			std::cout << "User: " << skeleton.user_id << " Left hand rised" << std::endl;
-    	}
-
-		skeletons.skeletons.pop_back();
-  	}
-  	pubGestures.publish(gestures_detected);
+		float displacement = lateral - extreme;
+		if(direction == 2)
+		{
+			if(displacement > WAVE_AMPLITUDE || displacement < -WAVE_AMPLITUDE)
+			{
+				direction = displacement > 0 ? 1 : -1;
+				extreme = lateral;
+			}
+			continue;
+		}
+		if(direction * displacement > 0)
+			extreme = lateral;   //Same direction, extreme moves along
+		else if(direction * displacement < -WAVE_AMPLITUDE)
+		{
+			direction = -direction;
+			extreme = lateral;
+			reversals++;
+		}
+	}
+	return reversals;
 }
 
-void callbackGetRHandPos(const vision_msgs::Skeletons& msg)
+//Temporal state machine of the gestures of a user: a static gesture starts when its pose holds in most of the
+//last samples and ends when it rarely holds (hysteresis), waving requires several reversals of a hand.
+void updateGestures(UserHistory& history)
 {
-	vision_msgs::Skeletons skeletons;
-
-    skeletons = msg;
-    geometry_msgs::Point handCentroid;
-
-    vision_msgs::HandSkeletonPos hands_pos;
-    
-    for(int i = 0; i < skeletons.skeletons.size(); i++){
-    	vision_msgs::Skeleton skeleton = skeletons.skeletons[i];
-    	handCentroid.x = skeleton.right_hand.position.x;
-    	handCentroid.y = skeleton.right_hand.position.y;
-    	handCentroid.z = skeleton.right_hand.position.z;
-    	hands_pos.hands_position.push_back(handCentroid);
-    }
-
-    pubRHnadPos.publish(hands_pos);
+	int window = history.count < STATIC_WINDOW ? history.count : STATIC_WINDOW;
+	for(int g = 0; g < WAVING; g++)
+	{
+		int holds = 0;
+		for(int age = 0; age < window; age++)
+			if(history.Get(age).poses[g])
+				holds++;
+		float ratio = (float)holds / STATIC_WINDOW;
+		if(!history.active[g] && ratio >= ENTER_RATIO)
+			history.active[g] = true;
+		else if(history.active[g] && ratio <= EXIT_RATIO)
+			history.active[g] = false;
+	}
+	history.active[WAVING] = countWaveReversals(history, true) >= WAVE_REVERSALS ||
+		countWaveReversals(history, false) >= WAVE_REVERSALS;
 }
 
-void callbackGetLHandPos(const vision_msgs::Skeletons& msg)
+//Only one pass over the skeletons fills the gestures and the positions of hands and torso
+void callbackSkeletons(const vision_msgs::Skeletons::ConstPtr& msg)
 {
-	vision_msgs::Skeletons skeletons;
-
-    skeletons = msg;
-
-    geometry_msgs::Point handCentroid;
-
-    vision_msgs::HandSkeletonPos hands_pos;
-
-    for(int i = 0; i < skeletons.skeletons.size(); i++){
-    	vision_msgs::Skeleton skeleton = skeletons.skeletons[i];
-    	handCentroid.x = skeleton.left_hand.position.x;
-    	handCentroid.y = skeleton.left_hand.position.y;
-    	handCentroid.z = skeleton.left_hand.position.z;
-    	hands_pos.hands_position.push_back(handCentroid);
-    }
-    pubLHnadPos.publish(hands_pos);
-}
-
-void callbackGetTorsoPos(const vision_msgs::Skeletons& msg)
-{
-	vision_msgs::Skeletons skeletons;
-
-    skeletons = msg;
-
-    geometry_msgs::Point torsoCentroid;
-
-    vision_msgs::HandSkeletonPos torso_pos;
-
-    for(int i = 0; i < skeletons.skeletons.size(); i++){
-    	vision_msgs::Skeleton skeleton = skeletons.skeletons[i];
-    	torsoCentroid.x = skeleton.torso.position.x;
-    	torsoCentroid.y = skeleton.torso.position.y;
-    	torsoCentroid.z = skeleton.torso.position.z;
-    	torso_pos.hands_position.push_back(torsoCentroid);
-    }
-    pubTorsoPos.publish(torso_pos);
+	ros::Time stamp = msg->header.stamp.isZero() ? ros::Time::now() : msg->header.stamp;
+
+	vision_msgs::GestureSkeletons gestures_detected;
+	vision_msgs::HandSkeletonPos right_hands_pos;
+	vision_msgs::HandSkeletonPos left_hands_pos;
+	vision_msgs::HandSkeletonPos torso_pos;
+
+	for(size_t i = 0; i < msg->skeletons.size(); i++)
+	{
+		const vision_msgs::Skeleton& skeleton = msg->skeletons[i];
+
+		geometry_msgs::Point point;
+		point.x = skeleton.right_hand.position.x;
+		point.y = skeleton.right_hand.position.y;
+		point.z = skeleton.right_hand.position.z;
+		right_hands_pos.hands_position.push_back(point);
+		point.x = skeleton.left_hand.position.x;
+		point.y = skeleton.left_hand.position.y;
+		point.z = skeleton.left_hand.position.z;
+		left_hands_pos.hands_position.push_back(point);
+		point.x = skeleton.torso.position.x;
+		point.y = skeleton.torso.position.y;
+		point.z = skeleton.torso.position.z;
+		torso_pos.hands_position.push_back(point);
+
+		UserHistory& history = usersHistory[skeleton.user_id];
+		history.Add(getSample(skeleton, stamp));
+		updateGestures(history);
+
+		for(int g = 0; g < NUM_GESTURES; g++)
+		{
+			if(!history.active[g])
+				continue;
+			vision_msgs::GestureSkeleton gesture_detected;
+			gesture_detected.id = skeleton.user_id;
+			gesture_detected.gesture = gestureNames[g];
+			gesture_detected.gesture_centroid = point;
+			gestures_detected.recog_gestures.push_back(gesture_detected);
+			std::cout << "User: " << skeleton.user_id << " " << gestureNames[g] << std::endl;
+		}
+	}
+
+	//Histories of lost users are removed
+	for(std::map<int, UserHistory>::iterator it = usersHistory.begin(); it != usersHistory.end();)
+	{
+		if((stamp - it->second.lastSeen).toSec() > USER_TIMEOUT)
+			usersHistory.erase(it++);
+		else
+			++it;
+	}
+
+	pubGestures.publish(gestures_detected);
+	pubRHnadPos.publish(right_hands_pos);
+	pubLHnadPos.publish(left_hands_pos);
+	pubTorsoPos.publish(torso_pos);
 }
 
-
-
 int main(int argc, char** argv)
 {
 	std::cout << "INITIALIZING GESTURE RECOGNIZER SKELETONS..." << std::endl;
     ros::init(argc, argv, "gesture_recognizer");
     ros::NodeHandle n;
 
-    ros::Subscriber subGetGesture = n.subscribe("/vision/skeleton_finder/skeleton_recog", 1, callbackGetGesture);
-    ros::Subscriber subGetRHandPos = n.subscribe("/vision/skeleton_finder/skeleton_recog", 1, callbackGetRHandPos);
-    ros::Subscriber subGetLHandPos = n.subscribe("/vision/skeleton_finder/skeleton_recog", 1, callbackGetLHandPos);
-    ros::Subscriber subGetTorsoPos = n.subscribe("/vision/skeleton_finder/skeleton_recog", 1, callbackGetTorsoPos);
+    ros::Subscriber subSkeletons = n.subscribe("/vision/skeleton_finder/skeleton_recog", 1, callbackSkeletons);
     pubGestures = n.advertise<vision_msgs::GestureSkeletons> ("/vision/gesture_recog_skeleton/gesture_recog", 1);
     pubRHnadPos = n.advertise<vision_msgs::HandSkeletonPos> ("/vision/gesture_recog_skeleton/right_hand_pos", 1);
     pubLHnadPos = n.advertise<vision_msgs::HandSkeletonPos> ("/vision/gesture_recog_skeleton/left_hand_pos", 1);
@@ -4,6 +4,7 @@
 
 #include "opencv2/core/core.hpp"
 #include "opencv2/highgui/highgui.hpp"
+#include "justina_tools/JustinaRansac.h"
 
 // Standard includes
 #include <iostream>
@@ -15,16 +16,9 @@
 #define ERROR_APROX_PIX 3.0 
 #define ERROR_APROX_METRIC 0.01
 
-//Random sampling n numbers out maxn
-cv::Mat randomSample(int n, cv::Mat points);
-
-//Get the inliers in a point set over a 2D line defined by two points
-std::vector<int> find2DConsensus(cv::Mat points, cv::Mat sample);
-
-//Get the inliers in a point set over a 3D line defined by two points
-std::vector<int> find3DConsensus(cv::Mat points, cv::Mat sample);
-
-//Get the best line that fits a point set using RANSAC
+//Get the best line that fits a point set using RANSAC.
+//Points are 2D pixels (CV_32S, 2 cols) or 3D metric points (CV_64F, 3 cols).
+//Returns the indexes of the inliers with min and max x (left and right extremes of the line).
 std::vector<int> lineRANSAC(cv::Mat points);
 
 #endif
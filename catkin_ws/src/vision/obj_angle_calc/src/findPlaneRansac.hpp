@@ -7,6 +7,7 @@
 #include "opencv2/core/core.hpp"
 #include "opencv2/highgui/highgui.hpp"
 #include "plane3D.hpp"
+#include "justina_tools/JustinaRansac.h"
 
 
 // Muetreo aleatorio de n muestras de la nube de puntos
@@ -18,8 +19,8 @@ cv::Mat randomSample(int n, cv::Mat points);
 // Obtenemos los puntos que se ajustan al plano definido por tres puntos
 cv::Mat findPlaneConsensus(std::vector<cv::Vec3d> sample, cv::Mat points, float threshold);
 
-// Obtenemos la ecuacion del plano que mejor se justa a los puntos
-std::vector<double> planeRANSAC(cv::Mat points);
+// Obtenemos la ecuacion del plano [a, b, c, d] que mejor se justa a los puntos (nube CV_32FC3)
+std::vector<double> planeRANSAC(cv::Mat points, float threshold = 0.005);
 
 
 /*
@@ -118,3 +119,39 @@ cv::Mat findPlaneConsensus(cv::Mat sample, cv::Mat points, float threshold)
 	std::cout << "inliers: " << inliers << std::endl;
 	return consensus;
 }
+
+//Metodo para obtener el plano con mas inliers de la nube de puntos
+std::vector<double> planeRANSAC(cv::Mat points, float threshold)
+{
+	std::vector<double> planeComp;
+
+	// Solo se toman los puntos validos
+	RansacPoints validPoints;
+	validPoints.Reserve(points.rows * points.cols);
+	for (int i = 0; i < points.rows; i++)
+	{
+		const cv::Vec3f* row = points.ptr<cv::Vec3f>(i);
+		for (int j = 0; j < points.cols; j++)
+			if (verifyPoint(cv::Vec3d(row[j][0], row[j][1], row[j][2])))
+				validPoints.Add(row[j][0], row[j][1], row[j][2]);
+	}
+
+	Ransac<RansacPlane> ransac;
+	ransac.threshold = threshold;
+	ransac.Seed((unsigned int) time(NULL));
+
+	RansacPlane plane;
+	std::vector<int> inliers;
+	if (!ransac.Estimate(validPoints, plane, inliers))
+	{
+		std::cout << "findPlaneRansac.->Cannot find a plane" << std::endl;
+		return planeComp;
+	}
+
+	std::cout << "inliers: " << inliers.size() << std::endl;
+	planeComp.push_back(plane.a);
+	planeComp.push_back(plane.b);
+	planeComp.push_back(plane.c);
+	planeComp.push_back(plane.d);
+	return planeComp;
+}
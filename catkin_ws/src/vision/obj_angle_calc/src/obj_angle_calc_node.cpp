@@ -25,7 +25,7 @@ int main(int argc, char** argv)
 
 	cv::Mat imgBGR;
 	cv::Mat imgDepth;
-	cv::Mat randomSamples;
+	std::vector<double> planeComp;
 	cv::Mat consensus;
 	cv::Mat croppedImage;
 
@@ -44,7 +44,9 @@ int main(int argc, char** argv)
 		cv::Rect myROI(25, 35, 520, 430);
 		croppedImage = imgDepth(myROI);
 
-		randomSamples = randomSample(3, croppedImage);
+		planeComp = planeRANSAC(croppedImage);
+		if (planeComp.size() == 4)
+			std::cout << "Angle_Calc.-> Plane: " << planeComp[0] << " " << planeComp[1] << " " << planeComp[2] << " " << planeComp[3] << std::endl;
 		//consensus = findPlaneConsensus(randomSamples, croppedImage, 0.005);
 
 		//cv::imshow("Kinect depth", consensus);
@@ -0,0 +1,175 @@
+#include "IntegralNormals.hpp"
+
+// Channels of the integral image: count, x, y, z, xx, xy, xz, yy, yz, zz
+#define INTEGRAL_CHANNELS 10
+
+std::vector< double > IntegralNormals::integral;
+ros::Time IntegralNormals::cacheStamp;
+int IntegralNormals::cacheWindowSize = 0;
+cv::Mat IntegralNormals::cacheNormals;
+
+cv::Mat IntegralNormals::GetNormals(cv::Mat pointCloud, ros::Time stamp, int windowSize)
+{
+	// A zero stamp means the cloud does not come from a captured frame, thus it is never cached.
+	if( !stamp.isZero() && stamp == cacheStamp && windowSize == cacheWindowSize &&
+		cacheNormals.rows == pointCloud.rows && cacheNormals.cols == pointCloud.cols )
+		return cacheNormals;
+
+	cv::Mat normals = Compute( pointCloud, windowSize );
+	if( !stamp.isZero() )
+	{
+		cacheStamp = stamp;
+		cacheWindowSize = windowSize;
+		cacheNormals = normals;
+	}
+	return normals;
+}
+
+cv::Mat IntegralNormals::Compute(cv::Mat pointCloud, int windowSize)
+{
+	cv::Mat normals = cv::Mat::zeros( pointCloud.rows, pointCloud.cols, CV_32FC3 );
+	if( pointCloud.empty() || pointCloud.type() != CV_32FC3 )
+	{
+		std::cout << "IntegralNormals.->Point cloud must be a non empty CV_32FC3 matrix." << std::endl;
+		return normals;
+	}
+
+	ComputeIntegral( pointCloud, integral );
+
+	int rows = pointCloud.rows;
+	int cols = pointCloud.cols;
+	int half = std::max( windowSize / 2, 1 );
+	int minPoints = std::max( 3, ( 2*half + 1 ) * ( 2*half + 1 ) / 2 );
+	int stride = ( cols + 1 ) * INTEGRAL_CHANNELS;
+	double sums[INTEGRAL_CHANNELS];
+	double cov[6];
+
+	for( int row = 0; row < rows; row++ )
+	{
+		const cv::Vec3f* points = pointCloud.ptr< cv::Vec3f >( row );
+		cv::Vec3f* normalsRow = normals.ptr< cv::Vec3f >( row );
+		// Window is clipped at the borders of the image
+		const double* top    = &integral[ std::max( row - half, 0 ) * stride ];
+		const double* bottom = &integral[ std::min( row + half + 1, rows ) * stride ];
+		for( int col = 0; col < cols; col++ )
+		{
+			const cv::Vec3f& p = points[col];
+			if( ( p[0] == 0.0f && p[1] == 0.0f && p[2] == 0.0f ) || p[0] != p[0] || p[1] != p[1] || p[2] != p[2] )
+				continue;
+
+			int left  = std::max( col - half, 0 ) * INTEGRAL_CHANNELS;
+			int right = std::min( col + half + 1, cols ) * INTEGRAL_CHANNELS;
+			for( int c = 0; c < INTEGRAL_CHANNELS; c++ )
+				sums[c] = bottom[right + c] - bottom[left + c] - top[right + c] + top[left + c];
+			if( sums[0] < minPoints )
+				continue;
+
+			double n = sums[0];
+			double mx = sums[1] / n;
+			double my = sums[2] / n;
+			double mz = sums[3] / n;
+			cov[0] = sums[4] / n - mx*mx;
+			cov[1] = sums[5] / n - mx*my;
+			cov[2] = sums[6] / n - mx*mz;
+			cov[3] = sums[7] / n - my*my;
+			cov[4] = sums[8] / n - my*mz;
+			cov[5] = sums[9] / n - mz*mz;
+
+			cv::Vec3f normal;
+			if( !SmallestEigenVector( cov, normal ) )
+				continue;
+			if( normal[2] < 0 )
+				normal = -normal;
+			normalsRow[col] = normal;
+		}
+	}
+	return normals;
+}
+
+void IntegralNormals::ComputeIntegral(cv::Mat pointCloud, std::vector< double >& integral)
+{
+	int rows = pointCloud.rows;
+	int cols = pointCloud.cols;
+	int stride = ( cols + 1 ) * INTEGRAL_CHANNELS;
+	integral.resize( ( rows + 1 ) * stride );
+	std::fill( integral.begin(), integral.begin() + stride, 0.0 );
+
+	double rowSum[INTEGRAL_CHANNELS];
+	for( int row = 0; row < rows; row++ )
+	{
+		const cv::Vec3f* points = pointCloud.ptr< cv::Vec3f >( row );
+		const double* above = &integral[ row * stride ];
+		double* current = &integral[ ( row + 1 ) * stride ];
+		std::fill( current, current + INTEGRAL_CHANNELS, 0.0 );
+		std::fill( rowSum, rowSum + INTEGRAL_CHANNELS, 0.0 );
+		for( int col = 0; col < cols; col++ )
+		{
+			const cv::Vec3f& p = points[col];
+			bool valid = !( p[0] == 0.0f && p[1] == 0.0f && p[2] == 0.0f ) && p[0] == p[0] && p[1] == p[1] && p[2] == p[2];
+			if( valid )
+			{
+				double x = p[0], y = p[1], z = p[2];
+				rowSum[0] += 1.0;
+				rowSum[1] += x;
+				rowSum[2] += y;
+				rowSum[3] += z;
+				rowSum[4] += x*x;
+				rowSum[5] += x*y;
+				rowSum[6] += x*z;
+				rowSum[7] += y*y;
+				rowSum[8] += y*z;
+				rowSum[9] += z*z;
+			}
+			const double* up = above + ( col + 1 ) * INTEGRAL_CHANNELS;
+			double* cell = current + ( col + 1 ) * INTEGRAL_CHANNELS;
+			for( int c = 0; c < INTEGRAL_CHANNELS; c++ )
+				cell[c] = up[c] + rowSum[c];
+		}
+	}
+}
+
+bool IntegralNormals::SmallestEigenVector(const double* cov, cv::Vec3f& eigenVector)
+{
+	// Closed form eigenvalues of a symmetric 3x3 matrix (trigonometric solution of the characteristic polynomial).
+	// Matrix is scaled to avoid losing precision with very small covariances.
+	double scale = 0.0;
+	for( int i = 0; i < 6; i++ )
+		scale = std::max( scale, std::abs( cov[i] ) );
+	if( scale <= 0.0 )
+		return false;
+	double a00 = cov[0] / scale, a01 = cov[1] / scale, a02 = cov[2] / scale;
+	double a11 = cov[3] / scale, a12 = cov[4] / scale, a22 = cov[5] / scale;
+
+	double q = ( a00 + a11 + a22 ) / 3.0;
+	double p1 = a01*a01 + a02*a02 + a12*a12;
+	double p2 = ( a00 - q )*( a00 - q ) + ( a11 - q )*( a11 - q ) + ( a22 - q )*( a22 - q ) + 2.0*p1;
+	double p = std::sqrt( p2 / 6.0 );
+	if( p <= 1e-12 )
+		return false; // Isotropic covariance, there is no dominant plane
+
+	double b00 = ( a00 - q ) / p, b11 = ( a11 - q ) / p, b22 = ( a22 - q ) / p;
+	double b01 = a01 / p, b02 = a02 / p, b12 = a12 / p;
+	double r = ( b00*( b11*b22 - b12*b12 ) - b01*( b01*b22 - b12*b02 ) + b02*( b01*b12 - b11*b02 ) ) / 2.0;
+	r = std::min( 1.0, std::max( -1.0, r ) );
+	double phi = std::acos( r ) / 3.0;
+	double smallest = q + 2.0*p*std::cos( phi + 2.0*M_PI/3.0 );
+
+	// Eigenvector is orthogonal to the rows of (A - smallest*I): largest cross product of two rows
+	cv::Vec3d row0( a00 - smallest, a01, a02 );
+	cv::Vec3d row1( a01, a11 - smallest, a12 );
+	cv::Vec3d row2( a02, a12, a22 - smallest );
+	cv::Vec3d c01 = row0.cross( row1 );
+	cv::Vec3d c02 = row0.cross( row2 );
+	cv::Vec3d c12 = row1.cross( row2 );
+	double n01 = c01.dot( c01 ), n02 = c02.dot( c02 ), n12 = c12.dot( c12 );
+	cv::Vec3d best = c01;
+	double bestNorm = n01;
+	if( n02 > bestNorm ) { best = c02; bestNorm = n02; }
+	if( n12 > bestNorm ) { best = c12; bestNorm = n12; }
+	if( bestNorm <= 1e-24 )
+		return false;
+
+	best *= 1.0 / std::sqrt( bestNorm );
+	eigenVector = cv::Vec3f( (float)best[0], (float)best[1], (float)best[2] );
+	return true;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <opencv2/core/core.hpp>
+#include "ros/ros.h"
+
+// Normals of an organized point cloud (CV_32FC3) from the covariance of the points in a window around each pixel,
+// as PCL IntegralImageNormalEstimation does with COVARIANCE_MATRIX. Sums of first and second order of XYZ are
+// taken from integral images, so the cost per pixel does not depend on the window size.
+// Points equal to zero or NaN are invalid. Normals are unitary, oriented with z >= 0, and zero where the
+// window has not enough valid points.
+// GetNormals keeps the normals of the last cloud, so that several requests on the same frame (same stamp)
+// compute them only once. The returned matrix is shared with the cache and must not be modified.
+class IntegralNormals
+{
+	public:
+		static cv::Mat Compute(cv::Mat pointCloud, int windowSize=7);
+		static cv::Mat GetNormals(cv::Mat pointCloud, ros::Time stamp, int windowSize=7);
+
+	private:
+		static void ComputeIntegral(cv::Mat pointCloud, std::vector< double >& integral);
+		static bool SmallestEigenVector(const double* cov, cv::Vec3f& eigenVector);
+
+		static std::vector< double > integral;
+		static ros::Time cacheStamp;
+		static int cacheWindowSize;
+		static cv::Mat cacheNormals;
+};
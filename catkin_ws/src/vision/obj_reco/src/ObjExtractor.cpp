@@ -16,12 +16,12 @@ int ObjExtractor::H = 130, ObjExtractor::S = 127, ObjExtractor::V = 127;
 int ObjExtractor:: Hth = 10, ObjExtractor::Sth = 80, ObjExtractor::Vth = 80;
 
 
-std::vector<PlanarSegment>  ObjExtractor::GetHorizontalPlanes(cv::Mat pointCloud)
+std::vector<PlanarSegment>  ObjExtractor::GetHorizontalPlanes(cv::Mat pointCloud, ros::Time stamp)
 {
 	// PARAMS: Valid Points 
 	double floorDistRemoval = 0.15;
 	// PARAMS: Normals Extraction
-	int blurSize = 5; 
+	int normalsWindow = 7; 
 	double normalZThreshold = 0.8; 
 	// PARAMS: Planes RANSAC 
 	double maxDistToPlane = 0.02; 
@@ -37,10 +37,8 @@ std::vector<PlanarSegment>  ObjExtractor::GetHorizontalPlanes(cv::Mat pointCloud
 	cv::Mat validPointCloud;
 	cv::inRange(pointCloud, cv::Scalar(-3.0, -3.0, floorDistRemoval), cv::Scalar(3.0, 3.0, 3.0), validPointCloud); 
 	
-	// Getting Normals 	
-	cv::Mat pointCloudBlur;
-	cv::blur(pointCloud, pointCloudBlur, cv::Size(blurSize, blurSize));
-	cv::Mat normals = ObjExtractor::CalculateNormals( pointCloudBlur ); 
+	// Getting Normals (shared by all the requests on the same frame)
+	cv::Mat normals = IntegralNormals::GetNormals( pointCloud, stamp, normalsWindow ); 
 
 	// Getting Mask of Normals pointing horizonaliy
 	cv::Mat  horizontalNormals;
@@ -53,13 +51,13 @@ std::vector<PlanarSegment>  ObjExtractor::GetHorizontalPlanes(cv::Mat pointCloud
 	return	ObjExtractor::ExtractHorizontalPlanesRANSAC(pointCloud, maxDistToPlane, maxIterations, minPointsForPlane, horizontalsValidPoints);
 }
 
-cv::Vec4i ObjExtractor::GetLine(cv::Mat pointCloud)
+cv::Vec4i ObjExtractor::GetLine(cv::Mat pointCloud, ros::Time stamp)
 {
 
 	// PARAMS: Valid Points 
 	double floorDistRemoval = 0.15;
 	// PARAMS: Normals Extraction
-	int blurSize = 5; 
+	int normalsWindow = 7; 
 	double normalZThreshold = 0.8; 
 	// PARAMS: Planes RANSAC 
 	double maxDistToPlane = 0.02; 
@@ -75,10 +73,8 @@ cv::Vec4i ObjExtractor::GetLine(cv::Mat pointCloud)
 	cv::Mat validPointCloud;
 	cv::inRange(pointCloud, cv::Scalar(-1.0, -1.0, floorDistRemoval), cv::Scalar(1.5, 1.0, 2.0), validPointCloud); 
 	
-	// Getting Normals 	
-	cv::Mat pointCloudBlur;
-	cv::blur(pointCloud, pointCloudBlur, cv::Size(blurSize, blurSize));
-	cv::Mat normals = ObjExtractor::CalculateNormals( pointCloudBlur ); 
+	// Getting Normals (shared by all the requests on the same frame)
+	cv::Mat normals = IntegralNormals::GetNormals( pointCloud, stamp, normalsWindow ); 
 
 	// Getting Mask of Normals pointing horizonaliy
 	cv::Mat  horizontalNormals;
@@ -159,7 +155,7 @@ cv::Vec4i ObjExtractor::GetLine(cv::Mat pointCloud)
 	return bestLine; 
 }
 
-std::vector<DetectedObject> ObjExtractor::GetObjectsInHorizontalPlanes(cv::Mat pointCloud)
+std::vector<DetectedObject> ObjExtractor::GetObjectsInHorizontalPlanes(cv::Mat pointCloud, ros::Time stamp)
 {
 	std::vector< DetectedObject > detectedObjectsList; 
 
@@ -168,7 +164,7 @@ std::vector<DetectedObject> ObjExtractor::GetObjectsInHorizontalPlanes(cv::Mat p
 	// PARAMS: Valid Points 
 	double floorDistRemoval = 0.25;
 	// PARAMS: Normals Extraction
-	int blurSize = 5; 
+	int normalsWindow = 7; 
 	double normalZThreshold = 0.8; 
 	// PARAMS: Planes RANSAC 
 	double maxDistToPlane = 0.02; 
@@ -184,10 +180,8 @@ std::vector<DetectedObject> ObjExtractor::GetObjectsInHorizontalPlanes(cv::Mat p
 	cv::Mat validPointCloud;
 	cv::inRange(pointCloud, cv::Scalar(-1, -1.0, floorDistRemoval), cv::Scalar(1.5, 1.0, 2.0), validPointCloud); 
 	
-	// Getting Normals 	
-	cv::Mat pointCloudBlur;
-	cv::blur(pointCloud, pointCloudBlur, cv::Size(blurSize, blurSize));
-	cv::Mat normals = ObjExtractor::CalculateNormals( pointCloudBlur ); 
+	// Getting Normals (shared by all the requests on the same frame)
+	cv::Mat normals = IntegralNormals::GetNormals( pointCloud, stamp, normalsWindow ); 
 	if(DebugMode)
 		cv::imshow("normals", normals);
 
@@ -249,7 +243,7 @@ std::vector<DetectedObject> ObjExtractor::GetObjectsInHorizontalPlanes(cv::Mat p
 
 	// Cluster objects by distance: 
 	ticks = cv::getTickCount(); 
-	std::vector< std::vector< int > > objIdxClusters  = ObjExtractor::SegmentByDistance( objectsPoints, maxDistBetweenObjs ); 
+	std::vector< std::vector< int > > objIdxClusters  = ObjExtractor::SegmentByDistance( pointCloud, objectsIdx, maxDistBetweenObjs ); 
 	
 	cv::Mat objMat = cv::Mat::zeros(pointCloud.rows, pointCloud.cols, CV_8UC3); 
 	for(int i=0; i<(int)objIdxClusters.size(); i++)
@@ -486,6 +480,10 @@ std::vector< std::vector< int > > ObjExtractor::SegmentByDistance(std::vector< c
 	// KD uses distance without squareRoot 
 	double distSquare = distThreshold*distThreshold; 
 
+	const int maxNeighbors = 16; 
+	std::vector<float> dists( maxNeighbors ); 
+	std::vector<int> idxs( maxNeighbors ); 
+
 	int labelCnt = 0;
 	for(int p=0; p<xyzPointMat.rows; p++)
 	{
@@ -497,26 +495,25 @@ std::vector< std::vector< int > > ObjExtractor::SegmentByDistance(std::vector< c
 		labelCnt++;   
 		labels[p] = labelCnt; 
 
-		std::queue< cv::Mat > nnQueue; 	
-		nnQueue.push( xyzPointMat.row(p) ); 
+		std::queue< int > nnQueue; 	
+		nnQueue.push( p ); 
 
 		labelCluster.push_back( p ); 
 
 		while( nnQueue.size() > 0 )
 		{
-			cv::Mat currentPoint = nnQueue.front(); 
+			int currentIdx = nnQueue.front(); 
 			nnQueue.pop(); 
 
-			std::vector<float> dists(1000); 
-			std::vector<int> idxs(1000); 
-			kdTree.radiusSearch( currentPoint, idxs, dists, distSquare, 16 ); 
+			int noFound = kdTree.radiusSearch( xyzPointMat.row( currentIdx ), idxs, dists, distSquare, maxNeighbors ); 
+			noFound = std::min( noFound, maxNeighbors ); 
 
-			for(int i=0; i<(int)idxs.size(); i++)
+			for(int i=0; i<noFound; i++)
 			{
 				if( labels[ idxs[i] ] == 0)
 				{
 					labels[ idxs[i] ] = labelCnt; 
-					nnQueue.push( xyzPointMat.row( idxs[i]) ); 
+					nnQueue.push( idxs[i] ); 
 					labelCluster.push_back( idxs[i] );
 				}
 			}
@@ -526,81 +523,100 @@ std::vector< std::vector< int > > ObjExtractor::SegmentByDistance(std::vector< c
 	return labelsVec; 
 }
 
+// Same as above for points taken from an organized cloud: points are connected only through their 8-neighbors in the image, 
+// so clusters are found with a union-find over the pixel grid instead of a KD-tree. 
+// Returned indexes refer to the indexes list. 
+std::vector< std::vector< int > > ObjExtractor::SegmentByDistance(cv::Mat pointCloud, std::vector< cv::Point2i > indexes, double distThreshold)
+{
+	std::vector< std::vector< int > > labelsVec; 
+	if( indexes.size() == 0 )
+		return labelsVec; 
+
+	cv::Mat mask = cv::Mat::zeros( pointCloud.rows, pointCloud.cols, CV_8UC1 ); 
+	for( int i=0; i<(int)indexes.size(); i++)
+		mask.at<uchar>( indexes[i] ) = 255; 
+
+	cv::Mat labels; 
+	std::vector< std::vector< cv::Point2i > > clustersIdx; 
+	int noClusters = OrganizedClusters::Segment( pointCloud, mask, distThreshold, labels, clustersIdx, boost::thread::hardware_concurrency() ); 
+
+	labelsVec.resize( noClusters ); 
+	for( int i=0; i<(int)indexes.size(); i++)
+	{
+		int label = labels.at<int>( indexes[i] ); 
+		if( label > 0 )
+			labelsVec[ label - 1 ].push_back( i ); 
+	}
+	return labelsVec; 
+}
+
+static bool isHorizontalPlane(const RansacPlane& plane)
+{
+	return std::abs( plane.c ) >= 0.99; 
+}
+
 std::vector<PlanarSegment> ObjExtractor::ExtractHorizontalPlanesRANSAC(cv::Mat pointCloud, double maxDistPointToPlane, int maxIterations, int minPointsForPlane, cv::Mat mask)
 {
 	std::vector< PlanarSegment > horizontalPlanesList; 
 
-	// Getting mask indexe
+	// Getting mask indexes and points (contiguous, for RANSAC) 
 	std::vector< cv::Point2i > indexes; 
+	RansacPoints points; 
 	for( int i=0; i<mask.rows; i++)
 	{
+		const uchar* maskRow = mask.ptr<uchar>(i); 
+		const cv::Vec3f* cloudRow = pointCloud.ptr<cv::Vec3f>(i); 
 		for(int j=0; j< mask.cols; j++) 
 		{
-			if( mask.at<uchar>(i,j) != 0 )
+			if( maskRow[j] != 0 )
+			{
 				indexes.push_back( cv::Point(j,i) ); 
+				points.Add( cloudRow[j][0], cloudRow[j][1], cloudRow[j][2] ); 
+			}
 		}
 	}
 
-	int cntIteratiosn = 0; 
-	while( cntIteratiosn++ < maxIterations && indexes.size() > minPointsForPlane)
-	{
-		cv::Point3f p1  = pointCloud.at< cv::Vec3f >( indexes[rand()%indexes.size()] ); 
-		cv::Point3f p2  = pointCloud.at< cv::Vec3f >( indexes[rand()%indexes.size()] ); 
-		cv::Point3f p3  = pointCloud.at< cv::Vec3f >( indexes[rand()%indexes.size()] ); 
-
-		if( !Plane3D::AreValidPointsForPlane( p1, p2, p3))
-			continue; 
-
-		Plane3D candidatePlane( p1, p2, p3);
-
-		// Heuristics ??
-		if( std::abs(candidatePlane.GetNormal().z < 0.99) )
-			continue; 
-
-		// For all points, checking distance to candidate plane (getting inliers) 
-		std::vector< cv::Point3f > inliers; 
-		for( int i=0; i < (int)indexes.size(); i++)
-		{
-			cv::Point3f xyzPoint = pointCloud.at<cv::Vec3f>(indexes[i]);
-			double distToPlane = candidatePlane.DistanceToPoint(xyzPoint);
-
-			if( distToPlane < maxDistPointToPlane )
-				inliers.push_back(xyzPoint); 
-		}
-
-		if( inliers.size() < minPointsForPlane )
-			continue; 
-
-		// Getting better plane using PCA
-		cv::PCA pca( cv::Mat(inliers).reshape(1), cv::Mat(), CV_PCA_DATA_AS_ROW); 
-		cv::Point3f pcaNormal( pca.eigenvectors.at<float>(2,0), pca.eigenvectors.at<float>(2,1), pca.eigenvectors.at<float>(2,2) ); 
-		cv::Point3f pcaPoint(pca.mean.at<float>(0,0), pca.mean.at<float>(0,1), pca.mean.at<float>(0,2));
+	Ransac< RansacPlane > ransac; 
+	ransac.threshold = maxDistPointToPlane; 
+	ransac.minInliers = minPointsForPlane; 
+	ransac.isValidModel = isHorizontalPlane; 
 
-		Plane3D refinedPlane( pcaNormal, pcaPoint ); 
-
-		// Obtaining Refined Plane
+	// Planes are extracted one by one, each one with the best hypothesis on the remaining points 
+	int iterationsLeft = maxIterations; 
+	std::vector< int > inliers; 
+	std::vector< unsigned char > isInlier; 
+	while( iterationsLeft > 0 && (int)indexes.size() > minPointsForPlane)
+	{
+		RansacPlane plane; 
+		ransac.maxIterations = iterationsLeft; 
+		bool found = ransac.Estimate( points, plane, inliers ); 
+		iterationsLeft -= std::max( ransac.GetLastIterations(), 1 ); 
+		if( !found )
+			break; 
+
+		// Obtaining Refined Plane (RANSAC inliers are already the ones of the least squares plane) 
 		std::vector< cv::Point3f > pointsPlane;
 		std::vector< cv::Point2f > xyPointsPlane; 
 		std::vector< cv::Point2i > indexesPlane;
-		std::vector< cv::Point2i > indexesNew; 
-
-		for( int i=0; i<(int)indexes.size() ; i++)
+		pointsPlane.reserve( inliers.size() ); 
+		xyPointsPlane.reserve( inliers.size() ); 
+		indexesPlane.reserve( inliers.size() ); 
+		isInlier.assign( indexes.size(), 0 ); 
+		for( int i=0; i<(int)inliers.size() ; i++)
 		{
-			cv::Point3f xyzPoint = pointCloud.at<cv::Vec3f>(indexes[i]);
-			double distToPlane = refinedPlane.DistanceToPoint(xyzPoint);
-
-			if( distToPlane < maxDistPointToPlane )
-			{
-				pointsPlane.push_back( xyzPoint );
-				xyPointsPlane.push_back( cv::Point2f(xyzPoint.x, xyzPoint.y) ); 
-				indexesPlane.push_back( indexes[i] ); 
-			}
-			else
-			{
-				indexesNew.push_back( indexes[i] ); 
-			}
+			int idx = inliers[i]; 
+			cv::Point3f xyzPoint( points.x[idx], points.y[idx], points.z[idx] ); 
+			pointsPlane.push_back( xyzPoint );
+			xyPointsPlane.push_back( cv::Point2f(xyzPoint.x, xyzPoint.y) ); 
+			indexesPlane.push_back( indexes[idx] ); 
+			isInlier[idx] = 1; 
 		}
-		indexes = indexesNew; 
+		int kept = 0; 
+		for( int i=0; i<(int)indexes.size(); i++)
+			if( !isInlier[i] )
+				indexes[kept++] = indexes[i]; 
+		indexes.resize( kept ); 
+		points.RemoveFlagged( isInlier ); 
 
 		if( ObjExtractor::UseBetterPlanes )
 		{
@@ -618,12 +634,10 @@ std::vector<PlanarSegment> ObjExtractor::ExtractHorizontalPlanesRANSAC(cv::Mat p
 				}
 			}
 
-			// Return points if cluster are small 
+			// Plane is rejected if clusters are small. Its points are not returned, otherwise RANSAC would find 
+			// the same plane again; the search goes on with the remaining points. 
 			if( maxSize < minPointsForPlane )
-			{
-				indexes.insert( indexes.end(), indexesPlane.begin(), indexesPlane.end() ); 
 				continue; 
-			}
 
 			// Remove only bigger cluster. 
 			std::vector< cv::Point3f > finalPointsPlane;
@@ -643,7 +657,9 @@ std::vector<PlanarSegment> ObjExtractor::ExtractHorizontalPlanesRANSAC(cv::Mat p
 					}
 					else
 					{
+						cv::Point3f ptPlane = pointsPlane[ clusterPlane[i][j] ];  
 						indexes.push_back( indexesPlane[ clusterPlane[i][j] ] ) ; 
+						points.Add( ptPlane.x, ptPlane.y, ptPlane.z ); 
 					}
 				}
 			}
@@ -670,69 +686,7 @@ std::vector<PlanarSegment> ObjExtractor::ExtractHorizontalPlanesRANSAC(cv::Mat p
 
 cv::Mat ObjExtractor::CalculateNormals(cv::Mat pointCloud, cv::Mat mask)
 {
-	cv::Mat normals = cv::Mat::zeros(pointCloud.rows, pointCloud.cols, CV_32FC3); 
-
-	if( !mask.data )
-		mask = cv::Mat::ones(pointCloud.rows, pointCloud.cols, CV_8UC1); 
-
-	cv::Point3f pointi; 
-	cv::Point3f topLeft; 
-	cv::Point3f topRight; 
-	cv::Point3f downLeft; 
-	cv::Point3f downRight; 
-
-	cv::Point3f normal_1; 
-	cv::Point3f normal_2; 
-	cv::Point3f normal; 
-			
-	cv::Point3f viewPoint(0.0,0.0,0.0);
-
-	for( int idxRow = 1 ; idxRow < pointCloud.rows - 1 ; idxRow++ )
-	{
-		for( int idxCol = 1 ; idxCol < pointCloud.cols - 1 ; idxCol++ )
-		{			
-			//if( mask.at<uchar>( idxRow,idxCol ) == 0.0 )
-				//continue; 
-			
-			// Getting Vectors
-			pointi = pointCloud.at<cv::Vec3f>(idxRow, idxCol);
-
-			topLeft = pointCloud.at<cv::Vec3f>(idxRow-1, idxCol-1);
-			topRight = pointCloud.at<cv::Vec3f>(idxRow-1, idxCol+1);
-			downLeft = pointCloud.at<cv::Vec3f>(idxRow+1, idxCol-1);
-			downRight = pointCloud.at<cv::Vec3f>(idxRow+1, idxCol+1);
-			
-			if( topLeft.x == 0.0 && topLeft.y == 0.0 && topLeft.z == 0.0 )
-				continue; 
-			if( topRight.x == 0.0 && topRight.y == 0.0 && topRight.z == 0.0 )
-				continue; 
-			if( downLeft.x == 0.0 && downLeft.y == 0.0 && downLeft.z == 0.0 )
-				continue; 
-			if( downRight.x == 0.0 && downRight.y == 0.0 && downRight.z == 0.0 )
-				continue; 
-			
-			// Normals
-			normal_1 = topRight - downLeft;
-			normal_2 = topLeft - downRight; 
-
-			// Normal by cross product (v x h)
-			normal  = normal_2.cross(normal_1);
-
-			// Make normal unitary and assignin to mat
-			float norm = sqrt(normal.x*normal.x + normal.y*normal.y + normal.z*normal.z);
-			if(norm != 0.0f)
-			{
-				// Proyecting all normals over XY plane
-				//if(normal.dot(viewPoint-pointi)<0)
-				//	normal *= -1;
-				if( normal.z < 0 )
-					normal *= -1; 
-
-				normals.at<cv::Vec3f>(idxRow, idxCol) = ( 1.0f / norm ) * normal;
-			}
-		}
-	}
-	return normals;
+	return IntegralNormals::Compute( pointCloud ); 
 }
 
 cv::Vec3f ObjExtractor::RandomFloatColor()
@@ -8,10 +8,13 @@
 #include "opencv2/flann/flann.hpp"
 #include "opencv2/tracking/tracking.hpp"
 #include "justina_tools/JustinaTools.h"
+#include "justina_tools/JustinaRansac.h"
 #include "boost/filesystem.hpp"
 #include "Plane3D.hpp"
 #include "PlanarSegment.hpp"
 #include "DetectedObject.hpp"
+#include "OrganizedClusters.hpp"
+#include "IntegralNormals.hpp"
 
 class ObjExtractor
 {
@@ -24,19 +27,20 @@ class ObjExtractor
 
 
 		static cv::Mat CalculateNormals(cv::Mat pointCloud, cv::Mat mask=cv::Mat());
-		static std::vector<DetectedObject> GetObjectsInHorizontalPlanes(cv::Mat pointCloud);
+		static std::vector<DetectedObject> GetObjectsInHorizontalPlanes(cv::Mat pointCloud, ros::Time stamp=ros::Time());
 		static cv::Vec3f GetGrippers(cv::Mat imageBGR, cv::Mat pointCloud);
 		static bool TrainGripper(cv::Mat imageBGR);
 		static void LoadValueGripper();
 		static std::vector<PlanarSegment> ExtractHorizontalPlanesRANSAC(cv::Mat pointCloud, double maxDistPointToPlane, int maxIterations, int minPointsForPlane, cv::Mat mask); 
 		static std::vector<PlanarSegment> ExtractHorizontalPlanesRANSAC_2(cv::Mat pointCloud, double maxDistPointToPlane, int maxIterations, int minPointsForPlane, cv::Mat mask); 
 		static std::vector< std::vector< int > >  SegmentByDistance( std::vector< cv::Point3f > xyzPoints, double distThreshold );
+		static std::vector< std::vector< int > >  SegmentByDistance( cv::Mat pointCloud, std::vector< cv::Point2i > indexes, double distThreshold );
 		static cv::Vec3f RandomFloatColor(); 
 
-		static cv::Vec4i GetLine(cv::Mat pointCloud);
+		static cv::Vec4i GetLine(cv::Mat pointCloud, ros::Time stamp=ros::Time());
 		//ObjExtractor::H = 130, ObjExtractor::S = 127, ObjExtractor::V = 127;
 		//ObjExtractor:: Hth = 10, ObjExtractor::Sth = 80, ObjExtrac tor::Vth = 80;
-		static std::vector<PlanarSegment>  GetHorizontalPlanes(cv::Mat pointCloud);
+		static std::vector<PlanarSegment>  GetHorizontalPlanes(cv::Mat pointCloud, ros::Time stamp=ros::Time());
 
         static DetectedObject GetObjectInBox(cv::Mat& imaBGR, cv::Mat& imaXYZ); 
         static cv::Scalar frontLeftTop;
@@ -0,0 +1,165 @@
+#include "OrganizedClusters.hpp"
+
+int OrganizedClusters::Segment(cv::Mat pointCloud, cv::Mat mask, double distThreshold, cv::Mat& labels,
+	std::vector< std::vector< cv::Point2i > >& clustersIdx, int noThreads)
+{
+	clustersIdx.clear();
+	labels = cv::Mat::zeros( pointCloud.rows, pointCloud.cols, CV_32SC1 );
+	if( pointCloud.empty() || pointCloud.type() != CV_32FC3 )
+	{
+		std::cout << "OrganizedClusters.->Point cloud must be a non empty CV_32FC3 matrix." << std::endl;
+		return 0;
+	}
+	if( !mask.empty() && ( mask.type() != CV_8UC1 || mask.size() != pointCloud.size() ) )
+	{
+		std::cout << "OrganizedClusters.->Mask must be CV_8UC1 and of the same size as the point cloud." << std::endl;
+		return 0;
+	}
+
+	int rows = pointCloud.rows;
+	int cols = pointCloud.cols;
+	float distSquare = (float)( distThreshold * distThreshold );
+	// Parent of each pixel in the union-find forest, -1 if pixel is not clustered.
+	// Roots are always the smallest index of their tree.
+	std::vector< int > parent( rows * cols, -1 );
+
+	// First pass: unions inside each strip. Every thread only writes parents of its own strip.
+	noThreads = std::max( 1, std::min( noThreads, rows ) );
+	int stripRows = ( rows + noThreads - 1 ) / noThreads;
+	boost::thread_group threads;
+	for( int firstRow = stripRows; firstRow < rows; firstRow += stripRows )
+		threads.create_thread( boost::bind( &OrganizedClusters::UnionStrip, pointCloud, mask, distSquare,
+			boost::ref( parent ), firstRow, std::min( firstRow + stripRows, rows ) ) );
+	UnionStrip( pointCloud, mask, distSquare, parent, 0, std::min( stripRows, rows ) );
+	threads.join_all();
+
+	// Merge of strips
+	for( int firstRow = stripRows; firstRow < rows; firstRow += stripRows )
+		UnionWithUpperRow( pointCloud, distSquare, parent, firstRow );
+
+	// Second pass: compact labels. Since roots are the first pixel of their cluster,
+	// a root is always labeled before the rest of the pixels of its cluster.
+	int* labelsPtr = labels.ptr< int >( 0 );
+	for( int row = 0; row < rows; row++ )
+	{
+		for( int col = 0; col < cols; col++ )
+		{
+			int idx = row * cols + col;
+			if( parent[idx] < 0 )
+				continue;
+			int root = FindRoot( parent, idx );
+			if( root == idx )
+			{
+				clustersIdx.push_back( std::vector< cv::Point2i >() );
+				labelsPtr[idx] = clustersIdx.size();
+			}
+			else
+				labelsPtr[idx] = labelsPtr[root];
+			clustersIdx[ labelsPtr[idx] - 1 ].push_back( cv::Point2i( col, row ) );
+		}
+	}
+	return clustersIdx.size();
+}
+
+void OrganizedClusters::GetMasks(cv::Mat labels, int noClusters, std::vector< cv::Mat >& masks)
+{
+	masks.clear();
+	for( int i=0; i<noClusters; i++)
+		masks.push_back( cv::Mat::zeros( labels.rows, labels.cols, CV_8UC1 ) );
+
+	for( int row = 0; row < labels.rows; row++ )
+	{
+		const int* labelsRow = labels.ptr< int >( row );
+		for( int col = 0; col < labels.cols; col++ )
+			if( labelsRow[col] > 0 && labelsRow[col] <= noClusters )
+				masks[ labelsRow[col] - 1 ].ptr< uchar >( row )[col] = 255;
+	}
+}
+
+void OrganizedClusters::UnionStrip(cv::Mat pointCloud, cv::Mat mask, float distSquare, std::vector< int >& parent, int firstRow, int lastRow)
+{
+	int cols = pointCloud.cols;
+	for( int row = firstRow; row < lastRow; row++ )
+	{
+		const cv::Vec3f* points = pointCloud.ptr< cv::Vec3f >( row );
+		const cv::Vec3f* upperPoints = row > firstRow ? pointCloud.ptr< cv::Vec3f >( row - 1 ) : 0;
+		const uchar* maskRow = mask.empty() ? 0 : mask.ptr< uchar >( row );
+		for( int col = 0; col < cols; col++ )
+		{
+			if( maskRow != 0 && maskRow[col] == 0 )
+				continue;
+			const cv::Vec3f& p = points[col];
+			if( p[0] != p[0] || p[1] != p[1] || p[2] != p[2] )
+				continue;
+
+			int idx = row * cols + col;
+			parent[idx] = idx;
+
+			// Previous neighbors in raster order: left, upper left, upper and upper right
+			if( col > 0 && parent[idx - 1] >= 0 && AreNear( p, points[col - 1], distSquare ) )
+				Union( parent, idx, idx - 1 );
+			if( upperPoints == 0 )
+				continue;
+			for( int dCol = -1; dCol <= 1; dCol++ )
+			{
+				int nCol = col + dCol;
+				if( nCol < 0 || nCol >= cols )
+					continue;
+				int nIdx = idx - cols + dCol;
+				if( parent[nIdx] >= 0 && AreNear( p, upperPoints[nCol], distSquare ) )
+					Union( parent, idx, nIdx );
+			}
+		}
+	}
+}
+
+void OrganizedClusters::UnionWithUpperRow(cv::Mat pointCloud, float distSquare, std::vector< int >& parent, int row)
+{
+	int cols = pointCloud.cols;
+	const cv::Vec3f* points = pointCloud.ptr< cv::Vec3f >( row );
+	const cv::Vec3f* upperPoints = pointCloud.ptr< cv::Vec3f >( row - 1 );
+	for( int col = 0; col < cols; col++ )
+	{
+		int idx = row * cols + col;
+		if( parent[idx] < 0 )
+			continue;
+		for( int dCol = -1; dCol <= 1; dCol++ )
+		{
+			int nCol = col + dCol;
+			if( nCol < 0 || nCol >= cols )
+				continue;
+			int nIdx = idx - cols + dCol;
+			if( parent[nIdx] >= 0 && AreNear( points[col], upperPoints[nCol], distSquare ) )
+				Union( parent, idx, nIdx );
+		}
+	}
+}
+
+int OrganizedClusters::FindRoot(std::vector< int >& parent, int idx)
+{
+	// Path halving
+	while( parent[idx] != idx )
+	{
+		parent[idx] = parent[ parent[idx] ];
+		idx = parent[idx];
+	}
+	return idx;
+}
+
+void OrganizedClusters::Union(std::vector< int >& parent, int idxA, int idxB)
+{
+	int rootA = FindRoot( parent, idxA );
+	int rootB = FindRoot( parent, idxB );
+	if( rootA < rootB )
+		parent[rootB] = rootA;
+	else if( rootB < rootA )
+		parent[rootA] = rootB;
+}
+
+bool OrganizedClusters::AreNear(const cv::Vec3f& a, const cv::Vec3f& b, float distSquare)
+{
+	float dx = a[0] - b[0];
+	float dy = a[1] - b[1];
+	float dz = a[2] - b[2];
+	return dx*dx + dy*dy + dz*dz < distSquare;
+}
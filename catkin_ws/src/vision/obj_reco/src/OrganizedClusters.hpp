@@ -0,0 +1,28 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <opencv2/core/core.hpp>
+#include "boost/thread/thread.hpp"
+#include "boost/bind.hpp"
+
+// Connected components of an organized point cloud (CV_32FC3). Two pixels of the mask are connected if they
+// are 8-neighbors in the image and their 3D distance is less than distThreshold. Components are found with a
+// union-find over the pixel grid, thus no KD-tree is built. The raster pass can be split in horizontal strips
+// processed in parallel; unions across the borders of the strips are done afterwards.
+// Labels are CV_32SC1, 0 for pixels out of the mask or with invalid points, and 1..n ordered by the first
+// pixel of each cluster in raster order.
+class OrganizedClusters
+{
+	public:
+		static int Segment(cv::Mat pointCloud, cv::Mat mask, double distThreshold, cv::Mat& labels,
+			std::vector< std::vector< cv::Point2i > >& clustersIdx, int noThreads=1);
+		static void GetMasks(cv::Mat labels, int noClusters, std::vector< cv::Mat >& masks);
+
+	private:
+		static void UnionStrip(cv::Mat pointCloud, cv::Mat mask, float distSquare, std::vector< int >& parent, int firstRow, int lastRow);
+		static void UnionWithUpperRow(cv::Mat pointCloud, float distSquare, std::vector< int >& parent, int row);
+		static int FindRoot(std::vector< int >& parent, int idx);
+		static void Union(std::vector< int >& parent, int idxA, int idxB);
+		static bool AreNear(const cv::Vec3f& a, const cv::Vec3f& b, float distSquare);
+};
@@ -0,0 +1,317 @@
+#include "PersonDetector.hpp"
+#include "OrganizedClusters.hpp"
+#include <opencv2/highgui/highgui.hpp>
+
+// Label of the person class in the PASCAL VOC MobileNet-SSD
+#define SSD_PERSON_LABEL 15
+#define SSD_INPUT_SIZE 300
+// Candidates are searched on the cloud decimated by this step
+#define CANDIDATES_STEP 4
+
+float PersonDetector::ConfidenceThreshold = 0.5;
+float PersonDetector::MinPersonHeight = 0.9;
+float PersonDetector::MaxPersonHeight = 2.1;
+float PersonDetector::MaxPersonWidth = 1.2;
+float PersonDetector::MaxDistance = 5.0;
+bool PersonDetector::DebugMode = false;
+
+bool PersonDetector::modelLoaded = false;
+cv::HOGDescriptor PersonDetector::hog;
+#ifdef PERSON_DETECTOR_USE_DNN
+cv::dnn::Net PersonDetector::net;
+#endif
+
+bool DetectedPerson::CompareByDistance(const DetectedPerson& a, const DetectedPerson& b)
+{
+	return a.centroid.x*a.centroid.x + a.centroid.y*a.centroid.y < b.centroid.x*b.centroid.x + b.centroid.y*b.centroid.y;
+}
+
+bool PersonDetector::LoadModel(std::string prototxtFile, std::string caffeModelFile)
+{
+	hog.setSVMDetector( cv::HOGDescriptor::getDefaultPeopleDetector() );
+	modelLoaded = false;
+#ifdef PERSON_DETECTOR_USE_DNN
+	try
+	{
+		net = cv::dnn::readNetFromCaffe( prototxtFile, caffeModelFile );
+		modelLoaded = !net.empty();
+	}
+	catch( cv::Exception& e )
+	{
+		std::cout << "PersonDetector.->Cannot load " << caffeModelFile << ": " << e.what() << std::endl;
+	}
+#endif
+	if( modelLoaded )
+		std::cout << "PersonDetector.->Using MobileNet-SSD from " << caffeModelFile << std::endl;
+	else
+		std::cout << "PersonDetector.->Network not available, using HOG people detector" << std::endl;
+	return modelLoaded;
+}
+
+bool PersonDetector::IsModelLoaded()
+{
+	return modelLoaded;
+}
+
+std::vector< DetectedPerson > PersonDetector::Detect(cv::Mat imaBGR, cv::Mat pointCloud)
+{
+	std::vector< DetectedPerson > persons;
+	if( imaBGR.empty() || pointCloud.type() != CV_32FC3 || imaBGR.size() != pointCloud.size() )
+	{
+		std::cout << "PersonDetector.->Image and point cloud must be non empty and of the same size." << std::endl;
+		return persons;
+	}
+	if( hog.svmDetector.empty() )
+		hog.setSVMDetector( cv::HOGDescriptor::getDefaultPeopleDetector() );
+
+	std::vector< cv::Rect > candidates = GetCandidates( pointCloud );
+	if( candidates.size() == 0 )
+		return persons;
+
+	std::vector< DetectedPerson > detections;
+	if( modelLoaded )
+		detections = ScoreWithNetwork( imaBGR, candidates );
+	else
+		detections = ScoreWithHOG( imaBGR, pointCloud, candidates );
+
+	// Boxes whose points are not of the size of a person are discarded
+	for( size_t i = 0; i < detections.size(); i++ )
+		if( GetMetricBox( pointCloud, detections[i].boundBox, detections[i] ) )
+			persons.push_back( detections[i] );
+	SuppressOverlapped( persons );
+	std::sort( persons.begin(), persons.end(), DetectedPerson::CompareByDistance );
+
+	if( DebugMode )
+	{
+		cv::Mat imaToShow = imaBGR.clone();
+		for( size_t i = 0; i < candidates.size(); i++ )
+			cv::rectangle( imaToShow, candidates[i], cv::Scalar(255,0,0) );
+		for( size_t i = 0; i < persons.size(); i++ )
+			cv::rectangle( imaToShow, persons[i].boundBox, cv::Scalar(0,255,0), 2 );
+		cv::imshow( "Person Detector", imaToShow );
+	}
+	std::cout << "PersonDetector.->Candidates: " << candidates.size() << " Persons: " << persons.size() << std::endl;
+	return persons;
+}
+
+// Clusters of points above the floor whose top is at the height of a head. Their bounding boxes, with some margin,
+// are the regions scored by the detectors. Clusters wider than a person (persons side by side, a person touching
+// a chair or a table) are split along the image columns into overlapping person-wide regions; false positives
+// are rejected afterwards by the metric size of the detections.
+std::vector< cv::Rect > PersonDetector::GetCandidates(cv::Mat pointCloud)
+{
+	std::vector< cv::Rect > candidates;
+	cv::Mat smallCloud;
+	cv::resize( pointCloud, smallCloud, cv::Size( pointCloud.cols / CANDIDATES_STEP, pointCloud.rows / CANDIDATES_STEP ), 0, 0, cv::INTER_NEAREST );
+
+	float maxDistance2 = MaxDistance * MaxDistance;
+	cv::Mat mask = cv::Mat::zeros( smallCloud.rows, smallCloud.cols, CV_8UC1 );
+	for( int row = 0; row < smallCloud.rows; row++ )
+	{
+		const cv::Vec3f* points = smallCloud.ptr< cv::Vec3f >( row );
+		uchar* maskRow = mask.ptr< uchar >( row );
+		for( int col = 0; col < smallCloud.cols; col++ )
+		{
+			const cv::Vec3f& p = points[col];
+			if( p[2] > 0.1f && p[2] < MaxPersonHeight && p[0]*p[0] + p[1]*p[1] < maxDistance2 )
+				maskRow[col] = 255;
+		}
+	}
+
+	cv::Mat labels;
+	std::vector< std::vector< cv::Point2i > > clustersIdx;
+	OrganizedClusters::Segment( smallCloud, mask, 0.1, labels, clustersIdx );
+	for( size_t i = 0; i < clustersIdx.size(); i++ )
+	{
+		if( clustersIdx[i].size() < 30 )
+			continue;
+		cv::Point3f minP( 1e6, 1e6, 1e6 );
+		cv::Point3f maxP( -1e6, -1e6, -1e6 );
+		for( size_t j = 0; j < clustersIdx[i].size(); j++ )
+		{
+			const cv::Vec3f& p = smallCloud.at< cv::Vec3f >( clustersIdx[i][j] );
+			minP.x = std::min( minP.x, p[0] ); maxP.x = std::max( maxP.x, p[0] );
+			minP.y = std::min( minP.y, p[1] ); maxP.y = std::max( maxP.y, p[1] );
+			minP.z = std::min( minP.z, p[2] ); maxP.z = std::max( maxP.z, p[2] );
+		}
+		if( maxP.z < MinPersonHeight )
+			continue;
+
+		cv::Rect box = cv::boundingRect( clustersIdx[i] );
+		box = cv::Rect( box.x * CANDIDATES_STEP, box.y * CANDIDATES_STEP, box.width * CANDIDATES_STEP, box.height * CANDIDATES_STEP );
+		std::vector< cv::Rect > boxes;
+		float width = maxP.y - minP.y;
+		if( width <= MaxPersonWidth )
+			boxes.push_back( box );
+		else
+		{
+			// Tiles overlap half their width, so a person is completely inside one of them
+			int tileWidth = std::max( (int)( box.width * MaxPersonWidth / width ), CANDIDATES_STEP );
+			int tileStep = std::max( tileWidth / 2, 1 );
+			for( int x = box.x; ; x += tileStep )
+			{
+				boxes.push_back( cv::Rect( x, box.y, std::min( tileWidth, box.x + box.width - x ), box.height ) );
+				if( x + tileWidth >= box.x + box.width )
+					break;
+			}
+		}
+		for( size_t j = 0; j < boxes.size(); j++ )
+		{
+			cv::Rect roi = boxes[j];
+			int marginX = roi.width / 5 + CANDIDATES_STEP;
+			int marginY = roi.height / 10 + CANDIDATES_STEP;
+			roi = cv::Rect( roi.x - marginX, roi.y - marginY, roi.width + 2*marginX, roi.height + 2*marginY );
+			roi &= cv::Rect( 0, 0, pointCloud.cols, pointCloud.rows );
+			if( roi.area() > 0 )
+				candidates.push_back( roi );
+		}
+	}
+	return candidates;
+}
+
+// All candidates go in one blob (one image per candidate), thus the network runs a single forward per frame
+std::vector< DetectedPerson > PersonDetector::ScoreWithNetwork(cv::Mat imaBGR, std::vector< cv::Rect >& candidates)
+{
+	std::vector< DetectedPerson > detections;
+#ifdef PERSON_DETECTOR_USE_DNN
+	std::vector< cv::Mat > rois;
+	for( size_t i = 0; i < candidates.size(); i++ )
+		rois.push_back( imaBGR( candidates[i] ) );
+
+	cv::Mat blob = cv::dnn::blobFromImages( rois, 0.007843, cv::Size( SSD_INPUT_SIZE, SSD_INPUT_SIZE ), cv::Scalar( 127.5, 127.5, 127.5 ), false );
+	net.setInput( blob );
+	cv::Mat output = net.forward();
+
+	// Output is 1 x 1 x N x 7: image id, label, confidence, and the corners normalized to the input image
+	cv::Mat results( output.size[2], output.size[3], CV_32F, output.ptr< float >() );
+	for( int i = 0; i < results.rows; i++ )
+	{
+		const float* r = results.ptr< float >( i );
+		int imageId = (int)r[0];
+		if( imageId < 0 || imageId >= (int)candidates.size() || (int)r[1] != SSD_PERSON_LABEL || r[2] < ConfidenceThreshold )
+			continue;
+		const cv::Rect& roi = candidates[imageId];
+		int x1 = roi.x + (int)( std::max( r[3], 0.0f ) * roi.width );
+		int y1 = roi.y + (int)( std::max( r[4], 0.0f ) * roi.height );
+		int x2 = roi.x + (int)( std::min( r[5], 1.0f ) * roi.width );
+		int y2 = roi.y + (int)( std::min( r[6], 1.0f ) * roi.height );
+		if( x2 <= x1 || y2 <= y1 )
+			continue;
+		DetectedPerson person;
+		person.boundBox = cv::Rect( x1, y1, x2 - x1, y2 - y1 );
+		person.confidence = r[2];
+		detections.push_back( person );
+	}
+#endif
+	return detections;
+}
+
+// Each candidate is resized so that a person filling it is slightly taller than the HOG window, thus only the
+// few pyramid levels around the scale given by the depth are evaluated instead of the whole image pyramid.
+std::vector< DetectedPerson > PersonDetector::ScoreWithHOG(cv::Mat imaBGR, cv::Mat pointCloud, std::vector< cv::Rect >& candidates)
+{
+	std::vector< DetectedPerson > detections;
+	const double targetHeight = 1.4 * hog.winSize.height;
+	for( size_t i = 0; i < candidates.size(); i++ )
+	{
+		const cv::Rect& roi = candidates[i];
+		double scale = targetHeight / roi.height;
+		cv::Mat resized;
+		cv::resize( imaBGR( roi ), resized, cv::Size(), scale, scale, scale < 1 ? cv::INTER_AREA : cv::INTER_LINEAR );
+		int padX = std::max( hog.winSize.width - resized.cols, 0 );
+		int padY = std::max( hog.winSize.height - resized.rows, 0 );
+		if( padX > 0 || padY > 0 )
+			cv::copyMakeBorder( resized, resized, 0, padY, 0, padX, cv::BORDER_REPLICATE );
+
+		std::vector< cv::Rect > found;
+		std::vector< double > weights;
+		hog.detectMultiScale( resized, found, weights, 0, cv::Size(8,8), cv::Size(16,16), 1.1, 2 );
+		for( size_t j = 0; j < found.size(); j++ )
+		{
+			// SVM margin mapped to [0,1], 0.5 at the decision boundary
+			float confidence = j < weights.size() ? 1.0 / ( 1.0 + std::exp( -weights[j] ) ) : 0.5;
+			if( confidence < ConfidenceThreshold )
+				continue;
+			DetectedPerson person;
+			person.boundBox = cv::Rect( roi.x + (int)( found[j].x / scale ), roi.y + (int)( found[j].y / scale ),
+				(int)( found[j].width / scale ), (int)( found[j].height / scale ) );
+			person.boundBox &= cv::Rect( 0, 0, imaBGR.cols, imaBGR.rows );
+			person.confidence = confidence;
+			if( person.boundBox.area() > 0 )
+				detections.push_back( person );
+		}
+	}
+	return detections;
+}
+
+// Points of the box at the distance of its center (the box also contains background). Returns false if they
+// are too few or their size is not the one of a person.
+bool PersonDetector::GetMetricBox(cv::Mat pointCloud, cv::Rect box, DetectedPerson& person)
+{
+	const int step = 2;
+	cv::Rect center( box.x + box.width/4, box.y + box.height/4, box.width/2, box.height/2 );
+	std::vector< float > distances;
+	for( int row = center.y; row < center.y + center.height; row += step )
+	{
+		const cv::Vec3f* points = pointCloud.ptr< cv::Vec3f >( row );
+		for( int col = center.x; col < center.x + center.width; col += step )
+			if( points[col][2] > 0.0f )
+				distances.push_back( std::sqrt( points[col][0]*points[col][0] + points[col][1]*points[col][1] ) );
+	}
+	if( distances.size() < 10 )
+		return false;
+	std::nth_element( distances.begin(), distances.begin() + distances.size()/2, distances.end() );
+	float medianDist = distances[ distances.size()/2 ];
+
+	int noPoints = 0;
+	cv::Point3f sum( 0, 0, 0 );
+	cv::Point3f minP( 1e6, 1e6, 1e6 );
+	cv::Point3f maxP( -1e6, -1e6, -1e6 );
+	for( int row = box.y; row < box.y + box.height; row += step )
+	{
+		const cv::Vec3f* points = pointCloud.ptr< cv::Vec3f >( row );
+		for( int col = box.x; col < box.x + box.width; col += step )
+		{
+			const cv::Vec3f& p = points[col];
+			if( p[2] <= 0.0f || std::fabs( std::sqrt( p[0]*p[0] + p[1]*p[1] ) - medianDist ) > 0.4f )
+				continue;
+			sum += cv::Point3f( p[0], p[1], p[2] );
+			minP.x = std::min( minP.x, p[0] ); maxP.x = std::max( maxP.x, p[0] );
+			minP.y = std::min( minP.y, p[1] ); maxP.y = std::max( maxP.y, p[1] );
+			minP.z = std::min( minP.z, p[2] ); maxP.z = std::max( maxP.z, p[2] );
+			noPoints++;
+		}
+	}
+	if( noPoints < 20 || maxP.z < MinPersonHeight || maxP.z > MaxPersonHeight + 0.2f || maxP.y - minP.y > MaxPersonWidth )
+		return false;
+
+	person.centroid = sum * ( 1.0f / noPoints );
+	person.minPoint = minP;
+	person.maxPoint = maxP;
+	return true;
+}
+
+// Keeps the most confident detection among those overlapped in the image or too near in space
+void PersonDetector::SuppressOverlapped(std::vector< DetectedPerson >& persons)
+{
+	for( size_t i = 1; i < persons.size(); i++ )
+		for( size_t j = i; j > 0 && persons[j].confidence > persons[j-1].confidence; j-- )
+			std::swap( persons[j], persons[j-1] );
+
+	std::vector< DetectedPerson > kept;
+	for( size_t i = 0; i < persons.size(); i++ )
+	{
+		bool suppressed = false;
+		for( size_t j = 0; j < kept.size() && !suppressed; j++ )
+		{
+			double inter = ( persons[i].boundBox & kept[j].boundBox ).area();
+			double uni = persons[i].boundBox.area() + kept[j].boundBox.area() - inter;
+			float dx = persons[i].centroid.x - kept[j].centroid.x;
+			float dy = persons[i].centroid.y - kept[j].centroid.y;
+			suppressed = inter > 0.5 * uni || dx*dx + dy*dy < 0.3f * 0.3f;
+		}
+		if( !suppressed )
+			kept.push_back( persons[i] );
+	}
+	persons.swap( kept );
+}
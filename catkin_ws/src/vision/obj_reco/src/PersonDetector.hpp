@@ -0,0 +1,59 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/objdetect/objdetect.hpp>
+#include <opencv2/opencv_modules.hpp>
+
+#if defined(HAVE_OPENCV_DNN) && (CV_VERSION_MAJOR > 3 || (CV_VERSION_MAJOR == 3 && CV_VERSION_MINOR >= 3))
+#define PERSON_DETECTOR_USE_DNN
+#include <opencv2/dnn.hpp>
+#endif
+
+class DetectedPerson
+{
+	public:
+		cv::Rect boundBox;
+		cv::Point3f centroid;
+		cv::Point3f minPoint;
+		cv::Point3f maxPoint;
+		float confidence;
+
+		static bool CompareByDistance(const DetectedPerson& a, const DetectedPerson& b);
+};
+
+// Person detector on the BGR image and the organized cloud (CV_32FC3, wrt robot, z up) of the same frame.
+// Candidates are proposed from the cloud: clusters of points above the floor whose 3D size could be a standing
+// or seated person. Each candidate ROI is scored by a MobileNet-SSD network (all ROIs of a frame are batched in
+// one forward) or, if the network is not available, by the HOG people detector restricted to the scales that
+// the depth of the ROI allows. Detections are kept only if the points inside their box have a plausible size.
+// The network is loaded once by LoadModel; without it (or without the OpenCV dnn module) HOG is used.
+class PersonDetector
+{
+	public:
+		static bool LoadModel(std::string prototxtFile, std::string caffeModelFile);
+		static bool IsModelLoaded();
+		static std::vector< DetectedPerson > Detect(cv::Mat imaBGR, cv::Mat pointCloud);
+
+		static float ConfidenceThreshold;
+		static float MinPersonHeight;
+		static float MaxPersonHeight;
+		static float MaxPersonWidth;
+		static float MaxDistance;
+		static bool DebugMode;
+
+	private:
+		static std::vector< cv::Rect > GetCandidates(cv::Mat pointCloud);
+		static std::vector< DetectedPerson > ScoreWithNetwork(cv::Mat imaBGR, std::vector< cv::Rect >& candidates);
+		static std::vector< DetectedPerson > ScoreWithHOG(cv::Mat imaBGR, cv::Mat pointCloud, std::vector< cv::Rect >& candidates);
+		static bool GetMetricBox(cv::Mat pointCloud, cv::Rect box, DetectedPerson& person);
+		static void SuppressOverlapped(std::vector< DetectedPerson >& persons);
+
+		static bool modelLoaded;
+		static cv::HOGDescriptor hog;
+#ifdef PERSON_DETECTOR_USE_DNN
+		static cv::dnn::Net net;
+#endif
+};
@@ -176,118 +176,56 @@ std::vector<DetectedObject> ObjectsExtractor::ExtractObjectsHorizantalPlanes( cv
 
 void ObjectsExtractor::GetNormalsCross(cv::Mat& xyzPoints, cv::Mat& normals){
 	
-	normals = cv::Mat::zeros(xyzPoints.rows, xyzPoints.cols, CV_32FC3); 
-	
-	cv::Point3f topLeft; 
-	cv::Point3f topRight; 
-	cv::Point3f downLeft; 
-	cv::Point3f downRight; 
-
-	cv::Point3f normal_1; 
-	cv::Point3f normal_2; 
-	cv::Point3f normal; 
-			
-	cv::Point3f center;
-	
-	float norm = 0.0;
-
-	for( int idxRow = 1 ; idxRow < xyzPoints.rows - 1 ; idxRow++ )
-	{
-		for( int idxCol = 1 ; idxCol < xyzPoints.cols - 1 ; idxCol++ )
-		{			
-			// Getting Vectors
-			topLeft = xyzPoints.at<cv::Vec3f>(idxRow-1, idxCol-1);
-			topRight = xyzPoints.at<cv::Vec3f>(idxRow-1, idxCol+1);
-			downLeft = xyzPoints.at<cv::Vec3f>(idxRow+1, idxCol-1);
-			downRight = xyzPoints.at<cv::Vec3f>(idxRow+1, idxCol+1);
-			
-			if( topLeft.x == 0.0 && topLeft.y == 0.0 && topLeft.z == 0.0 )
-				continue; 
-			if( topRight.x == 0.0 && topRight.y == 0.0 && topRight.z == 0.0 )
-				continue; 
-			if( downLeft.x == 0.0 && downLeft.y == 0.0 && downLeft.z == 0.0 )
-				continue; 
-			if( downRight.x == 0.0 && downRight.y == 0.0 && downRight.z == 0.0 )
-				continue; 
-			
-			// Normals
-			normal_1 = topRight - downLeft;
-			normal_2 = topLeft - downRight; 
-
-			// Normal by cross product (v x h)
-			normal  = normal_2.cross(normal_1);
-
-			// Proyecting all normals over XY plane
-			if(  normal.z < 0 )
-				normal = -normal;
-
-			// Make normal unitary
-			norm = sqrt(normal.x*normal.x + normal.y*normal.y + normal.z*normal.z);
-						
-			if(norm == 0.0f)
-				continue; 
+	normals = IntegralNormals::Compute( xyzPoints ); 
+}
 
-			// Asignign Value To normal
-			normals.at<cv::Vec3f>(idxRow, idxCol) = ( 1.0f / norm ) * normal;
-		}
-	}
+static bool isHorizontalPlane(const RansacPlane& plane)
+{
+	return std::abs( plane.c ) >= 0.99; 
 }
 
 std::vector<PlanarHorizontalSegment> ObjectsExtractor::GetPlanesRANSAC_2(cv::Mat pointCloud, std::vector<cv::Point2i> indexes, int minPointsForPlane, double distThresholdForPlane, int maxIterations, cv::Mat& out_planesMask){
 	
 	float distToPlane; 
 	cv::Point3f xyzPoint; 
-	double dist1;
-	double dist2;
-	double dist3;
 
 	std::vector<PlanarHorizontalSegment> horizontalPlanes; 
 	std::vector< std::vector< cv::Point2i > > indexesPlanes; 
 
 	out_planesMask = cv::Mat::zeros( pointCloud.rows, pointCloud.cols, CV_8UC1); 
 
-	int iterationsCnt = 0; 
-	while( iterationsCnt++ < maxIterations && indexes.size() > minPointsForPlane ){
-		
-		// Getting Random points 
-		cv::Point3f p1 = pointCloud.at<cv::Vec3f>( indexes[rand() % indexes.size() ] );  
-		cv::Point3f p2 = pointCloud.at<cv::Vec3f>( indexes[rand() % indexes.size() ] ); 
-		cv::Point3f p3 = pointCloud.at<cv::Vec3f>( indexes[rand() % indexes.size() ] ); 
-
-		// Checking that are valid points for plane, ej. not paralls
-		if( !Plane3D::AreValidPointsForPlane( p1, p2, p3 ) )
-			continue;
+	// Hypotheses are drawn by the shared RANSAC: samples closer than 0.2 and non horizontal planes 
+	// are discarded before scoring. The PCA refinement below is kept since the segment needs the pca. 
+	Ransac< RansacPlane > ransac; 
+	ransac.threshold = distThresholdForPlane; 
+	ransac.minInliers = minPointsForPlane; 
+	ransac.minSampleDistance = 0.2; 
+	ransac.refine = false; 
+	ransac.isValidModel = isHorizontalPlane; 
+
+	RansacPoints points; 
+	std::vector< int > ransacInliers; 
+	int iterationsLeft = maxIterations; 
+	while( iterationsLeft > 0 && indexes.size() > minPointsForPlane ){
 		
-		// Checking not so close points
-		dist1 = cv::norm(p1 - p2);
-		dist2 = cv::norm(p1 - p3); 
-		dist3 = cv::norm(p2 - p3); 
-		if(dist1 < 0.2 || dist2 < 0.2 || dist3 < 0.2 )
-			continue; 
-
-		// Calculating candidate plane
-		Plane3D candidatePlane( p1, p2, p3 ); 
-
-		if( std::abs( candidatePlane.GetNormal().z ) < 0.99 ){			
-			continue; 
-		}
-
-		// Checking distance to candidate plane of points
-		std::vector< cv::Point3f > inliers; 
-		inliers.reserve( indexes.size() ); 
-
+		points.Clear(); 
+		points.Reserve( indexes.size() ); 
 		for(size_t i=0; i<indexes.size(); i++ ){
-			
-			xyzPoint = pointCloud.at<cv::Vec3f>(indexes[i]); 
-			distToPlane = candidatePlane.DistanceToPoint( xyzPoint );
-			
-			if( distToPlane < distThresholdForPlane )
-				inliers.push_back( xyzPoint ); 
+			const cv::Vec3f& p = pointCloud.at<cv::Vec3f>( indexes[i] ); 
+			points.Add( p[0], p[1], p[2] ); 
 		}
 
-		// If there are few inliers discard
-		if( inliers.size() < minPointsForPlane )
-			continue; 
+		RansacPlane candidatePlane; 
+		ransac.maxIterations = iterationsLeft; 
+		bool found = ransac.Estimate( points, candidatePlane, ransacInliers ); 
+		iterationsLeft -= std::max( ransac.GetLastIterations(), 1 ); 
+		if( !found )
+			break; 
+
+		std::vector< cv::Point3f > inliers; 
+		inliers.reserve( ransacInliers.size() ); 
+		for(size_t i=0; i<ransacInliers.size(); i++ )
+			inliers.push_back( cv::Point3f( points.x[ransacInliers[i]], points.y[ransacInliers[i]], points.z[ransacInliers[i]] ) ); 
 
 		// Getting a better plane using PCA analisys
 		cv::PCA pca( cv::Mat(inliers).reshape(1), cv::Mat(), CV_PCA_DATA_AS_ROW);
@@ -613,195 +551,15 @@ std::vector<PlanarHorizontalSegment> ObjectsExtractor::GetPlanesRANSAC(cv::Mat p
 
 void ObjectsExtractor::ConnectedComponents3D(cv::Mat pointCloud, cv::Mat mask, double minDist, cv::Mat labelsMask, std::vector<std::vector<cv::Point2i> >& objIndexes, std::vector<cv::Mat>& objectsMask){
 	
-	labelsMask = cv::Mat::zeros(pointCloud.rows, pointCloud.cols, CV_32FC1); 
-	
-	float currentLabel = 0.0f; 
-	for( int i=1 ; i < pointCloud.rows-1 ; i++){
-		for( int j=1 ; j < pointCloud.cols-1 ; j++){
-
-			if( mask.at<uchar>( i,j ) == 0 ) 
-				continue; 
-
-			if( labelsMask.at<float>( i,j ) != 0.0f )
-				continue; 
-
-			std::queue< cv::Point2i > neighboursQueue; 
-			std::vector< cv::Point2i > indexes; 
-			cv::Mat objMask = cv::Mat::zeros(pointCloud.rows, pointCloud.cols, CV_8UC1); 
-
-			currentLabel += 1.0; 
-			labelsMask.at<float>( i,j ) = currentLabel; 
-			neighboursQueue.push( cv::Point2i(j,i) ); 
-			indexes.push_back( cv::Point2i(j,i) ); 
-
-			objMask.at<uchar>(i,j) = 255; 
-
-			while( neighboursQueue.size() > 0 ){
-				
-				cv::Point2i currentPixel = neighboursQueue.front(); 
-				neighboursQueue.pop(); 
-
-				cv::Point3f currentPoint = pointCloud.at< cv::Vec3f >( currentPixel ); 			
-
-				// Neighbours			
-				cv::Point2i up    = currentPixel + cv::Point2i( 1 , 0); 
-				cv::Point2i down  = currentPixel + cv::Point2i(-1 , 0); 
-				cv::Point2i left  = currentPixel + cv::Point2i( 0 ,-1); 
-				cv::Point2i right = currentPixel + cv::Point2i( 0 ,+1); 
-				
-				// Checking for Neighbours
-				cv::Point2i neighPixel; 
-				cv::Point3f neighPoint; 
+	// Union-find over the 8-neighbors of the pixel grid, in a single raster pass (see OrganizedClusters)
+	std::vector< std::vector< cv::Point2i > > clustersIdx; 
+	int noClusters = OrganizedClusters::Segment( pointCloud, mask, minDist, labelsMask, clustersIdx, boost::thread::hardware_concurrency() ); 
 
-				bool isInMask = false; 
-				bool isNotLabeled = false; 
-				bool isNearPoint = false;
-				
-				// Checking for up
-				neighPixel = up;
-				if( neighPixel.x>=0 && neighPixel.x<pointCloud.cols && neighPixel.y>=0 && neighPixel.y<pointCloud.rows ) {
-					neighPoint = pointCloud.at<cv::Vec3f>( neighPixel );
-					isInMask = mask.at<uchar>(neighPixel) != 0 ;  // has normal up
-					isNotLabeled = labelsMask.at<float>(neighPixel) == 0.0 ;
-					isNearPoint = cv::norm( neighPoint - currentPoint ) < minDist; 
-					if( isInMask && isNearPoint )
-					{
-						if( isNotLabeled ) 
-						{
-							labelsMask.at<float>( neighPixel ) = currentLabel;
-							neighboursQueue.push( neighPixel );
-							indexes.push_back( neighPixel ); 
-							objMask.at<uchar>(neighPixel) = 255; 
-						}
-						else
-						{
-							float neighLabel = labelsMask.at<float>( neighPixel ); 
-							if( neighLabel < currentLabel )
-							{
-								labelsMask.at<float>( neighPixel ) = neighLabel; 	
-								neighboursQueue.push( neighPixel );
-								indexes.push_back( neighPixel ); 
-								objMask.at<uchar>(neighPixel) = 255; 
-							}
-						}
-					}
-				}
-
-				// Checking for down
-				neighPixel = down;
-				if( neighPixel.x>=0 && neighPixel.x<pointCloud.cols && neighPixel.y>=0 && neighPixel.y<pointCloud.rows ) {
-					neighPoint = pointCloud.at<cv::Vec3f>( neighPixel );
-					isInMask = mask.at<uchar>(neighPixel) != 0 ;  // has normal up
-					isNotLabeled = labelsMask.at<float>(neighPixel) == 0.0 ;
-					isNearPoint = cv::norm( neighPoint - currentPoint ) < minDist; 
-					if( isInMask && isNearPoint )
-					{
-						if( isNotLabeled ) 
-						{
-							labelsMask.at<float>( neighPixel ) = currentLabel;
-							neighboursQueue.push( neighPixel );
-							indexes.push_back( neighPixel ); 
-							objMask.at<uchar>(neighPixel) = 255; 
-						}
-						else
-						{
-							float neighLabel = labelsMask.at<float>( neighPixel ); 
-							if( neighLabel < currentLabel )
-							{
-								labelsMask.at<float>( neighPixel ) = neighLabel; 	
-								neighboursQueue.push( neighPixel );
-								indexes.push_back( neighPixel ); 
-								objMask.at<uchar>(neighPixel) = 255; 
-							}
-						}
-					}
-				}
-
-				// Checking for left
-				neighPixel = left;
-				if( neighPixel.x>=0 && neighPixel.x<pointCloud.cols && neighPixel.y>=0 && neighPixel.y<pointCloud.rows ) {
-					neighPoint = pointCloud.at<cv::Vec3f>( neighPixel );
-					isInMask = mask.at<uchar>(neighPixel) != 0 ;  // has normal up
-					isNotLabeled = labelsMask.at<float>(neighPixel) == 0.0 ;
-					isNearPoint = cv::norm( neighPoint - currentPoint ) < minDist; 
-					if( isInMask && isNearPoint )
-					{
-						if( isNotLabeled ) 
-						{
-							labelsMask.at<float>( neighPixel ) = currentLabel;
-							neighboursQueue.push( neighPixel );
-							indexes.push_back( neighPixel ); 
-							objMask.at<uchar>(neighPixel) = 255; 
-						}
-						else
-						{
-							float neighLabel = labelsMask.at<float>( neighPixel ); 
-							if( neighLabel < currentLabel )
-							{
-								labelsMask.at<float>( neighPixel ) = neighLabel; 	
-								neighboursQueue.push( neighPixel );
-								indexes.push_back( neighPixel ); 
-								objMask.at<uchar>(neighPixel) = 255; 
-							}
-						}
-					}
-				}
-
-				// Checking for right
-				neighPixel = right;
-				if( neighPixel.x>=0 && neighPixel.x<pointCloud.cols && neighPixel.y>=0 && neighPixel.y<pointCloud.rows ) {
-					neighPoint = pointCloud.at<cv::Vec3f>( neighPixel );
-					isInMask = mask.at<uchar>(neighPixel) != 0 ;  // has normal up
-					isNotLabeled = labelsMask.at<float>(neighPixel) == 0.0 ;
-					isNearPoint = cv::norm( neighPoint - currentPoint ) < minDist; 
-					if( isInMask && isNearPoint )
-					{
-						if( isNotLabeled ) 
-						{
-							labelsMask.at<float>( neighPixel ) = currentLabel;
-							neighboursQueue.push( neighPixel );
-							indexes.push_back( neighPixel ); 
-							objMask.at<uchar>(neighPixel) = 255; 
-						}
-						else
-						{
-							float neighLabel = labelsMask.at<float>( neighPixel ); 
-							if( neighLabel < currentLabel )
-							{
-								labelsMask.at<float>( neighPixel ) = neighLabel; 	
-								neighboursQueue.push( neighPixel );
-								indexes.push_back( neighPixel ); 
-								objMask.at<uchar>(neighPixel) = 255; 
-							}
-						}
-					}
-				}
-
-			}
-
-			objectsMask.push_back( objMask );
-			objIndexes.push_back( indexes ); 
-		}
-	}
-
-	if( false  ){
+	std::vector< cv::Mat > clustersMask; 
+	OrganizedClusters::GetMasks( labelsMask, noClusters, clustersMask ); 
 
-		cv::Mat colorLabel = cv::Mat::zeros(pointCloud.rows, pointCloud.cols, CV_8UC3); 
-		
-		std::vector< cv::Vec3b > colors; 
-		for( int i=0; i <= currentLabel; i++ ){
-			colors.push_back( cv::Vec3b( rand() % 256 , rand() % 256 , rand() % 256 ) ); 
-		}
-		
-		for( int i=0 ; i<pointCloud.rows ; i++){
-			for( int j=0 ; j<pointCloud.cols ; j++){
-				if( labelsMask.at<float>(i,j) != 0.0 )
-					colorLabel.at<cv::Vec3b>(i,j) = colors[ labelsMask.at<float>(i,j) ] ; 		
-			}
-		}
-		cv::imshow( "colorLabel", colorLabel); 
-		cv::waitKey(20); 
-	}
+	objIndexes.insert( objIndexes.end(), clustersIdx.begin(), clustersIdx.end() ); 
+	objectsMask.insert( objectsMask.end(), clustersMask.begin(), clustersMask.end() ); 
 }
 
 //void ObjectsExtractor::ConnectedComponents3D(cv::Mat pointCloud, cv::Mat mask, double minDist, cv::Mat labelsMask, std::vector<std::vector<cv::Point2i>>& objIndexes, std::vector<cv::Mat>& objectsMask){
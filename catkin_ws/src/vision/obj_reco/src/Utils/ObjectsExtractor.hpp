@@ -6,6 +6,9 @@
 #include "Plane3D.hpp"
 #include "PlanarHorizontalSegment.hpp"
 #include "DetectedObject.hpp"
+#include "../OrganizedClusters.hpp"
+#include "../IntegralNormals.hpp"
+#include "justina_tools/JustinaRansac.h"
 #include <queue>
 
 class ObjectsExtractor{
@@ -32,6 +32,7 @@
 #include "ObjExtractor.hpp"
 #include "DetectedObject.hpp"
 #include "ObjRecognizer.hpp"
+#include "PersonDetector.hpp"
 
 cv::VideoCapture kinect;
 cv::Mat lastImaBGR;
@@ -50,6 +51,7 @@ bool enableRecognizeTopic = false;
 
 std::string dirToSaveFiles   = "";
 std::string data_base_folder = "";
+std::string person_model_folder = "";
 
 ros::NodeHandle* node; 
 
@@ -73,6 +75,7 @@ ros::ServiceServer srvFindTable;
 ros::ServiceServer srvFindFreePlane;
 ros::ServiceServer srv_trainByHeight;
 ros::ServiceServer srvDetectGripper;
+ros::ServiceServer srvDetectPersons;
 
 ros::ServiceClient cltRgbdRobot;
 
@@ -81,6 +84,7 @@ void callback_subEnableRecognizeTopic(const std_msgs::Bool::ConstPtr& msg);
 bool callback_srvDetectObjects(vision_msgs::DetectObjects::Request &req, vision_msgs::DetectObjects::Response &resp);
 bool callback_srvDetectAllObjects(vision_msgs::DetectObjects::Request &req, vision_msgs::DetectObjects::Response &resp);
 bool callback_srvDetectGripper(vision_msgs::DetectGripper::Request &req, vision_msgs::DetectGripper::Response &resp);
+bool callback_srvDetectPersons(vision_msgs::DetectObjects::Request &req, vision_msgs::DetectObjects::Response &resp);
 bool callback_srvTrainObject(vision_msgs::TrainObject::Request &req, vision_msgs::TrainObject::Response &resp);
 bool callback_srvFindLines(vision_msgs::FindLines::Request &req, vision_msgs::FindLines::Response &resp);
 bool callback_srvFindPlane(vision_msgs::FindPlane::Request &req, vision_msgs::FindPlane::Response &resp);
@@ -91,6 +95,7 @@ bool cb_srvTrainByHeigth(vision_msgs::TrainObject::Request &req, vision_msgs::Tr
 void call_pointCloudRobot(const sensor_msgs::PointCloud2::ConstPtr& msg);
 
 bool GetImagesFromJustina( cv::Mat& imaBGR, cv::Mat& imaPCL); 
+bool GetImagesFromJustina( cv::Mat& imaBGR, cv::Mat& imaPCL, ros::Time& stamp); 
 void GetParams(int argc, char** argv);
 void DrawObjects(std::vector< vision_msgs::VisionObject >& objList); 
 void DrawObjects(std::vector<DetectedObject> detObjList); 
@@ -101,7 +106,8 @@ void cb_sub_pointCloudRobot(const sensor_msgs::PointCloud2::ConstPtr& msg)
 
     cv::Mat imaRGB; 
     cv::Mat imaXYZ; 
-    if( !GetImagesFromJustina(imaRGB, imaXYZ) )
+    ros::Time stamp; 
+    if( !GetImagesFromJustina(imaRGB, imaXYZ, stamp) )
         return;   
 
     winName = "Detect by Heigth"; 
@@ -123,7 +129,7 @@ void cb_sub_pointCloudRobot(const sensor_msgs::PointCloud2::ConstPtr& msg)
     winName = "Detect by Plane";
     if( enaDetectByPlane )
     {
-        std::vector<DetectedObject> detObjList = ObjExtractor::GetObjectsInHorizontalPlanes( imaXYZ ); 
+        std::vector<DetectedObject> detObjList = ObjExtractor::GetObjectsInHorizontalPlanes( imaXYZ, stamp ); 
         std::sort(detObjList.begin(), detObjList.end(), DetectedObject::CompareByEuclidean ); 
         
         cv::Mat imaToShow = imaRGB.clone(); 
@@ -221,6 +227,7 @@ int main(int argc, char** argv)
     srvTrainObject          = n.advertiseService("/vision/obj_reco/trainObject"     , callback_srvTrainObject);
     srv_trainByHeight       = n.advertiseService("/vision/obj_reco/train_byHeight"  , cb_srvTrainByHeigth);
     srvDetectGripper        = n.advertiseService("/vision/obj_reco/gripper"         , callback_srvDetectGripper);
+    srvDetectPersons        = n.advertiseService("/vision/obj_reco/det_persons"     , callback_srvDetectPersons);
 
     srvFindLines            = n.advertiseService("/vision/line_finder/find_lines_ransac"    , callback_srvFindLines);
     srvFindPlane            = n.advertiseService("/vision/geometry_finder/findPlane"        , callback_srvFindPlane);
@@ -241,6 +248,9 @@ int main(int argc, char** argv)
     objReco.TrainingDir = data_base_folder; 
     objReco.LoadTrainingDir();
     ObjExtractor::LoadValueGripper();  
+    if( person_model_folder == "" )
+        person_model_folder = ros::package::getPath("obj_reco") + std::string("/PersonModel");
+    PersonDetector::LoadModel( person_model_folder + "/MobileNetSSD_deploy.prototxt", person_model_folder + "/MobileNetSSD_deploy.caffemodel" );
     JustinaRepresentation::setNodeHandle(&n); 
 
 
@@ -285,6 +295,52 @@ bool callback_srvDetectGripper(vision_msgs::DetectGripper::Request &req, vision_
 }
 
 
+bool callback_srvDetectPersons(vision_msgs::DetectObjects::Request &req, vision_msgs::DetectObjects::Response &resp)
+{
+    std::cout << execMsg << "srvDetectPersons" << std::endl;
+    cv::Mat imaBGR;
+    cv::Mat imaPCL;
+    ros::Time stamp;
+    if( !GetImagesFromJustina( imaBGR, imaPCL, stamp) )
+        return false;
+
+    PersonDetector::DebugMode = debugMode;
+    std::vector< DetectedPerson > persons = PersonDetector::Detect( imaBGR, imaPCL );
+    for( size_t i=0; i<persons.size(); i++)
+    {
+        vision_msgs::VisionObject obj;
+        obj.header.stamp = stamp;
+        obj.header.frame_id = "base_link";
+        obj.id = "person";
+        obj.category = "person";
+        obj.confidence = persons[i].confidence;
+        obj.pose.position.x = persons[i].centroid.x;
+        obj.pose.position.y = persons[i].centroid.y;
+        obj.pose.position.z = persons[i].centroid.z;
+        obj.pose.orientation.w = 1.0;
+        obj.size.x = persons[i].maxPoint.x - persons[i].minPoint.x;
+        obj.size.y = persons[i].maxPoint.y - persons[i].minPoint.y;
+        obj.size.z = persons[i].maxPoint.z - persons[i].minPoint.z;
+        geometry_msgs::Vector3 minPoint;
+        geometry_msgs::Vector3 maxPoint;
+        minPoint.x = persons[i].minPoint.x;
+        minPoint.y = persons[i].minPoint.y;
+        minPoint.z = persons[i].minPoint.z;
+        maxPoint.x = persons[i].maxPoint.x;
+        maxPoint.y = persons[i].maxPoint.y;
+        maxPoint.z = persons[i].maxPoint.z;
+        obj.bounding_box.push_back( minPoint );
+        obj.bounding_box.push_back( maxPoint );
+        resp.recog_objects.push_back( obj );
+
+        if( dirToSaveFiles != "" && req.saveFiles )
+            cv::rectangle( imaBGR, persons[i].boundBox, cv::Scalar(0,255,0), 2 );
+    }
+    if( dirToSaveFiles != "" && req.saveFiles )
+        cv::imwrite( dirToSaveFiles + "persons.png", imaBGR );
+    return true;
+}
+
 bool callback_srvTrainObject(vision_msgs::TrainObject::Request &req, vision_msgs::TrainObject::Response &resp)
 {
     if( req.name == "" )
@@ -306,7 +362,7 @@ bool callback_srvTrainObject(vision_msgs::TrainObject::Request &req, vision_msgs
     //cv::Mat imaPCL = lastImaPCL.clone();
 
     ObjExtractor::DebugMode = debugMode;
-    std::vector<DetectedObject> detObjList = ObjExtractor::GetObjectsInHorizontalPlanes(imaPCL);
+    std::vector<DetectedObject> detObjList = ObjExtractor::GetObjectsInHorizontalPlanes(imaPCL, srv.response.point_cloud.header.stamp);
     std::sort(detObjList.begin(), detObjList.end(), DetectedObject::CompareByEuclidean ); 
 
     if( detObjList.size() > 0 )
@@ -322,11 +378,12 @@ bool callback_srvDetectObjects(vision_msgs::DetectObjects::Request &req, vision_
 
     cv::Mat imaBGR;
     cv::Mat imaPCL;
-    if( !GetImagesFromJustina( imaBGR, imaPCL) )
+    ros::Time stamp;
+    if( !GetImagesFromJustina( imaBGR, imaPCL, stamp) )
         return false; 
 
     ObjExtractor::DebugMode = debugMode;
-    std::vector<DetectedObject> detObjList = ObjExtractor::GetObjectsInHorizontalPlanes(imaPCL);
+    std::vector<DetectedObject> detObjList = ObjExtractor::GetObjectsInHorizontalPlanes(imaPCL, stamp);
     DrawObjects( detObjList ); 
 
     cv::Mat imaToShow = imaBGR.clone();
@@ -424,11 +481,12 @@ bool callback_srvDetectAllObjects(vision_msgs::DetectObjects::Request &req, visi
 
     cv::Mat imaBGR;
     cv::Mat imaPCL;
-    if( !GetImagesFromJustina( imaBGR, imaPCL) )
+    ros::Time stamp;
+    if( !GetImagesFromJustina( imaBGR, imaPCL, stamp) )
         return false; 
 
     ObjExtractor::DebugMode = debugMode;
-    std::vector<DetectedObject> detObjList = ObjExtractor::GetObjectsInHorizontalPlanes(imaPCL);
+    std::vector<DetectedObject> detObjList = ObjExtractor::GetObjectsInHorizontalPlanes(imaPCL, stamp);
 
     cv::Mat imaToShow = imaBGR.clone();
     int indexObjUnknown = 0;
@@ -589,7 +647,7 @@ bool callback_srvFindLines(vision_msgs::FindLines::Request &req, vision_msgs::Fi
     //cv::Mat xyzCloud = lastImaPCL.clone();
 
     ObjExtractor::DebugMode = debugMode;
-    cv::Vec4i pointsLine = ObjExtractor::GetLine( xyzCloud );
+    cv::Vec4i pointsLine = ObjExtractor::GetLine( xyzCloud, srv.response.point_cloud.header.stamp );
     if( pointsLine == cv::Vec4i(0,0,0,0) )
     {
         std::cout << "Line not Detected" << std::endl;
@@ -638,7 +696,7 @@ bool callback_srvFindPlane(vision_msgs::FindPlane::Request &req, vision_msgs::Fi
     cv::Mat imaPCL;
     JustinaTools::PointCloud2Msg_ToCvMat(srv.response.point_cloud, imaBGR, imaPCL);
 
-    std::vector<PlanarSegment>  horizontalPlanes = ObjExtractor::GetHorizontalPlanes(imaPCL);
+    std::vector<PlanarSegment>  horizontalPlanes = ObjExtractor::GetHorizontalPlanes(imaPCL, srv.response.point_cloud.header.stamp);
 
     if( horizontalPlanes.size() < 1 )
     {
@@ -704,7 +762,7 @@ bool callback_srvFindFreePlane(vision_msgs::FindPlane::Request &req, vision_msgs
     }
     JustinaTools::PointCloud2Msg_ToCvMat(srv.response.point_cloud, imaBGR, imaPCL);
 
-    std::vector<PlanarSegment>  horizontalPlanes = ObjExtractor::GetHorizontalPlanes(imaPCL);
+    std::vector<PlanarSegment>  horizontalPlanes = ObjExtractor::GetHorizontalPlanes(imaPCL, srv.response.point_cloud.header.stamp);
 
     if( horizontalPlanes.size() < 1 )
     {
@@ -819,7 +877,7 @@ bool callback_srvFindTable(vision_msgs::FindPlane::Request &req, vision_msgs::Fi
 
     std::vector<PlanarSegment> tablePlane;
 
-    tablePlane = ObjExtractor::GetHorizontalPlanes(imaPCL);
+    tablePlane = ObjExtractor::GetHorizontalPlanes(imaPCL, srv.response.point_cloud.header.stamp);
 
     if(tablePlane.size() > 1 || tablePlane.size() == 0)
         return false;
@@ -872,6 +930,12 @@ bool callback_srvFindTable(vision_msgs::FindPlane::Request &req, vision_msgs::Fi
 
 
 bool GetImagesFromJustina( cv::Mat& imaBGR, cv::Mat& imaPCL)
+{
+    ros::Time stamp;
+    return GetImagesFromJustina( imaBGR, imaPCL, stamp );
+}
+
+bool GetImagesFromJustina( cv::Mat& imaBGR, cv::Mat& imaPCL, ros::Time& stamp)
 {
     point_cloud_manager::GetRgbd srv;
     if(!cltRgbdRobot.call(srv))
@@ -880,6 +944,7 @@ bool GetImagesFromJustina( cv::Mat& imaBGR, cv::Mat& imaPCL)
         return false;
     }
     JustinaTools::PointCloud2Msg_ToCvMat(srv.response.point_cloud, imaBGR, imaPCL);
+    stamp = srv.response.point_cloud.header.stamp;
     return true; 
 }
 
@@ -942,5 +1007,10 @@ void GetParams(int argc, char** argv)
             data_base_folder = argv[++i];
             std::cout << "\nobj_reco_node.-> EXTERN Training folder: " << data_base_folder << std::endl;
         }
+        else if( params == "--person_model")
+        {
+            person_model_folder = argv[++i];
+            std::cout << "\nobj_reco_node.-> Person detector model folder: " << person_model_folder << std::endl;
+        }
     }
 }
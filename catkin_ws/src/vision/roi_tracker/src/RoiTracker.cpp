@@ -177,40 +177,28 @@ bool RoiTracker::Update(cv::Mat imaBGR, cv::Mat imaXYZ, cv::Rect& nextRoi, doubl
 
     //std::vector< cv::Rect > rois =  this->GetSearchRois( this->roiToTrack, imaBGR );
     std::vector< cv::Rect > rois = GetSearchRoisMultiscale( this->roiToTrack, imaBGR );
-    
-    std::vector< cv::Mat > histos; 
-    std::vector< double > matches; 
+
+    // Histograms of all candidates come from one integral histogram over the region they cover
+    cv::Rect searchRegion; 
+    for(int i=0; i< rois.size(); i++)
+        searchRegion |= rois[i]; 
+    searchRegion &= cv::Rect( 0, 0, imaBGR.cols, imaBGR.rows ); 
+    if( searchRegion.area() > 0 )
+        BuildIntegralHistogram( imaBGR, searchRegion ); 
+
+    std::vector< double > matches( rois.size(), 0.0 ); 
 
     double bestMatch = -9999999999999.9;
     int bestIndex = 0; 
     for(int i=0; i< rois.size(); i++)
     {
-        cv::Mat roiIma; 
-        try
-        {
-            roiIma = imaBGR( rois[i] );
-        }
-        catch(...)
-        {
-            std::cout << ">>>>> EXCEPTION!! at roiIma" << std::endl; 
-            continue; 
-        }
-
-        cv::Mat histo;
-        try
-        {
-            histo = CalculateHistogram( roiIma ); 
-        }
-        catch(...)
+        double match; 
+        if( !MatchIntegralHistogram( rois[i], match ) )
         {
-            std::cout << ">>>>> EXCEPTION!! at  CalculateHistogram" << std::endl; 
+            std::cout << ">>>>> Roi outside of search region" << std::endl; 
             continue; 
         }
-
-        double match = cv::compareHist( this->histoToTrack, histo, cv::HISTCMP_INTERSECT );
-
-        histos.push_back( histo );
-        matches.push_back( match ); 
+        matches[i] = match; 
     
         if( match > bestMatch )
         {
@@ -301,6 +289,94 @@ cv::Mat RoiTracker::CalculateHistogram(cv::Mat bgrIma)
     return this->CalculateHistogram( bgrIma, mask); 
 }
 
+void RoiTracker::BuildIntegralHistogram(cv::Mat bgrIma, cv::Rect region)
+{
+    // Same bins and thresholds as CalculateHistogram: noBins hue bins, then black and white counts. 
+    // Masks are evaluated independently, as there, so a pixel on a threshold may count in two bins. 
+    int totalBins = this->noBins + 2; 
+    int blackBin = this->noBins; 
+    int whiteBin = this->noBins + 1; 
+
+    // Hue bins as calcHist computes them for the uniform range [0,255)
+    this->hueBinLut.resize( 256 ); 
+    double binScale = ((double)this->noBins) / 255.0; 
+    for( int h=0; h<256; h++)
+    {
+        int bin = cvFloor( h * binScale ); 
+        this->hueBinLut[h] = ( bin >= 0 && bin < this->noBins ) ? bin : -1; 
+    }
+
+    cv::cvtColor( bgrIma( region ), this->hsvRegion, CV_BGR2HSV_FULL ); 
+
+    int stride = ( region.width + 1 ) * totalBins; 
+    this->integralRegion = region; 
+    this->integralHisto.resize( ( region.height + 1 ) * stride ); 
+    std::fill( this->integralHisto.begin(), this->integralHisto.begin() + stride, 0 ); 
+
+    std::vector< int > rowCount( totalBins ); 
+    for( int y=0; y<region.height; y++)
+    {
+        const unsigned char* hsv = this->hsvRegion.ptr< unsigned char >( y ); 
+        const int* above = &this->integralHisto[ y * stride ]; 
+        int* current = &this->integralHisto[ ( y + 1 ) * stride ]; 
+        std::fill( current, current + totalBins, 0 ); 
+        std::fill( rowCount.begin(), rowCount.end(), 0 ); 
+        for( int x=0; x<region.width; x++, hsv += 3)
+        {
+            int hueBin = this->hueBinLut[ hsv[0] ]; 
+            int sat = hsv[1]; 
+            int val = hsv[2]; 
+            if( hueBin >= 0 && sat >= 50 && val >= 50 && val <= 205 )
+                rowCount[ hueBin ]++; 
+            if( val <= 50 )
+                rowCount[ blackBin ]++; 
+            if( sat <= 50 && val >= 205 )
+                rowCount[ whiteBin ]++; 
+
+            const int* up = above + ( x + 1 ) * totalBins; 
+            int* cell = current + ( x + 1 ) * totalBins; 
+            for( int b=0; b<totalBins; b++)
+                cell[b] = up[b] + rowCount[b]; 
+        }
+    }
+}
+
+bool RoiTracker::MatchIntegralHistogram(const cv::Rect& roi, double& match)
+{
+    // Equivalent to compareHist( histoToTrack, CalculateHistogram( ima(roi) ), HISTCMP_INTERSECT )
+    match = 0.0; 
+    if( roi.area() <= 0 || ( roi & this->integralRegion ) != roi )
+        return false; 
+
+    int totalBins = this->noBins + 2; 
+    if( this->histoToTrack.rows * this->histoToTrack.cols != totalBins )
+        return false; 
+
+    int stride = ( this->integralRegion.width + 1 ) * totalBins; 
+    int x1 = ( roi.x - this->integralRegion.x ) * totalBins; 
+    int x2 = x1 + roi.width * totalBins; 
+    int y1 = ( roi.y - this->integralRegion.y ) * stride; 
+    int y2 = y1 + roi.height * stride; 
+    const int* tl = &this->integralHisto[ y1 + x1 ]; 
+    const int* tr = &this->integralHisto[ y1 + x2 ]; 
+    const int* bl = &this->integralHisto[ y2 + x1 ]; 
+    const int* br = &this->integralHisto[ y2 + x2 ]; 
+
+    int total = 0; 
+    for( int b=0; b<totalBins; b++)
+        total += br[b] - tr[b] - bl[b] + tl[b]; 
+    if( total == 0 )
+        return true; 
+
+    const float* histo = this->histoToTrack.ptr< float >( 0 ); 
+    for( int b=0; b<totalBins; b++)
+    {
+        float binValue = (float)( br[b] - tr[b] - bl[b] + tl[b] ) / (float)total; 
+        match += std::min( histo[b], binValue ); 
+    }
+    return true; 
+}
+
 std::vector< cv::Rect > RoiTracker::GetSearchRois( cv::Rect centerRoi, cv::Mat bgrIma )
 { 
     std::vector< cv::Rect > rois; 
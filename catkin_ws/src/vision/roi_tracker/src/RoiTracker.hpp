@@ -24,6 +24,10 @@ class RoiTracker
         cv::Mat CalculateHistogram(cv::Mat bgrIma, cv::Mat mask);
         cv::Mat CalculateHistogram(cv::Mat bgrIma);
 
+        // Integral histogram of the search region, so each candidate roi is scored in O(bins)
+        void BuildIntegralHistogram(cv::Mat bgrIma, cv::Rect region);
+        bool MatchIntegralHistogram(const cv::Rect& roi, double& match);
+
         std::vector< cv::Rect > GetSearchRois( cv::Rect centerRoi, cv::Mat bgrIma );
         std::vector< cv::Rect > GetSearchRoisMultiscale( cv::Rect centerRoi, cv::Mat bgrIma );
         
@@ -47,4 +51,9 @@ class RoiTracker
         int scaleSteps; 
 
         double matchThreshold;
+
+        cv::Mat hsvRegion;
+        cv::Rect integralRegion;
+        std::vector< int > integralHisto;   // (rows+1) x (cols+1) x (noBins+2) counts
+        std::vector< int > hueBinLut;       // Hue value to bin, -1 if out of range
 };
@@ -67,67 +67,74 @@ void XN_CALLBACK_TYPE UserPose_PoseDetected(xn::PoseDetectionCapability& capabil
     g_UserGenerator.GetSkeletonCap().RequestCalibration(nId, TRUE);
 }
 
-void publishTransform(XnUserID const& user, XnSkeletonJoint const& joint, string const& frame_id, string const& child_frame_id, vision_msgs::SkeletonJoint &skeletonJoint) {
-    static tf::TransformBroadcaster br;
-
-    XnSkeletonJointPosition joint_position;
-    g_UserGenerator.GetSkeletonCap().GetSkeletonJointPosition(user, joint, joint_position);
-    double x = -joint_position.position.X / 1000.0;
-    double y = joint_position.position.Y / 1000.0;
-    double z = joint_position.position.Z / 1000.0;
+//Joints of the skeleton: OpenNI joint, name of the tf frame and field of the Skeleton message.
+//Left and right are swapped since OpenNI names them from the point of view of the sensor.
+struct SkeletonJointInfo {
+    XnSkeletonJoint joint;
+    const char* name;
+    vision_msgs::SkeletonJoint vision_msgs::Skeleton::* field;
+};
+
+const SkeletonJointInfo skeletonJoints[] = {
+    {XN_SKEL_HEAD,           "head",           &vision_msgs::Skeleton::head},
+    {XN_SKEL_NECK,           "neck",           &vision_msgs::Skeleton::neck},
+    {XN_SKEL_TORSO,          "torso",          &vision_msgs::Skeleton::torso},
+    {XN_SKEL_RIGHT_SHOULDER, "left_shoulder",  &vision_msgs::Skeleton::left_shoulder},
+    {XN_SKEL_RIGHT_ELBOW,    "left_elbow",     &vision_msgs::Skeleton::left_elbow},
+    {XN_SKEL_RIGHT_HAND,     "left_hand",      &vision_msgs::Skeleton::left_hand},
+    {XN_SKEL_LEFT_SHOULDER,  "right_shoulder", &vision_msgs::Skeleton::right_shoulder},
+    {XN_SKEL_LEFT_ELBOW,     "right_elbow",    &vision_msgs::Skeleton::right_elbow},
+    {XN_SKEL_LEFT_HAND,      "right_hand",     &vision_msgs::Skeleton::right_hand},
+    {XN_SKEL_RIGHT_HIP,      "left_hip",       &vision_msgs::Skeleton::left_hip},
+    {XN_SKEL_RIGHT_KNEE,     "left_knee",      &vision_msgs::Skeleton::left_knee},
+    {XN_SKEL_RIGHT_FOOT,     "left_foot",      &vision_msgs::Skeleton::left_foot},
+    {XN_SKEL_LEFT_HIP,       "right_hip",      &vision_msgs::Skeleton::right_hip},
+    {XN_SKEL_LEFT_KNEE,      "right_knee",     &vision_msgs::Skeleton::right_knee},
+    {XN_SKEL_LEFT_FOOT,      "right_foot",     &vision_msgs::Skeleton::right_foot}
+};
+const int skeletonJointsCount = sizeof(skeletonJoints) / sizeof(skeletonJoints[0]);
+
+//If false, only the Skeletons topic is published (no tf frame per joint)
+bool publish_tf = true;
+
+//Transform of a joint wrt the sensor frame
+tf::Transform getJointTransform(XnUserID const& user, XnSkeletonJoint const& joint) {
+    // #4994
+    static tf::Transform change_frame(tf::createQuaternionFromRPY(0, 0, M_PI), tf::Vector3(0, 0, 0));
 
-    XnSkeletonJointOrientation joint_orientation;
-    g_UserGenerator.GetSkeletonCap().GetSkeletonJointOrientation(user, joint, joint_orientation);
+    //Position and orientation in only one call
+    XnSkeletonJointTransformation joint_transformation;
+    g_UserGenerator.GetSkeletonCap().GetSkeletonJoint(user, joint, joint_transformation);
+    double x = -joint_transformation.position.position.X / 1000.0;
+    double y = joint_transformation.position.position.Y / 1000.0;
+    double z = joint_transformation.position.position.Z / 1000.0;
 
-    XnFloat* m = joint_orientation.orientation.elements;
+    XnFloat* m = joint_transformation.orientation.orientation.elements;
     KDL::Rotation rotation(m[0], m[1], m[2],
             m[3], m[4], m[5],
             m[6], m[7], m[8]);
     double qx, qy, qz, qw;
     rotation.GetQuaternion(qx, qy, qz, qw);
 
-    char child_frame_no[128];
-    snprintf(child_frame_no, sizeof(child_frame_no), "%s_%d", child_frame_id.c_str(), user);
-
     tf::Transform transform;
     transform.setOrigin(tf::Vector3(x, y, z));
     transform.setRotation(tf::Quaternion(qx, -qy, -qz, qw));
-
-    // #4994
-    tf::Transform change_frame;
-    change_frame.setOrigin(tf::Vector3(0, 0, 0));
-    tf::Quaternion frame_rotation;
-    frame_rotation.setEuler(0, 0, M_PI);
-
-    change_frame.setRotation(frame_rotation);
-
-    transform = change_frame * transform;
-
-    br.sendTransform(tf::StampedTransform(transform, ros::Time::now(), frame_id, child_frame_no));
-
-    tf::StampedTransform globalTransform;
-    transformListener->lookupTransform("/base_link", frame_id,
-                             ros::Time(0), globalTransform);
-    transform = globalTransform * transform;
-    
-    geometry_msgs::Vector3 position;
-    geometry_msgs::Quaternion orientation; 
-    position.x = transform.getOrigin().getX();
-    position.y = transform.getOrigin().getY();
-    position.z = transform.getOrigin().getZ();
-    orientation.x = transform.getRotation().getX();
-    orientation.y = transform.getRotation().getY();
-    orientation.z = transform.getRotation().getZ();
-    orientation.w = transform.getRotation().getW();
-    skeletonJoint.position = position;
-    skeletonJoint.orientation = orientation;
+    return change_frame * transform;
 }
 
+//All joints of all users are computed in one pass, with only one lookup of the sensor frame wrt base_link
+//and, if enabled, only one broadcast of all the joint frames.
 void publishTransforms(const std::string& frame_id) {
+    static tf::TransformBroadcaster br;
+
     XnUserID users[15];
     XnUInt16 users_count = 15;
     g_UserGenerator.GetUsers(users, users_count);
 
+    ros::Time now = ros::Time::now();
+    tf::StampedTransform globalTransform;
+    bool globalTransformFound = false;
+    std::vector<tf::StampedTransform> transforms;
     vision_msgs::Skeletons skeletons;
 
     for (int i = 0; i < users_count; ++i) {
@@ -135,64 +142,45 @@ void publishTransforms(const std::string& frame_id) {
         if (!g_UserGenerator.GetSkeletonCap().IsTracking(user))
             continue;
 
-        vision_msgs::Skeleton skeleton;
+        if(!globalTransformFound){
+            try{
+                transformListener->lookupTransform("/base_link", frame_id, ros::Time(0), globalTransform);
+            }
+            catch(tf::TransformException& ex){
+                ROS_WARN_THROTTLE(1.0, "Cannot get transform from %s to base_link: %s", frame_id.c_str(), ex.what());
+                return;
+            }
+            globalTransformFound = true;
+        }
 
-        vision_msgs::SkeletonJoint jointHead;
-        vision_msgs::SkeletonJoint jointNeck;
-        vision_msgs::SkeletonJoint jointTorso;
-        vision_msgs::SkeletonJoint jointLeftShoulder;
-        vision_msgs::SkeletonJoint jointLeftElbow;
-        vision_msgs::SkeletonJoint jointLeftHand;
-        vision_msgs::SkeletonJoint jointRightShoulder;
-        vision_msgs::SkeletonJoint jointRightElbow;
-        vision_msgs::SkeletonJoint jointRightHand;
-        vision_msgs::SkeletonJoint jointLeftHip;
-        vision_msgs::SkeletonJoint jointLeftKnee;
-        vision_msgs::SkeletonJoint jointLeftFoot;
-        vision_msgs::SkeletonJoint jointRightHip;
-        vision_msgs::SkeletonJoint jointRightKnee;
-        vision_msgs::SkeletonJoint jointRightFoot;
-
-        publishTransform(user, XN_SKEL_HEAD,           frame_id, "head", jointHead);
-        publishTransform(user, XN_SKEL_NECK,           frame_id, "neck", jointNeck);
-        publishTransform(user, XN_SKEL_TORSO,          frame_id, "torso", jointTorso);
-
-        publishTransform(user, XN_SKEL_RIGHT_SHOULDER,  frame_id, "left_shoulder", jointLeftShoulder);
-        publishTransform(user, XN_SKEL_RIGHT_ELBOW,     frame_id, "left_elbow", jointLeftElbow);
-        publishTransform(user, XN_SKEL_RIGHT_HAND,      frame_id, "left_hand", jointLeftHand);
-
-        publishTransform(user, XN_SKEL_LEFT_SHOULDER, frame_id, "right_shoulder", jointRightShoulder);
-        publishTransform(user, XN_SKEL_LEFT_ELBOW,    frame_id, "right_elbow", jointRightElbow);
-        publishTransform(user, XN_SKEL_LEFT_HAND,     frame_id, "right_hand", jointRightHand);
-
-        publishTransform(user, XN_SKEL_RIGHT_HIP,       frame_id, "left_hip", jointLeftHip);
-        publishTransform(user, XN_SKEL_RIGHT_KNEE,      frame_id, "left_knee", jointLeftKnee);
-        publishTransform(user, XN_SKEL_RIGHT_FOOT,      frame_id, "left_foot", jointLeftFoot);
-
-        publishTransform(user, XN_SKEL_LEFT_HIP,      frame_id, "right_hip", jointRightHip);
-        publishTransform(user, XN_SKEL_LEFT_KNEE,     frame_id, "right_knee", jointRightKnee);
-        publishTransform(user, XN_SKEL_LEFT_FOOT,     frame_id, "right_foot", jointRightFoot);
-    
+        vision_msgs::Skeleton skeleton;
         skeleton.user_id = user;
-        skeleton.head = jointHead;
-        skeleton.neck = jointNeck;
-        skeleton.torso = jointTorso;
-        skeleton.left_shoulder = jointLeftShoulder;
-        skeleton.left_elbow = jointLeftElbow;
-        skeleton.left_hand = jointLeftHand;
-        skeleton.right_shoulder = jointRightShoulder;
-        skeleton.right_elbow = jointRightElbow;
-        skeleton.right_hand = jointRightHand;
-        skeleton.left_hip = jointLeftHip;
-        skeleton.left_knee = jointLeftKnee;
-        skeleton.left_foot = jointLeftFoot;
-        skeleton.right_hip = jointRightHip;
-        skeleton.right_knee = jointRightKnee;
-        skeleton.right_foot = jointRightFoot;
-
+        for (int j = 0; j < skeletonJointsCount; ++j) {
+            tf::Transform transform = getJointTransform(user, skeletonJoints[j].joint);
+
+            if(publish_tf){
+                char child_frame_no[128];
+                snprintf(child_frame_no, sizeof(child_frame_no), "%s_%d", skeletonJoints[j].name, user);
+                transforms.push_back(tf::StampedTransform(transform, now, frame_id, child_frame_no));
+            }
+
+            transform = globalTransform * transform;
+            vision_msgs::SkeletonJoint& skeletonJoint = skeleton.*(skeletonJoints[j].field);
+            skeletonJoint.position.x = transform.getOrigin().getX();
+            skeletonJoint.position.y = transform.getOrigin().getY();
+            skeletonJoint.position.z = transform.getOrigin().getZ();
+            skeletonJoint.orientation.x = transform.getRotation().getX();
+            skeletonJoint.orientation.y = transform.getRotation().getY();
+            skeletonJoint.orientation.z = transform.getRotation().getZ();
+            skeletonJoint.orientation.w = transform.getRotation().getW();
+        }
         skeletons.skeletons.push_back(skeleton);
     }
 
+    if(!transforms.empty())
+        br.sendTransform(transforms);
+    skeletons.header.stamp = now;
+    skeletons.header.frame_id = "base_link";
     pubSkeletons.publish(skeletons);
 }
 
@@ -284,6 +272,8 @@ int main(int argc, char **argv) {
 
     ros::NodeHandle pnh("~");
     frame_id = "kinect_link";
+    pnh.param<bool>("publish_tf", publish_tf, true);
+    std::cout << "SkeletonFinder.->Publishing tf of joints: " << (publish_tf ? "true" : "false") << std::endl;
     ros::Subscriber subStartTracking = pnh.subscribe("/vision/skeleton_finder/start_tracking", 1, callbackStartTracking);
     ros::Subscriber subStopTracking = pnh.subscribe("/vision/skeleton_finder/stop_tracking", 1, callbackStopTracking);
     pubSkeletons = pnh.advertise<vision_msgs::Skeletons>("/vision/skeleton_finder/skeleton_recog", 1);